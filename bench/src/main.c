@@ -0,0 +1,689 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include <common/common.h>
+#include <common/error.h>
+#include <ecs/ecs.h>
+#include <ecs/system.h>
+#include <ecs/query.h>
+#include <ecs/extract.h>
+#include <time/time.h>
+
+/*
+ * @brief ECS benchmark
+ *
+ * Measures the cost of the basic ECS operations for a range of entity counts and archetype counts.
+ * Every scenario spawns N entities with 4 data components, spread over A archetypes using tag components,
+ * and then measures iteration (with system iterators and typed queries), frame extraction to a consumer
+ * thread, random access, component migration and destruction on that world.
+ *
+ * Usage: maybe_ecs_bench [--min-entities N] [--max-entities N] [--archetypes A,B,...] [--seed S] [--json FILE]
+ * */
+
+#define BENCH_DEFAULT_MIN_ENTITIES (1000)
+#define BENCH_DEFAULT_MAX_ENTITIES (10000000)
+#define BENCH_TAG_COUNT (8)
+#define BENCH_MAX_ARCHETYPE_COUNTS (8)
+#define BENCH_MAX_RESULTS (512)
+#define BENCH_MIN_ITERATED_ENTITIES (10000000) /* Iteration passes are repeated until at least this many rows were visited */
+
+typedef struct {
+	float x;
+	float y;
+	float z;
+} position_t;
+
+typedef struct {
+	float x;
+	float y;
+	float z;
+} velocity_t;
+
+typedef struct {
+	float value;
+	uint32_t flags;
+} health_t;
+
+typedef struct {
+	float value;
+} mass_t;
+
+typedef struct {
+	uint32_t value;
+} migrate_t;
+
+/* The component IDs are compile-time constants, the tags are registered after them */
+#define BENCH_COMPONENTS(COMPONENT, SHARED_COMPONENT) \
+	COMPONENT(position_t) \
+	COMPONENT(velocity_t) \
+	COMPONENT(health_t) \
+	COMPONENT(mass_t) \
+	COMPONENT(migrate_t)
+
+MAYBE_DECLARE_COMPONENT_MANIFEST(BENCH_COMPONENTS)
+
+typedef enum {
+	BENCH_SYSTEM_ITERATE_1,
+	BENCH_SYSTEM_ITERATE_2,
+	BENCH_SYSTEM_ITERATE_4,
+	BENCH_SYSTEM_COUNT
+} bench_system_t;
+
+/* @brief The consumer of extracted frames, it only checksums them so no renderer is needed */
+typedef struct {
+	uint64_t checksum;
+	uint64_t packet_count;
+} bench_frame_consumer_t;
+
+typedef struct {
+	const char* phase;
+	uint64_t entities;
+	uint32_t archetypes;
+	uint64_t operations;
+	uint64_t total_ns;
+	long peak_rss_kb;
+} bench_result_t;
+
+typedef struct {
+	uint64_t min_entities;
+	uint64_t max_entities;
+	uint32_t archetype_counts[BENCH_MAX_ARCHETYPE_COUNTS];
+	uint32_t archetype_counts_count;
+	uint64_t seed;
+	const char* json_path;
+} bench_options_t;
+
+static bench_result_t results[BENCH_MAX_RESULTS];
+static uint32_t result_count = 0;
+static uint32_t tag_ids[BENCH_TAG_COUNT];
+static volatile float sink = 0.0f; /* Prevents the compiler from dropping the measured work */
+
+/*
+ * @brief A small xorshift generator, so runs with the same seed access the same entities
+ * */
+static uint64_t bench_random(uint64_t* state) {
+	uint64_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	*state = x;
+
+	return x;
+}
+
+static long bench_get_peak_rss_kb(void) {
+	struct rusage usage;
+
+	if (0 != getrusage(RUSAGE_SELF, &usage)) {
+		return -1;
+	}
+
+	/* @note On Linux ru_maxrss is in kilobytes */
+	return usage.ru_maxrss;
+}
+
+static void bench_record(
+	const char* phase,
+	uint64_t entities,
+	uint32_t archetypes,
+	uint64_t operations,
+	uint64_t total_ns
+) {
+	bench_result_t* entry;
+	double ns_per_entity = (operations > 0) ? ((double)total_ns / (double)operations) : 0.0;
+	double throughput = (total_ns > 0) ? ((double)operations * 1e9 / (double)total_ns) : 0.0;
+
+	if (result_count >= BENCH_MAX_RESULTS) {
+		return;
+	}
+
+	entry = &results[result_count];
+	entry->phase = phase;
+	entry->entities = entities;
+	entry->archetypes = archetypes;
+	entry->operations = operations;
+	entry->total_ns = total_ns;
+	entry->peak_rss_kb = bench_get_peak_rss_kb();
+	result_count++;
+
+	printf(
+		"%-16s %10llu %6u %14.2f %16.0f %12ld\n",
+		phase,
+		(unsigned long long)entities,
+		archetypes,
+		ns_per_entity,
+		throughput,
+		entry->peak_rss_kb
+	);
+	fflush(stdout);
+}
+
+void bench_iterate_1(void* system) {
+	maybe_system_component_iterator_t position;
+	position_t* p;
+
+	maybe_system_init_component_iterator(system, MAYBE_COMPONENT_ID(position_t), &position);
+
+	while (position.current_component_pointer) {
+		p = (position_t*)position.current_component_pointer;
+		p->x += 1.0f;
+
+		maybe_system_component_iterator_get_next_component(system, &position);
+	}
+}
+
+void bench_iterate_2(void* system) {
+	maybe_system_component_iterator_t position, velocity;
+	position_t* p;
+	velocity_t* v;
+
+	maybe_system_init_component_iterator(system, MAYBE_COMPONENT_ID(position_t), &position);
+	maybe_system_init_component_iterator(system, MAYBE_COMPONENT_ID(velocity_t), &velocity);
+
+	while (position.current_component_pointer) {
+		p = (position_t*)position.current_component_pointer;
+		v = (velocity_t*)velocity.current_component_pointer;
+		p->x += v->x;
+		p->y += v->y;
+		p->z += v->z;
+
+		maybe_system_component_iterator_get_next_component(system, &position);
+		maybe_system_component_iterator_get_next_component(system, &velocity);
+	}
+}
+
+void bench_iterate_4(void* system) {
+	maybe_system_component_iterator_t position, velocity, health, mass;
+	position_t* p;
+	velocity_t* v;
+	health_t* h;
+	mass_t* m;
+
+	maybe_system_init_component_iterator(system, MAYBE_COMPONENT_ID(position_t), &position);
+	maybe_system_init_component_iterator(system, MAYBE_COMPONENT_ID(velocity_t), &velocity);
+	maybe_system_init_component_iterator(system, MAYBE_COMPONENT_ID(health_t), &health);
+	maybe_system_init_component_iterator(system, MAYBE_COMPONENT_ID(mass_t), &mass);
+
+	while (position.current_component_pointer) {
+		p = (position_t*)position.current_component_pointer;
+		v = (velocity_t*)velocity.current_component_pointer;
+		h = (health_t*)health.current_component_pointer;
+		m = (mass_t*)mass.current_component_pointer;
+		p->x += v->x * m->value;
+		p->y += v->y * m->value;
+		p->z += v->z * m->value;
+		h->value -= 0.5f * m->value;
+
+		maybe_system_component_iterator_get_next_component(system, &position);
+		maybe_system_component_iterator_get_next_component(system, &velocity);
+		maybe_system_component_iterator_get_next_component(system, &health);
+		maybe_system_component_iterator_get_next_component(system, &mass);
+	}
+}
+
+static void bench_query_1(maybe_world_t* world) {
+	MAYBE_QUERY_EACH(world, (position_t, p)) {
+		p->x += 1.0f;
+	}
+}
+
+static void bench_query_2(maybe_world_t* world) {
+	MAYBE_QUERY_EACH(world, (position_t, p), (velocity_t, v)) {
+		p->x += v->x;
+		p->y += v->y;
+		p->z += v->z;
+	}
+}
+
+static void bench_query_4(maybe_world_t* world) {
+	MAYBE_QUERY_EACH(world, (position_t, p), (velocity_t, v), (health_t, h), (mass_t, m)) {
+		p->x += v->x * m->value;
+		p->y += v->y * m->value;
+		p->z += v->z * m->value;
+		h->value -= 0.5f * m->value;
+	}
+}
+
+static void bench_consume_frame(
+	void* context,
+	const maybe_frame_packet_t* packet
+) {
+	bench_frame_consumer_t* consumer = (bench_frame_consumer_t*)context;
+	const position_t* positions = (const position_t*)MAYBE_VECTOR_ELEMENT(packet->columns, maybe_vector_t, 0).elements;
+	uint64_t checksum = consumer->checksum;
+	uint32_t bits, i;
+
+	for (i = 0; i < packet->entity_count; i++) {
+		memcpy(&bits, &positions[i].x, sizeof(bits));
+		checksum = (checksum ^ bits) * 0x100000001b3ull;
+	}
+
+	consumer->checksum = checksum;
+	consumer->packet_count++;
+}
+
+static maybe_error_t bench_init_world(
+	maybe_world_t* world
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t i;
+
+	result = maybe_world_init(world);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	MAYBE_REGISTER_COMPONENT_MANIFEST(world, BENCH_COMPONENTS);
+
+	/* Tags are only used to split the entities into archetypes */
+	for (i = 0; i < BENCH_TAG_COUNT; i++) {
+		result = maybe_world_add_component_type(world, sizeof(uint8_t), &tag_ids[i]);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	/* The systems are registered in the order of bench_system_t */
+	result = maybe_world_register_system(world, bench_iterate_1, 1, MAYBE_COMPONENT_ID(position_t));
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_world_register_system(world, bench_iterate_2, 2, MAYBE_COMPONENT_ID(position_t), MAYBE_COMPONENT_ID(velocity_t));
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_world_register_system(
+		world,
+		bench_iterate_4,
+		4,
+		MAYBE_COMPONENT_ID(position_t),
+		MAYBE_COMPONENT_ID(velocity_t),
+		MAYBE_COMPONENT_ID(health_t),
+		MAYBE_COMPONENT_ID(mass_t)
+	);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+static maybe_error_t bench_spawn(
+	maybe_world_t* world,
+	uint64_t entity_count,
+	uint32_t archetype_count,
+	maybe_entity_t* entities
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t component_ids[4 + BENCH_TAG_COUNT];
+	uint32_t component_count, archetype, bit;
+	uint64_t i;
+	position_t* p;
+	velocity_t* v;
+	health_t* h;
+	mass_t* m;
+
+	component_ids[0] = MAYBE_COMPONENT_ID(position_t);
+	component_ids[1] = MAYBE_COMPONENT_ID(velocity_t);
+	component_ids[2] = MAYBE_COMPONENT_ID(health_t);
+	component_ids[3] = MAYBE_COMPONENT_ID(mass_t);
+
+	for (i = 0; i < entity_count; i++) {
+		/* The bits of the archetype number select the tags */
+		archetype = (uint32_t)(i % archetype_count);
+		component_count = 4;
+		for (bit = 0; bit < BENCH_TAG_COUNT; bit++) {
+			if (archetype & (1u << bit)) {
+				component_ids[component_count] = tag_ids[bit];
+				component_count++;
+			}
+		}
+
+		result = maybe_world_add_entity_array(world, component_count, component_ids, &entities[i]);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		/* Initialize the components, as a real spawn would */
+		(void)maybe_world_get_component(world, entities[i], MAYBE_COMPONENT_ID(position_t), (void**)&p);
+		(void)maybe_world_get_component(world, entities[i], MAYBE_COMPONENT_ID(velocity_t), (void**)&v);
+		(void)maybe_world_get_component(world, entities[i], MAYBE_COMPONENT_ID(health_t), (void**)&h);
+		(void)maybe_world_get_component(world, entities[i], MAYBE_COMPONENT_ID(mass_t), (void**)&m);
+		*p = (position_t){ (float)i, 0.0f, 0.0f };
+		*v = (velocity_t){ 1.0f, 0.5f, 0.25f };
+		*h = (health_t){ 100.0f, 0 };
+		*m = (mass_t){ 1.0f };
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+static void bench_iterate(
+	maybe_world_t* world,
+	bench_system_t system_index,
+	const char* phase,
+	uint64_t entity_count,
+	uint32_t archetype_count
+) {
+	maybe_system_t* system = &MAYBE_VECTOR_ELEMENT(world->systems, maybe_system_t, system_index);
+	uint64_t passes = (BENCH_MIN_ITERATED_ENTITIES + entity_count - 1) / entity_count;
+	uint64_t i, start;
+
+	start = maybe_time_get_monotonic_ns();
+	for (i = 0; i < passes; i++) {
+		system->function((void*)system);
+	}
+	bench_record(phase, entity_count, archetype_count, passes * entity_count, maybe_time_get_monotonic_ns() - start);
+}
+
+static void bench_query(
+	maybe_world_t* world,
+	void (*query)(maybe_world_t* world),
+	const char* phase,
+	uint64_t entity_count,
+	uint32_t archetype_count
+) {
+	uint64_t passes = (BENCH_MIN_ITERATED_ENTITIES + entity_count - 1) / entity_count;
+	uint64_t i, start;
+
+	start = maybe_time_get_monotonic_ns();
+	for (i = 0; i < passes; i++) {
+		query(world);
+	}
+	bench_record(phase, entity_count, archetype_count, passes * entity_count, maybe_time_get_monotonic_ns() - start);
+}
+
+static maybe_error_t bench_extract(
+	maybe_world_t* world,
+	const char* phase,
+	uint64_t entity_count,
+	uint32_t archetype_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_frame_extractor_t extractor;
+	bench_frame_consumer_t consumer = { 0 };
+	uint32_t component_ids[2] = { MAYBE_COMPONENT_ID(position_t), MAYBE_COMPONENT_ID(velocity_t) };
+	uint64_t passes = (BENCH_MIN_ITERATED_ENTITIES + entity_count - 1) / entity_count;
+	uint64_t i, start;
+	bool extractor_initialized = false;
+
+	result = maybe_frame_extractor_init(&extractor, world, 2, component_ids);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	extractor_initialized = true;
+
+	result = maybe_frame_extractor_start(&extractor, bench_consume_frame, &consumer);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* The consumer checksums one frame while the next one is extracted */
+	start = maybe_time_get_monotonic_ns();
+	for (i = 0; i < passes; i++) {
+		result = maybe_frame_extractor_extract(&extractor, world);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = maybe_frame_extractor_stop(&extractor);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	bench_record(phase, entity_count, archetype_count, passes * entity_count, maybe_time_get_monotonic_ns() - start);
+	sink = (float)consumer.checksum;
+
+	if (consumer.packet_count != passes) {
+		result = MAYBE_ERROR_FRAME_EXTRACTOR_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (extractor_initialized) {
+		(void)maybe_frame_extractor_free(&extractor);
+	}
+
+	return result;
+}
+
+static maybe_error_t bench_run_scenario(
+	uint64_t entity_count,
+	uint32_t archetype_count,
+	uint64_t seed
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_world_t world;
+	bool world_initialized = false;
+	maybe_entity_t* entities = NULL;
+	maybe_entity_t temp;
+	position_t* p;
+	uint64_t i, j, start;
+	uint64_t random_state = seed;
+	float sum = 0.0f;
+
+	entities = MALLOC_T(maybe_entity_t, entity_count);
+	if (NULL == entities) {
+		result = MAYBE_ERROR_ECS_WORLD_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+
+	result = bench_init_world(&world);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	world_initialized = true;
+
+	/* Spawn */
+	start = maybe_time_get_monotonic_ns();
+	result = bench_spawn(&world, entity_count, archetype_count, entities);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	bench_record("spawn", entity_count, archetype_count, entity_count, maybe_time_get_monotonic_ns() - start);
+
+	/* Iteration */
+	bench_iterate(&world, BENCH_SYSTEM_ITERATE_1, "iterate_1", entity_count, archetype_count);
+	bench_iterate(&world, BENCH_SYSTEM_ITERATE_2, "iterate_2", entity_count, archetype_count);
+	bench_iterate(&world, BENCH_SYSTEM_ITERATE_4, "iterate_4", entity_count, archetype_count);
+	bench_query(&world, bench_query_1, "query_1", entity_count, archetype_count);
+	bench_query(&world, bench_query_2, "query_2", entity_count, archetype_count);
+	bench_query(&world, bench_query_4, "query_4", entity_count, archetype_count);
+
+	/* Frame extraction */
+	result = bench_extract(&world, "extract", entity_count, archetype_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* Random access */
+	start = maybe_time_get_monotonic_ns();
+	for (i = 0; i < entity_count; i++) {
+		result = maybe_world_get_component(&world, entities[bench_random(&random_state) % entity_count], MAYBE_COMPONENT_ID(position_t), (void**)&p);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+		sum += p->x;
+	}
+	bench_record("random_access", entity_count, archetype_count, entity_count, maybe_time_get_monotonic_ns() - start);
+	sink = sum;
+
+	/* Migration between archetypes */
+	start = maybe_time_get_monotonic_ns();
+	for (i = 0; i < entity_count; i++) {
+		result = maybe_world_add_component(&world, entities[i], MAYBE_COMPONENT_ID(migrate_t));
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+	bench_record("add_component", entity_count, archetype_count, entity_count, maybe_time_get_monotonic_ns() - start);
+
+	start = maybe_time_get_monotonic_ns();
+	for (i = 0; i < entity_count; i++) {
+		result = maybe_world_remove_component(&world, entities[i], MAYBE_COMPONENT_ID(migrate_t));
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+	bench_record("remove_component", entity_count, archetype_count, entity_count, maybe_time_get_monotonic_ns() - start);
+
+	/* Destroy in a random order, so rows are removed from the middle of the archetypes */
+	for (i = entity_count - 1; i > 0; i--) {
+		j = bench_random(&random_state) % (i + 1);
+		temp = entities[i];
+		entities[i] = entities[j];
+		entities[j] = temp;
+	}
+
+	start = maybe_time_get_monotonic_ns();
+	for (i = 0; i < entity_count; i++) {
+		result = maybe_world_remove_entity(&world, entities[i]);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+	bench_record("destroy", entity_count, archetype_count, entity_count, maybe_time_get_monotonic_ns() - start);
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (world_initialized) {
+		(void)maybe_world_free(&world);
+	}
+
+	if (entities) {
+		free(entities);
+	}
+
+	return result;
+}
+
+static bool bench_write_json(
+	const char* path,
+	bench_options_t* options
+) {
+	FILE* file = NULL;
+	bench_result_t* entry;
+	uint32_t i;
+
+	file = fopen(path, "w");
+	if (NULL == file) {
+		return false;
+	}
+
+	fprintf(file, "{\n\t\"benchmark\": \"maybe_ecs_bench\",\n\t\"seed\": %llu,\n\t\"results\": [\n", (unsigned long long)options->seed);
+	for (i = 0; i < result_count; i++) {
+		entry = &results[i];
+		fprintf(
+			file,
+			"\t\t{ \"phase\": \"%s\", \"entities\": %llu, \"archetypes\": %u, \"operations\": %llu, \"total_ns\": %llu, "
+			"\"ns_per_entity\": %.3f, \"entities_per_second\": %.1f, \"peak_rss_kb\": %ld }%s\n",
+			entry->phase,
+			(unsigned long long)entry->entities,
+			entry->archetypes,
+			(unsigned long long)entry->operations,
+			(unsigned long long)entry->total_ns,
+			(entry->operations > 0) ? ((double)entry->total_ns / (double)entry->operations) : 0.0,
+			(entry->total_ns > 0) ? ((double)entry->operations * 1e9 / (double)entry->total_ns) : 0.0,
+			entry->peak_rss_kb,
+			(i + 1 < result_count) ? "," : ""
+		);
+	}
+	fprintf(file, "\t]\n}\n");
+
+	fclose(file);
+
+	return true;
+}
+
+static bool bench_parse_options(
+	int argc,
+	char** argv,
+	bench_options_t* options
+) {
+	char* token;
+	int i;
+
+	options->min_entities = BENCH_DEFAULT_MIN_ENTITIES;
+	options->max_entities = BENCH_DEFAULT_MAX_ENTITIES;
+	options->archetype_counts[0] = 1;
+	options->archetype_counts[1] = 16;
+	options->archetype_counts[2] = 256;
+	options->archetype_counts_count = 3;
+	options->seed = 0x2545f4914f6cdd1dull;
+	options->json_path = NULL;
+
+	for (i = 1; i < argc; i++) {
+		if ((0 == strcmp(argv[i], "--min-entities")) && (i + 1 < argc)) {
+			options->min_entities = strtoull(argv[++i], NULL, 10);
+		} else if ((0 == strcmp(argv[i], "--max-entities")) && (i + 1 < argc)) {
+			options->max_entities = strtoull(argv[++i], NULL, 10);
+		} else if ((0 == strcmp(argv[i], "--seed")) && (i + 1 < argc)) {
+			options->seed = strtoull(argv[++i], NULL, 10);
+		} else if ((0 == strcmp(argv[i], "--json")) && (i + 1 < argc)) {
+			options->json_path = argv[++i];
+		} else if ((0 == strcmp(argv[i], "--archetypes")) && (i + 1 < argc)) {
+			options->archetype_counts_count = 0;
+			for (token = strtok(argv[++i], ","); token && (options->archetype_counts_count < BENCH_MAX_ARCHETYPE_COUNTS); token = strtok(NULL, ",")) {
+				options->archetype_counts[options->archetype_counts_count] = (uint32_t)strtoul(token, NULL, 10);
+				options->archetype_counts_count++;
+			}
+		} else {
+			return false;
+		}
+	}
+
+	/* The archetypes are selected with the tag bits */
+	for (i = 0; i < (int)options->archetype_counts_count; i++) {
+		if ((0 == options->archetype_counts[i]) || (options->archetype_counts[i] > (1u << BENCH_TAG_COUNT))) {
+			return false;
+		}
+	}
+
+	/* A 0 seed would get the generator stuck */
+	return (options->min_entities > 0) && (options->min_entities <= options->max_entities) && (0 != options->seed);
+}
+
+int main(int argc, char** argv) {
+	bench_options_t options;
+	maybe_error_t result;
+	uint64_t entity_count;
+	uint32_t i;
+
+	maybe_time_init();
+
+	if (!bench_parse_options(argc, argv, &options)) {
+		fprintf(stderr, "Usage: %s [--min-entities N] [--max-entities N] [--archetypes A,B,...] [--seed S] [--json FILE]\n", argv[0]);
+		return 1;
+	}
+
+	printf("%-16s %10s %6s %14s %16s %12s\n", "phase", "entities", "arch", "ns/entity", "entities/s", "peak_rss_kb");
+
+	for (entity_count = options.min_entities; entity_count <= options.max_entities; entity_count *= 10) {
+		for (i = 0; i < options.archetype_counts_count; i++) {
+			result = bench_run_scenario(entity_count, options.archetype_counts[i], options.seed);
+			if (IS_FAILURE(result)) {
+				fprintf(stderr, "Scenario with %llu entities and %u archetypes failed with error %d\n", (unsigned long long)entity_count, options.archetype_counts[i], (int)result);
+				return 1;
+			}
+		}
+	}
+
+	if (options.json_path && !bench_write_json(options.json_path, &options)) {
+		fprintf(stderr, "Failed to write %s\n", options.json_path);
+		return 1;
+	}
+
+	return 0;
+}
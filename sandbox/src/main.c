@@ -1,4 +1,9 @@
 #include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
 
 #include <common/common.h>
 #include <common/error.h>
@@ -7,6 +12,9 @@
 #include <common/vector/vector.h>
 #include <ecs/ecs.h>
 #include <ecs/system.h>
+#include <ecs/spatial.h>
+#include <ecs/replication.h>
+#include <common/thread/thread_pool.h>
 
 typedef struct {
 	float x;
@@ -42,28 +50,291 @@ void test(maybe_system_t* system) {
 	}	
 }
 
+#define SANDBOX_REPLICATED_ENTITIES (10000) /* Enough for the first stream to be larger than a pipe's buffer */
+#define SANDBOX_REPLICATION_TICKS (40)
+#define SANDBOX_PIPE_CHUNK (4096) /* The most bytes written to the pipe before they are read back */
+
+/*
+ * Sends a stream through a pipe and reads it back, as a network connection would deliver it.
+ * The stream is sent in chunks the pipe can hold, since the pipe is not read while a write blocks,
+ * and both reads and writes may transfer only part of what they were asked to.
+ * */
+bool transfer_over_pipe(const int* pipe_files, const maybe_vector_t* stream, maybe_vector_t* received) {
+	const uint8_t* data = (const uint8_t*)stream->elements;
+	uint32_t sent, chunk, done;
+	ssize_t count;
+
+	received->length = 0;
+	if (IS_FAILURE(maybe_vector_reserve(received, stream->length))) {
+		return false;
+	}
+
+	for (sent = 0; sent < stream->length; sent += chunk) {
+		chunk = stream->length - sent;
+		if (chunk > SANDBOX_PIPE_CHUNK) {
+			chunk = SANDBOX_PIPE_CHUNK;
+		}
+
+		for (done = 0; done < chunk; done += (uint32_t)count) {
+			count = write(pipe_files[1], data + sent + done, chunk - done);
+			if (count < 0) {
+				if (EINTR == errno) {
+					count = 0;
+					continue;
+				}
+
+				return false;
+			}
+		}
+
+		for (done = 0; done < chunk; done += (uint32_t)count) {
+			count = read(pipe_files[0], (uint8_t*)received->elements + sent + done, chunk - done);
+			if (count <= 0) {
+				if ((count < 0) && (EINTR == errno)) {
+					count = 0;
+					continue;
+				}
+
+				return false;
+			}
+		}
+	}
+
+	received->length = stream->length;
+
+	return true;
+}
+
+/* Counts the differences between a client's world and the server's snapshot of the tick the client applied */
+uint32_t count_replica_mismatches(maybe_replication_server_t* server, maybe_replication_client_t* client, uint64_t tick) {
+	maybe_replication_snapshot_t* snapshot = &server->snapshots[tick % MAYBE_REPLICATION_HISTORY];
+	maybe_replication_layout_t* layout = &server->layout;
+	maybe_entity_t entity;
+	maybe_entity_t* client_entity;
+	const uint8_t* row;
+	void* value;
+	uint32_t mismatches = 0;
+	uint32_t i, j;
+	bool has_component;
+
+	if (snapshot->tick != tick) {
+		return 1;
+	}
+
+	/* The client has no entity the server did not have at that tick */
+	if (client->entities.count != snapshot->entities.length) {
+		mismatches++;
+	}
+
+	for (i = 0; i < snapshot->entities.length; i++) {
+		entity = MAYBE_VECTOR_ELEMENT(snapshot->entities, maybe_entity_t, i);
+		if (IS_FAILURE(maybe_map_get(&client->entities, &entity, sizeof(entity), (void**)&client_entity))) {
+			mismatches++;
+			continue;
+		}
+
+		row = (const uint8_t*)snapshot->values.elements + ((size_t)i * layout->row_size);
+		for (j = 0; j < layout->component_count; j++) {
+			has_component = !IS_FAILURE(maybe_world_get_component(client->world, *client_entity, layout->component_ids[j], &value));
+
+			if (MAYBE_VECTOR_ELEMENT(snapshot->masks, uint32_t, i) & (1u << j)) {
+				if (!has_component || (0 != memcmp(value, row + layout->component_offsets[j], layout->component_sizes[j]))) {
+					mismatches++;
+				}
+			} else if (has_component) {
+				mismatches++;
+			}
+		}
+	}
+
+	return mismatches;
+}
+
+/* Applies a stream to the client, and checks the client's world against the server's */
+void deliver_stream(
+	const int* pipe_files,
+	maybe_replication_server_t* server,
+	maybe_replication_client_t* client,
+	uint32_t peer_index,
+	const maybe_vector_t* stream,
+	maybe_vector_t* received
+) {
+	uint64_t acknowledged_tick;
+	uint32_t mismatches;
+
+	if (!transfer_over_pipe(pipe_files, stream, received)) {
+		MAYBE_ERROR_LOG("Could not send a stream of {0i} bytes through the pipe", stream->length);
+		return;
+	}
+
+	if (IS_FAILURE(maybe_replication_client_decode(client, received->elements, received->length, &acknowledged_tick))) {
+		MAYBE_ERROR_LOG("Could not decode a stream of {0i} bytes", received->length);
+		return;
+	}
+
+	maybe_replication_server_acknowledge(server, peer_index, acknowledged_tick);
+
+	mismatches = count_replica_mismatches(server, client, acknowledged_tick);
+	if (mismatches > 0) {
+		MAYBE_ERROR_LOG("The client's world differs from the server's at tick {0i} in {1i} places", (int)acknowledged_tick, mismatches);
+	}
+}
+
+/* Replicates a world to a client world through a pipe, as a network connection would, dropping and reordering some streams */
+void replicate_over_pipe(void) {
+	maybe_world_t server_world;
+	maybe_world_t client_world;
+	maybe_replication_server_t server;
+	maybe_replication_client_t client;
+	maybe_replication_peer_t* peer;
+	maybe_vector_t stream;
+	maybe_vector_t delayed_stream;
+	maybe_vector_t received;
+	maybe_vector_t entities;
+	maybe_vector_t temp;
+	maybe_entity_t entity;
+	position_t* position;
+	color_t* color;
+	uint32_t component_ids[2];
+	uint32_t peer_index, tick, i;
+	bool has_delayed_stream = false;
+	int pipe_files[2];
+
+	if (0 != pipe(pipe_files)) {
+		return;
+	}
+
+	maybe_world_init(&server_world);
+	maybe_world_init(&client_world);
+	MAYBE_REGISTER_COMPONENT_TYPE(&server_world, position_t);
+	MAYBE_REGISTER_COMPONENT_TYPE(&server_world, color_t);
+	MAYBE_REGISTER_COMPONENT_TYPE(&client_world, position_t);
+	MAYBE_REGISTER_COMPONENT_TYPE(&client_world, color_t);
+
+	component_ids[0] = MAYBE_COMPONENT_ID(position_t);
+	component_ids[1] = MAYBE_COMPONENT_ID(color_t);
+	maybe_replication_server_init(&server, &server_world, 2, component_ids);
+	maybe_replication_client_init(&client, &client_world, 2, component_ids);
+	maybe_replication_server_add_peer(&server, &peer_index);
+	maybe_vector_init(&stream, sizeof(uint8_t), 0);
+	maybe_vector_init(&delayed_stream, sizeof(uint8_t), 0);
+	maybe_vector_init(&received, sizeof(uint8_t), 0);
+	maybe_vector_init(&entities, sizeof(maybe_entity_t), SANDBOX_REPLICATED_ENTITIES);
+
+	for (i = 0; i < SANDBOX_REPLICATED_ENTITIES; i++) {
+		maybe_world_add_entity(&server_world, 2, &entity, MAYBE_COMPONENT_ID(position_t), MAYBE_COMPONENT_ID(color_t));
+		maybe_world_set_component(&server_world, entity, MAYBE_COMPONENT_ID(position_t), &(position_t){ (float)i, 0.0f });
+		maybe_world_set_component(&server_world, entity, MAYBE_COMPONENT_ID(color_t), &(color_t){ 0, 0, 0 });
+		maybe_vector_push(&entities, &entity);
+	}
+
+	for (tick = 0; tick < SANDBOX_REPLICATION_TICKS; tick++) {
+		/* Only a few entities move every tick, and a few are added, recolored and removed */
+		for (i = tick % 50; i < entities.length; i += 50) {
+			maybe_world_get_component(&server_world, MAYBE_VECTOR_ELEMENT(entities, maybe_entity_t, i), MAYBE_COMPONENT_ID(position_t), (void**)&position);
+			position->y += 0.5f;
+		}
+
+		for (i = 0; i < 5; i++) {
+			maybe_world_add_entity(&server_world, 1, &entity, MAYBE_COMPONENT_ID(position_t));
+			maybe_world_set_component(&server_world, entity, MAYBE_COMPONENT_ID(position_t), &(position_t){ (float)tick, (float)i });
+			maybe_vector_push(&entities, &entity);
+		}
+
+		entity = MAYBE_VECTOR_ELEMENT(entities, maybe_entity_t, (tick * 97) % entities.length);
+		if (!IS_FAILURE(maybe_world_get_component(&server_world, entity, MAYBE_COMPONENT_ID(color_t), (void**)&color))) {
+			color->r = (uint8_t)tick;
+		}
+
+		maybe_world_remove_entity(&server_world, MAYBE_VECTOR_ELEMENT(entities, maybe_entity_t, (tick * 31) % entities.length));
+		maybe_vector_swap_remove(&entities, (tick * 31) % entities.length);
+
+		maybe_replication_server_capture(&server, &server_world);
+		maybe_replication_server_encode(&server, peer_index, &stream);
+
+		peer = &MAYBE_VECTOR_ELEMENT(server.peers, maybe_replication_peer_t, peer_index);
+		MAYBE_DEBUG_LOG("Tick {0i}: sent {1i} bytes instead of {2i}", tick, peer->stats.encoded_bytes, peer->stats.full_bytes);
+
+		/* Some streams are lost, and some arrive after the stream of the next tick */
+		if (3 == (tick % 7)) {
+			continue;
+		}
+
+		if ((1 == (tick % 5)) && !has_delayed_stream) {
+			temp = delayed_stream;
+			delayed_stream = stream;
+			stream = temp;
+			has_delayed_stream = true;
+			continue;
+		}
+
+		deliver_stream(pipe_files, &server, &client, peer_index, &stream, &received);
+
+		if (has_delayed_stream) {
+			deliver_stream(pipe_files, &server, &client, peer_index, &delayed_stream, &received);
+			has_delayed_stream = false;
+		}
+	}
+
+	close(pipe_files[0]);
+	close(pipe_files[1]);
+	maybe_vector_free(&entities);
+	maybe_vector_free(&received);
+	maybe_vector_free(&delayed_stream);
+	maybe_vector_free(&stream);
+	maybe_replication_client_free(&client);
+	maybe_replication_server_free(&server);
+	maybe_world_free(&client_world);
+	maybe_world_free(&server_world);
+}
+
 int application_init(void) {
 	maybe_world_t world;
+	maybe_thread_pool_t thread_pool;
+	maybe_spatial_index_t spatial_index;
+	maybe_vector_t neighbours;
 	maybe_entity_t entity;
+	position_t* position;
+	float origin[2] = { 0.0f, 0.0f };
 	uint32_t i;
  
 	MAYBE_DEBUG_LOG("Initializing application");
 
 	maybe_world_init(&world);
+	maybe_thread_pool_init(&thread_pool, 0);
+	maybe_world_set_thread_pool(&world, &thread_pool);
 
 	MAYBE_REGISTER_COMPONENT_TYPE(&world, position_t);
 	MAYBE_REGISTER_COMPONENT_TYPE(&world, color_t);
 
 	maybe_world_register_system(&world, &test, 1, MAYBE_COMPONENT_ID(color_t));
 
-	maybe_world_add_entity(&world, 2, &entity, MAYBE_COMPONENT_ID(position_t), MAYBE_COMPONENT_ID(color_t));
-	maybe_world_add_entity(&world, 2, &entity, MAYBE_COMPONENT_ID(position_t), MAYBE_COMPONENT_ID(color_t));
+	maybe_spatial_index_init(&spatial_index, (maybe_spatial_index_config_t){
+		MAYBE_COMPONENT_ID(position_t), offsetof(position_t, x), 2, 1.0f, MAYBE_SYSTEM_RATE_VARIABLE
+	});
+	maybe_world_add_spatial_index(&world, &spatial_index);
+	maybe_vector_init(&neighbours, sizeof(maybe_spatial_result_t), 0);
+
+	for (i = 0; i < 2; i++) {
+		maybe_world_add_entity(&world, 2, &entity, MAYBE_COMPONENT_ID(position_t), MAYBE_COMPONENT_ID(color_t));
+		maybe_world_get_component(&world, entity, MAYBE_COMPONENT_ID(position_t), (void**)&position);
+		position->x = (float)i * 3.0f;
+		position->y = 0.0f;
+	}
 
 	for (i = 0; i < 10; i++) {
 		maybe_world_update(&world);
 	}
 
+	maybe_spatial_index_query_radius(&spatial_index, origin, 2.0f, &neighbours);
+	MAYBE_DEBUG_LOG("{0i} entities near the origin", neighbours.length);
+
+	maybe_vector_free(&neighbours);
 	maybe_world_free(&world);
+	maybe_spatial_index_free(&spatial_index);
+	maybe_thread_pool_free(&thread_pool);
+
+	replicate_over_pipe();
 
 	return 0;
 }
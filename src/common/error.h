@@ -15,16 +15,73 @@ typedef enum {
 
 	MAYBE_ERROR_MAP_NULL_PARAM,
 	MAYBE_ERROR_MAP_ALLOCATION_FAILED,
+	MAYBE_ERROR_MAP_INVALID_PARAM,
 
 	MAYBE_ERROR_VECTOR_NULL_PARAM,
 	MAYBE_ERROR_VECTOR_ALLOCATION_FAILED,
 	MAYBE_ERROR_VECTOR_INDEX_OUT_OF_RANGE,
+
+	MAYBE_ERROR_THREAD_POOL_NULL_PARAM,
+	MAYBE_ERROR_THREAD_POOL_ALLOCATION_FAILED,
+	MAYBE_ERROR_THREAD_POOL_THREAD_CREATION_FAILED,
+
+	MAYBE_ERROR_PAGE_STORE_NULL_PARAM,
+	MAYBE_ERROR_PAGE_STORE_INVALID_PARAM,
+	MAYBE_ERROR_PAGE_STORE_ALLOCATION_FAILED,
+	MAYBE_ERROR_PAGE_STORE_FILE_FAILED,
+	MAYBE_ERROR_PAGE_STORE_MAP_FAILED,
 	
 	MAYBE_ERROR_ARCHETYPE_NULL_PARAM,
 	MAYBE_ERROR_ARCHETYPE_ALLOCATION_FAILED,
+	MAYBE_ERROR_ARCHETYPE_ROW_OUT_OF_RANGE,
 
 	MAYBE_ERROR_ECS_WORLD_NULL_PARAM,
 	MAYBE_ERROR_ECS_WORLD_ALLOCATION_FAILED,
+	MAYBE_ERROR_ECS_WORLD_ENTITY_NOT_FOUND,
+	MAYBE_ERROR_ECS_WORLD_COMPONENT_NOT_FOUND,
+	MAYBE_ERROR_ECS_WORLD_COMPONENT_ALREADY_EXISTS,
+	MAYBE_ERROR_ECS_WORLD_INVALID_PARAM,
+	MAYBE_ERROR_ECS_WORLD_COMPONENT_MISMATCH,
+	MAYBE_ERROR_ECS_WORLD_HAS_FORKS,
+
+	MAYBE_ERROR_SHARED_STORE_NULL_PARAM,
+	MAYBE_ERROR_SHARED_STORE_ALLOCATION_FAILED,
+
+	MAYBE_ERROR_ROW_SORTER_NULL_PARAM,
+
+	MAYBE_ERROR_WORLD_EXPORT_NULL_PARAM,
+	MAYBE_ERROR_WORLD_EXPORT_ALLOCATION_FAILED,
+	MAYBE_ERROR_WORLD_EXPORT_OPEN_FAILED,
+	MAYBE_ERROR_WORLD_EXPORT_BAD_SEGMENT,
+
+	MAYBE_ERROR_FRAME_EXTRACTOR_NULL_PARAM,
+	MAYBE_ERROR_FRAME_EXTRACTOR_ALLOCATION_FAILED,
+	MAYBE_ERROR_FRAME_EXTRACTOR_INVALID_PARAM,
+	MAYBE_ERROR_FRAME_EXTRACTOR_THREAD_CREATION_FAILED,
+
+	MAYBE_ERROR_REPLICATION_NULL_PARAM,
+	MAYBE_ERROR_REPLICATION_ALLOCATION_FAILED,
+	MAYBE_ERROR_REPLICATION_INVALID_PARAM,
+	MAYBE_ERROR_REPLICATION_BAD_STREAM,
+	MAYBE_ERROR_REPLICATION_MISSING_BASELINE,
+
+	MAYBE_ERROR_COMPONENT_INDEX_NULL_PARAM,
+	MAYBE_ERROR_COMPONENT_INDEX_INVALID_PARAM,
+
+	MAYBE_ERROR_REDUCTION_NULL_PARAM,
+	MAYBE_ERROR_REDUCTION_INVALID_PARAM,
+
+	MAYBE_ERROR_READ_GUARD_NULL_PARAM,
+	MAYBE_ERROR_READ_GUARD_INVALID_PARAM,
+	MAYBE_ERROR_READ_GUARD_ALLOCATION_FAILED,
+	MAYBE_ERROR_READ_GUARD_NO_FREE_READERS,
+
+	MAYBE_ERROR_OBSERVER_NULL_PARAM,
+	MAYBE_ERROR_OBSERVER_ALLOCATION_FAILED,
+
+	MAYBE_ERROR_SPATIAL_INDEX_NULL_PARAM,
+	MAYBE_ERROR_SPATIAL_INDEX_ALLOCATION_FAILED,
+	MAYBE_ERROR_SPATIAL_INDEX_INVALID_PARAM,
 
 	MAYBE_ERROR_SYSTEM_NULL_PARAM,
 	MAYBE_ERROR_SYSTEM_ALLOCATION_FAILED,
@@ -79,14 +79,17 @@ maybe_error_t maybe_list_remove(
 		goto l_cleanup;
 	}
 
-	/* Remove node */
-	if (list->head == node) {
-		list->head = node->next;
-	} else if (list->tail == node) {
-		list->tail = node->prev;
-	} else {
+	/* Unlink the node from its neighbours */
+	if (node->prev) {
 		node->prev->next = node->next;
+	} else {
+		list->head = node->next;
+	}
+
+	if (node->next) {
 		node->next->prev = node->prev;
+	} else {
+		list->tail = node->prev;
 	}
 
 	free(node);
@@ -4,67 +4,60 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "common/common.h"
 #include "common/error.h"
-#include "common/list/list.h"
 
 #include "map.h"
+#include "map_internal.h"
 
 maybe_error_t maybe_map_init(
 	maybe_map_t* map,
+	uint32_t key_size,
 	uint32_t element_size,
 	uint32_t capacity,
 	maybe_hash_function_t hash_function
 ) {
 	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
-	uint32_t i;
+	uint32_t slot_count = MAYBE_MAP_GROUP_WIDTH;
 
 	if ((NULL == map) || (NULL == hash_function)) {
 		result = MAYBE_ERROR_MAP_NULL_PARAM;
 		goto l_cleanup;
 	}
 
+	memset(map, 0, sizeof(*map));
+
+	if ((0 == key_size) || (capacity > MAP_MAX_LOAD(1u << 31))) {
+		result = MAYBE_ERROR_MAP_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
 	/* Set a default capacity, if no capacity was given */
 	if (0 == capacity) {
 		capacity = MAYBE_MAP_DEFAULT_CAPACITY;
 	}
 
+	while (MAP_MAX_LOAD(slot_count) < capacity) {
+		slot_count *= 2;
+	}
+
 	map->hash_function = hash_function;
-	map->capacity = capacity;
+	map->key_size = key_size;
 	map->element_size = element_size;
+	map->value_offset = (key_size + 7) & ~7u;
+	map->slot_size = (map->value_offset + element_size + 7) & ~7u;
 
-	map->values = malloc(element_size * capacity);
-	if (NULL == map->values) {
-		result = MAYBE_ERROR_MAP_ALLOCATION_FAILED;
-		goto l_cleanup;
-	}
-
-	map->entries = malloc(sizeof(maybe_map_entry_t) * capacity);
-	if (NULL == map->entries) {
-		result = MAYBE_ERROR_MAP_ALLOCATION_FAILED;
+	result = resize(map, slot_count);
+	if (IS_FAILURE(result)) {
 		goto l_cleanup;
 	}
 
-	/* Initialize all entries */
-	for (i = 0; i < map->capacity; i++) {
-		map->entries[i].is_empty = true;
-		map->entries[i].contains_collisions = false;
-		map->entries[i].list_initialized = false;
-		map->entries[i].key = NULL;
-	}
-
 	result = MAYBE_ERROR_SUCCESS;
 l_cleanup:
-	if (IS_FAILURE(result)) {
-		if (map->values) {
-			free(map->values);
-		}
-
-		if (map->entries) {
-			free(map->entries);
-		}
-	}
-
 	return result;
 }
 
@@ -75,54 +68,74 @@ maybe_error_t maybe_map_set(
 	void* value
 ) {
 	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
-	maybe_map_entry_t* entry = NULL;
-	void* node = NULL;
-	uint32_t index = 0;
+	uint32_t capacity;
+	uint64_t hash;
+	uint32_t index;
 
-	if (NULL == map) {
+	if ((NULL == map) || (NULL == key)) {
 		result = MAYBE_ERROR_MAP_NULL_PARAM;
 		goto l_cleanup;
 	}
 
-	index = map->hash_function(key, key_size) % map->capacity;
-	entry = &(map->entries[index]);
+	if (key_size != map->key_size) {
+		result = MAYBE_ERROR_MAP_INVALID_PARAM;
+		goto l_cleanup;
+	}
 
-	if (entry->is_empty) {
-		/* If the entry is empty, copy the key and and the value */
-		entry->key = malloc(key_size);
-		if (!entry->key) {
-			result = MAYBE_ERROR_MAP_ALLOCATION_FAILED;
-			goto l_cleanup;
-		}
+	hash = hash_key(map, key);
+
+	/* Every set moves a running rehash along, whether it adds a pair or not */
+	if (NULL != map->old_table.control) {
+		migrate(map, MAYBE_MAP_MIGRATE_SLOTS);
+	}
+
+	index = find_slot(map, &map->table, key, hash);
+	if (UINT32_MAX != index) {
+		memcpy(MAP_SLOT_VALUE(map, &map->table, index), value, map->element_size);
 
-		memcpy(entry->key, key, key_size);
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
 
-		entry->is_empty = false;
+	index = find_slot(map, &map->old_table, key, hash);
+	if (UINT32_MAX != index) {
+		memcpy(MAP_SLOT_VALUE(map, &map->old_table, index), value, map->element_size);
 
-		memcpy((void*)((uint8_t*)map->values + (index * map->element_size)), value, map->element_size);
-	} else {
-		if (!entry->list_initialized) {
-			/* If this is the first collision, initilize the collision list */
-			result = maybe_list_init(&entry->list);
-			if (IS_FAILURE(result)) {
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	if ((map->count - map->old_count + map->deleted_count) >= MAP_MAX_LOAD(map->table.capacity)) {
+		/* A rehash ends long before its table fills up, this only finishes one in case it did not */
+		migrate(map, UINT32_MAX);
+
+		/* A map whose used slots are mostly deleted is rehashed at the same size, otherwise it doubles */
+		capacity = map->table.capacity;
+		if (map->count >= (MAP_MAX_LOAD(capacity) / 2)) {
+			if (capacity >= (1u << 31)) {
+				result = MAYBE_ERROR_MAP_ALLOCATION_FAILED;
 				goto l_cleanup;
 			}
 
-			entry->contains_collisions = true;
-			entry->list_initialized = true;
+			capacity *= 2;
 		}
 
-		/* Allocate another node in the collision list */
-		result = maybe_list_add(&entry->list, key_size + map->element_size, &node);
+		result = resize(map, capacity);
 		if (IS_FAILURE(result)) {
 			goto l_cleanup;
 		}
+	}
 
-		/*  Copy the key and value to the new node */
-		memcpy(node, key, key_size);
-		memcpy((void*)((uint8_t*)node + key_size), value, map->element_size);
+	index = find_free_slot(&map->table, hash);
+	if (MAP_CONTROL_DELETED == map->table.control[index]) {
+		map->deleted_count--;
 	}
 
+	map->table.control[index] = MAP_CONTROL_FULL(hash);
+	memcpy(MAP_SLOT_KEY(map, &map->table, index), key, map->key_size);
+	memcpy(MAP_SLOT_VALUE(map, &map->table, index), value, map->element_size);
+	map->count++;
+
 	result = MAYBE_ERROR_SUCCESS;
 l_cleanup:
 	return result;
@@ -135,40 +148,29 @@ maybe_error_t maybe_map_get(
 	void** value
 ) {
 	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
-	maybe_map_entry_t* entry = NULL;
-	maybe_list_node_t* current_node = NULL;
-	void* found_value = NULL;
-	uint32_t index = 0;
+	uint64_t hash;
+	uint32_t index;
 
-	if ((NULL == map) || (NULL == value)) {
+	if ((NULL == map) || (NULL == key) || (NULL == value)) {
 		result = MAYBE_ERROR_MAP_NULL_PARAM;
 		goto l_cleanup;
 	}
 
-	index = map->hash_function(key, key_size) % map->capacity;
-	entry = &(map->entries[index]);
-
-	/* @TODO Export search to a function */
-	if (!entry->is_empty) {
-		if (entry->contains_collisions && entry->list_initialized) {
-			for (current_node = entry->list.head; current_node != NULL;) {
-				if (0 == memcmp(key, (void*)&current_node->data, key_size)) {
-					found_value = (void*)((uint8_t*)&current_node->data + key_size);
-					break;
-				}
-				
-				current_node = current_node->next;
-			}	
-		} 
-
-		if (entry->key && (NULL == found_value)) {
-			if (0 == memcmp(key, entry->key, key_size)) {
-				found_value = (void*)((uint8_t*)map->values + (index * map->element_size));
-			}
-		}
+	if (key_size != map->key_size) {
+		result = MAYBE_ERROR_MAP_INVALID_PARAM;
+		goto l_cleanup;
 	}
 
-	*value = found_value;
+	hash = hash_key(map, key);
+
+	/* A key that is being migrated is in the old table until its slot is reached */
+	index = find_slot(map, &map->table, key, hash);
+	if (UINT32_MAX != index) {
+		*value = MAP_SLOT_VALUE(map, &map->table, index);
+	} else {
+		index = find_slot(map, &map->old_table, key, hash);
+		*value = (UINT32_MAX != index) ? MAP_SLOT_VALUE(map, &map->old_table, index) : NULL;
+	}
 
 	result = MAYBE_ERROR_SUCCESS;
 l_cleanup:
@@ -181,46 +183,77 @@ maybe_error_t maybe_map_remove(
 	uint32_t key_size
 ) {
 	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
-	maybe_map_entry_t* entry = NULL;
-	maybe_list_node_t* current_node = NULL;
-	void* found_value = NULL;
-	uint32_t index = 0;
+	uint64_t hash;
+	uint32_t index;
 
-	if (NULL == map) {
+	if ((NULL == map) || (NULL == key)) {
 		result = MAYBE_ERROR_MAP_NULL_PARAM;
 		goto l_cleanup;
 	}
 
-	index = map->hash_function(key, key_size) % map->capacity;
-	entry = &(map->entries[index]);
+	if (key_size != map->key_size) {
+		result = MAYBE_ERROR_MAP_INVALID_PARAM;
+		goto l_cleanup;
+	}
 
-	if (!entry->is_empty) {
-		if (entry->contains_collisions && entry->list_initialized) {
-			for (current_node = entry->list.head; current_node != NULL;) {
-				if (0 == memcmp(key, (void*)&current_node->data, key_size)) {
-					(void)maybe_list_remove(&entry->list, current_node);
+	hash = hash_key(map, key);
 
-					if (entry->list.count == 0) {
-						entry->contains_collisions = false;
-					}
+	index = find_slot(map, &map->table, key, hash);
+	if (UINT32_MAX != index) {
+		remove_slot(map, index);
+	} else {
+		/* The old table only shrinks, so its slots can stay deleted until it is freed */
+		index = find_slot(map, &map->old_table, key, hash);
+		if (UINT32_MAX == index) {
+			result = MAYBE_ERROR_SUCCESS;
+			goto l_cleanup;
+		}
 
-					break;
-				}
-				
-				current_node = current_node->next;
-			}	
-		} 
+		map->old_table.control[index] = MAP_CONTROL_DELETED;
+		map->old_count--;
+	}
+	map->count--;
 
-		if (entry->key && (NULL == found_value)) {
-			if (0 == memcmp(key, entry->key, key_size)) {
-				free(entry->key);
-				entry->key = NULL;
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
 
-				if (!entry->list_initialized || (entry->list.count == 0)) {
-					entry->is_empty = true;
-				}
-			}
+maybe_error_t maybe_map_reserve(
+	maybe_map_t* map,
+	uint32_t additional_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint64_t needed_count;
+	uint32_t capacity;
+
+	if (NULL == map) {
+		result = MAYBE_ERROR_MAP_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* The pairs still in the old table take slots of the table too once they are migrated */
+	needed_count = (uint64_t)map->count + additional_count;
+	if ((needed_count + map->deleted_count) <= MAP_MAX_LOAD(map->table.capacity)) {
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	migrate(map, UINT32_MAX);
+
+	capacity = map->table.capacity;
+	while (MAP_MAX_LOAD((uint64_t)capacity) < needed_count) {
+		if (capacity >= (1u << 31)) {
+			result = MAYBE_ERROR_MAP_ALLOCATION_FAILED;
+			goto l_cleanup;
 		}
+
+		capacity *= 2;
+	}
+
+	result = resize(map, capacity);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
 	}
 
 	result = MAYBE_ERROR_SUCCESS;
@@ -232,30 +265,53 @@ maybe_error_t maybe_map_free(
 	maybe_map_t* map
 ) {
 	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
-	uint32_t i;
 
 	if (NULL == map) {
 		result = MAYBE_ERROR_MAP_NULL_PARAM;
 		goto l_cleanup;
 	}
 
-	if (map->values) {
-		free(map->values);
+	if (map->table.control) {
+		free(map->table.control);
 	}
 
-	/* Free all used collision lists and entry keys */
-	if (map->entries) {
-		for (i = 0; i < map->capacity; i++) {
-			if (map->entries[i].list_initialized) {
-				maybe_list_free(&map->entries[i].list);
-			}
+	if (map->table.slots) {
+		free(map->table.slots);
+	}
 
-			if (map->entries[i].key) {
-				free(map->entries[i].key);	
-			}
-		}
+	if (map->old_table.control) {
+		free(map->old_table.control);
+	}
+
+	if (map->old_table.slots) {
+		free(map->old_table.slots);
+	}
+
+	memset(&map->table, 0, sizeof(map->table));
+	memset(&map->old_table, 0, sizeof(map->old_table));
+	map->count = 0;
+	map->deleted_count = 0;
+	map->old_count = 0;
+	map->migrate_cursor = 0;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_map_get_memory_usage(
+	maybe_map_t* map,
+	uint64_t* bytes
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if ((NULL == map) || (NULL == bytes)) {
+		result = MAYBE_ERROR_MAP_NULL_PARAM;
+		goto l_cleanup;
 	}
 
+	*bytes = ((uint64_t)map->table.capacity + map->old_table.capacity) * (sizeof(int8_t) + map->slot_size);
+
 	result = MAYBE_ERROR_SUCCESS;
 l_cleanup:
 	return result;
@@ -284,3 +340,202 @@ uint32_t maybe_map_default_hash_function(
 
 	return result;
 }
+
+uint64_t hash_key(
+	maybe_map_t* map,
+	void* key
+) {
+	/* Fibonacci hashing, every bit of the hash reaches the top bits */
+	return (uint64_t)map->hash_function((uint8_t*)key, map->key_size) * 0x9E3779B97F4A7C15ull;
+}
+
+uint32_t match_control(
+	const int8_t* control,
+	int8_t value
+) {
+#if defined(__SSE2__)
+	__m128i group = _mm_loadu_si128((const __m128i*)control);
+
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(value)));
+#else
+	uint32_t matches = 0;
+	uint32_t i;
+
+	for (i = 0; i < MAYBE_MAP_GROUP_WIDTH; i++) {
+		matches |= (uint32_t)(control[i] == value) << i;
+	}
+
+	return matches;
+#endif
+}
+
+uint32_t match_free(
+	const int8_t* control
+) {
+#if defined(__SSE2__)
+	/* Full slots are the only ones with the top bit of their control byte set */
+	return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)control)) ^ 0xFFFFu;
+#else
+	uint32_t matches = 0;
+	uint32_t i;
+
+	for (i = 0; i < MAYBE_MAP_GROUP_WIDTH; i++) {
+		matches |= (uint32_t)(control[i] >= 0) << i;
+	}
+
+	return matches;
+#endif
+}
+
+uint32_t find_slot(
+	maybe_map_t* map,
+	const maybe_map_table_t* table,
+	void* key,
+	uint64_t hash
+) {
+	const int8_t* control;
+	uint32_t group_mask, group, matches, index, step;
+
+	if (NULL == table->control) {
+		return UINT32_MAX;
+	}
+
+	group_mask = (table->capacity / MAYBE_MAP_GROUP_WIDTH) - 1;
+	group = (uint32_t)(hash >> 25) & group_mask;
+
+	/* Triangular steps visit every group, and a table always has an empty slot to stop at */
+	for (step = 1; ; step++) {
+		control = &table->control[group * MAYBE_MAP_GROUP_WIDTH];
+
+		for (matches = match_control(control, MAP_CONTROL_FULL(hash)); 0 != matches; matches &= matches - 1) {
+			index = (group * MAYBE_MAP_GROUP_WIDTH) + (uint32_t)__builtin_ctz(matches);
+			if (0 == memcmp(MAP_SLOT_KEY(map, table, index), key, map->key_size)) {
+				return index;
+			}
+		}
+
+		if (0 != match_control(control, MAP_CONTROL_EMPTY)) {
+			return UINT32_MAX;
+		}
+
+		group = (group + step) & group_mask;
+	}
+}
+
+uint32_t find_free_slot(
+	const maybe_map_table_t* table,
+	uint64_t hash
+) {
+	uint32_t group_mask = (table->capacity / MAYBE_MAP_GROUP_WIDTH) - 1;
+	uint32_t group = (uint32_t)(hash >> 25) & group_mask;
+	uint32_t matches, step;
+
+	for (step = 1; ; step++) {
+		matches = match_free(&table->control[group * MAYBE_MAP_GROUP_WIDTH]);
+		if (0 != matches) {
+			return (group * MAYBE_MAP_GROUP_WIDTH) + (uint32_t)__builtin_ctz(matches);
+		}
+
+		group = (group + step) & group_mask;
+	}
+}
+
+void remove_slot(
+	maybe_map_t* map,
+	uint32_t index
+) {
+	/*
+	 * Lookups stop at the first group with an empty slot, so if the slot's group has one no lookup
+	 * probes past it and the slot can be empty again. Otherwise it is marked deleted.
+	 * */
+	if (0 != match_control(&map->table.control[index & ~(MAYBE_MAP_GROUP_WIDTH - 1)], MAP_CONTROL_EMPTY)) {
+		map->table.control[index] = MAP_CONTROL_EMPTY;
+	} else {
+		map->table.control[index] = MAP_CONTROL_DELETED;
+		map->deleted_count++;
+	}
+}
+
+void migrate(
+	maybe_map_t* map,
+	uint32_t slot_count
+) {
+	maybe_map_table_t* old_table = &map->old_table;
+	void* slot;
+	uint32_t index;
+
+	for (; (0 != slot_count) && (map->migrate_cursor < old_table->capacity); slot_count--, map->migrate_cursor++) {
+		if (old_table->control[map->migrate_cursor] >= 0) {
+			continue;
+		}
+
+		/* The pairs are known to be distinct, so they only need a free slot */
+		slot = MAP_SLOT_KEY(map, old_table, map->migrate_cursor);
+		index = find_free_slot(&map->table, hash_key(map, slot));
+		if (MAP_CONTROL_DELETED == map->table.control[index]) {
+			map->deleted_count--;
+		}
+
+		map->table.control[index] = old_table->control[map->migrate_cursor];
+		memcpy(MAP_SLOT_KEY(map, &map->table, index), slot, map->slot_size);
+
+		/* The key is now found in the table, so a removal there must not leave it in the old one */
+		old_table->control[map->migrate_cursor] = MAP_CONTROL_DELETED;
+		map->old_count--;
+	}
+
+	if (map->migrate_cursor < old_table->capacity) {
+		return;
+	}
+
+	if (old_table->control) {
+		free(old_table->control);
+	}
+
+	if (old_table->slots) {
+		free(old_table->slots);
+	}
+
+	memset(old_table, 0, sizeof(*old_table));
+	map->migrate_cursor = 0;
+}
+
+maybe_error_t resize(
+	maybe_map_t* map,
+	uint32_t capacity
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_map_table_t table = { 0 };
+
+	table.control = (int8_t*)calloc(capacity, sizeof(int8_t));
+	table.slots = (uint8_t*)malloc((size_t)capacity * map->slot_size);
+	table.capacity = capacity;
+	if ((NULL == table.control) || (NULL == table.slots)) {
+		result = MAYBE_ERROR_MAP_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+
+	map->old_table = map->table;
+	map->table = table;
+	map->deleted_count = 0;
+	map->old_count = map->count;
+	map->migrate_cursor = 0;
+	memset(&table, 0, sizeof(table));
+
+	/* Small tables are migrated right away, large ones by the sets that follow */
+	if (map->old_table.capacity < MAYBE_MAP_INCREMENTAL_CAPACITY) {
+		migrate(map, UINT32_MAX);
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (table.control) {
+		free(table.control);
+	}
+
+	if (table.slots) {
+		free(table.slots);
+	}
+
+	return result;
+}
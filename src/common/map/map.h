@@ -4,39 +4,73 @@
 #include <stdbool.h>
 
 #include "common/error.h"
-#include "common/list/list.h"
 
+/*
+ * Maps
+ *
+ * A map is an open addressing hash table in the style of a Swiss table. Every slot holds a key and its
+ * value inline, and has a control byte that tells whether the slot is empty, deleted, or full, along with
+ * 7 bits of a full slot's hash. Lookups scan the control bytes of a group of MAYBE_MAP_GROUP_WIDTH slots
+ * at once, with SSE2 when it is available, and only compare the keys of slots whose 7 bits match. A
+ * lookup usually reads a single group of control bytes and a single slot, and nothing is allocated
+ * per key.
+ *
+ * The map grows once 7/8 of its slots are used. A small map moves its pairs to the new slots at once. A
+ * map with at least MAYBE_MAP_INCREMENTAL_CAPACITY slots keeps its old slots while it migrates, and every
+ * set moves the pairs of the next MAYBE_MAP_MIGRATE_SLOTS old slots, so no single set pays for the whole
+ * map. Until the migration ends new pairs go to the new slots and lookups check both. Lookups never
+ * migrate, so they do not change the map.
+ *
+ * Pointers returned by maybe_map_get stay valid until the next maybe_map_set.
+ * */
+
+/* @brief The number of pairs a map can hold before it first grows, when init is given 0 */
 #define MAYBE_MAP_DEFAULT_CAPACITY (10)
 
-/* @TODO move to internal */
-typedef struct {
-	bool is_empty; /* @TODO Think about optimizing this */
-	bool contains_collisions;
-	maybe_list_t list;
-	bool list_initialized;
-	void* key;
-} maybe_map_entry_t;
+/* @brief The number of slots whose control bytes are scanned together */
+#define MAYBE_MAP_GROUP_WIDTH (16)
+
+/* @brief The number of slots from which a map rehashes incrementally */
+#define MAYBE_MAP_INCREMENTAL_CAPACITY (1024)
+
+/* @brief The number of old slots every set migrates during an incremental rehash */
+#define MAYBE_MAP_MIGRATE_SLOTS (64)
 
 typedef uint32_t (*maybe_hash_function_t)(uint8_t* buffer, uint32_t size);
 
+/* @brief The slots of a map */
+typedef struct {
+	int8_t* control; /* The control byte of every slot: empty, deleted, or the top 7 bits of a full slot's hash */
+	uint8_t* slots; /* The key and the value of every slot, slot_size bytes each */
+	uint32_t capacity; /* The number of slots, a power of two and at least MAYBE_MAP_GROUP_WIDTH */
+} maybe_map_table_t;
+
 typedef struct {
 	maybe_hash_function_t hash_function;
-	maybe_map_entry_t* entries;
-	void* values; /* @TODO Change this to a vector? */
-	uint32_t capacity;
+	maybe_map_table_t table;
+	maybe_map_table_t old_table; /* The slots an incremental rehash migrates from, empty when no rehash is running */
+	uint32_t key_size;
 	uint32_t element_size;
+	uint32_t value_offset; /* The offset of the value in a slot, so values are 8 byte aligned */
+	uint32_t slot_size;
+	uint32_t count; /* The number of key-value pairs in the map */
+	uint32_t deleted_count; /* The number of deleted slots in the table, which lookups probe past like full ones */
+	uint32_t old_count; /* The number of pairs left in the old table */
+	uint32_t migrate_cursor; /* The next old slot to migrate */
 } maybe_map_t;
 
 /*
  * @brief Initialize a map
  *
  * @param map A pointer to the new map
+ * @param key_size The size of a key in the map
  * @param element_size The size of an element in the map
- * @param capacity The capacity of the map, if 0 the capacity will be set to a default value
+ * @param capacity The number of pairs the map can hold before it grows, if 0 a default value is used
  * @param hash_function The function used for hashing the keys
  * */
 maybe_error_t maybe_map_init(
 	maybe_map_t* map,
+	uint32_t key_size,
 	uint32_t element_size,
 	uint32_t capacity,
 	maybe_hash_function_t hash_function
@@ -44,11 +78,11 @@ maybe_error_t maybe_map_init(
 
 /*
  * @TODO Maybe return a pointer to the value
- * @brief Set a value for a key in a map
+ * @brief Set a value for a key in a map, replacing the key's current value if it has one
  *
  * @param map A pointer to the map
  * @param key The key data
- * @param key_size The size of the key's data
+ * @param key_size The size of the key's data, must be the map's key size
  * @param value The value to set
  * */
 maybe_error_t maybe_map_set(
@@ -63,7 +97,7 @@ maybe_error_t maybe_map_set(
  *
  * @param map A pointer to the map
  * @param key The key data
- * @param key_size The size of the key's data
+ * @param key_size The size of the key's data, must be the map's key size
  * @param value A pointer to the value, NULL if key was not found
  * */
 maybe_error_t maybe_map_get(
@@ -78,7 +112,7 @@ maybe_error_t maybe_map_get(
  *
  * @param map A pointer to the map
  * @param key The key data
- * @param key_size The size of the key's data
+ * @param key_size The size of the key's data, must be the map's key size
  * */
 maybe_error_t maybe_map_remove(
 	maybe_map_t* map,
@@ -86,7 +120,29 @@ maybe_error_t maybe_map_remove(
 	uint32_t key_size
 );
 
-/* @TODO Add resize function */
+/*
+ * @brief Make room for a number of keys the map does not have yet, so setting them can not fail
+ *
+ * @param map A pointer to the map
+ * @param additional_count The number of new keys
+ *
+ * @note Removing keys before setting the new ones may use up the room again
+ * */
+maybe_error_t maybe_map_reserve(
+	maybe_map_t* map,
+	uint32_t additional_count
+);
+
+/*
+ * @brief Get the amount of memory used by a map
+ *
+ * @param map A pointer to the map
+ * @param bytes The amount of bytes allocated by the map
+ * */
+maybe_error_t maybe_map_get_memory_usage(
+	maybe_map_t* map,
+	uint64_t* bytes
+);
 
 /*
  * @brief Free a map's resources
@@ -1 +1,131 @@
 #pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "map.h"
+
+/*
+ * @brief The control byte of a slot that never held a pair, stops lookups
+ *
+ * Empty is 0 so new tables can come from calloc, whose pages the OS zeroes as they are first touched
+ * instead of all at once when a large map grows.
+ * */
+#define MAP_CONTROL_EMPTY ((int8_t)0)
+
+/* @brief The control byte of a slot whose pair was removed, lookups probe past it */
+#define MAP_CONTROL_DELETED ((int8_t)1)
+
+/* @brief The control byte of a full slot, the top bit and the top 7 bits of its hash */
+#define MAP_CONTROL_FULL(hash) ((int8_t)(0x80 | ((hash) >> 57)))
+
+/* @brief The number of slots a map may use, full or deleted, before it grows */
+#define MAP_MAX_LOAD(capacity) ((capacity) - ((capacity) / 8))
+
+/* @brief A pointer to the key of a slot of a table */
+#define MAP_SLOT_KEY(map, table, index) ((void*)((table)->slots + ((size_t)(index) * (map)->slot_size)))
+
+/* @brief A pointer to the value of a slot of a table */
+#define MAP_SLOT_VALUE(map, table, index) ((void*)((table)->slots + ((size_t)(index) * (map)->slot_size) + (map)->value_offset))
+
+/*
+ * @brief Hash a key and spread the hash's bits, so weak hash functions still use all the groups
+ *
+ * @param map The map
+ * @param key The key
+ *
+ * @return The spread hash, its top 7 bits go in the key's control byte and the bits below them pick its first group
+ * */
+static uint64_t hash_key(
+	maybe_map_t* map,
+	void* key
+);
+
+/*
+ * @brief Get the slots of a group whose control byte is a value
+ *
+ * @param control The group's control bytes
+ * @param value The control byte
+ *
+ * @return A bit for every matching slot of the group
+ * */
+static uint32_t match_control(
+	const int8_t* control,
+	int8_t value
+);
+
+/*
+ * @brief Get the slots of a group that are empty or deleted
+ *
+ * @param control The group's control bytes
+ *
+ * @return A bit for every empty or deleted slot of the group
+ * */
+static uint32_t match_free(
+	const int8_t* control
+);
+
+/*
+ * @brief Find the slot of a key in a table
+ *
+ * @param map The map
+ * @param table The table, can have no slots
+ * @param key The key
+ * @param hash The key's spread hash
+ *
+ * @return The key's slot, UINT32_MAX if the table does not have the key
+ * */
+static uint32_t find_slot(
+	maybe_map_t* map,
+	const maybe_map_table_t* table,
+	void* key,
+	uint64_t hash
+);
+
+/*
+ * @brief Find the first empty or deleted slot in a hash's probe sequence
+ *
+ * @param table The table, it must have an empty slot
+ * @param hash The spread hash
+ *
+ * @return The slot
+ * */
+static uint32_t find_free_slot(
+	const maybe_map_table_t* table,
+	uint64_t hash
+);
+
+/*
+ * @brief Mark a slot of the table as no longer used
+ *
+ * @param map The map
+ * @param index The slot
+ * */
+static void remove_slot(
+	maybe_map_t* map,
+	uint32_t index
+);
+
+/*
+ * @brief Move the pairs of the next old slots to the table, and free the old table once it is migrated
+ *
+ * @param map The map
+ * @param slot_count The number of old slots to migrate
+ * */
+static void migrate(
+	maybe_map_t* map,
+	uint32_t slot_count
+);
+
+/*
+ * @brief Give a map a new table with room for more pairs, or without its deleted slots
+ *
+ * The old table is migrated right away if it is small, and over the next sets otherwise.
+ *
+ * @param map The map, it must not be migrating
+ * @param capacity The new number of slots, a power of two that fits every pair
+ * */
+static maybe_error_t resize(
+	maybe_map_t* map,
+	uint32_t capacity
+);
@@ -0,0 +1,519 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "common/error.h"
+#include "common/common.h"
+#include "common/vector/vector.h"
+
+#include "page_store.h"
+#include "page_store_internal.h"
+
+maybe_error_t maybe_page_store_init(
+	maybe_page_store_t* store,
+	const char* path,
+	uint64_t reserved_bytes
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	int file = -1;
+
+	if ((NULL == store) || (NULL == path)) {
+		result = MAYBE_ERROR_PAGE_STORE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* The file is only reachable through the mapping, so it is removed once the store is done with it */
+	file = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if (-1 == file) {
+		result = MAYBE_ERROR_PAGE_STORE_FILE_FAILED;
+		goto l_cleanup;
+	}
+	(void)unlink(path);
+
+	store->shared_name = NULL;
+	result = map_file(store, file, reserved_bytes);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	file = -1;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (-1 != file) {
+		(void)close(file);
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_page_store_init_shared(
+	maybe_page_store_t* store,
+	const char* name,
+	uint64_t reserved_bytes
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	int file = -1;
+
+	if ((NULL == store) || (NULL == name)) {
+		result = MAYBE_ERROR_PAGE_STORE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	store->shared_name = MALLOC_T(char, strlen(name) + 1);
+	if (NULL == store->shared_name) {
+		result = MAYBE_ERROR_PAGE_STORE_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+	strcpy(store->shared_name, name);
+
+	/* Other processes open the object by its name, so it is only removed when the store is freed */
+	file = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if (-1 == file) {
+		result = MAYBE_ERROR_PAGE_STORE_FILE_FAILED;
+		goto l_cleanup;
+	}
+
+	result = map_file(store, file, reserved_bytes);
+	if (IS_FAILURE(result)) {
+		(void)shm_unlink(name);
+		goto l_cleanup;
+	}
+	file = -1;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (-1 != file) {
+		(void)close(file);
+	}
+
+	if (IS_FAILURE(result) && (NULL != store) && (NULL != name)) {
+		free(store->shared_name);
+		store->shared_name = NULL;
+	}
+
+	return result;
+}
+
+const maybe_vector_allocator_t* maybe_page_store_get_allocator(
+	maybe_page_store_t* store
+) {
+	if (NULL == store) {
+		return NULL;
+	}
+
+	return &store->allocator;
+}
+
+bool maybe_page_store_contains(
+	const maybe_page_store_t* store,
+	const void* memory
+) {
+	if ((NULL == store) || (NULL == store->base) || (NULL == memory)) {
+		return false;
+	}
+
+	return ((const uint8_t*)memory >= store->base) && ((const uint8_t*)memory < store->base + store->end);
+}
+
+maybe_error_t maybe_page_store_prefetch(
+	maybe_page_store_t* store,
+	void* memory,
+	size_t size
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	size_t start;
+	size_t end;
+
+	if ((NULL == store) || (NULL == memory)) {
+		result = MAYBE_ERROR_PAGE_STORE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (!maybe_page_store_contains(store, memory) || (size > store->end - (size_t)((uint8_t*)memory - store->base))) {
+		result = MAYBE_ERROR_PAGE_STORE_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Every page the range touches is needed */
+	start = (size_t)((uint8_t*)memory - store->base) / store->page_size * store->page_size;
+	end = round_to_pages(store, (size_t)((uint8_t*)memory - store->base) + size);
+	if (0 != size) {
+		(void)madvise(store->base + start, end - start, MADV_WILLNEED);
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_page_store_evict(
+	maybe_page_store_t* store,
+	void* memory,
+	size_t size
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	size_t start;
+	size_t end;
+
+	if ((NULL == store) || (NULL == memory)) {
+		result = MAYBE_ERROR_PAGE_STORE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (!maybe_page_store_contains(store, memory) || (size > store->end - (size_t)((uint8_t*)memory - store->base))) {
+		result = MAYBE_ERROR_PAGE_STORE_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Pages that are partly outside the range may belong to another allocation that is still in use */
+	start = ((size_t)((uint8_t*)memory - store->base) + store->page_size - 1) / store->page_size * store->page_size;
+	end = ((size_t)((uint8_t*)memory - store->base) + size) / store->page_size * store->page_size;
+	if (end <= start) {
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	/* Written pages of a shared mapping are kept in the file, so dropping them from the process only frees memory */
+#ifdef MADV_PAGEOUT
+	if (0 != madvise(store->base + start, end - start, MADV_PAGEOUT))
+#endif
+	{
+		(void)madvise(store->base + start, end - start, MADV_DONTNEED);
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_page_store_free(
+	maybe_page_store_t* store
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_error_t free_result;
+
+	if (NULL == store) {
+		result = MAYBE_ERROR_PAGE_STORE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+
+	if (NULL != store->base) {
+		if (0 != munmap(store->base, store->reserved_bytes)) {
+			result = MAYBE_ERROR_PAGE_STORE_MAP_FAILED;
+		}
+		store->base = NULL;
+	}
+
+	if (-1 != store->file) {
+		if (0 != close(store->file)) {
+			result = MAYBE_ERROR_PAGE_STORE_FILE_FAILED;
+		}
+		store->file = -1;
+	}
+
+	if (NULL != store->shared_name) {
+		if (0 != shm_unlink(store->shared_name)) {
+			result = MAYBE_ERROR_PAGE_STORE_FILE_FAILED;
+		}
+		free(store->shared_name);
+		store->shared_name = NULL;
+	}
+
+	free_result = maybe_vector_free(&store->free_extents);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	/* If any free operation failed, return an error */
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t map_file(
+	maybe_page_store_t* store,
+	int file,
+	uint64_t reserved_bytes
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	long page_size;
+	void* base;
+
+	store->file = -1;
+	store->base = NULL;
+
+	page_size = sysconf(_SC_PAGESIZE);
+	if (page_size <= 0) {
+		result = MAYBE_ERROR_PAGE_STORE_MAP_FAILED;
+		goto l_cleanup;
+	}
+
+	if (0 == reserved_bytes) {
+		reserved_bytes = MAYBE_PAGE_STORE_DEFAULT_RESERVED_BYTES;
+	}
+
+	store->page_size = (size_t)page_size;
+	store->reserved_bytes = (size_t)((reserved_bytes + store->page_size - 1) / store->page_size * store->page_size);
+	store->end = 0;
+	store->allocated_bytes = 0;
+	store->allocator.reallocate = store_reallocate;
+	store->allocator.free = store_free;
+	store->allocator.context = store;
+
+	/* The file is sparse, so its size only reserves space */
+	if (0 != ftruncate(file, (off_t)store->reserved_bytes)) {
+		result = MAYBE_ERROR_PAGE_STORE_FILE_FAILED;
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&store->free_extents, sizeof(maybe_page_store_extent_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	base = mmap(NULL, store->reserved_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_NORESERVE, file, 0);
+	if (MAP_FAILED == base) {
+		(void)maybe_vector_free(&store->free_extents);
+		result = MAYBE_ERROR_PAGE_STORE_MAP_FAILED;
+		goto l_cleanup;
+	}
+
+	store->base = (uint8_t*)base;
+	store->file = file;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+void* store_reallocate(
+	void* context,
+	void* memory,
+	size_t old_size,
+	size_t new_size
+) {
+	maybe_page_store_t* store = (maybe_page_store_t*)context;
+	size_t old_pages;
+	size_t new_pages = round_to_pages(store, new_size);
+	size_t offset;
+	size_t new_offset;
+
+	if (NULL == memory) {
+		if (!allocate_pages(store, new_pages, &new_offset)) {
+			return NULL;
+		}
+
+		store->allocated_bytes += new_pages;
+		return store->base + new_offset;
+	}
+
+	old_pages = round_to_pages(store, old_size);
+	offset = (size_t)((uint8_t*)memory - store->base);
+
+	if (new_pages <= old_pages) {
+		if (new_pages < old_pages) {
+			free_pages(store, offset + new_pages, old_pages - new_pages);
+			store->allocated_bytes -= old_pages - new_pages;
+		}
+
+		return memory;
+	}
+
+	if (extend_pages(store, offset, old_pages, new_pages)) {
+		store->allocated_bytes += new_pages - old_pages;
+		return memory;
+	}
+
+	if (!allocate_pages(store, new_pages, &new_offset)) {
+		return NULL;
+	}
+
+	memcpy(store->base + new_offset, memory, old_size);
+	free_pages(store, offset, old_pages);
+	store->allocated_bytes += new_pages - old_pages;
+
+	return store->base + new_offset;
+}
+
+void store_free(
+	void* context,
+	void* memory,
+	size_t size
+) {
+	maybe_page_store_t* store = (maybe_page_store_t*)context;
+	size_t pages = round_to_pages(store, size);
+
+	if (NULL == memory) {
+		return;
+	}
+
+	free_pages(store, (size_t)((uint8_t*)memory - store->base), pages);
+	store->allocated_bytes -= pages;
+}
+
+size_t round_to_pages(
+	const maybe_page_store_t* store,
+	size_t size
+) {
+	if (0 == size) {
+		return store->page_size;
+	}
+
+	return (size + store->page_size - 1) / store->page_size * store->page_size;
+}
+
+bool allocate_pages(
+	maybe_page_store_t* store,
+	size_t size,
+	size_t* offset
+) {
+	maybe_page_store_extent_t* extent;
+	uint32_t i;
+
+	for (i = 0; i < store->free_extents.length; i++) {
+		extent = &MAYBE_VECTOR_ELEMENT(store->free_extents, maybe_page_store_extent_t, i);
+		if (extent->size < size) {
+			continue;
+		}
+
+		*offset = extent->offset;
+		if (extent->size == size) {
+			(void)maybe_vector_remove(&store->free_extents, i);
+		} else {
+			extent->offset += size;
+			extent->size -= size;
+		}
+
+		return true;
+	}
+
+	if (size > store->reserved_bytes - store->end) {
+		return false;
+	}
+
+	*offset = store->end;
+	store->end += size;
+
+	return true;
+}
+
+bool extend_pages(
+	maybe_page_store_t* store,
+	size_t offset,
+	size_t old_size,
+	size_t new_size
+) {
+	maybe_page_store_extent_t* extent;
+	size_t growth = new_size - old_size;
+	uint32_t i;
+
+	if (offset + old_size == store->end) {
+		if (growth > store->reserved_bytes - store->end) {
+			return false;
+		}
+
+		store->end += growth;
+		return true;
+	}
+
+	for (i = 0; i < store->free_extents.length; i++) {
+		extent = &MAYBE_VECTOR_ELEMENT(store->free_extents, maybe_page_store_extent_t, i);
+		if (extent->offset < offset + old_size) {
+			continue;
+		}
+
+		if ((extent->offset != offset + old_size) || (extent->size < growth)) {
+			return false;
+		}
+
+		if (extent->size == growth) {
+			(void)maybe_vector_remove(&store->free_extents, i);
+		} else {
+			extent->offset += growth;
+			extent->size -= growth;
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+void free_pages(
+	maybe_page_store_t* store,
+	size_t offset,
+	size_t size
+) {
+	maybe_page_store_extent_t* previous = NULL;
+	maybe_page_store_extent_t* next = NULL;
+	maybe_page_store_extent_t extent = { .offset = offset, .size = size };
+	uint32_t index;
+
+	/* The content is not needed anymore, so it does not have to be written to the file either */
+#ifdef MADV_REMOVE
+	if (0 != madvise(store->base + offset, size, MADV_REMOVE))
+#endif
+	{
+		(void)madvise(store->base + offset, size, MADV_DONTNEED);
+	}
+
+	for (index = 0; index < store->free_extents.length; index++) {
+		if (MAYBE_VECTOR_ELEMENT(store->free_extents, maybe_page_store_extent_t, index).offset > offset) {
+			break;
+		}
+	}
+
+	if (0 != index) {
+		previous = &MAYBE_VECTOR_ELEMENT(store->free_extents, maybe_page_store_extent_t, index - 1);
+	}
+	if (index < store->free_extents.length) {
+		next = &MAYBE_VECTOR_ELEMENT(store->free_extents, maybe_page_store_extent_t, index);
+	}
+
+	/* Merge with the free extents around the pages, so they never have to be merged when allocating */
+	if ((NULL != previous) && (previous->offset + previous->size == offset)) {
+		previous->size += size;
+		if ((NULL != next) && (previous->offset + previous->size == next->offset)) {
+			previous->size += next->size;
+			(void)maybe_vector_remove(&store->free_extents, index);
+		}
+		extent = *previous;
+		index--;
+	} else if ((NULL != next) && (offset + size == next->offset)) {
+		next->offset = offset;
+		next->size += size;
+		extent = *next;
+	} else if (offset + size != store->end) {
+		/* If the extent can not be saved the pages are lost until the store is freed, but nothing breaks */
+		if (IS_FAILURE(maybe_vector_push(&store->free_extents, NULL))) {
+			return;
+		}
+
+		memmove(
+			&MAYBE_VECTOR_ELEMENT(store->free_extents, maybe_page_store_extent_t, index + 1),
+			&MAYBE_VECTOR_ELEMENT(store->free_extents, maybe_page_store_extent_t, index),
+			(size_t)(store->free_extents.length - index - 1) * sizeof(maybe_page_store_extent_t)
+		);
+		MAYBE_VECTOR_ELEMENT(store->free_extents, maybe_page_store_extent_t, index) = extent;
+		return;
+	}
+
+	/* Free pages at the end are given back to the end instead of being kept as an extent */
+	if (extent.offset + extent.size == store->end) {
+		store->end = extent.offset;
+		if (index < store->free_extents.length) {
+			(void)maybe_vector_remove(&store->free_extents, index);
+		}
+	}
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "common/error.h"
+#include "common/vector/vector.h"
+
+/*
+ * Page stores
+ *
+ * A page store is a file mapped into memory that vectors can allocate their elements from, see
+ * maybe_page_store_get_allocator. The OS pages its memory to the file and back like any other file
+ * mapping, so data that is not touched does not have to stay in RAM.
+ *
+ * The file is a scratch file, it is removed as soon as it is opened and its space is returned when
+ * the store is freed. It is extended sparsely, so disk space is only used for pages that were written.
+ * A shared store uses a POSIX shared memory object instead, which other processes can map by its name.
+ *
+ * Every allocation is a whole number of pages, so it can be paged out and prefetched on its own:
+ *
+ * 		maybe_page_store_evict(&store, memory, size);		pages the memory out to the file
+ * 		maybe_page_store_prefetch(&store, memory, size);	starts reading it back before it is touched
+ * */
+
+/* @brief The size of the address range a store reserves when no size is given */
+#define MAYBE_PAGE_STORE_DEFAULT_RESERVED_BYTES (1ull << 36)
+
+/* @brief A range of free pages in a store's file */
+typedef struct {
+	size_t offset;
+	size_t size;
+} maybe_page_store_extent_t;
+
+/* @brief A file mapped into memory that vectors allocate their elements from */
+typedef struct {
+	int file;
+	uint8_t* base; /* The start of the mapping, which covers the whole file */
+	size_t reserved_bytes; /* The size of the file and the mapping, allocations can not go past it */
+	size_t page_size;
+	size_t end; /* The end of the last allocation, the pages after it are free */
+	MAYBE_VECTOR(maybe_page_store_extent_t) free_extents; /* Free pages before the end, sorted by offset and never adjacent */
+	size_t allocated_bytes; /* The size of all the allocations, in whole pages */
+	maybe_vector_allocator_t allocator;
+	char* shared_name; /* The name of the shared memory object, NULL if the store uses a file */
+} maybe_page_store_t;
+
+/*
+ * @brief Initialize a page store
+ *
+ * @param store A pointer to the new store
+ * @param path The path of the store's file, it is created and removed right away.
+ * 		  It should be on a disk, not in a directory that is kept in memory
+ * @param reserved_bytes The most memory the store can hand out. It only reserves addresses, not memory or disk space.
+ * 		  If 0 MAYBE_PAGE_STORE_DEFAULT_RESERVED_BYTES is used
+ * */
+maybe_error_t maybe_page_store_init(
+	maybe_page_store_t* store,
+	const char* path,
+	uint64_t reserved_bytes
+);
+
+/*
+ * @brief Initialize a page store in a POSIX shared memory object, which other processes can map
+ *
+ * @param store A pointer to the new store
+ * @param name The name of the shared memory object, like "/name". An existing object with the name is replaced
+ * @param reserved_bytes The size of the object, the most memory the store can hand out.
+ * 		  Only the pages that are written use memory. If 0 MAYBE_PAGE_STORE_DEFAULT_RESERVED_BYTES is used
+ *
+ * @note The object is removed when the store is freed, processes that mapped it keep their mapping
+ * */
+maybe_error_t maybe_page_store_init_shared(
+	maybe_page_store_t* store,
+	const char* name,
+	uint64_t reserved_bytes
+);
+
+/*
+ * @brief Get an allocator that allocates vector elements from a page store
+ *
+ * @param store A pointer to the store, it must stay valid while vectors use the allocator
+ * */
+const maybe_vector_allocator_t* maybe_page_store_get_allocator(
+	maybe_page_store_t* store
+);
+
+/*
+ * @brief Check if memory was allocated from a page store
+ *
+ * @param store A pointer to the store
+ * @param memory The memory
+ * */
+bool maybe_page_store_contains(
+	const maybe_page_store_t* store,
+	const void* memory
+);
+
+/*
+ * @brief Start reading memory of a page store back from its file, so touching it later does not wait for the disk
+ *
+ * @param store A pointer to the store
+ * @param memory The start of the range
+ * @param size The size of the range in bytes, it is widened to whole pages
+ *
+ * @note This is only advice to the OS, so it can not fail once the range is valid
+ * */
+maybe_error_t maybe_page_store_prefetch(
+	maybe_page_store_t* store,
+	void* memory,
+	size_t size
+);
+
+/*
+ * @brief Page memory of a page store out to its file, so it stops using RAM until it is touched again
+ *
+ * @param store A pointer to the store
+ * @param memory The start of the range
+ * @param size The size of the range in bytes, only the pages the range covers completely are paged out
+ *
+ * @note The content of the memory does not change
+ * */
+maybe_error_t maybe_page_store_evict(
+	maybe_page_store_t* store,
+	void* memory,
+	size_t size
+);
+
+/*
+ * @brief Free a page store's resources
+ *
+ * @param store A pointer to the store
+ *
+ * @note All the memory allocated from the store is freed, so no vector may use it anymore
+ * */
+maybe_error_t maybe_page_store_free(
+	maybe_page_store_t* store
+);
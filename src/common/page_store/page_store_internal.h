@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "page_store.h"
+
+/*
+ * @brief Size and map a store's file, and initialize the rest of the store
+ *
+ * @param store The store
+ * @param file The open file, owned by the store on success
+ * @param reserved_bytes The size of the mapping, if 0 the default is used
+ * */
+static maybe_error_t map_file(
+	maybe_page_store_t* store,
+	int file,
+	uint64_t reserved_bytes
+);
+
+/*
+ * @brief The reallocate function of a store's allocator, see maybe_vector_allocator_t
+ *
+ * @param context The store
+ * @param memory The current memory, or NULL to allocate new memory
+ * @param old_size The size of the current memory in bytes
+ * @param new_size The new size in bytes
+ *
+ * @note Returns NULL if the store has no room left
+ * */
+static void* store_reallocate(
+	void* context,
+	void* memory,
+	size_t old_size,
+	size_t new_size
+);
+
+/*
+ * @brief The free function of a store's allocator, see maybe_vector_allocator_t
+ *
+ * @param context The store
+ * @param memory The memory
+ * @param size The size of the memory in bytes
+ * */
+static void store_free(
+	void* context,
+	void* memory,
+	size_t size
+);
+
+/*
+ * @brief Round a size up to whole pages, an empty allocation still gets a page so it has an address of its own
+ *
+ * @param store The store
+ * @param size The size in bytes
+ * */
+static size_t round_to_pages(
+	const maybe_page_store_t* store,
+	size_t size
+);
+
+/*
+ * @brief Find room for an allocation, in the first free extent that is big enough or after the end
+ *
+ * @param store The store
+ * @param size The size of the allocation, in whole pages
+ * @param offset Set to the offset of the allocation in the file
+ * */
+static bool allocate_pages(
+	maybe_page_store_t* store,
+	size_t size,
+	size_t* offset
+);
+
+/*
+ * @brief Grow an allocation into the free pages right after it
+ *
+ * @param store The store
+ * @param offset The offset of the allocation
+ * @param old_size The size of the allocation, in whole pages
+ * @param new_size The new size, in whole pages
+ *
+ * @note Returns false without changing anything if the pages after the allocation are not free
+ * */
+static bool extend_pages(
+	maybe_page_store_t* store,
+	size_t offset,
+	size_t old_size,
+	size_t new_size
+);
+
+/*
+ * @brief Return pages to the store, and their memory and disk space to the OS
+ *
+ * @param store The store
+ * @param offset The offset of the pages
+ * @param size The size of the pages, in whole pages
+ * */
+static void free_pages(
+	maybe_page_store_t* store,
+	size_t offset,
+	size_t size
+);
@@ -0,0 +1,214 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "common/error.h"
+#include "common/common.h"
+
+#include "thread_pool.h"
+#include "thread_pool_internal.h"
+
+maybe_error_t maybe_thread_pool_init(
+	maybe_thread_pool_t* pool,
+	uint32_t thread_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	long processor_count;
+	uint32_t i;
+
+	if (NULL == pool) {
+		result = MAYBE_ERROR_THREAD_POOL_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (0 == thread_count) {
+		processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+		thread_count = (processor_count > 0) ? (uint32_t)processor_count : 1;
+	}
+
+	pool->thread_count = 0;
+	pool->job = NULL;
+	pool->context = NULL;
+	pool->job_count = 0;
+	atomic_init(&pool->next_job, 0);
+	pool->busy_workers = 0;
+	pool->batch = 0;
+	pool->stopping = false;
+
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_cond_init(&pool->work_condition, NULL);
+	pthread_cond_init(&pool->done_condition, NULL);
+
+	/* The thread that runs a batch is one of its threads */
+	pool->threads = MALLOC_T(pthread_t, thread_count);
+	if (NULL == pool->threads) {
+		result = MAYBE_ERROR_THREAD_POOL_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < thread_count - 1; i++) {
+		if (0 != pthread_create(&pool->threads[i], NULL, worker_main, pool)) {
+			result = MAYBE_ERROR_THREAD_POOL_THREAD_CREATION_FAILED;
+			goto l_cleanup;
+		}
+
+		pool->thread_count++;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (IS_FAILURE(result) && (NULL != pool) && (MAYBE_ERROR_THREAD_POOL_NULL_PARAM != result)) {
+		(void)maybe_thread_pool_free(pool);
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_thread_pool_run(
+	maybe_thread_pool_t* pool,
+	maybe_thread_pool_job_t job,
+	void* context,
+	uint32_t job_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t i;
+
+	if (NULL == job) {
+		result = MAYBE_ERROR_THREAD_POOL_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Small batches are not worth waking the workers for */
+	if ((NULL == pool) || (0 == pool->thread_count) || (job_count <= 1)) {
+		for (i = 0; i < job_count; i++) {
+			job(context, i);
+		}
+
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->job = job;
+	pool->context = context;
+	pool->job_count = job_count;
+	atomic_store_explicit(&pool->next_job, 0, memory_order_relaxed);
+	pool->busy_workers = pool->thread_count;
+	pool->batch++;
+	pthread_cond_broadcast(&pool->work_condition);
+	pthread_mutex_unlock(&pool->mutex);
+
+	run_jobs(pool, job, context, job_count);
+
+	/* Wait for the workers that are still running jobs */
+	pthread_mutex_lock(&pool->mutex);
+	while (pool->busy_workers > 0) {
+		pthread_cond_wait(&pool->done_condition, &pool->mutex);
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+uint32_t maybe_thread_pool_get_concurrency(
+	maybe_thread_pool_t* pool
+) {
+	if (NULL == pool) {
+		return 1;
+	}
+
+	return pool->thread_count + 1;
+}
+
+maybe_error_t maybe_thread_pool_free(
+	maybe_thread_pool_t* pool
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t i;
+
+	if (NULL == pool) {
+		result = MAYBE_ERROR_THREAD_POOL_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->stopping = true;
+	pthread_cond_broadcast(&pool->work_condition);
+	pthread_mutex_unlock(&pool->mutex);
+
+	for (i = 0; i < pool->thread_count; i++) {
+		pthread_join(pool->threads[i], NULL);
+	}
+
+	free(pool->threads);
+	pool->threads = NULL;
+	pool->thread_count = 0;
+
+	pthread_cond_destroy(&pool->done_condition);
+	pthread_cond_destroy(&pool->work_condition);
+	pthread_mutex_destroy(&pool->mutex);
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+void* worker_main(
+	void* pool_pointer
+) {
+	maybe_thread_pool_t* pool = (maybe_thread_pool_t*)pool_pointer;
+	maybe_thread_pool_job_t job;
+	void* context;
+	uint32_t job_count;
+	uint64_t seen_batch = 0;
+
+	pthread_mutex_lock(&pool->mutex);
+	for (;;) {
+		while ((pool->batch == seen_batch) && !pool->stopping) {
+			pthread_cond_wait(&pool->work_condition, &pool->mutex);
+		}
+
+		if (pool->stopping) {
+			break;
+		}
+
+		seen_batch = pool->batch;
+		job = pool->job;
+		context = pool->context;
+		job_count = pool->job_count;
+		pthread_mutex_unlock(&pool->mutex);
+
+		run_jobs(pool, job, context, job_count);
+
+		pthread_mutex_lock(&pool->mutex);
+		pool->busy_workers--;
+		if (0 == pool->busy_workers) {
+			pthread_cond_signal(&pool->done_condition);
+		}
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	return NULL;
+}
+
+void run_jobs(
+	maybe_thread_pool_t* pool,
+	maybe_thread_pool_job_t job,
+	void* context,
+	uint32_t job_count
+) {
+	uint32_t job_index;
+
+	for (;;) {
+		job_index = atomic_fetch_add_explicit(&pool->next_job, 1, memory_order_relaxed);
+		if (job_index >= job_count) {
+			break;
+		}
+
+		job(context, job_index);
+	}
+}
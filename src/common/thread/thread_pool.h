@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "common/error.h"
+
+/* @brief A prototype for a thread pool job, called once for every job index */
+typedef void (*maybe_thread_pool_job_t)(void* context, uint32_t job_index);
+
+/* @brief A fixed set of worker threads that run batches of jobs */
+typedef struct {
+	pthread_t* threads;
+	uint32_t thread_count; /* The number of worker threads, the thread that runs a batch works on it too */
+	pthread_mutex_t mutex;
+	pthread_cond_t work_condition; /* Signaled when a batch starts or the pool stops */
+	pthread_cond_t done_condition; /* Signaled when the last worker leaves a batch */
+	maybe_thread_pool_job_t job;
+	void* context;
+	uint32_t job_count;
+	atomic_uint next_job; /* The next job index that was not claimed yet */
+	uint32_t busy_workers; /* The number of workers that did not leave the current batch yet */
+	uint64_t batch; /* Incremented for every batch, so workers know there is new work */
+	bool stopping;
+} maybe_thread_pool_t;
+
+/*
+ * @brief Initialize a thread pool and start its worker threads
+ *
+ * @param pool A pointer to the new thread pool
+ * @param thread_count The number of threads that run a batch, including the thread that runs it.
+ * 		  If 0 the number of online processors is used
+ * */
+maybe_error_t maybe_thread_pool_init(
+	maybe_thread_pool_t* pool,
+	uint32_t thread_count
+);
+
+/*
+ * @brief Run a batch of jobs on a thread pool and wait for all of them to finish
+ *
+ * @param pool A pointer to the thread pool, if NULL the jobs run on the calling thread
+ * @param job The job function
+ * @param context A pointer passed to every job
+ * @param job_count The number of jobs, each job gets a different index in [0, job_count)
+ *
+ * @note The calling thread works on the batch too, and jobs are claimed one at a time, so
+ * 		 jobs of uneven length are balanced between the threads
+ * @note Only one batch may run on a pool at a time
+ * */
+maybe_error_t maybe_thread_pool_run(
+	maybe_thread_pool_t* pool,
+	maybe_thread_pool_job_t job,
+	void* context,
+	uint32_t job_count
+);
+
+/*
+ * @brief Get the number of threads that run a batch, including the thread that runs it
+ *
+ * @param pool A pointer to the thread pool, can be NULL
+ * */
+uint32_t maybe_thread_pool_get_concurrency(
+	maybe_thread_pool_t* pool
+);
+
+/*
+ * @brief Stop a thread pool's workers and free its resources
+ *
+ * @param pool A pointer to the thread pool
+ * */
+maybe_error_t maybe_thread_pool_free(
+	maybe_thread_pool_t* pool
+);
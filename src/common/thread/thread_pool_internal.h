@@ -0,0 +1,27 @@
+#pragma once
+
+#include "thread_pool.h"
+
+/*
+ * @brief The function every worker thread runs, waiting for batches and working on them until the pool stops
+ *
+ * @param pool The thread pool
+ * */
+static void* worker_main(
+	void* pool
+);
+
+/*
+ * @brief Claim and run jobs from the current batch until none are left
+ *
+ * @param pool The thread pool
+ * @param job The batch's job function
+ * @param context The batch's context
+ * @param job_count The batch's number of jobs
+ * */
+static void run_jobs(
+	maybe_thread_pool_t* pool,
+	maybe_thread_pool_job_t job,
+	void* context,
+	uint32_t job_count
+);
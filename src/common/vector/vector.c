@@ -9,11 +9,21 @@
 #include "logger/logger.h"
 
 #include "vector.h"
+#include "vector_internal.h"
 
 maybe_error_t maybe_vector_init(
 	maybe_vector_t* vector,
 	uint32_t element_size,
 	uint32_t initial_capacity
+) {
+	return maybe_vector_init_with_allocator(vector, element_size, initial_capacity, NULL);
+}
+
+maybe_error_t maybe_vector_init_with_allocator(
+	maybe_vector_t* vector,
+	uint32_t element_size,
+	uint32_t initial_capacity,
+	const maybe_vector_allocator_t* allocator
 ) {
 	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
 
@@ -31,7 +41,8 @@ maybe_error_t maybe_vector_init(
 	vector->element_size = element_size;
 	vector->length = 0;
 	vector->capacity = initial_capacity;
-	vector->elements = malloc(initial_capacity * element_size);
+	vector->allocator = allocator;
+	vector->elements = reallocate_elements(allocator, NULL, 0, (size_t)initial_capacity * element_size);
 	if (NULL == vector->elements) {
 		result = MAYBE_ERROR_VECTOR_ALLOCATION_FAILED;
 		goto l_cleanup;
@@ -47,6 +58,7 @@ maybe_error_t maybe_vector_push(
 	void* element	
 ) {
 	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	void* elements = NULL;
 
 	if (NULL == vector) {
 		result = MAYBE_ERROR_VECTOR_NULL_PARAM;
@@ -55,12 +67,19 @@ maybe_error_t maybe_vector_push(
 
 	/* Allocate more memory if needed */
 	if (vector->length == vector->capacity) {
-		vector->capacity *= 2;
-		vector->elements = realloc(vector->elements, vector->capacity * vector->element_size);
-		if (NULL == vector->elements) {
+		elements = reallocate_elements(
+			vector->allocator,
+			vector->elements,
+			(size_t)vector->capacity * vector->element_size,
+			(size_t)vector->capacity * 2 * vector->element_size
+		);
+		if (NULL == elements) {
 			result = MAYBE_ERROR_VECTOR_ALLOCATION_FAILED;
 			goto l_cleanup;
 		}
+
+		vector->elements = elements;
+		vector->capacity *= 2;
 	}
 
 	/* Initialize element */
@@ -97,7 +116,7 @@ maybe_error_t maybe_vector_remove(
 	}
 	
 	/* Move all elements after the selected element back one spot */
-	memcpy(
+	memmove(
 		(void*)((uint8_t*)(vector->elements + (index * vector->element_size))),
 		(void*)((uint8_t*)(vector->elements + ((index + 1) * vector->element_size))),
 		(vector->length - index - 1) * vector->element_size
@@ -110,6 +129,185 @@ l_cleanup:
 	return result;
 }
 
+maybe_error_t maybe_vector_swap_remove(
+	maybe_vector_t* vector,
+	uint32_t index
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if (NULL == vector) {
+		result = MAYBE_ERROR_VECTOR_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Validate index */
+	if (index >= vector->length) {
+		result = MAYBE_ERROR_VECTOR_INDEX_OUT_OF_RANGE;
+		goto l_cleanup;
+	}
+
+	/* Move the last element into the removed element's spot */
+	if (index != (vector->length - 1)) {
+		memcpy(
+			MAYBE_VECTOR_PTR_ELEMENT_VOID_PTR(vector, index),
+			MAYBE_VECTOR_PTR_ELEMENT_VOID_PTR(vector, (vector->length - 1)),
+			vector->element_size
+		);
+	}
+
+	vector->length--;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_vector_reserve(
+	maybe_vector_t* vector,
+	uint32_t capacity
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	void* elements = NULL;
+
+	if (NULL == vector) {
+		result = MAYBE_ERROR_VECTOR_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (capacity <= vector->capacity) {
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	elements = reallocate_elements(
+		vector->allocator,
+		vector->elements,
+		(size_t)vector->capacity * vector->element_size,
+		(size_t)capacity * vector->element_size
+	);
+	if (NULL == elements) {
+		result = MAYBE_ERROR_VECTOR_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+
+	vector->elements = elements;
+	vector->capacity = capacity;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_vector_shrink(
+	maybe_vector_t* vector,
+	uint32_t capacity
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	void* elements = NULL;
+
+	if (NULL == vector) {
+		result = MAYBE_ERROR_VECTOR_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* The capacity is doubled on growth, so it can never be 0 */
+	if (capacity < vector->length) {
+		capacity = vector->length;
+	}
+	if (0 == capacity) {
+		capacity = 1;
+	}
+
+	if (capacity >= vector->capacity) {
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	elements = reallocate_elements(
+		vector->allocator,
+		vector->elements,
+		(size_t)vector->capacity * vector->element_size,
+		(size_t)capacity * vector->element_size
+	);
+	if (NULL == elements) {
+		result = MAYBE_ERROR_VECTOR_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+
+	vector->elements = elements;
+	vector->capacity = capacity;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_vector_set_allocator(
+	maybe_vector_t* vector,
+	const maybe_vector_allocator_t* allocator
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	size_t capacity_bytes;
+	void* elements = NULL;
+
+	if (NULL == vector) {
+		result = MAYBE_ERROR_VECTOR_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (allocator == vector->allocator) {
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	capacity_bytes = (size_t)vector->capacity * vector->element_size;
+	elements = reallocate_elements(allocator, NULL, 0, capacity_bytes);
+	if (NULL == elements) {
+		result = MAYBE_ERROR_VECTOR_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+
+	if (0 != vector->length) {
+		memcpy(elements, vector->elements, (size_t)vector->length * vector->element_size);
+	}
+
+	free_elements(vector->allocator, vector->elements, capacity_bytes);
+	vector->elements = elements;
+	vector->allocator = allocator;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_vector_copy_elements(
+	maybe_vector_t* vector
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	void* elements = NULL;
+
+	if (NULL == vector) {
+		result = MAYBE_ERROR_VECTOR_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	elements = reallocate_elements(vector->allocator, NULL, 0, (size_t)vector->capacity * vector->element_size);
+	if (NULL == elements) {
+		result = MAYBE_ERROR_VECTOR_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+
+	if (0 != vector->length) {
+		memcpy(elements, vector->elements, (size_t)vector->length * vector->element_size);
+	}
+
+	vector->elements = elements;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
 maybe_error_t maybe_vector_free(
 	maybe_vector_t* vector
 ) {
@@ -121,10 +319,36 @@ maybe_error_t maybe_vector_free(
 	}
 
 	if (vector->elements) {
-		free(vector->elements);
+		free_elements(vector->allocator, vector->elements, (size_t)vector->capacity * vector->element_size);
 	}
 
 	result = MAYBE_ERROR_SUCCESS;
 l_cleanup:
 	return result;
 }
+
+void* reallocate_elements(
+	const maybe_vector_allocator_t* allocator,
+	void* elements,
+	size_t old_size,
+	size_t new_size
+) {
+	if (NULL != allocator) {
+		return allocator->reallocate(allocator->context, elements, old_size, new_size);
+	}
+
+	return realloc(elements, new_size);
+}
+
+void free_elements(
+	const maybe_vector_allocator_t* allocator,
+	void* elements,
+	size_t size
+) {
+	if (NULL != allocator) {
+		allocator->free(allocator->context, elements, size);
+		return;
+	}
+
+	free(elements);
+}
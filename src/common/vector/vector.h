@@ -2,16 +2,30 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "common/error.h"
 
 #define MAYBE_VECTOR_DEAULT_INITIAL_CAPCITY (10)
 
+/*
+ * @brief Allocates a vector's elements in place of the heap
+ *
+ * The functions work like realloc and free, but are also given the current size of the memory.
+ * Reallocating NULL memory allocates it.
+ * */
+typedef struct {
+	void* (*reallocate)(void* context, void* memory, size_t old_size, size_t new_size);
+	void (*free)(void* context, void* memory, size_t size);
+	void* context;
+} maybe_vector_allocator_t;
+
 typedef struct {
 	void* elements;
 	uint32_t element_size;
 	uint32_t length;
 	uint32_t capacity;
+	const maybe_vector_allocator_t* allocator; /* NULL if the elements are on the heap */
 } maybe_vector_t;
 
 /*
@@ -28,6 +42,21 @@ maybe_error_t maybe_vector_init(
 	uint32_t initial_capacity
 );
 
+/*
+ * @brief Initialize a vector whose elements are allocated by an allocator
+ *
+ * @param vector A pointer to the new vector
+ * @param element_size The size of an element in the vector
+ * @param initial_capacity The initial capcity of the vector, if 0 the default is used
+ * @param allocator A pointer to the allocator, it must stay valid while the vector uses it. If NULL the heap is used
+ * */
+maybe_error_t maybe_vector_init_with_allocator(
+	maybe_vector_t* vector,
+	uint32_t element_size,
+	uint32_t initial_capacity,
+	const maybe_vector_allocator_t* allocator
+);
+
 /* @brief Push an element to the end of a vector
  *
  * @param vector A pointer to the vector
@@ -49,6 +78,67 @@ maybe_error_t maybe_vector_remove(
 	uint32_t index
 );
 
+/*
+ * @brief Remove an element at a specified index from a vector by moving the last element into its place
+ *
+ * @param vector A pointer to the vector
+ * @param index The element's index
+ *
+ * @note This does not preserve the order of the elements, but runs in constant time
+ * */
+maybe_error_t maybe_vector_swap_remove(
+	maybe_vector_t* vector,
+	uint32_t index
+);
+
+/*
+ * @brief Make sure a vector has room for a number of elements without reallocating
+ *
+ * @param vector A pointer to the vector
+ * @param capacity The minimal capacity of the vector
+ * */
+maybe_error_t maybe_vector_reserve(
+	maybe_vector_t* vector,
+	uint32_t capacity
+);
+
+/*
+ * @brief Reduce the allocated capacity of a vector
+ *
+ * @param vector A pointer to the vector
+ * @param capacity The new capacity, it is raised to the vector's length if it is smaller, and to 1 if it is 0
+ *
+ * @note Nothing is done if the capacity is not smaller than the current capacity
+ * */
+maybe_error_t maybe_vector_shrink(
+	maybe_vector_t* vector,
+	uint32_t capacity
+);
+
+/*
+ * @brief Move a vector's elements to memory from another allocator
+ *
+ * @param vector A pointer to the vector
+ * @param allocator A pointer to the new allocator, if NULL the heap is used
+ *
+ * @note The vector keeps its capacity, and is not changed if the allocation fails
+ * */
+maybe_error_t maybe_vector_set_allocator(
+	maybe_vector_t* vector,
+	const maybe_vector_allocator_t* allocator
+);
+
+/*
+ * @brief Replace a vector's elements with a copy from its own allocator
+ *
+ * @param vector A pointer to the vector
+ *
+ * @note Used when the elements are shared with another vector, the shared elements are not freed
+ * */
+maybe_error_t maybe_vector_copy_elements(
+	maybe_vector_t* vector
+);
+
 /*
  * @breif Free a vector's resources
  *
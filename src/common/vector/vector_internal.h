@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "vector.h"
+
+/*
+ * @brief Resize the memory of a vector's elements with an allocator, or the heap if there is none
+ *
+ * @param allocator The allocator, can be NULL
+ * @param elements The current elements, can be NULL
+ * @param old_size The size of the current elements in bytes
+ * @param new_size The new size in bytes
+ * */
+static void* reallocate_elements(
+	const maybe_vector_allocator_t* allocator,
+	void* elements,
+	size_t old_size,
+	size_t new_size
+);
+
+/*
+ * @brief Free the memory of a vector's elements with an allocator, or the heap if there is none
+ *
+ * @param allocator The allocator, can be NULL
+ * @param elements The elements
+ * @param size The size of the elements in bytes
+ * */
+static void free_elements(
+	const maybe_vector_allocator_t* allocator,
+	void* elements,
+	size_t size
+);
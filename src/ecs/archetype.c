@@ -1,11 +1,15 @@
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "common/error.h"
 #include "common/common.h"
 #include "common/vector/vector.h"
 
 #include "archetype.h"
+#include "archetype_internal.h"
 
 maybe_error_t maybe_archetype_init(
 	maybe_archetype_t* archetype
@@ -19,6 +23,15 @@ maybe_error_t maybe_archetype_init(
 
 	/* Initialize archetype */
 	archetype->component_types_count = 0;
+	archetype->disabled_count = 0;
+	archetype->layout_version = 0;
+	archetype->component_mask = 0;
+	archetype->is_parked = false;
+	archetype->column_allocator = NULL;
+	archetype->last_access_tick = 0;
+	archetype->is_paged_out = false;
+	archetype->entities_reference_count = NULL;
+	archetype->enabled_rows_reference_count = NULL;
 	result = maybe_vector_init(&archetype->components, sizeof(maybe_vector_t), 0);
 	if (IS_FAILURE(result)) {
 		goto l_cleanup;
@@ -27,44 +40,827 @@ maybe_error_t maybe_archetype_init(
 	if (IS_FAILURE(result)) {
 		goto l_cleanup;
 	}
+	result = maybe_vector_init(&archetype->entities, sizeof(maybe_entity_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	result = maybe_vector_init(&archetype->enabled_rows, sizeof(uint64_t), 1);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	result = maybe_vector_init(&archetype->shared_component_ids, sizeof(uint32_t), 1);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	result = maybe_vector_init(&archetype->shared_values, sizeof(void*), 1);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	result = maybe_vector_init(&archetype->column_reference_counts, sizeof(uint32_t*), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	result = maybe_vector_init(&archetype->column_access_counts, sizeof(uint32_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_archetype_add_component_type(
+	maybe_archetype_t* archetype,
+	uint32_t component_id,
+	uint32_t component_size
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_vector_t component_vector;
+
+	if (NULL == archetype) {
+		result = MAYBE_ERROR_ARCHETYPE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Add component ID */
+	result = maybe_vector_push(&archetype->component_ids, &component_id);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* Create a vector to store the components */
+	result = maybe_vector_init_with_allocator(&component_vector, component_size, 0, archetype->column_allocator);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* Add the component storage to the components vector */
+	result = maybe_vector_push(&archetype->components, &component_vector);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_push(&archetype->column_reference_counts, &(uint32_t*){ NULL });
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_push(&archetype->column_access_counts, &(uint32_t){ 0 });
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	archetype->component_types_count++;
+	archetype->component_mask |= MAYBE_COMPONENT_MASK_BIT(component_id);
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_archetype_add_filled_component_type(
+	maybe_archetype_t* archetype,
+	uint32_t component_id,
+	uint32_t component_size
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_vector_t* column;
+	uint32_t row_count;
+
+	if (NULL == archetype) {
+		result = MAYBE_ERROR_ARCHETYPE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = maybe_archetype_add_component_type(archetype, component_id, component_size);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	row_count = archetype->entities.length;
+	column = &MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, archetype->component_types_count - 1);
+	result = maybe_vector_reserve(column, row_count);
+	if (IS_FAILURE(result)) {
+		/* Every column must have a value for every row, so take the new one back */
+		(void)maybe_archetype_remove_component_type(archetype, archetype->component_types_count - 1);
+		goto l_cleanup;
+	}
+
+	if (0 != row_count) {
+		memset(column->elements, 0, (size_t)row_count * component_size);
+	}
+	column->length = row_count;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_archetype_remove_component_type(
+	maybe_archetype_t* archetype,
+	uint32_t component_index
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if (NULL == archetype) {
+		result = MAYBE_ERROR_ARCHETYPE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (component_index >= archetype->component_types_count) {
+		result = MAYBE_ERROR_ARCHETYPE_ROW_OUT_OF_RANGE;
+		goto l_cleanup;
+	}
+
+	result = release_storage(
+		&MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, component_index),
+		MAYBE_VECTOR_ELEMENT(archetype->column_reference_counts, uint32_t*, component_index)
+	);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* Removing from the vectors only moves elements, so it cannot fail once the index is valid */
+	archetype->component_mask &= ~MAYBE_COMPONENT_MASK_BIT(MAYBE_VECTOR_ELEMENT(archetype->component_ids, uint32_t, component_index));
+	(void)maybe_vector_remove(&archetype->components, component_index);
+	(void)maybe_vector_remove(&archetype->component_ids, component_index);
+	(void)maybe_vector_remove(&archetype->column_reference_counts, component_index);
+	(void)maybe_vector_remove(&archetype->column_access_counts, component_index);
+	archetype->component_types_count--;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_archetype_init_copy_on_write(
+	maybe_archetype_t* archetype,
+	maybe_archetype_t* source
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_vector_t column;
+	uint32_t* reference_count;
+	uint32_t i;
+
+	if ((NULL == archetype) || (NULL == source)) {
+		result = MAYBE_ERROR_ARCHETYPE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = maybe_archetype_init(archetype);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < source->component_types_count; i++) {
+		result = maybe_vector_push(&archetype->component_ids, &MAYBE_VECTOR_ELEMENT(source->component_ids, uint32_t, i));
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		result = maybe_vector_push(&archetype->column_access_counts, &MAYBE_VECTOR_ELEMENT(source->column_access_counts, uint32_t, i));
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		reference_count = share_storage(&MAYBE_VECTOR_ELEMENT(source->column_reference_counts, uint32_t*, i));
+		if (NULL == reference_count) {
+			result = MAYBE_ERROR_ARCHETYPE_ALLOCATION_FAILED;
+			goto l_cleanup;
+		}
+
+		/* The column is counted as shared from here, so the archetype has to own the column even if a push fails */
+		column = MAYBE_VECTOR_ELEMENT(source->components, maybe_vector_t, i);
+		result = maybe_vector_push(&archetype->column_reference_counts, &reference_count);
+		if (IS_FAILURE(result)) {
+			(*reference_count)--;
+			goto l_cleanup;
+		}
+
+		result = maybe_vector_push(&archetype->components, &column);
+		if (IS_FAILURE(result)) {
+			archetype->column_reference_counts.length--;
+			(*reference_count)--;
+			goto l_cleanup;
+		}
+
+		archetype->component_types_count++;
+	}
+
+	for (i = 0; i < source->shared_component_ids.length; i++) {
+		result = maybe_archetype_add_shared_component(
+			archetype,
+			MAYBE_VECTOR_ELEMENT(source->shared_component_ids, uint32_t, i),
+			MAYBE_VECTOR_ELEMENT(source->shared_values, void*, i)
+		);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	/* Replace the empty storage of the entities and the enabled bits */
+	archetype->entities_reference_count = share_storage(&source->entities_reference_count);
+	if (NULL == archetype->entities_reference_count) {
+		result = MAYBE_ERROR_ARCHETYPE_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+	(void)maybe_vector_free(&archetype->entities);
+	archetype->entities = source->entities;
+
+	archetype->enabled_rows_reference_count = share_storage(&source->enabled_rows_reference_count);
+	if (NULL == archetype->enabled_rows_reference_count) {
+		result = MAYBE_ERROR_ARCHETYPE_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+	(void)maybe_vector_free(&archetype->enabled_rows);
+	archetype->enabled_rows = source->enabled_rows;
+	archetype->disabled_count = source->disabled_count;
+	archetype->component_mask = source->component_mask;
+	archetype->is_parked = source->is_parked;
+	archetype->column_allocator = source->column_allocator;
+	archetype->last_access_tick = source->last_access_tick;
+	archetype->is_paged_out = source->is_paged_out;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_archetype_make_column_writable(
+	maybe_archetype_t* archetype,
+	uint32_t column_index
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if (NULL == archetype) {
+		result = MAYBE_ERROR_ARCHETYPE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = take_storage(
+		&MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, column_index),
+		&MAYBE_VECTOR_ELEMENT(archetype->column_reference_counts, uint32_t*, column_index)
+	);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_archetype_make_writable(
+	maybe_archetype_t* archetype
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t i;
+
+	if (NULL == archetype) {
+		result = MAYBE_ERROR_ARCHETYPE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < archetype->component_types_count; i++) {
+		result = maybe_archetype_make_column_writable(archetype, i);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = take_storage(&archetype->entities, &archetype->entities_reference_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = take_storage(&archetype->enabled_rows, &archetype->enabled_rows_reference_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+bool maybe_archetype_is_shared(
+	maybe_archetype_t* archetype
+) {
+	uint32_t* reference_count;
+	uint32_t i;
+
+	/* A count of 1 means the other archetypes already stopped using the storage */
+	for (i = 0; i < archetype->component_types_count; i++) {
+		reference_count = MAYBE_VECTOR_ELEMENT(archetype->column_reference_counts, uint32_t*, i);
+		if ((NULL != reference_count) && (*reference_count > 1)) {
+			return true;
+		}
+	}
+
+	return ((NULL != archetype->entities_reference_count) && (*archetype->entities_reference_count > 1)) ||
+		   ((NULL != archetype->enabled_rows_reference_count) && (*archetype->enabled_rows_reference_count > 1));
+}
+
+maybe_error_t maybe_archetype_add_shared_component(
+	maybe_archetype_t* archetype,
+	uint32_t component_id,
+	void* value
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if ((NULL == archetype) || (NULL == value)) {
+		result = MAYBE_ERROR_ARCHETYPE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_push(&archetype->shared_component_ids, &component_id);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_push(&archetype->shared_values, &value);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	archetype->component_mask |= MAYBE_COMPONENT_MASK_BIT(component_id);
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+bool maybe_archetype_find_shared_component(
+	maybe_archetype_t* archetype,
+	uint32_t component_id,
+	void** value
+) {
+	uint32_t i;
+
+	for (i = 0; i < archetype->shared_component_ids.length; i++) {
+		if (MAYBE_VECTOR_ELEMENT(archetype->shared_component_ids, uint32_t, i) == component_id) {
+			*value = MAYBE_VECTOR_ELEMENT(archetype->shared_values, void*, i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool maybe_archetype_find_component(
+	maybe_archetype_t* archetype,
+	uint32_t component_id,
+	uint32_t* component_index
+) {
+	uint32_t i;
+
+	for (i = 0; i < archetype->component_types_count; i++) {
+		if (MAYBE_VECTOR_ELEMENT(archetype->component_ids, uint32_t, i) == component_id) {
+			*component_index = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+maybe_error_t maybe_archetype_add_row(
+	maybe_archetype_t* archetype,
+	maybe_entity_t entity,
+	uint32_t* row
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t i;
+
+	if ((NULL == archetype) || (NULL == row)) {
+		result = MAYBE_ERROR_ARCHETYPE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = maybe_archetype_make_writable(archetype);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* Add an element to every component storage */
+	for (i = 0; i < archetype->component_types_count; i++) {
+		result = maybe_vector_push(&MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, i), NULL);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = maybe_vector_push(&archetype->entities, &entity);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	*row = archetype->entities.length - 1;
+
+	/* New rows are enabled */
+	if (0 == (*row % MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD)) {
+		result = maybe_vector_push(&archetype->enabled_rows, &(uint64_t){ 0 });
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+	MAYBE_VECTOR_ELEMENT(archetype->enabled_rows, uint64_t, *row / MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD) |=
+		(1ull << (*row % MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD));
+	archetype->layout_version++;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_archetype_remove_row(
+	maybe_archetype_t* archetype,
+	uint32_t row,
+	maybe_entity_t* moved_entity,
+	bool* entity_moved
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t i, last_row;
+
+	if ((NULL == archetype) || (NULL == moved_entity) || (NULL == entity_moved)) {
+		result = MAYBE_ERROR_ARCHETYPE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (row >= archetype->entities.length) {
+		result = MAYBE_ERROR_ARCHETYPE_ROW_OUT_OF_RANGE;
+		goto l_cleanup;
+	}
+
+	result = maybe_archetype_make_writable(archetype);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* Swap remove the row from every component storage, so no other row has to be moved */
+	for (i = 0; i < archetype->component_types_count; i++) {
+		result = maybe_vector_swap_remove(&MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, i), row);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	*entity_moved = (row != (archetype->entities.length - 1));
+	if (*entity_moved) {
+		*moved_entity = MAYBE_VECTOR_ELEMENT(archetype->entities, maybe_entity_t, archetype->entities.length - 1);
+	}
+
+	result = maybe_vector_swap_remove(&archetype->entities, row);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* Move the last row's enabled bit like its data, and drop the last word once it has no rows */
+	last_row = archetype->entities.length;
+	if (!maybe_archetype_is_row_enabled(archetype, row)) {
+		archetype->disabled_count--;
+	}
+
+	if (row != last_row) {
+		(void)set_enabled_bit(archetype, row, maybe_archetype_is_row_enabled(archetype, last_row));
+	}
+	(void)set_enabled_bit(archetype, last_row, false);
+
+	if (0 == (last_row % MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD)) {
+		archetype->enabled_rows.length--;
+	}
+	archetype->layout_version++;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_archetype_clear(
+	maybe_archetype_t* archetype
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t i;
+
+	if (NULL == archetype) {
+		result = MAYBE_ERROR_ARCHETYPE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Storage that other archetypes still use is given up instead of copied, there is nothing to keep */
+	for (i = 0; i < archetype->component_types_count; i++) {
+		result = drop_storage(
+			&MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, i),
+			&MAYBE_VECTOR_ELEMENT(archetype->column_reference_counts, uint32_t*, i)
+		);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = drop_storage(&archetype->entities, &archetype->entities_reference_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = drop_storage(&archetype->enabled_rows, &archetype->enabled_rows_reference_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	archetype->disabled_count = 0;
+	archetype->layout_version++;
 
 	result = MAYBE_ERROR_SUCCESS;
 l_cleanup:
 	return result;
 }
 
-maybe_error_t maybe_archetype_add_component_type(
+maybe_error_t maybe_archetype_swap_rows(
 	maybe_archetype_t* archetype,
-	uint32_t component_id,
-	uint32_t component_size
+	uint32_t row_a,
+	uint32_t row_b
 ) {
 	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
-	maybe_vector_t component_vector;
+	maybe_vector_t* column;
+	maybe_entity_t entity;
+	bool is_a_enabled;
+	uint32_t i;
 
 	if (NULL == archetype) {
 		result = MAYBE_ERROR_ARCHETYPE_NULL_PARAM;
 		goto l_cleanup;
 	}
 
-	/* Add component ID */
-	result = maybe_vector_push(&archetype->component_ids, &component_id);
+	if ((row_a >= archetype->entities.length) || (row_b >= archetype->entities.length)) {
+		result = MAYBE_ERROR_ARCHETYPE_ROW_OUT_OF_RANGE;
+		goto l_cleanup;
+	}
+
+	if (row_a == row_b) {
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	result = maybe_archetype_make_writable(archetype);
 	if (IS_FAILURE(result)) {
 		goto l_cleanup;
 	}
 
-	/* Create a vector to store the components */
-	result = maybe_vector_init(&component_vector, component_size, 0);
+	for (i = 0; i < archetype->component_types_count; i++) {
+		column = &MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, i);
+		swap_bytes(
+			(uint8_t*)MAYBE_VECTOR_PTR_ELEMENT_VOID_PTR(column, row_a),
+			(uint8_t*)MAYBE_VECTOR_PTR_ELEMENT_VOID_PTR(column, row_b),
+			column->element_size
+		);
+	}
+
+	entity = MAYBE_VECTOR_ELEMENT(archetype->entities, maybe_entity_t, row_a);
+	MAYBE_VECTOR_ELEMENT(archetype->entities, maybe_entity_t, row_a) = MAYBE_VECTOR_ELEMENT(archetype->entities, maybe_entity_t, row_b);
+	MAYBE_VECTOR_ELEMENT(archetype->entities, maybe_entity_t, row_b) = entity;
+
+	/* The disabled count does not change */
+	is_a_enabled = maybe_archetype_is_row_enabled(archetype, row_a);
+	(void)set_enabled_bit(archetype, row_a, maybe_archetype_is_row_enabled(archetype, row_b));
+	(void)set_enabled_bit(archetype, row_b, is_a_enabled);
+
+	archetype->layout_version++;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_archetype_set_row_enabled(
+	maybe_archetype_t* archetype,
+	uint32_t row,
+	bool enabled
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if (NULL == archetype) {
+		result = MAYBE_ERROR_ARCHETYPE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (row >= archetype->entities.length) {
+		result = MAYBE_ERROR_ARCHETYPE_ROW_OUT_OF_RANGE;
+		goto l_cleanup;
+	}
+
+	/* Only the enabled bits change, the columns can stay shared */
+	result = take_storage(&archetype->enabled_rows, &archetype->enabled_rows_reference_count);
 	if (IS_FAILURE(result)) {
 		goto l_cleanup;
 	}
 
-	/* Add the component storage to the components vector */
-	result = maybe_vector_push(&archetype->components, &component_vector);
+	if (set_enabled_bit(archetype, row, enabled)) {
+		if (enabled) {
+			archetype->disabled_count--;
+		} else {
+			archetype->disabled_count++;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+bool maybe_archetype_is_row_enabled(
+	maybe_archetype_t* archetype,
+	uint32_t row
+) {
+	return 0 != (MAYBE_VECTOR_ELEMENT(archetype->enabled_rows, uint64_t, row / MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD) &
+				 (1ull << (row % MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD)));
+}
+
+bool maybe_archetype_find_enabled_rows(
+	maybe_archetype_t* archetype,
+	uint32_t start,
+	uint32_t* first,
+	uint32_t* end
+) {
+	const uint64_t* words = (const uint64_t*)archetype->enabled_rows.elements;
+	uint32_t word_count = archetype->enabled_rows.length;
+	uint32_t row_count = archetype->entities.length;
+	uint32_t word_index;
+	uint64_t word;
+
+	if (start >= row_count) {
+		return false;
+	}
+
+	/* The fast path, every row is enabled */
+	if (0 == archetype->disabled_count) {
+		*first = start;
+		*end = row_count;
+		return true;
+	}
+
+	/* Find the first set bit, skipping whole words of disabled rows */
+	word_index = start / MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD;
+	word = words[word_index] & (~0ull << (start % MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD));
+	while (0 == word) {
+		word_index++;
+		if (word_index >= word_count) {
+			return false;
+		}
+
+		word = words[word_index];
+	}
+	*first = (word_index * MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD) + (uint32_t)__builtin_ctzll(word);
+
+	/* Find the first clear bit after it, the bits past the last row are clear so the range ends there at the latest */
+	word = ~words[word_index] & (~0ull << (*first % MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD));
+	while (0 == word) {
+		word_index++;
+		if (word_index >= word_count) {
+			*end = row_count;
+			return true;
+		}
+
+		word = ~words[word_index];
+	}
+	*end = (word_index * MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD) + (uint32_t)__builtin_ctzll(word);
+	if (*end > row_count) {
+		*end = row_count;
+	}
+
+	return true;
+}
+
+maybe_error_t maybe_archetype_update_enabled_rows(
+	maybe_archetype_t* archetype,
+	uint32_t first_new_row
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t row_count, word_count, old_word_count, tail_bits, i;
+	uint64_t* words;
+
+	if (NULL == archetype) {
+		result = MAYBE_ERROR_ARCHETYPE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = take_storage(&archetype->enabled_rows, &archetype->enabled_rows_reference_count);
 	if (IS_FAILURE(result)) {
 		goto l_cleanup;
 	}
 
-	archetype->component_types_count++;
+	row_count = archetype->entities.length;
+	word_count = (row_count + MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD - 1) / MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD;
+	old_word_count = archetype->enabled_rows.length;
+
+	result = maybe_vector_reserve(&archetype->enabled_rows, word_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	words = (uint64_t*)archetype->enabled_rows.elements;
+	for (i = old_word_count; i < word_count; i++) {
+		words[i] = 0;
+	}
+	archetype->enabled_rows.length = word_count;
+
+	for (i = first_new_row; i < row_count; i++) {
+		words[i / MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD] |= (1ull << (i % MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD));
+	}
+
+	tail_bits = row_count % MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD;
+	if (0 != tail_bits) {
+		words[word_count - 1] &= (1ull << tail_bits) - 1;
+	}
+
+	archetype->disabled_count = row_count;
+	for (i = 0; i < word_count; i++) {
+		archetype->disabled_count -= (uint32_t)__builtin_popcountll(words[i]);
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+float maybe_archetype_get_fill_ratio(
+	maybe_archetype_t* archetype
+) {
+	/* All the columns grow together with the entities column */
+	return (float)archetype->entities.length / (float)archetype->entities.capacity;
+}
+
+maybe_error_t maybe_archetype_set_column_allocator(
+	maybe_archetype_t* archetype,
+	const maybe_vector_allocator_t* allocator
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t i;
+
+	if (NULL == archetype) {
+		result = MAYBE_ERROR_ARCHETYPE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Storage that other archetypes use must stay where it is */
+	result = maybe_archetype_make_writable(archetype);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < archetype->component_types_count; i++) {
+		result = maybe_vector_set_allocator(&MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, i), allocator);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	/* The entities go with the columns, so every row can be read from the allocator's memory alone */
+	result = maybe_vector_set_allocator(&archetype->entities, allocator);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	archetype->column_allocator = allocator;
+	archetype->is_paged_out = false;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_archetype_shrink(
+	maybe_archetype_t* archetype
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t i;
+
+	if (NULL == archetype) {
+		result = MAYBE_ERROR_ARCHETYPE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = maybe_archetype_make_writable(archetype);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < archetype->component_types_count; i++) {
+		result = maybe_vector_shrink(&MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, i), archetype->entities.length);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = maybe_vector_shrink(&archetype->entities, archetype->entities.length);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_shrink(&archetype->enabled_rows, archetype->enabled_rows.length);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
 
 	result = MAYBE_ERROR_SUCCESS;
 l_cleanup:
@@ -83,10 +879,15 @@ maybe_error_t maybe_archetype_free(
 		goto l_cleanup;
 	}
 
+	result = MAYBE_ERROR_SUCCESS;
+
 	/* @TODO Who's responsible for freeing the components resources */
 	/* Iterate over components and free them */
 	for (i = 0; i < archetype->component_types_count; i++) {
-		free_result = maybe_vector_free(&MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, i));
+		free_result = release_storage(
+			&MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, i),
+			MAYBE_VECTOR_ELEMENT(archetype->column_reference_counts, uint32_t*, i)
+		);
 		if (IS_FAILURE(free_result)) {
 			result = free_result;
 		}
@@ -102,6 +903,37 @@ maybe_error_t maybe_archetype_free(
 		result = free_result;
 	}
 
+	free_result = maybe_vector_free(&archetype->column_reference_counts);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&archetype->column_access_counts);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = release_storage(&archetype->entities, archetype->entities_reference_count);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = release_storage(&archetype->enabled_rows, archetype->enabled_rows_reference_count);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	/* The shared values belong to their types' stores */
+	free_result = maybe_vector_free(&archetype->shared_component_ids);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&archetype->shared_values);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
 	/* If any free operation failed, return an error */
 	if (IS_FAILURE(result)) {
 		goto l_cleanup;
@@ -111,3 +943,138 @@ maybe_error_t maybe_archetype_free(
 l_cleanup:
 	return result;
 }
+
+bool set_enabled_bit(
+	maybe_archetype_t* archetype,
+	uint32_t row,
+	bool enabled
+) {
+	uint64_t* word = &MAYBE_VECTOR_ELEMENT(archetype->enabled_rows, uint64_t, row / MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD);
+	uint64_t bit = 1ull << (row % MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD);
+	bool was_enabled = (0 != (*word & bit));
+
+	if (enabled) {
+		*word |= bit;
+	} else {
+		*word &= ~bit;
+	}
+
+	return was_enabled != enabled;
+}
+
+maybe_error_t take_storage(
+	maybe_vector_t* vector,
+	uint32_t** reference_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if (NULL == *reference_count) {
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	/* The other archetypes stopped using the storage, so it is already owned */
+	if (1 == **reference_count) {
+		free(*reference_count);
+		*reference_count = NULL;
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	/* The copy comes from the same allocator, so the storage stays where its owner put it */
+	result = maybe_vector_copy_elements(vector);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	(**reference_count)--;
+	*reference_count = NULL;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t release_storage(
+	maybe_vector_t* vector,
+	uint32_t* reference_count
+) {
+	if (NULL != reference_count) {
+		if (1 == *reference_count) {
+			free(reference_count);
+		} else {
+			/* Another archetype still uses the storage */
+			(*reference_count)--;
+			vector->elements = NULL;
+		}
+	}
+
+	return maybe_vector_free(vector);
+}
+
+maybe_error_t drop_storage(
+	maybe_vector_t* vector,
+	uint32_t** reference_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t element_size = vector->element_size;
+	const maybe_vector_allocator_t* allocator = vector->allocator;
+
+	if (NULL == *reference_count) {
+		vector->length = 0;
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	result = release_storage(vector, *reference_count);
+	*reference_count = NULL;
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init_with_allocator(vector, element_size, 0, allocator);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+uint32_t* share_storage(
+	uint32_t** reference_count
+) {
+	if (NULL == *reference_count) {
+		*reference_count = MALLOC_T(uint32_t, 1);
+		if (NULL == *reference_count) {
+			return NULL;
+		}
+
+		**reference_count = 1;
+	}
+
+	(**reference_count)++;
+
+	return *reference_count;
+}
+
+void swap_bytes(
+	uint8_t* a,
+	uint8_t* b,
+	size_t size
+) {
+	uint8_t buffer[64];
+	size_t chunk_size;
+
+	while (size > 0) {
+		chunk_size = (size < sizeof(buffer)) ? size : sizeof(buffer);
+		memcpy(buffer, a, chunk_size);
+		memcpy(a, b, chunk_size);
+		memcpy(b, buffer, chunk_size);
+
+		a += chunk_size;
+		b += chunk_size;
+		size -= chunk_size;
+	}
+}
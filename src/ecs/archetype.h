@@ -1,17 +1,69 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "common/error.h"
 #include "common/vector/vector.h"
+#include "entity.h"
 
 /* @TODO Consider grouping together each entity's components together to optimize iteration */
 typedef struct {
 	uint32_t component_types_count;
 	MAYBE_VECTOR(maybe_vector_t) components; /* @TODO Maybe change this to a map of <component_id, component_storage> */
 	MAYBE_VECTOR(uint32_t) component_ids;
+	MAYBE_VECTOR(maybe_entity_t) entities; /* The entity stored in each row */
+	MAYBE_VECTOR(uint32_t) shared_component_ids; /* The shared component types of the archetype, they have no column */
+	MAYBE_VECTOR(void*) shared_values; /* The value of every shared component type, stored in its type's shared store */
+	MAYBE_VECTOR(uint64_t) enabled_rows; /* A bit for every row, set if the row's entity is enabled. Bits past the last row are clear */
+	uint32_t disabled_count; /* The number of disabled rows, when 0 the enabled bits do not need to be checked */
+	uint32_t layout_version; /* Changed whenever rows are added, removed or reordered, so saved row indices can be checked */
+	uint64_t component_mask; /* The bit of every component type of the archetype, shared or not, see MAYBE_COMPONENT_MASK_BIT */
+	MAYBE_VECTOR(uint32_t*) column_reference_counts; /* The number of archetypes using every column's storage, NULL if no other archetype uses it */
+	uint32_t* entities_reference_count; /* Like column_reference_counts, for the entities */
+	uint32_t* enabled_rows_reference_count; /* Like column_reference_counts, for the enabled bits */
+	bool is_parked; /* Parked archetypes are empty and were removed from the systems' archetype lists */
+	const maybe_vector_allocator_t* column_allocator; /* Allocates the storage of new columns, NULL for the heap */
+	uint64_t last_access_tick; /* The world's access tick when a system last touched the archetype, see maybe_world_page_out */
+	bool is_paged_out; /* Set when the archetype's columns were paged out, cleared when they are prefetched */
+	MAYBE_VECTOR(uint32_t) column_access_counts; /* The number of system runs that read every column since the counts were reset, see maybe_world_split_cold_columns */
 } maybe_archetype_t;
 
+/* @brief The number of rows in a word of an archetype's enabled bits */
+#define MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD (64)
+
+/* @brief The number of component IDs that have a bit in a component mask */
+#define MAYBE_COMPONENT_MASK_BITS (64)
+
+/*
+ * @brief The bit of a component ID in a component mask, used to reject archetypes without comparing IDs
+ *
+ * IDs past the mask have no bit, so a mask check can only rule archetypes out and the IDs are still
+ * compared. With compile-time IDs (see MAYBE_DECLARE_COMPONENT_MANIFEST) the masks are constants.
+ * */
+#define MAYBE_COMPONENT_MASK_BIT(component_id) \
+	(((uint32_t)(component_id) < MAYBE_COMPONENT_MASK_BITS) ? (1ull << ((uint32_t)(component_id) % MAYBE_COMPONENT_MASK_BITS)) : 0ull)
+
+/*
+ * @brief Get the component mask of a list of component IDs
+ *
+ * @param component_ids An array of the component type IDs
+ * @param component_count The amount of components
+ * */
+static inline uint64_t maybe_archetype_get_component_mask(
+	const uint32_t* component_ids,
+	uint32_t component_count
+) {
+	uint64_t mask = 0;
+	uint32_t i;
+
+	for (i = 0; i < component_count; i++) {
+		mask |= MAYBE_COMPONENT_MASK_BIT(component_ids[i]);
+	}
+
+	return mask;
+}
+
 /*
  * @brief Initialize an archetype
  *
@@ -34,6 +86,259 @@ maybe_error_t maybe_archetype_add_component_type(
 	uint32_t component_size
 );
 
+/*
+ * @brief Add a component type to an archetype that may already have rows, the new column is zeroed for them
+ *
+ * @param archetype The archetype
+ * @param component_id The id of the component to be added
+ * @param component_size The size of an instance of the component type
+ * */
+maybe_error_t maybe_archetype_add_filled_component_type(
+	maybe_archetype_t* archetype,
+	uint32_t component_id,
+	uint32_t component_size
+);
+
+/*
+ * @brief Remove a component type and its column from an archetype, keeping the order of the other columns
+ *
+ * @param archetype The archetype
+ * @param component_index The index of the component in the archetype
+ * */
+maybe_error_t maybe_archetype_remove_component_type(
+	maybe_archetype_t* archetype,
+	uint32_t component_index
+);
+
+/*
+ * @brief Initialize an archetype with the same rows as another archetype, without copying them
+ *
+ * Both archetypes use the same column storage until one of them writes to it. Functions that change
+ * rows make the archetype's storage writable first, and code that writes through column pointers
+ * must call maybe_archetype_make_column_writable first.
+ *
+ * @param archetype The new archetype
+ * @param source The archetype whose rows are shared
+ *
+ * @note The archetypes must not be used concurrently
+ * */
+maybe_error_t maybe_archetype_init_copy_on_write(
+	maybe_archetype_t* archetype,
+	maybe_archetype_t* source
+);
+
+/*
+ * @brief Make a column's storage writable, copying it if another archetype uses it
+ *
+ * @param archetype The archetype
+ * @param column_index The index of the column's storage in the archetype
+ * */
+maybe_error_t maybe_archetype_make_column_writable(
+	maybe_archetype_t* archetype,
+	uint32_t column_index
+);
+
+/*
+ * @brief Make all of an archetype's storage writable, copying what other archetypes use
+ *
+ * @param archetype The archetype
+ * */
+maybe_error_t maybe_archetype_make_writable(
+	maybe_archetype_t* archetype
+);
+
+/*
+ * @brief Check if any of an archetype's storage is used by other archetypes, so writing to it would copy it
+ *
+ * @param archetype The archetype
+ * */
+bool maybe_archetype_is_shared(
+	maybe_archetype_t* archetype
+);
+
+/*
+ * @brief Add a shared component type with a value to an archetype
+ *
+ * @param archetype The archetype
+ * @param component_id The id of the shared component
+ * @param value The stored value all the archetype's rows share
+ * */
+maybe_error_t maybe_archetype_add_shared_component(
+	maybe_archetype_t* archetype,
+	uint32_t component_id,
+	void* value
+);
+
+/*
+ * @brief Find the value of a shared component type in an archetype
+ *
+ * @param archetype The archetype
+ * @param component_id The id of the shared component
+ * @param value The shared value, set only if the shared component was found
+ *
+ * @return Whether the archetype has the shared component type
+ * */
+bool maybe_archetype_find_shared_component(
+	maybe_archetype_t* archetype,
+	uint32_t component_id,
+	void** value
+);
+
+/*
+ * @brief Find the index of a component type's storage in an archetype
+ *
+ * @param archetype The archetype
+ * @param component_id The id of the component
+ * @param component_index The index of the component's storage, set only if the component was found
+ *
+ * @return Whether the archetype contains the component type
+ * */
+bool maybe_archetype_find_component(
+	maybe_archetype_t* archetype,
+	uint32_t component_id,
+	uint32_t* component_index
+);
+
+/*
+ * @brief Add an uninitialized, enabled row to an archetype
+ *
+ * @param archetype The archetype
+ * @param entity The entity the row belongs to
+ * @param row The index of the new row
+ * */
+maybe_error_t maybe_archetype_add_row(
+	maybe_archetype_t* archetype,
+	maybe_entity_t entity,
+	uint32_t* row
+);
+
+/*
+ * @brief Remove a row from an archetype, the last row is moved into its place
+ *
+ * @param archetype The archetype
+ * @param row The index of the row to remove
+ * @param moved_entity The entity whose row was moved into the removed row, if any
+ * @param entity_moved Whether a row was moved
+ * */
+maybe_error_t maybe_archetype_remove_row(
+	maybe_archetype_t* archetype,
+	uint32_t row,
+	maybe_entity_t* moved_entity,
+	bool* entity_moved
+);
+
+/*
+ * @brief Remove all the rows of an archetype, keeping the capacity of the storage it owns
+ *
+ * @param archetype The archetype
+ * */
+maybe_error_t maybe_archetype_clear(
+	maybe_archetype_t* archetype
+);
+
+/*
+ * @brief Swap two rows of an archetype, including their entities and enabled bits
+ *
+ * @param archetype The archetype
+ * @param row_a The first row
+ * @param row_b The second row
+ *
+ * @note The caller is responsible for updating the records of the rows' entities
+ * */
+maybe_error_t maybe_archetype_swap_rows(
+	maybe_archetype_t* archetype,
+	uint32_t row_a,
+	uint32_t row_b
+);
+
+/*
+ * @brief Enable or disable a row of an archetype
+ *
+ * @param archetype The archetype
+ * @param row The row
+ * @param enabled Whether the row is enabled
+ *
+ * @note This never moves a row, disabled rows keep their place and are only skipped by iteration
+ * */
+maybe_error_t maybe_archetype_set_row_enabled(
+	maybe_archetype_t* archetype,
+	uint32_t row,
+	bool enabled
+);
+
+/*
+ * @brief Check whether a row of an archetype is enabled
+ *
+ * @param archetype The archetype
+ * @param row The row, must be in range
+ * */
+bool maybe_archetype_is_row_enabled(
+	maybe_archetype_t* archetype,
+	uint32_t row
+);
+
+/*
+ * @brief Find the next range of consecutive enabled rows in an archetype
+ *
+ * @param archetype The archetype
+ * @param start The row the search starts from
+ * @param first The first row of the range
+ * @param end The row after the last row of the range
+ *
+ * @return Whether an enabled row was found at or after start
+ *
+ * @note The enabled bits are checked a word at a time, so 64 disabled rows are skipped at once, and
+ * 		 an archetype without disabled rows is a single range that is found without checking them
+ * */
+bool maybe_archetype_find_enabled_rows(
+	maybe_archetype_t* archetype,
+	uint32_t start,
+	uint32_t* first,
+	uint32_t* end
+);
+
+/*
+ * @brief Fit the enabled bits to the archetype's rows, after rows were added or removed without add_row and remove_row
+ *
+ * @param archetype The archetype
+ * @param first_new_row Rows from this row to the last row are enabled, rows before it keep their state
+ * */
+maybe_error_t maybe_archetype_update_enabled_rows(
+	maybe_archetype_t* archetype,
+	uint32_t first_new_row
+);
+
+/*
+ * @brief Get the fraction of an archetype's allocated rows that are used
+ *
+ * @param archetype The archetype
+ * */
+float maybe_archetype_get_fill_ratio(
+	maybe_archetype_t* archetype
+);
+
+/*
+ * @brief Move the storage of an archetype's columns and entities to another allocator, new columns are allocated from it too
+ *
+ * @param archetype The archetype
+ * @param allocator The allocator, it must stay valid while the archetype uses it. If NULL the heap is used
+ *
+ * @note Shared storage is copied, so the archetype owns all of its storage afterwards
+ * */
+maybe_error_t maybe_archetype_set_column_allocator(
+	maybe_archetype_t* archetype,
+	const maybe_vector_allocator_t* allocator
+);
+
+/*
+ * @brief Release the unused capacity of an archetype's storage
+ *
+ * @param archetype The archetype
+ * */
+maybe_error_t maybe_archetype_shrink(
+	maybe_archetype_t* archetype
+);
+
 /*
  * @brief Free an archetype's resources
  *
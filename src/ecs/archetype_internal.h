@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "archetype.h"
+
+/*
+ * @brief Set a row's enabled bit, without updating the archetype's disabled count
+ *
+ * @param archetype The archetype
+ * @param row The row, its word must exist
+ * @param enabled The bit's new value
+ *
+ * @return Whether the bit changed
+ * */
+static bool set_enabled_bit(
+	maybe_archetype_t* archetype,
+	uint32_t row,
+	bool enabled
+);
+
+/*
+ * @brief Take ownership of a vector's storage, copying it if other archetypes still use it
+ *
+ * @param vector The vector
+ * @param reference_count The storage's reference count, set to NULL
+ * */
+static maybe_error_t take_storage(
+	maybe_vector_t* vector,
+	uint32_t** reference_count
+);
+
+/*
+ * @brief Free a vector, keeping its storage if other archetypes still use it
+ *
+ * @param vector The vector
+ * @param reference_count The storage's reference count, can be NULL
+ * */
+static maybe_error_t release_storage(
+	maybe_vector_t* vector,
+	uint32_t* reference_count
+);
+
+/*
+ * @brief Remove all the elements of a vector, giving up its storage instead if other archetypes still use it
+ *
+ * @param vector The vector
+ * @param reference_count The storage's reference count, set to NULL
+ * */
+static maybe_error_t drop_storage(
+	maybe_vector_t* vector,
+	uint32_t** reference_count
+);
+
+/*
+ * @brief Get the reference count of storage that is about to be shared, creating it if needed
+ *
+ * @param reference_count A pointer to the storage's reference count, NULL if the storage is not shared yet
+ *
+ * @return The reference count, already counting the new user, or NULL if it could not be allocated
+ * */
+static uint32_t* share_storage(
+	uint32_t** reference_count
+);
+
+/*
+ * @brief Swap two non-overlapping byte ranges
+ *
+ * @param a The first range
+ * @param b The second range
+ * @param size The size of each range
+ * */
+static void swap_bytes(
+	uint8_t* a,
+	uint8_t* b,
+	size_t size
+);
@@ -0,0 +1,871 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/error.h"
+#include "common/common.h"
+#include "common/vector/vector.h"
+#include "common/map/map.h"
+
+#include "component_index.h"
+#include "component_index_internal.h"
+
+maybe_error_t maybe_component_index_init(
+	maybe_component_index_t* index,
+	maybe_world_t* world,
+	maybe_component_index_config_t config
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_component_type_t* component_type;
+	uint32_t event;
+
+	if ((NULL == index) || (NULL == world)) {
+		result = MAYBE_ERROR_COMPONENT_INDEX_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	memset(index, 0, sizeof(*index));
+	index->config = config;
+	index->world = world;
+	index->field_size = get_field_size(config.field);
+
+	if ((0 == index->field_size) ||
+		((MAYBE_COMPONENT_INDEX_HASH != config.type) && (MAYBE_COMPONENT_INDEX_SORTED != config.type)) ||
+		(config.component_id >= world->component_types.length)) {
+		result = MAYBE_ERROR_COMPONENT_INDEX_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	component_type = &MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, config.component_id);
+	if ((NULL != component_type->shared_store) ||
+		((uint64_t)config.offset + index->field_size > component_type->component_size)) {
+		result = MAYBE_ERROR_COMPONENT_INDEX_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&index->bucket_entities, sizeof(maybe_vector_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&index->free_buckets, sizeof(uint32_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&index->keys, sizeof(uint64_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&index->entities, sizeof(maybe_entity_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&index->insertions, sizeof(maybe_component_index_entry_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&index->removals, sizeof(maybe_component_index_entry_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&index->merged_keys, sizeof(uint64_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&index->merged_entities, sizeof(maybe_entity_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_component_index_rebuild(index);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* Every event is handled the same way, the entities are updated from the world as it is at the flush */
+	for (event = 0; event < MAYBE_OBSERVER_EVENT_COUNT; event++) {
+		result = maybe_world_add_observer(world, config.component_id, (maybe_observer_event_t)event, observe, index);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+		index->is_observing[event] = true;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (IS_FAILURE(result) && (MAYBE_ERROR_COMPONENT_INDEX_NULL_PARAM != result)) {
+		(void)maybe_component_index_free(index);
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_component_index_find(
+	maybe_component_index_t* index,
+	const void* value,
+	const maybe_entity_t** entities,
+	uint32_t* entity_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_vector_t* bucket;
+	uint32_t* bucket_index = NULL;
+	uint32_t first, end;
+	uint64_t key;
+
+	if ((NULL == index) || (NULL == value) || (NULL == entities) || (NULL == entity_count)) {
+		result = MAYBE_ERROR_COMPONENT_INDEX_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (index->is_stale) {
+		result = maybe_component_index_rebuild(index);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	key = maybe_component_index_get_key(index, value);
+
+	if (MAYBE_COMPONENT_INDEX_HASH == index->config.type) {
+		result = maybe_map_get(&index->buckets, &key, sizeof(key), (void**)&bucket_index);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		if (NULL == bucket_index) {
+			*entities = NULL;
+			*entity_count = 0;
+		} else {
+			bucket = &MAYBE_VECTOR_ELEMENT(index->bucket_entities, maybe_vector_t, *bucket_index);
+			*entities = (const maybe_entity_t*)bucket->elements;
+			*entity_count = bucket->length;
+		}
+	} else {
+		first = lower_bound(index, key);
+		end = (UINT64_MAX == key) ? index->keys.length : lower_bound(index, key + 1);
+
+		*entities = (const maybe_entity_t*)index->entities.elements + first;
+		*entity_count = end - first;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_component_index_find_range(
+	maybe_component_index_t* index,
+	const void* min,
+	const void* max,
+	const maybe_entity_t** entities,
+	uint32_t* entity_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint64_t min_key, max_key;
+	uint32_t first, end;
+
+	if ((NULL == index) || (NULL == min) || (NULL == max) || (NULL == entities) || (NULL == entity_count)) {
+		result = MAYBE_ERROR_COMPONENT_INDEX_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (MAYBE_COMPONENT_INDEX_SORTED != index->config.type) {
+		result = MAYBE_ERROR_COMPONENT_INDEX_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	if (index->is_stale) {
+		result = maybe_component_index_rebuild(index);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	min_key = maybe_component_index_get_key(index, min);
+	max_key = maybe_component_index_get_key(index, max);
+
+	if (min_key > max_key) {
+		*entities = NULL;
+		*entity_count = 0;
+	} else {
+		first = lower_bound(index, min_key);
+		end = (UINT64_MAX == max_key) ? index->keys.length : lower_bound(index, max_key + 1);
+
+		*entities = (const maybe_entity_t*)index->entities.elements + first;
+		*entity_count = end - first;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_component_index_refresh(
+	maybe_component_index_t* index,
+	const maybe_entity_t* entities,
+	uint32_t entity_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if ((NULL == index) || ((NULL == entities) && (entity_count > 0))) {
+		result = MAYBE_ERROR_COMPONENT_INDEX_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* A stale index is rebuilt by the next lookup, which covers these entities */
+	if (index->is_stale) {
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	result = update_entities(index, entities, entity_count);
+	if (IS_FAILURE(result)) {
+		index->is_stale = true;
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_component_index_rebuild(
+	maybe_component_index_t* index
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_archetype_t* archetype;
+	uint32_t component_index;
+	uint32_t i;
+
+	if (NULL == index) {
+		result = MAYBE_ERROR_COMPONENT_INDEX_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Stays set if the rebuild fails, so the next lookup tries again */
+	index->is_stale = true;
+
+	result = clear(index);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < index->world->archetypes.length; i++) {
+		archetype = MAYBE_VECTOR_ELEMENT(index->world->archetypes, maybe_archetype_t*, i);
+
+		if ((0 == archetype->entities.length) ||
+			!maybe_archetype_find_component(archetype, index->config.component_id, &component_index)) {
+			continue;
+		}
+
+		result = collect_entities(index, (const maybe_entity_t*)archetype->entities.elements, archetype->entities.length);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	/* A sorted index gets every entity as one batch, so it is sorted once */
+	result = merge_batch(index);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	index->is_stale = false;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+uint64_t maybe_component_index_get_key(
+	const maybe_component_index_t* index,
+	const void* value
+) {
+	uint32_t value_32;
+	uint64_t value_64;
+
+	/*
+	 * Keys compare as unsigned integers: signed values get their sign bit flipped, and negative floats all of their bits.
+	 * -0.0f is folded into +0.0f first so both zeros share a key
+	 * */
+	switch (index->config.field) {
+	case MAYBE_COMPONENT_INDEX_FIELD_UINT32:
+		memcpy(&value_32, value, sizeof(value_32));
+		return value_32;
+	case MAYBE_COMPONENT_INDEX_FIELD_INT32:
+		memcpy(&value_32, value, sizeof(value_32));
+		return value_32 ^ 0x80000000u;
+	case MAYBE_COMPONENT_INDEX_FIELD_UINT64:
+		memcpy(&value_64, value, sizeof(value_64));
+		return value_64;
+	case MAYBE_COMPONENT_INDEX_FIELD_INT64:
+		memcpy(&value_64, value, sizeof(value_64));
+		return value_64 ^ 0x8000000000000000ull;
+	case MAYBE_COMPONENT_INDEX_FIELD_FLOAT:
+		memcpy(&value_32, value, sizeof(value_32));
+		if (0x80000000u == value_32) {
+			value_32 = 0;
+		}
+		return (value_32 & 0x80000000u) ? (uint32_t)~value_32 : (value_32 | 0x80000000u);
+	default:
+		return 0;
+	}
+}
+
+maybe_error_t maybe_component_index_free(
+	maybe_component_index_t* index
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_error_t free_result;
+	uint32_t i;
+
+	if (NULL == index) {
+		result = MAYBE_ERROR_COMPONENT_INDEX_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+
+	for (i = 0; i < MAYBE_OBSERVER_EVENT_COUNT; i++) {
+		if (index->is_observing[i]) {
+			free_result = maybe_world_remove_observer(
+				index->world,
+				index->config.component_id,
+				(maybe_observer_event_t)i,
+				observe,
+				index
+			);
+			if (IS_FAILURE(free_result)) {
+				result = free_result;
+			}
+			index->is_observing[i] = false;
+		}
+	}
+
+	if (index->is_records_initialized) {
+		free_result = maybe_map_free(&index->records);
+		if (IS_FAILURE(free_result)) {
+			result = free_result;
+		}
+		index->is_records_initialized = false;
+	}
+
+	if (index->is_buckets_initialized) {
+		free_result = maybe_map_free(&index->buckets);
+		if (IS_FAILURE(free_result)) {
+			result = free_result;
+		}
+		index->is_buckets_initialized = false;
+	}
+
+	for (i = 0; i < index->bucket_entities.length; i++) {
+		free_result = maybe_vector_free(&MAYBE_VECTOR_ELEMENT(index->bucket_entities, maybe_vector_t, i));
+		if (IS_FAILURE(free_result)) {
+			result = free_result;
+		}
+	}
+
+	free_result = maybe_vector_free(&index->bucket_entities);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&index->free_buckets);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&index->keys);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&index->entities);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&index->insertions);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&index->removals);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&index->merged_keys);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&index->merged_entities);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	/* If any free operation failed, return an error */
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+uint32_t get_field_size(
+	maybe_component_index_field_t field
+) {
+	switch (field) {
+	case MAYBE_COMPONENT_INDEX_FIELD_UINT32:
+	case MAYBE_COMPONENT_INDEX_FIELD_INT32:
+	case MAYBE_COMPONENT_INDEX_FIELD_FLOAT:
+		return sizeof(uint32_t);
+	case MAYBE_COMPONENT_INDEX_FIELD_UINT64:
+	case MAYBE_COMPONENT_INDEX_FIELD_INT64:
+		return sizeof(uint64_t);
+	default:
+		return 0;
+	}
+}
+
+void observe(
+	void* world,
+	uint32_t component_id,
+	maybe_observer_event_t event,
+	const maybe_entity_t* entities,
+	uint32_t entity_count,
+	void* context
+) {
+	maybe_component_index_t* index = (maybe_component_index_t*)context;
+
+	(void)world;
+	(void)component_id;
+	(void)event;
+
+	if (index->is_stale) {
+		return;
+	}
+
+	/* Observers cannot fail, so a batch that could not be applied is made up for by a rebuild */
+	if (IS_FAILURE(update_entities(index, entities, entity_count))) {
+		index->is_stale = true;
+	}
+}
+
+bool read_key(
+	maybe_component_index_t* index,
+	maybe_entity_t entity,
+	uint64_t* key
+) {
+	void* component = NULL;
+
+	/* Fails for entities that were removed or no longer have the component */
+	if (IS_FAILURE(maybe_world_get_component(index->world, entity, index->config.component_id, &component))) {
+		return false;
+	}
+
+	*key = maybe_component_index_get_key(index, (const uint8_t*)component + index->config.offset);
+	return true;
+}
+
+maybe_error_t update_entities(
+	maybe_component_index_t* index,
+	const maybe_entity_t* entities,
+	uint32_t entity_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	index->insertions.length = 0;
+	index->removals.length = 0;
+
+	result = collect_entities(index, entities, entity_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	if ((index->insertions.length > 0) || (index->removals.length > 0)) {
+		result = merge_batch(index);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t collect_entities(
+	maybe_component_index_t* index,
+	const maybe_entity_t* entities,
+	uint32_t entity_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_component_index_record_t* found = NULL;
+	maybe_component_index_record_t record = { 0 };
+	maybe_component_index_entry_t entry;
+	bool was_indexed, is_indexed;
+	uint64_t key = 0;
+	uint32_t i;
+
+	for (i = 0; i < entity_count; i++) {
+		result = maybe_map_get(&index->records, (void*)&entities[i], sizeof(maybe_entity_t), (void**)&found);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		was_indexed = (NULL != found);
+		if (was_indexed) {
+			record = *found;
+		}
+		is_indexed = read_key(index, entities[i], &key);
+
+		/* Repeated entities and writes of the same value leave the index as it is */
+		if ((was_indexed == is_indexed) && (!is_indexed || (record.key == key))) {
+			continue;
+		}
+
+		if (was_indexed) {
+			if (MAYBE_COMPONENT_INDEX_HASH == index->config.type) {
+				result = remove_from_bucket(index, record.key, record.position);
+			} else {
+				entry.key = record.key;
+				entry.entity = entities[i];
+				result = maybe_vector_push(&index->removals, &entry);
+			}
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+		}
+
+		if (is_indexed) {
+			record.key = key;
+			record.position = 0;
+
+			if (MAYBE_COMPONENT_INDEX_HASH == index->config.type) {
+				result = insert_into_bucket(index, key, entities[i], &record.position);
+			} else {
+				entry.key = key;
+				entry.entity = entities[i];
+				result = maybe_vector_push(&index->insertions, &entry);
+			}
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+
+			/* Existing records are updated in place, without looking them up again */
+			if (was_indexed) {
+				*found = record;
+				continue;
+			}
+
+			result = maybe_map_set(&index->records, (void*)&entities[i], sizeof(maybe_entity_t), &record);
+		} else {
+			result = maybe_map_remove(&index->records, (void*)&entities[i], sizeof(maybe_entity_t));
+		}
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t insert_into_bucket(
+	maybe_component_index_t* index,
+	uint64_t key,
+	maybe_entity_t entity,
+	uint32_t* position
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_vector_t new_bucket;
+	maybe_vector_t* bucket;
+	uint32_t* found = NULL;
+	uint32_t bucket_index;
+
+	result = maybe_map_get(&index->buckets, &key, sizeof(key), (void**)&found);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	if (NULL != found) {
+		bucket_index = *found;
+	} else if (index->free_buckets.length > 0) {
+		bucket_index = MAYBE_VECTOR_ELEMENT(index->free_buckets, uint32_t, index->free_buckets.length - 1);
+
+		result = maybe_map_set(&index->buckets, &key, sizeof(key), &bucket_index);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+		index->free_buckets.length--;
+	} else {
+		result = maybe_vector_init(&new_bucket, sizeof(maybe_entity_t), 0);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		result = maybe_vector_push(&index->bucket_entities, &new_bucket);
+		if (IS_FAILURE(result)) {
+			(void)maybe_vector_free(&new_bucket);
+			goto l_cleanup;
+		}
+		bucket_index = index->bucket_entities.length - 1;
+
+		result = maybe_map_set(&index->buckets, &key, sizeof(key), &bucket_index);
+		if (IS_FAILURE(result)) {
+			/* The new bucket is empty, it is kept for the next key */
+			(void)maybe_vector_push(&index->free_buckets, &bucket_index);
+			goto l_cleanup;
+		}
+	}
+
+	bucket = &MAYBE_VECTOR_ELEMENT(index->bucket_entities, maybe_vector_t, bucket_index);
+	result = maybe_vector_push(bucket, &entity);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	*position = bucket->length - 1;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t remove_from_bucket(
+	maybe_component_index_t* index,
+	uint64_t key,
+	uint32_t position
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_component_index_record_t* moved_record = NULL;
+	maybe_vector_t* bucket;
+	uint32_t* found = NULL;
+	uint32_t bucket_index;
+
+	result = maybe_map_get(&index->buckets, &key, sizeof(key), (void**)&found);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	bucket_index = *found;
+	bucket = &MAYBE_VECTOR_ELEMENT(index->bucket_entities, maybe_vector_t, bucket_index);
+
+	result = maybe_vector_swap_remove(bucket, position);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* The bucket's last entity took the removed one's place */
+	if (position < bucket->length) {
+		result = maybe_map_get(
+			&index->records,
+			&MAYBE_VECTOR_ELEMENT(*bucket, maybe_entity_t, position),
+			sizeof(maybe_entity_t),
+			(void**)&moved_record
+		);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+		moved_record->position = position;
+	}
+
+	if (0 == bucket->length) {
+		result = maybe_vector_push(&index->free_buckets, &bucket_index);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		result = maybe_map_remove(&index->buckets, &key, sizeof(key));
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t merge_batch(
+	maybe_component_index_t* index
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_component_index_entry_t* insertions = (maybe_component_index_entry_t*)index->insertions.elements;
+	maybe_component_index_entry_t* removals = (maybe_component_index_entry_t*)index->removals.elements;
+	maybe_component_index_entry_t current;
+	uint64_t* merged_keys;
+	maybe_entity_t* merged_entities;
+	maybe_vector_t swapped;
+	uint32_t merged_length = index->keys.length + index->insertions.length - index->removals.length;
+	uint32_t i = 0, inserted = 0, removed = 0, merged = 0;
+
+	result = maybe_vector_reserve(&index->merged_keys, merged_length);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_reserve(&index->merged_entities, merged_length);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	merged_keys = (uint64_t*)index->merged_keys.elements;
+	merged_entities = (maybe_entity_t*)index->merged_entities.elements;
+
+	/* Only the batch is sorted, the index is merged with it in order */
+	qsort(insertions, index->insertions.length, sizeof(maybe_component_index_entry_t), compare_entries);
+	qsort(removals, index->removals.length, sizeof(maybe_component_index_entry_t), compare_entries);
+
+	for (i = 0; i < index->keys.length; i++) {
+		current.key = MAYBE_VECTOR_ELEMENT(index->keys, uint64_t, i);
+		current.entity = MAYBE_VECTOR_ELEMENT(index->entities, maybe_entity_t, i);
+
+		while ((inserted < index->insertions.length) && (compare_entries(&insertions[inserted], &current) < 0)) {
+			merged_keys[merged] = insertions[inserted].key;
+			merged_entities[merged] = insertions[inserted].entity;
+			merged++;
+			inserted++;
+		}
+
+		if ((removed < index->removals.length) && (0 == compare_entries(&removals[removed], &current))) {
+			removed++;
+			continue;
+		}
+
+		merged_keys[merged] = current.key;
+		merged_entities[merged] = current.entity;
+		merged++;
+	}
+
+	for (; inserted < index->insertions.length; inserted++) {
+		merged_keys[merged] = insertions[inserted].key;
+		merged_entities[merged] = insertions[inserted].entity;
+		merged++;
+	}
+
+	index->merged_keys.length = merged;
+	index->merged_entities.length = merged;
+
+	swapped = index->keys;
+	index->keys = index->merged_keys;
+	index->merged_keys = swapped;
+
+	swapped = index->entities;
+	index->entities = index->merged_entities;
+	index->merged_entities = swapped;
+
+	index->insertions.length = 0;
+	index->removals.length = 0;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+int compare_entries(
+	const void* first,
+	const void* second
+) {
+	const maybe_component_index_entry_t* first_entry = (const maybe_component_index_entry_t*)first;
+	const maybe_component_index_entry_t* second_entry = (const maybe_component_index_entry_t*)second;
+
+	if (first_entry->key != second_entry->key) {
+		return (first_entry->key < second_entry->key) ? -1 : 1;
+	}
+
+	if (first_entry->entity != second_entry->entity) {
+		return (first_entry->entity < second_entry->entity) ? -1 : 1;
+	}
+
+	return 0;
+}
+
+uint32_t lower_bound(
+	const maybe_component_index_t* index,
+	uint64_t key
+) {
+	const uint64_t* keys = (const uint64_t*)index->keys.elements;
+	uint32_t first = 0;
+	uint32_t end = index->keys.length;
+	uint32_t middle;
+
+	while (first < end) {
+		middle = first + (end - first) / 2;
+		if (keys[middle] < key) {
+			first = middle + 1;
+		} else {
+			end = middle;
+		}
+	}
+
+	return first;
+}
+
+maybe_error_t clear(
+	maybe_component_index_t* index
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t i;
+
+	/* Maps cannot be emptied in place, so they are recreated */
+	if (index->is_records_initialized) {
+		index->is_records_initialized = false;
+		result = maybe_map_free(&index->records);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = maybe_map_init(&index->records, sizeof(maybe_entity_t), sizeof(maybe_component_index_record_t), 0, maybe_map_default_hash_function);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	index->is_records_initialized = true;
+
+	if (index->is_buckets_initialized) {
+		index->is_buckets_initialized = false;
+		result = maybe_map_free(&index->buckets);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = maybe_map_init(&index->buckets, sizeof(uint64_t), sizeof(uint32_t), 0, maybe_map_default_hash_function);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	index->is_buckets_initialized = true;
+
+	/* Every bucket is emptied and reused */
+	result = maybe_vector_reserve(&index->free_buckets, index->bucket_entities.length);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	index->free_buckets.length = 0;
+	for (i = 0; i < index->bucket_entities.length; i++) {
+		MAYBE_VECTOR_ELEMENT(index->bucket_entities, maybe_vector_t, i).length = 0;
+		MAYBE_VECTOR_ELEMENT(index->free_buckets, uint32_t, i) = i;
+	}
+	index->free_buckets.length = index->bucket_entities.length;
+
+	index->keys.length = 0;
+	index->entities.length = 0;
+	index->insertions.length = 0;
+	index->removals.length = 0;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
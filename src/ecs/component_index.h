@@ -0,0 +1,183 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "common/error.h"
+#include "common/vector/vector.h"
+#include "common/map/map.h"
+#include "entity.h"
+#include "observer.h"
+#include "ecs.h"
+
+/*
+ * Component indexes
+ *
+ * A component index maps the value of a field of a component to the entities that have it, so lookups
+ * like "the entity whose player_id is X" or "every entity of faction F" do not scan the world:
+ *
+ * 		maybe_component_index_init(&index, &world, (maybe_component_index_config_t){
+ * 			MAYBE_COMPONENT_ID(faction_t), offsetof(faction_t, id), MAYBE_COMPONENT_INDEX_FIELD_UINT32, MAYBE_COMPONENT_INDEX_HASH
+ * 		});
+ * 		...
+ * 		uint32_t faction = 3;
+ * 		maybe_component_index_find(&index, &faction, &entities, &entity_count);
+ *
+ * A hash index finds the entities with a value in O(1). A sorted index keeps the entities ordered by
+ * value, finds a value in O(log n) and can also find every value in a range.
+ *
+ * The index observes the component's add, remove and set events (see maybe_world_add_observer), so it
+ * is updated once per observer flush with all the entities that changed, and reads their values as
+ * they are at the flush. Values written through column pointers, like in systems, do not raise an
+ * event: entities whose indexed field is written that way must be passed to
+ * maybe_component_index_refresh, or the index rebuilt.
+ *
+ * Lookups see the world as of the last flush, the world flushes after every tick and
+ * maybe_world_flush_observers flushes between ticks.
+ * */
+
+/* @brief The kind of structure a component index keeps */
+typedef enum {
+	MAYBE_COMPONENT_INDEX_HASH, /* Finds equal values */
+	MAYBE_COMPONENT_INDEX_SORTED /* Finds equal values and ranges of values */
+} maybe_component_index_type_t;
+
+/* @brief The type of an indexed field */
+typedef enum {
+	MAYBE_COMPONENT_INDEX_FIELD_UINT32,
+	MAYBE_COMPONENT_INDEX_FIELD_INT32,
+	MAYBE_COMPONENT_INDEX_FIELD_UINT64,
+	MAYBE_COMPONENT_INDEX_FIELD_INT64,
+	MAYBE_COMPONENT_INDEX_FIELD_FLOAT
+} maybe_component_index_field_t;
+
+/* @brief Which field of which component an index is on */
+typedef struct {
+	uint32_t component_id;
+	uint32_t offset; /* The byte offset of the field in the component */
+	maybe_component_index_field_t field;
+	maybe_component_index_type_t type;
+} maybe_component_index_config_t;
+
+/* @brief Where an indexed entity is in its index */
+typedef struct {
+	uint64_t key; /* The entity's value as a key, see maybe_component_index_get_key */
+	uint32_t position; /* The entity's position in its key's bucket, only used by hash indexes */
+} maybe_component_index_record_t;
+
+/* @brief An entity whose key changed, waiting to be merged into a sorted index */
+typedef struct {
+	uint64_t key;
+	maybe_entity_t entity;
+} maybe_component_index_entry_t;
+
+/* @brief An index of the entities that have a component, by the value of one of its fields */
+typedef struct {
+	maybe_component_index_config_t config;
+	uint32_t field_size;
+	maybe_world_t* world;
+	MAYBE_MAP(maybe_entity_t, maybe_component_index_record_t) records; /* The key of every indexed entity */
+	bool is_records_initialized;
+	MAYBE_MAP(uint64_t, uint32_t) buckets; /* The bucket of every key, for hash indexes */
+	bool is_buckets_initialized;
+	MAYBE_VECTOR(maybe_vector_t) bucket_entities; /* The entities of every bucket, in no order */
+	MAYBE_VECTOR(uint32_t) free_buckets; /* Emptied buckets, reused for new keys */
+	MAYBE_VECTOR(uint64_t) keys; /* Sorted, for sorted indexes */
+	MAYBE_VECTOR(maybe_entity_t) entities; /* The entity of every key, entities with equal keys are sorted by ID */
+	MAYBE_VECTOR(maybe_component_index_entry_t) insertions; /* The entries a batch adds to a sorted index */
+	MAYBE_VECTOR(maybe_component_index_entry_t) removals; /* The entries a batch removes from a sorted index */
+	MAYBE_VECTOR(uint64_t) merged_keys; /* Used to merge a batch into a sorted index */
+	MAYBE_VECTOR(maybe_entity_t) merged_entities;
+	bool is_observing[MAYBE_OBSERVER_EVENT_COUNT];
+	bool is_stale; /* Set when a batch could not be applied, the index is rebuilt on the next lookup */
+} maybe_component_index_t;
+
+/*
+ * @brief Initialize a component index, with the entities that already have the component
+ *
+ * @param index A pointer to the new index, it must stay valid until it is freed
+ * @param world A pointer to the world, the index must be freed before it
+ * @param config The indexed component and field, and the type of the index
+ * */
+maybe_error_t maybe_component_index_init(
+	maybe_component_index_t* index,
+	maybe_world_t* world,
+	maybe_component_index_config_t config
+);
+
+/*
+ * @brief Find the entities whose field has a value
+ *
+ * @param index A pointer to the index
+ * @param value A pointer to the value, of the field's type
+ * @param entities Set to the entities, valid until the index changes
+ * @param entity_count Set to the number of entities
+ * */
+maybe_error_t maybe_component_index_find(
+	maybe_component_index_t* index,
+	const void* value,
+	const maybe_entity_t** entities,
+	uint32_t* entity_count
+);
+
+/*
+ * @brief Find the entities whose field is in a range of values, ordered by value
+ *
+ * @param index A pointer to the index, a sorted index
+ * @param min A pointer to the smallest value, of the field's type
+ * @param max A pointer to the largest value, of the field's type
+ * @param entities Set to the entities, valid until the index changes
+ * @param entity_count Set to the number of entities
+ * */
+maybe_error_t maybe_component_index_find_range(
+	maybe_component_index_t* index,
+	const void* min,
+	const void* max,
+	const maybe_entity_t** entities,
+	uint32_t* entity_count
+);
+
+/*
+ * @brief Update the index for entities whose field may have changed without an event
+ *
+ * @param index A pointer to the index
+ * @param entities The entities, entities that no longer have the component are removed from the index
+ * @param entity_count The number of entities
+ * */
+maybe_error_t maybe_component_index_refresh(
+	maybe_component_index_t* index,
+	const maybe_entity_t* entities,
+	uint32_t entity_count
+);
+
+/*
+ * @brief Rebuild an index from every entity that has the component
+ *
+ * @param index A pointer to the index
+ * */
+maybe_error_t maybe_component_index_rebuild(
+	maybe_component_index_t* index
+);
+
+/*
+ * @brief Convert a value of an index's field to its key, keys are ordered like the values
+ *
+ * -0.0f and +0.0f have the same key. NaNs are ordered by their bits: NaNs with the sign bit clear sort
+ * above +infinity and NaNs with it set below -infinity, and a NaN only finds NaNs with the same bits
+ *
+ * @param index A pointer to the index
+ * @param value A pointer to the value, of the field's type
+ * */
+uint64_t maybe_component_index_get_key(
+	const maybe_component_index_t* index,
+	const void* value
+);
+
+/*
+ * @brief Stop observing the world and free an index's resources
+ *
+ * @param index A pointer to the index
+ * */
+maybe_error_t maybe_component_index_free(
+	maybe_component_index_t* index
+);
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "component_index.h"
+
+/*
+ * @brief Get the size of a field type
+ *
+ * @param field The field type
+ *
+ * @return The size in bytes, 0 if the type is unknown
+ * */
+static uint32_t get_field_size(
+	maybe_component_index_field_t field
+);
+
+/*
+ * @brief The observer of the indexed component's events, updates the index with the batch's entities
+ * */
+static void observe(
+	void* world,
+	uint32_t component_id,
+	maybe_observer_event_t event,
+	const maybe_entity_t* entities,
+	uint32_t entity_count,
+	void* context
+);
+
+/*
+ * @brief Read an entity's key from the world
+ *
+ * @param index The index
+ * @param entity The entity
+ * @param key Set to the entity's key
+ *
+ * @return Whether the entity exists and has the indexed component
+ * */
+static bool read_key(
+	maybe_component_index_t* index,
+	maybe_entity_t entity,
+	uint64_t* key
+);
+
+/*
+ * @brief Bring the index up to date with the current keys of some entities
+ *
+ * @param index The index
+ * @param entities The entities, in any order and possibly repeated
+ * @param entity_count The number of entities
+ * */
+static maybe_error_t update_entities(
+	maybe_component_index_t* index,
+	const maybe_entity_t* entities,
+	uint32_t entity_count
+);
+
+/*
+ * @brief Update the records of some entities, applying the changes to a hash index and queueing them for a sorted one
+ *
+ * @param index The index
+ * @param entities The entities
+ * @param entity_count The number of entities
+ * */
+static maybe_error_t collect_entities(
+	maybe_component_index_t* index,
+	const maybe_entity_t* entities,
+	uint32_t entity_count
+);
+
+/*
+ * @brief Add an entity to the bucket of its key in a hash index
+ *
+ * @param index The index
+ * @param key The key
+ * @param entity The entity
+ * @param position Set to the entity's position in the bucket
+ * */
+static maybe_error_t insert_into_bucket(
+	maybe_component_index_t* index,
+	uint64_t key,
+	maybe_entity_t entity,
+	uint32_t* position
+);
+
+/*
+ * @brief Remove an entity from the bucket of its key in a hash index, the bucket is freed once it is empty
+ *
+ * @param index The index
+ * @param key The key
+ * @param position The entity's position in the bucket
+ * */
+static maybe_error_t remove_from_bucket(
+	maybe_component_index_t* index,
+	uint64_t key,
+	uint32_t position
+);
+
+/*
+ * @brief Merge a batch's insertions and removals into a sorted index, in one pass over it
+ *
+ * @param index The index
+ * */
+static maybe_error_t merge_batch(
+	maybe_component_index_t* index
+);
+
+/*
+ * @brief Compare entries by key and then by entity, for qsort
+ * */
+static int compare_entries(
+	const void* first,
+	const void* second
+);
+
+/*
+ * @brief Find the first key of a sorted index that is not less than a key
+ *
+ * @param index The index
+ * @param key The key
+ *
+ * @return The position of the key, the number of keys if every key is less
+ * */
+static uint32_t lower_bound(
+	const maybe_component_index_t* index,
+	uint64_t key
+);
+
+/*
+ * @brief Empty an index, keeping the memory of its vectors
+ *
+ * @param index The index
+ * */
+static maybe_error_t clear(
+	maybe_component_index_t* index
+);
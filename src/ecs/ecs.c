@@ -3,12 +3,18 @@
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "common/error.h"
 #include "common/common.h"
 #include "common/map/map.h"
+#include "time/time.h"
 
 #include "ecs.h"
+#include "spatial.h"
+#include "shared.h"
+#include "export.h"
+#include "read_guard.h"
 #include "ecs_internal.h"
 
 maybe_error_t maybe_world_init(
@@ -21,12 +27,12 @@ maybe_error_t maybe_world_init(
 		goto l_cleanup;
 	}
 
-	result = maybe_map_init(&world->entities, sizeof(maybe_world_record_t), 0, maybe_map_default_hash_function);
+	result = maybe_map_init(&world->entities, sizeof(maybe_entity_t), sizeof(maybe_world_record_t), 0, maybe_map_default_hash_function);
 	if (IS_FAILURE(result)) {
 		goto l_cleanup;
 	}
 
-	result = maybe_vector_init(&world->archetypes, sizeof(maybe_archetype_t), 0);
+	result = maybe_vector_init(&world->archetypes, sizeof(maybe_archetype_t*), 0);
 	if (IS_FAILURE(result)) {
 		goto l_cleanup;
 	}
@@ -41,8 +47,33 @@ maybe_error_t maybe_world_init(
 		goto l_cleanup;
 	}
 
+	result = maybe_vector_init(&world->spatial_indexes, sizeof(maybe_spatial_index_t*), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&world->observer_queues, sizeof(maybe_observer_queue_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
 	world->next_entity_id = 0;
 	world->next_component_id = 0;
+	world->fixed_timestep = MAYBE_WORLD_DEFAULT_FIXED_TIMESTEP;
+	world->accumulator = 0.0;
+	world->max_fixed_steps = MAYBE_WORLD_DEFAULT_MAX_FIXED_STEPS;
+	world->fixed_tick = 0;
+	world->variable_tick = 0;
+	world->compact_cursor = 0;
+	world->thread_pool = NULL;
+	world->has_pending_observer_events = false;
+	world->is_flushing_observers = false;
+	world->fork_parent = NULL;
+	world->fork_count = 0;
+	world->page_store = NULL;
+	world->access_tick = 0;
+	world->world_export = NULL;
+	world->read_guard = NULL;
 
 	result = MAYBE_ERROR_SUCCESS;
 l_cleanup:
@@ -55,14 +86,24 @@ maybe_error_t maybe_world_add_component_type(
 	uint32_t* component_id
 ) {
 	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_component_type_t component_type;
+	uint32_t i;
 
 	if ((NULL == world) || (NULL == component_id)) {
 		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
 		goto l_cleanup;
 	}
 
+	component_type.id = world->next_component_id;
+	component_type.component_size = component_size;
+	component_type.observed_events = 0;
+	component_type.shared_store = NULL;
+	for (i = 0; i < MAYBE_OBSERVER_EVENT_COUNT; i++) {
+		component_type.observer_queues[i] = MAYBE_WORLD_NO_OBSERVER_QUEUE;
+	}
+
 	/* Add component type info to component types */
-	result = maybe_vector_push(&world->component_types, (void*)&(maybe_component_type_t){ world->next_component_id, component_size });
+	result = maybe_vector_push(&world->component_types, (void*)&component_type);
 	if (IS_FAILURE(result)) {
 		goto l_cleanup;
 	}
@@ -75,99 +116,132 @@ l_cleanup:
 	return result;
 }
 
-maybe_error_t maybe_world_add_entity(
+maybe_error_t maybe_world_add_shared_component_type(
 	maybe_world_t* world,
-	uint32_t component_count,
-	maybe_entity_t* entity_id,
-	...
+	uint32_t component_size,
+	uint32_t* component_id
 ) {
 	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
-	maybe_error_t system_result = MAYBE_ERROR_UNINITIALIZED;
-	va_list args;
-	uint32_t i, component_id;
-	uint32_t* component_ids = NULL;
-	uint32_t* component_indices = NULL;
-	maybe_vector_t* component_vector = NULL;
-	maybe_archetype_t* archetype = NULL;
+	maybe_shared_store_t* store = NULL;
 
-	if ((NULL == world) || (NULL == entity_id)) {
+	if ((NULL == world) || (NULL == component_id)) {
 		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
 		goto l_cleanup;
 	}
 
-	/* Allocate memory for the list of component ids */
-	component_ids = (uint32_t*)malloc(component_count * sizeof(uint32_t));
-	if (NULL == component_ids) {
-		result = MAYBE_ERROR_ECS_WORLD_ALLOCATION_FAILED;
+	if (0 == component_size) {
+		result = MAYBE_ERROR_ECS_WORLD_INVALID_PARAM;
 		goto l_cleanup;
 	}
 
-	component_indices = (uint32_t*)malloc(component_count * sizeof(uint32_t));
-	if (NULL == component_indices) {
+	store = MALLOC_T(maybe_shared_store_t, 1);
+	if (NULL == store) {
 		result = MAYBE_ERROR_ECS_WORLD_ALLOCATION_FAILED;
 		goto l_cleanup;
 	}
 
-	va_start(args, entity_id);
+	result = maybe_shared_store_init(store, component_size);
+	if (IS_FAILURE(result)) {
+		free(store);
+		store = NULL;
+		goto l_cleanup;
+	}
 
-	/* Get all component ids */
-	for (i = 0; i < component_count; i++) {
-		component_id = va_arg(args, uint32_t);
-		component_ids[i] = component_id;
-	}	
+	result = maybe_world_add_component_type(world, component_size, component_id);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
 
-	archetype = find_matching_archetype(world, component_ids, component_count, component_indices);
+	/* The store is now owned by the world */
+	MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, *component_id).shared_store = store;
+	store = NULL;
 
-	/* If no mathing archetype was found, create a new one */
-	if (!archetype) {
-		result = maybe_vector_push(&world->archetypes, NULL);
-		if (IS_FAILURE(result)) {
-			goto l_cleanup;
-		}
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (store) {
+		(void)maybe_shared_store_free(store);
+		free(store);
+	}
 
-		/* Initialize the archetype */
-		archetype = &MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t, world->archetypes.length - 1);
-		result = maybe_archetype_init(archetype);
-		if (IS_FAILURE(result)) {
-			goto l_cleanup;
-		}
+	return result;
+}
 
-		/* Add the entity's component types to the archetype */
-		for (i = 0; i < component_count; i++) {
-			component_indices[i] = i;
-			result = maybe_archetype_add_component_type(
-				archetype, 
-				component_ids[i],
-				MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, component_ids[i]).component_size
-			);
-			if (IS_FAILURE(result)) {
-				goto l_cleanup;
-			}
-		}
+maybe_error_t maybe_world_add_component_types(
+	maybe_world_t* world,
+	uint32_t component_count,
+	const maybe_component_descriptor_t* descriptors
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t i, component_id;
 
-		/* Try to add the new archetype to all systems */
-		for (i = 0; i < world->systems.length; i++) {
-			system_result = maybe_system_add_archetype(&MAYBE_VECTOR_ELEMENT(world->systems, maybe_system_t, i), archetype);
-			if (IS_FAILURE(system_result)) {
-				if (MAYBE_ERROR_SYSTEM_BAD_ARCHETYPE != system_result) {
-					result = system_result;
-					goto l_cleanup;
-				}
-			}
+	if ((NULL == world) || ((NULL == descriptors) && (0 != component_count))) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Check everything first, so a bad manifest adds no component type at all */
+	for (i = 0; i < component_count; i++) {
+		if ((descriptors[i].id != world->next_component_id + i) ||
+			(0 == descriptors[i].alignment) ||
+			(0 != (descriptors[i].alignment & (descriptors[i].alignment - 1))) ||
+			(descriptors[i].alignment > _Alignof(max_align_t)) ||
+			(0 != (descriptors[i].size % descriptors[i].alignment))) {
+			result = MAYBE_ERROR_ECS_WORLD_COMPONENT_MISMATCH;
+			goto l_cleanup;
 		}
 	}
 
-	/* Add the entity's components to the archetype */
 	for (i = 0; i < component_count; i++) {
-		component_vector = &MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, component_indices[i]);
+		if (descriptors[i].is_shared) {
+			result = maybe_world_add_shared_component_type(world, descriptors[i].size, &component_id);
+		} else {
+			result = maybe_world_add_component_type(world, descriptors[i].size, &component_id);
+		}
 
-		result = maybe_vector_push(component_vector, NULL);
 		if (IS_FAILURE(result)) {
 			goto l_cleanup;
 		}
 	}
 
-	world->next_entity_id++;
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_add_entity(
+	maybe_world_t* world,
+	uint32_t component_count,
+	maybe_entity_t* entity_id,
+	...
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	va_list args;
+	uint32_t i;
+	uint32_t* component_ids = NULL;
+
+	va_start(args, entity_id);
+
+	if ((NULL == world) || (NULL == entity_id)) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Allocate memory for the list of component ids */
+	component_ids = (uint32_t*)malloc(component_count * sizeof(uint32_t));
+	if (NULL == component_ids) {
+		result = MAYBE_ERROR_ECS_WORLD_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+
+	/* Get all component ids */
+	for (i = 0; i < component_count; i++) {
+		component_ids[i] = va_arg(args, uint32_t);
+	}	
+
+	result = maybe_world_add_entity_array(world, component_count, component_ids, entity_id);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
 
 	result = MAYBE_ERROR_SUCCESS;
 l_cleanup:
@@ -177,116 +251,202 @@ l_cleanup:
 		free(component_ids);
 	}
 
-	if (component_indices) {
-		free(component_indices);	
-	}
-
 	return result;
 }
 
-maybe_error_t maybe_world_register_system(
+maybe_error_t maybe_world_add_entity_array(
 	maybe_world_t* world,
-	maybe_system_function_t system_function,
 	uint32_t component_count,
-	...
+	uint32_t* component_ids,
+	maybe_entity_t* entity_id
 ) {
 	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
-	maybe_system_t system;
-	va_list components;
+	maybe_world_record_t record;
+	maybe_entity_t new_entity_id;
 
-	if (NULL == world) {
+	if ((NULL == world) || (NULL == entity_id) || ((NULL == component_ids) && (0 != component_count))) {
 		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
 		goto l_cleanup;
 	}
 
-	va_start(components, component_count);
+	/* The forks of a world look up its records, so they must not change */
+	if (world->fork_count > 0) {
+		result = MAYBE_ERROR_ECS_WORLD_HAS_FORKS;
+		goto l_cleanup;
+	}
 
-	/* Initialize the new system */
-	if (IS_FAILURE(maybe_system_init_va_list(&system, system_function, component_count, components))) {
+	result = check_unshared_components(world, component_ids, component_count);
+	if (IS_FAILURE(result)) {
 		goto l_cleanup;
 	}
 
-	/* Add system to vector */
-	if (IS_FAILURE(maybe_vector_push(&world->systems, &system))) {
+	result = get_or_create_archetype(world, component_ids, component_count, NULL, NULL, 0, &record.archetype_index);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* Add the entity's components to the archetype */
+	new_entity_id = world->next_entity_id;
+	result = maybe_archetype_add_row(
+		MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, record.archetype_index),
+		new_entity_id,
+		&record.row
+	);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* Save the entity's location */
+	result = maybe_map_set(&world->entities, &new_entity_id, sizeof(new_entity_id), &record);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	*entity_id = new_entity_id;
+	world->next_entity_id++;
+
+	result = queue_archetype_observer_events(
+		world,
+		MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, record.archetype_index),
+		MAYBE_OBSERVER_EVENT_ADD,
+		&new_entity_id,
+		1
+	);
+	if (IS_FAILURE(result)) {
 		goto l_cleanup;
 	}
 
 	result = MAYBE_ERROR_SUCCESS;
 l_cleanup:
-	va_end(components);
-
 	return result;
 }
 
-maybe_error_t maybe_world_update(
-	maybe_world_t* world
+maybe_error_t maybe_world_remove_entity(
+	maybe_world_t* world,
+	maybe_entity_t entity_id
 ) {
 	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
-	maybe_system_t* system;
-	uint32_t i;
+	maybe_world_record_t* record = NULL;
 
 	if (NULL == world) {
 		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
 		goto l_cleanup;
 	}
 
-	/* Call all systems */
-	for (i = 0; i < world->systems.length; i++) {
-		system = &MAYBE_VECTOR_ELEMENT(world->systems, maybe_system_t, i);
-		system->function((void*)system);
-	}	
+	if (world->fork_count > 0) {
+		result = MAYBE_ERROR_ECS_WORLD_HAS_FORKS;
+		goto l_cleanup;
+	}
+
+	result = find_record(world, entity_id, &record);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	if (NULL == record) {
+		result = MAYBE_ERROR_ECS_WORLD_ENTITY_NOT_FOUND;
+		goto l_cleanup;
+	}
+
+	result = queue_archetype_observer_events(
+		world,
+		MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, record->archetype_index),
+		MAYBE_OBSERVER_EVENT_REMOVE,
+		&entity_id,
+		1
+	);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = remove_entity_row(world, record);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = forget_record(world, entity_id);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
 
 	result = MAYBE_ERROR_SUCCESS;
 l_cleanup:
 	return result;
 }
 
-maybe_error_t maybe_world_free(
-	maybe_world_t* world
+maybe_error_t maybe_world_get_component(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	uint32_t component_id,
+	void** component
 ) {
 	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
-	maybe_error_t free_result;
-	uint8_t i = 0;
+	maybe_world_record_t* record = NULL;
+	maybe_archetype_t* archetype = NULL;
+	uint32_t component_index;
 
-	if (NULL == world) {
+	if ((NULL == world) || (NULL == component)) {
 		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
 		goto l_cleanup;
 	}
 
-	for (i = 0; i < world->archetypes.length; i++) {
-		free_result = maybe_archetype_free(&MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t, i));
-		if (IS_FAILURE(free_result)) {
-			result = free_result;
-		}
+	result = find_record(world, entity_id, &record);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
 	}
 
-	free_result = maybe_vector_free(&world->archetypes);
-	if (IS_FAILURE(free_result)) {
-		result = free_result;
+	if (NULL == record) {
+		result = MAYBE_ERROR_ECS_WORLD_ENTITY_NOT_FOUND;
+		goto l_cleanup;
 	}
 
-	free_result = maybe_vector_free(&world->component_types);
-	if (IS_FAILURE(free_result)) {
-		result = free_result;
+	archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, record->archetype_index);
+	if (!maybe_archetype_find_component(archetype, component_id, &component_index)) {
+		result = MAYBE_ERROR_ECS_WORLD_COMPONENT_NOT_FOUND;
+		goto l_cleanup;
 	}
 
-	for (i = 0; i < world->systems.length; i++) {
-		free_result = maybe_system_free(&MAYBE_VECTOR_ELEMENT(world->systems, maybe_system_t, i));
-		if (IS_FAILURE(free_result)) {
-			result = free_result;
-		}
+	/* The component may be written through the pointer */
+	result = maybe_archetype_make_column_writable(archetype, component_index);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
 	}
 
-	free_result = maybe_vector_free(&world->systems);
-	if (IS_FAILURE(free_result)) {
-		result = free_result;
+	*component = MAYBE_VECTOR_ELEMENT_VOID_PTR(MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, component_index), record->row);
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_set_entity_enabled(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	bool enabled
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_world_record_t* record = NULL;
+
+	if (NULL == world) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
 	}
 
-	free_result = maybe_map_free(&world->entities);
-	if (IS_FAILURE(free_result)) {
-		result = free_result;
+	result = find_record(world, entity_id, &record);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	if (NULL == record) {
+		result = MAYBE_ERROR_ECS_WORLD_ENTITY_NOT_FOUND;
+		goto l_cleanup;
 	}
 
+	result = maybe_archetype_set_row_enabled(
+		MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, record->archetype_index),
+		record->row,
+		enabled
+	);
 	if (IS_FAILURE(result)) {
 		goto l_cleanup;
 	}
@@ -296,45 +456,2929 @@ l_cleanup:
 	return result;
 }
 
-maybe_archetype_t* find_matching_archetype(
+maybe_error_t maybe_world_is_entity_enabled(
 	maybe_world_t* world,
-	uint32_t* component_ids,
-	uint32_t component_count,
-	uint32_t* component_indices
+	maybe_entity_t entity_id,
+	bool* enabled
 ) {
-	uint32_t i, j, k;
-	bool found_archetype, found_component;
-	maybe_archetype_t* archetype = NULL;
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_world_record_t* record = NULL;
 
-	/* @TODO Search smarter (Maybe by making the component IDs prime and multiplying them)  */
-	for (i = 0; i < world->archetypes.length; i++) {
-		archetype = &MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t, i);
+	if ((NULL == world) || (NULL == enabled)) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
 
-		if (archetype->component_types_count != component_count) {
-			continue;
-		}
+	result = find_record(world, entity_id, &record);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
 
-		found_archetype = true;
-		for (j = 0; j < archetype->component_types_count; j++) {
-			found_component = false;
-			for (k = 0; k < component_count; k++) {
-				if (component_ids[k] == MAYBE_VECTOR_ELEMENT(archetype->component_ids, uint32_t, j)) {
-					component_indices[k] = j;
-					found_component = true;
-					break;
-				}
-			}
+	if (NULL == record) {
+		result = MAYBE_ERROR_ECS_WORLD_ENTITY_NOT_FOUND;
+		goto l_cleanup;
+	}
 
-			if (!found_component) {
-				found_archetype = false;
-				break;
-			}
+	*enabled = maybe_archetype_is_row_enabled(
+		MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, record->archetype_index),
+		record->row
+	);
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_set_component(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	uint32_t component_id,
+	const void* value
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	void* component = NULL;
+
+	if ((NULL == world) || (NULL == value)) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = maybe_world_get_component(world, entity_id, component_id, &component);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	memcpy(component, value, MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, component_id).component_size);
+
+	result = queue_observer_events(world, component_id, MAYBE_OBSERVER_EVENT_SET, &entity_id, 1);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_set_shared_component(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	uint32_t component_id,
+	const void* value
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_world_record_t* record = NULL;
+	maybe_archetype_t* archetype = NULL;
+	maybe_shared_store_t* store;
+	uint32_t* shared_component_ids = NULL;
+	void** shared_values = NULL;
+	void* stored_value;
+	uint32_t i, archetype_index, shared_count;
+	bool had_component = false;
+
+	if ((NULL == world) || (NULL == value)) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if ((component_id >= world->component_types.length) ||
+		(NULL == MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, component_id).shared_store)) {
+		result = MAYBE_ERROR_ECS_WORLD_INVALID_PARAM;
+		goto l_cleanup;
+	}
+	store = MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, component_id).shared_store;
+
+	if (world->fork_count > 0) {
+		result = MAYBE_ERROR_ECS_WORLD_HAS_FORKS;
+		goto l_cleanup;
+	}
+
+	result = find_record(world, entity_id, &record);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	if (NULL == record) {
+		result = MAYBE_ERROR_ECS_WORLD_ENTITY_NOT_FOUND;
+		goto l_cleanup;
+	}
+
+	result = maybe_shared_store_intern(store, value, &stored_value);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* The new shared values are the current ones, with this component's value replaced or appended */
+	archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, record->archetype_index);
+	shared_count = archetype->shared_component_ids.length;
+	shared_component_ids = (uint32_t*)malloc((shared_count + 1) * sizeof(uint32_t));
+	shared_values = (void**)malloc((shared_count + 1) * sizeof(void*));
+	if ((NULL == shared_component_ids) || (NULL == shared_values)) {
+		result = MAYBE_ERROR_ECS_WORLD_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < shared_count; i++) {
+		shared_component_ids[i] = MAYBE_VECTOR_ELEMENT(archetype->shared_component_ids, uint32_t, i);
+		shared_values[i] = MAYBE_VECTOR_ELEMENT(archetype->shared_values, void*, i);
+		if (shared_component_ids[i] == component_id) {
+			shared_values[i] = stored_value;
+			had_component = true;
+		}
+	}
+
+	if (!had_component) {
+		shared_component_ids[shared_count] = component_id;
+		shared_values[shared_count] = stored_value;
+		shared_count++;
+	}
+
+	result = get_or_create_archetype(
+		world,
+		(uint32_t*)archetype->component_ids.elements,
+		archetype->component_types_count,
+		shared_component_ids,
+		shared_values,
+		shared_count,
+		&archetype_index
+	);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* Setting the value the entity already has does not move it */
+	if (archetype_index != record->archetype_index) {
+		result = move_entity(world, entity_id, record, archetype_index);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = queue_observer_events(
+		world,
+		component_id,
+		had_component ? MAYBE_OBSERVER_EVENT_SET : MAYBE_OBSERVER_EVENT_ADD,
+		&entity_id,
+		1
+	);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (shared_component_ids) {
+		free(shared_component_ids);
+	}
+
+	if (shared_values) {
+		free(shared_values);
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_world_get_shared_component(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	uint32_t component_id,
+	const void** value
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_world_record_t* record = NULL;
+	void* stored_value;
+
+	if ((NULL == world) || (NULL == value)) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = find_record(world, entity_id, &record);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	if (NULL == record) {
+		result = MAYBE_ERROR_ECS_WORLD_ENTITY_NOT_FOUND;
+		goto l_cleanup;
+	}
+
+	if (!maybe_archetype_find_shared_component(
+		MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, record->archetype_index),
+		component_id,
+		&stored_value
+	)) {
+		result = MAYBE_ERROR_ECS_WORLD_COMPONENT_NOT_FOUND;
+		goto l_cleanup;
+	}
+
+	*value = stored_value;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_remove_shared_component(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	uint32_t component_id
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_world_record_t* record = NULL;
+	maybe_archetype_t* archetype = NULL;
+	uint32_t* shared_component_ids = NULL;
+	void** shared_values = NULL;
+	uint32_t i, archetype_index, shared_count = 0;
+	void* stored_value;
+
+	if (NULL == world) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (world->fork_count > 0) {
+		result = MAYBE_ERROR_ECS_WORLD_HAS_FORKS;
+		goto l_cleanup;
+	}
+
+	result = find_record(world, entity_id, &record);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	if (NULL == record) {
+		result = MAYBE_ERROR_ECS_WORLD_ENTITY_NOT_FOUND;
+		goto l_cleanup;
+	}
+
+	archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, record->archetype_index);
+	if (!maybe_archetype_find_shared_component(archetype, component_id, &stored_value)) {
+		result = MAYBE_ERROR_ECS_WORLD_COMPONENT_NOT_FOUND;
+		goto l_cleanup;
+	}
+
+	/* The new shared values are the current ones without the removed component */
+	shared_component_ids = (uint32_t*)malloc(archetype->shared_component_ids.length * sizeof(uint32_t));
+	shared_values = (void**)malloc(archetype->shared_component_ids.length * sizeof(void*));
+	if ((NULL == shared_component_ids) || (NULL == shared_values)) {
+		result = MAYBE_ERROR_ECS_WORLD_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < archetype->shared_component_ids.length; i++) {
+		if (MAYBE_VECTOR_ELEMENT(archetype->shared_component_ids, uint32_t, i) != component_id) {
+			shared_component_ids[shared_count] = MAYBE_VECTOR_ELEMENT(archetype->shared_component_ids, uint32_t, i);
+			shared_values[shared_count] = MAYBE_VECTOR_ELEMENT(archetype->shared_values, void*, i);
+			shared_count++;
+		}
+	}
+
+	result = get_or_create_archetype(
+		world,
+		(uint32_t*)archetype->component_ids.elements,
+		archetype->component_types_count,
+		shared_component_ids,
+		shared_values,
+		shared_count,
+		&archetype_index
+	);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = move_entity(world, entity_id, record, archetype_index);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = queue_observer_events(world, component_id, MAYBE_OBSERVER_EVENT_REMOVE, &entity_id, 1);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (shared_component_ids) {
+		free(shared_component_ids);
+	}
+
+	if (shared_values) {
+		free(shared_values);
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_world_add_component(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	uint32_t component_id
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_world_record_t* record = NULL;
+	maybe_archetype_t* archetype = NULL;
+	uint32_t* component_ids = NULL;
+	uint32_t component_index, archetype_index;
+
+	if (NULL == world) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (world->fork_count > 0) {
+		result = MAYBE_ERROR_ECS_WORLD_HAS_FORKS;
+		goto l_cleanup;
+	}
+
+	result = find_record(world, entity_id, &record);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	if (NULL == record) {
+		result = MAYBE_ERROR_ECS_WORLD_ENTITY_NOT_FOUND;
+		goto l_cleanup;
+	}
+
+	result = check_unshared_components(world, &component_id, 1);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, record->archetype_index);
+	if (maybe_archetype_find_component(archetype, component_id, &component_index)) {
+		result = MAYBE_ERROR_ECS_WORLD_COMPONENT_ALREADY_EXISTS;
+		goto l_cleanup;
+	}
+
+	/* The new component set is the current one with the new component appended */
+	component_ids = (uint32_t*)malloc((archetype->component_types_count + 1) * sizeof(uint32_t));
+	if (NULL == component_ids) {
+		result = MAYBE_ERROR_ECS_WORLD_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+
+	memcpy(component_ids, archetype->component_ids.elements, archetype->component_types_count * sizeof(uint32_t));
+	component_ids[archetype->component_types_count] = component_id;
+
+	result = get_or_create_archetype(
+		world,
+		component_ids,
+		archetype->component_types_count + 1,
+		(uint32_t*)archetype->shared_component_ids.elements,
+		(void**)archetype->shared_values.elements,
+		archetype->shared_component_ids.length,
+		&archetype_index
+	);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = move_entity(world, entity_id, record, archetype_index);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = queue_observer_events(world, component_id, MAYBE_OBSERVER_EVENT_ADD, &entity_id, 1);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (component_ids) {
+		free(component_ids);
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_world_remove_component(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	uint32_t component_id
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_world_record_t* record = NULL;
+	maybe_archetype_t* archetype = NULL;
+	uint32_t* component_ids = NULL;
+	uint32_t i, component_index, archetype_index, component_count = 0;
+
+	if (NULL == world) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (world->fork_count > 0) {
+		result = MAYBE_ERROR_ECS_WORLD_HAS_FORKS;
+		goto l_cleanup;
+	}
+
+	result = find_record(world, entity_id, &record);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	if (NULL == record) {
+		result = MAYBE_ERROR_ECS_WORLD_ENTITY_NOT_FOUND;
+		goto l_cleanup;
+	}
+
+	archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, record->archetype_index);
+	if (!maybe_archetype_find_component(archetype, component_id, &component_index)) {
+		result = MAYBE_ERROR_ECS_WORLD_COMPONENT_NOT_FOUND;
+		goto l_cleanup;
+	}
+
+	/* The new component set is the current one without the removed component */
+	component_ids = (uint32_t*)malloc(archetype->component_types_count * sizeof(uint32_t));
+	if (NULL == component_ids) {
+		result = MAYBE_ERROR_ECS_WORLD_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < archetype->component_types_count; i++) {
+		if (i != component_index) {
+			component_ids[component_count] = MAYBE_VECTOR_ELEMENT(archetype->component_ids, uint32_t, i);
+			component_count++;
+		}
+	}
+
+	result = get_or_create_archetype(
+		world,
+		component_ids,
+		component_count,
+		(uint32_t*)archetype->shared_component_ids.elements,
+		(void**)archetype->shared_values.elements,
+		archetype->shared_component_ids.length,
+		&archetype_index
+	);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = move_entity(world, entity_id, record, archetype_index);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = queue_observer_events(world, component_id, MAYBE_OBSERVER_EVENT_REMOVE, &entity_id, 1);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (component_ids) {
+		free(component_ids);
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_world_remove_matching_entities(
+	maybe_world_t* world,
+	uint32_t component_count,
+	uint32_t* component_ids,
+	uint32_t* removed_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_archetype_t* archetype;
+	uint32_t i, row, count = 0;
+
+	if ((NULL == world) || ((NULL == component_ids) && (0 != component_count))) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (world->fork_count > 0) {
+		result = MAYBE_ERROR_ECS_WORLD_HAS_FORKS;
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < world->archetypes.length; i++) {
+		archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i);
+		if ((0 == archetype->entities.length) || !archetype_matches(archetype, component_ids, component_count)) {
+			continue;
+		}
+
+		result = queue_archetype_observer_events(
+			world,
+			archetype,
+			MAYBE_OBSERVER_EVENT_REMOVE,
+			(const maybe_entity_t*)archetype->entities.elements,
+			archetype->entities.length
+		);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		for (row = 0; row < archetype->entities.length; row++) {
+			result = forget_record(world, MAYBE_VECTOR_ELEMENT(archetype->entities, maybe_entity_t, row));
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+		}
+
+		/* No row survives, so the columns are truncated instead of swap removing row by row */
+		count += archetype->entities.length;
+		result = maybe_archetype_clear(archetype);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (removed_count) {
+		*removed_count = count;
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_world_add_component_to_matching(
+	maybe_world_t* world,
+	uint32_t component_id,
+	uint32_t component_count,
+	uint32_t* component_ids,
+	uint32_t* changed_count
+) {
+	return change_matching_components(world, component_id, true, component_count, component_ids, changed_count);
+}
+
+maybe_error_t maybe_world_remove_component_from_matching(
+	maybe_world_t* world,
+	uint32_t component_id,
+	uint32_t component_count,
+	uint32_t* component_ids,
+	uint32_t* changed_count
+) {
+	return change_matching_components(world, component_id, false, component_count, component_ids, changed_count);
+}
+
+maybe_error_t maybe_world_register_system(
+	maybe_world_t* world,
+	maybe_system_function_t system_function,
+	uint32_t component_count,
+	...
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	va_list components;
+
+	va_start(components, component_count);
+
+	result = register_system_va_list(world, system_function, (maybe_system_schedule_t){ MAYBE_SYSTEM_RATE_VARIABLE, 1, 0 }, component_count, components);
+
+	va_end(components);
+
+	return result;
+}
+
+maybe_error_t maybe_world_register_system_with_schedule(
+	maybe_world_t* world,
+	maybe_system_function_t system_function,
+	maybe_system_schedule_t schedule,
+	uint32_t component_count,
+	...
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	va_list components;
+
+	va_start(components, component_count);
+
+	result = register_system_va_list(world, system_function, schedule, component_count, components);
+
+	va_end(components);
+
+	return result;
+}
+
+maybe_error_t maybe_world_add_observer(
+	maybe_world_t* world,
+	uint32_t component_id,
+	maybe_observer_event_t event,
+	maybe_observer_function_t function,
+	void* context
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_component_type_t* component_type;
+	maybe_observer_queue_t queue;
+	maybe_observer_queue_t* queue_pointer;
+	bool is_queue_initialized = false;
+
+	if ((NULL == world) || (NULL == function)) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if ((component_id >= world->component_types.length) || (event >= MAYBE_OBSERVER_EVENT_COUNT)) {
+		result = MAYBE_ERROR_ECS_WORLD_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	component_type = &MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, component_id);
+
+	/* The queue is kept after its last observer is removed, so it is reused */
+	if (MAYBE_WORLD_NO_OBSERVER_QUEUE == component_type->observer_queues[event]) {
+		result = maybe_observer_queue_init(&queue, component_id, event);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+		is_queue_initialized = true;
+
+		result = maybe_vector_push(&world->observer_queues, &queue);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+		is_queue_initialized = false;
+
+		component_type->observer_queues[event] = world->observer_queues.length - 1;
+	}
+
+	queue_pointer = &MAYBE_VECTOR_ELEMENT(world->observer_queues, maybe_observer_queue_t, component_type->observer_queues[event]);
+	result = maybe_vector_push(&queue_pointer->observers, &(maybe_observer_t){ function, context });
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	component_type->observed_events |= (1u << event);
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (is_queue_initialized) {
+		(void)maybe_observer_queue_free(&queue);
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_world_remove_observer(
+	maybe_world_t* world,
+	uint32_t component_id,
+	maybe_observer_event_t event,
+	maybe_observer_function_t function,
+	void* context
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_component_type_t* component_type;
+	maybe_observer_queue_t* queue;
+	maybe_observer_t* observer;
+	uint32_t i;
+
+	if (NULL == world) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if ((component_id >= world->component_types.length) || (event >= MAYBE_OBSERVER_EVENT_COUNT)) {
+		result = MAYBE_ERROR_ECS_WORLD_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	component_type = &MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, component_id);
+	if (MAYBE_WORLD_NO_OBSERVER_QUEUE == component_type->observer_queues[event]) {
+		result = MAYBE_ERROR_ECS_WORLD_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	queue = &MAYBE_VECTOR_ELEMENT(world->observer_queues, maybe_observer_queue_t, component_type->observer_queues[event]);
+	for (i = 0; i < queue->observers.length; i++) {
+		observer = &MAYBE_VECTOR_ELEMENT(queue->observers, maybe_observer_t, i);
+		if ((observer->function == function) && (observer->context == context)) {
+			break;
+		}
+	}
+
+	if (i == queue->observers.length) {
+		result = MAYBE_ERROR_ECS_WORLD_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Keep the order, observers are called in the order they were added */
+	result = maybe_vector_remove(&queue->observers, i);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	if (0 == queue->observers.length) {
+		component_type->observed_events &= ~(1u << event);
+		queue->entities.length = 0;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_flush_observers(
+	maybe_world_t* world
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_observer_queue_t* queue;
+	maybe_observer_t observer;
+	maybe_vector_t entities;
+	uint32_t i, j;
+
+	if (NULL == world) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (world->is_flushing_observers) {
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	world->is_flushing_observers = true;
+
+	while (world->has_pending_observer_events) {
+		world->has_pending_observer_events = false;
+
+		for (i = 0; i < world->observer_queues.length; i++) {
+			queue = &MAYBE_VECTOR_ELEMENT(world->observer_queues, maybe_observer_queue_t, i);
+			if (0 == queue->entities.length) {
+				continue;
+			}
+
+			/* Events queued by the observers go to the other vector, and are flushed on the next round */
+			entities = queue->entities;
+			queue->entities = queue->flushing_entities;
+			queue->flushing_entities = entities;
+
+			/* Observers can add observers, which can move the queues and their observers */
+			for (j = 0; j < MAYBE_VECTOR_ELEMENT(world->observer_queues, maybe_observer_queue_t, i).observers.length; j++) {
+				queue = &MAYBE_VECTOR_ELEMENT(world->observer_queues, maybe_observer_queue_t, i);
+				observer = MAYBE_VECTOR_ELEMENT(queue->observers, maybe_observer_t, j);
+				observer.function(
+					(void*)world,
+					queue->component_id,
+					queue->event,
+					(const maybe_entity_t*)entities.elements,
+					entities.length,
+					observer.context
+				);
+			}
+
+			MAYBE_VECTOR_ELEMENT(world->observer_queues, maybe_observer_queue_t, i).flushing_entities.length = 0;
+		}
+	}
+
+	world->is_flushing_observers = false;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_update(
+	maybe_world_t* world
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_system_t* system;
+	uint32_t i;
+	bool is_export_begun = false;
+
+	if (NULL == world) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Readers of the export retry until the update is published */
+	if (world->world_export) {
+		result = maybe_world_export_begin(world->world_export);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+		is_export_begun = true;
+	}
+
+	result = rebuild_spatial_indexes(world, MAYBE_SYSTEM_RATE_FIXED);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = rebuild_spatial_indexes(world, MAYBE_SYSTEM_RATE_VARIABLE);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	world->access_tick++;
+
+	/* Call all systems */
+	for (i = 0; i < world->systems.length; i++) {
+		system = &MAYBE_VECTOR_ELEMENT(world->systems, maybe_system_t, i);
+		touch_system_columns(world, system);
+		maybe_system_run(system);
+	}	
+
+	result = maybe_world_flush_observers(world);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	if (world->world_export) {
+		result = maybe_world_export_publish(world->world_export);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	if (world->read_guard) {
+		result = maybe_world_read_guard_publish(world->read_guard);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	/* Readers would retry until the next successful call, so what was changed is published anyway */
+	if (IS_FAILURE(result) && is_export_begun) {
+		(void)maybe_world_export_publish(world->world_export);
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_world_set_fixed_timestep(
+	maybe_world_t* world,
+	double fixed_timestep,
+	uint32_t max_fixed_steps
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if (NULL == world) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (fixed_timestep <= 0.0) {
+		result = MAYBE_ERROR_ECS_WORLD_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	world->fixed_timestep = fixed_timestep;
+	world->max_fixed_steps = (0 == max_fixed_steps) ? MAYBE_WORLD_DEFAULT_MAX_FIXED_STEPS : max_fixed_steps;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_set_thread_pool(
+	maybe_world_t* world,
+	maybe_thread_pool_t* thread_pool
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if (NULL == world) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	world->thread_pool = thread_pool;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_advance(
+	maybe_world_t* world,
+	double delta_time
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t steps = 0;
+	bool is_export_begun = false;
+
+	if (NULL == world) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (delta_time < 0.0) {
+		result = MAYBE_ERROR_ECS_WORLD_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Readers of the export retry until the advance is published */
+	if (world->world_export) {
+		result = maybe_world_export_begin(world->world_export);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+		is_export_begun = true;
+	}
+
+	world->access_tick++;
+
+	/* Run a fixed tick for every whole timestep that accumulated */
+	world->accumulator += delta_time;
+	while (world->accumulator >= world->fixed_timestep) {
+		if (steps >= world->max_fixed_steps) {
+			/* Drop the time that can not be caught up with */
+			world->accumulator = 0.0;
+			break;
+		}
+
+		result = rebuild_spatial_indexes(world, MAYBE_SYSTEM_RATE_FIXED);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		run_scheduled_systems(world, MAYBE_SYSTEM_RATE_FIXED, world->fixed_tick, world->fixed_timestep);
+
+		result = maybe_world_flush_observers(world);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		world->accumulator -= world->fixed_timestep;
+		world->fixed_tick++;
+		steps++;
+	}
+
+	/* Run the variable rate systems once */
+	result = rebuild_spatial_indexes(world, MAYBE_SYSTEM_RATE_VARIABLE);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	run_scheduled_systems(world, MAYBE_SYSTEM_RATE_VARIABLE, world->variable_tick, delta_time);
+	world->variable_tick++;
+
+	result = maybe_world_flush_observers(world);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	if (world->world_export) {
+		result = maybe_world_export_publish(world->world_export);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	if (world->read_guard) {
+		result = maybe_world_read_guard_publish(world->read_guard);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	/* Readers would retry until the next successful call, so what was changed is published anyway */
+	if (IS_FAILURE(result) && is_export_begun) {
+		(void)maybe_world_export_publish(world->world_export);
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_world_compact(
+	maybe_world_t* world,
+	float fill_ratio,
+	uint64_t time_budget_ns,
+	bool* finished
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_archetype_t* archetype;
+	uint64_t start = maybe_time_get_monotonic_ns();
+	bool is_shared;
+
+	if (NULL == world) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (finished) {
+		*finished = false;
+	}
+
+	while (world->compact_cursor < world->archetypes.length) {
+		archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, world->compact_cursor);
+
+		/* Shrinking storage a fork shares would copy it, so it is left until the forks are freed */
+		is_shared = maybe_archetype_is_shared(archetype);
+
+		if (0 == archetype->entities.length) {
+			if (!archetype->is_parked && !is_shared) {
+				result = park_archetype(world, archetype);
+				if (IS_FAILURE(result)) {
+					goto l_cleanup;
+				}
+			}
+		} else if (!is_shared && (maybe_archetype_get_fill_ratio(archetype) < fill_ratio)) {
+			result = maybe_archetype_shrink(archetype);
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+		}
+
+		world->compact_cursor++;
+
+		/* Continue from the next archetype on the next call */
+		if ((0 != time_budget_ns) && ((maybe_time_get_monotonic_ns() - start) >= time_budget_ns)) {
+			break;
+		}
+	}
+
+	if (world->compact_cursor >= world->archetypes.length) {
+		world->compact_cursor = 0;
+		if (finished) {
+			*finished = true;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_set_page_store(
+	maybe_world_t* world,
+	maybe_page_store_t* store
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	const maybe_vector_allocator_t* allocator = maybe_page_store_get_allocator(store);
+	uint32_t i;
+
+	if (NULL == world) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Forks share columns, which can not move to another allocator on only one side */
+	if ((NULL != world->fork_parent) || (world->fork_count > 0)) {
+		result = MAYBE_ERROR_ECS_WORLD_HAS_FORKS;
+		goto l_cleanup;
+	}
+
+	/* The read guard has to retire the columns' storage, which the store frees itself */
+	if (NULL != world->read_guard) {
+		result = MAYBE_ERROR_ECS_WORLD_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	/* New archetypes are allocated from the store even if moving an existing one fails */
+	world->page_store = store;
+
+	for (i = 0; i < world->archetypes.length; i++) {
+		result = maybe_archetype_set_column_allocator(MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i), allocator);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_page_out(
+	maybe_world_t* world,
+	uint64_t idle_ticks,
+	uint32_t* paged_out_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_archetype_t* archetype;
+	maybe_vector_t* column;
+	uint32_t i, j, count = 0;
+
+	if (NULL == world) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (NULL == world->page_store) {
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < world->archetypes.length; i++) {
+		archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i);
+		if (archetype->is_paged_out || ((world->access_tick - archetype->last_access_tick) < idle_ticks)) {
+			continue;
+		}
+
+		for (j = 0; j < archetype->component_types_count; j++) {
+			column = &MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, j);
+			if (column->allocator != &world->page_store->allocator) {
+				continue;
+			}
+
+			result = maybe_page_store_evict(world->page_store, column->elements, (size_t)column->capacity * column->element_size);
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+		}
+
+		archetype->is_paged_out = true;
+		count++;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (paged_out_count) {
+		*paged_out_count = count;
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_world_prefetch(
+	maybe_world_t* world,
+	uint32_t component_count,
+	uint32_t* component_ids
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_archetype_t* archetype;
+	uint32_t i, j, column_index;
+
+	if ((NULL == world) || ((NULL == component_ids) && (0 != component_count))) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < world->archetypes.length; i++) {
+		archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i);
+		if (archetype->is_parked || !archetype_matches(archetype, component_ids, component_count)) {
+			continue;
+		}
+
+		archetype->last_access_tick = world->access_tick;
+		archetype->is_paged_out = false;
+
+		/* Shared components have no column */
+		for (j = 0; j < component_count; j++) {
+			if (maybe_archetype_find_component(archetype, component_ids[j], &column_index)) {
+				touch_column(world, archetype, column_index);
+			}
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_split_cold_columns(
+	maybe_world_t* world,
+	uint32_t min_access_count,
+	uint32_t* moved_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_archetype_t* archetype;
+	maybe_vector_t* column;
+	const maybe_vector_allocator_t* allocator;
+	uint32_t* access_count;
+	uint32_t i, j, count = 0;
+
+	if (NULL == world) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Cold columns have nowhere to go without a page store */
+	if (NULL == world->page_store) {
+		result = MAYBE_ERROR_ECS_WORLD_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	if ((NULL != world->fork_parent) || (world->fork_count > 0)) {
+		result = MAYBE_ERROR_ECS_WORLD_HAS_FORKS;
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < world->archetypes.length; i++) {
+		archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i);
+
+		for (j = 0; j < archetype->component_types_count; j++) {
+			column = &MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, j);
+			access_count = &MAYBE_VECTOR_ELEMENT(archetype->column_access_counts, uint32_t, j);
+
+			/* Hot columns stay on the heap, so paging the archetype out only drops its cold columns */
+			allocator = (*access_count < min_access_count) ? &world->page_store->allocator : NULL;
+			*access_count = 0;
+			if (column->allocator == allocator) {
+				continue;
+			}
+
+			result = maybe_vector_set_allocator(column, allocator);
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+
+			count++;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (moved_count) {
+		*moved_count = count;
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_world_swap_rows(
+	maybe_world_t* world,
+	uint32_t archetype_index,
+	uint32_t row_a,
+	uint32_t row_b
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_archetype_t* archetype;
+	maybe_world_record_t* record = NULL;
+
+	if (NULL == world) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (archetype_index >= world->archetypes.length) {
+		result = MAYBE_ERROR_ECS_WORLD_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	if (world->fork_count > 0) {
+		result = MAYBE_ERROR_ECS_WORLD_HAS_FORKS;
+		goto l_cleanup;
+	}
+
+	archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, archetype_index);
+	result = maybe_archetype_swap_rows(archetype, row_a, row_b);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = find_record(world, MAYBE_VECTOR_ELEMENT(archetype->entities, maybe_entity_t, row_a), &record);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	if (record) {
+		record->row = row_a;
+	}
+
+	result = find_record(world, MAYBE_VECTOR_ELEMENT(archetype->entities, maybe_entity_t, row_b), &record);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	if (record) {
+		record->row = row_b;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_merge(
+	maybe_world_t* destination,
+	maybe_world_t* source,
+	uint32_t* component_map,
+	maybe_vector_t* entity_map
+) {
+	return maybe_world_move_entities(destination, source, component_map, entity_map, 0);
+}
+
+maybe_error_t maybe_world_move_entities(
+	maybe_world_t* destination,
+	maybe_world_t* source,
+	uint32_t* component_map,
+	maybe_vector_t* entity_map,
+	uint32_t filter_count,
+	...
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_archetype_t* archetype;
+	va_list args;
+	uint32_t* filter_ids = NULL;
+	uint32_t i, j, component_index;
+	bool matches;
+
+	va_start(args, filter_count);
+
+	if ((NULL == destination) || (NULL == source)) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (destination == source) {
+		result = MAYBE_ERROR_ECS_WORLD_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	if ((destination->fork_count > 0) || (source->fork_count > 0)) {
+		result = MAYBE_ERROR_ECS_WORLD_HAS_FORKS;
+		goto l_cleanup;
+	}
+
+	if (filter_count > 0) {
+		filter_ids = (uint32_t*)malloc(filter_count * sizeof(uint32_t));
+		if (NULL == filter_ids) {
+			result = MAYBE_ERROR_ECS_WORLD_ALLOCATION_FAILED;
+			goto l_cleanup;
+		}
+
+		for (i = 0; i < filter_count; i++) {
+			filter_ids[i] = va_arg(args, uint32_t);
+		}
+	}
+
+	for (i = 0; i < source->archetypes.length; i++) {
+		archetype = MAYBE_VECTOR_ELEMENT(source->archetypes, maybe_archetype_t*, i);
+		if (0 == archetype->entities.length) {
+			continue;
+		}
+
+		/* Only move archetypes that have all the filter's components */
+		matches = true;
+		for (j = 0; j < filter_count; j++) {
+			if (!maybe_archetype_find_component(archetype, filter_ids[j], &component_index)) {
+				matches = false;
+				break;
+			}
+		}
+
+		if (!matches) {
+			continue;
+		}
+
+		result = transfer_archetype(destination, source, archetype, component_map, entity_map);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	va_end(args);
+
+	if (filter_ids) {
+		free(filter_ids);
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_world_fork(
+	maybe_world_t* fork,
+	maybe_world_t* parent
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_component_type_t component_type;
+	maybe_archetype_t* archetype = NULL;
+	maybe_system_t* parent_system;
+	maybe_system_t* system;
+	maybe_system_archetype_info_t info;
+	uint32_t i, j, archetype_index;
+	bool is_initialized = false;
+
+	if ((NULL == fork) || (NULL == parent)) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* The fork would share columns whose storage the parent's read guard retires */
+	if (NULL != parent->read_guard) {
+		result = MAYBE_ERROR_ECS_WORLD_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	result = maybe_world_init(fork);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	is_initialized = true;
+
+	fork->next_entity_id = parent->next_entity_id;
+	fork->next_component_id = parent->next_component_id;
+	fork->fixed_timestep = parent->fixed_timestep;
+	fork->accumulator = parent->accumulator;
+	fork->max_fixed_steps = parent->max_fixed_steps;
+	fork->fixed_tick = parent->fixed_tick;
+	fork->variable_tick = parent->variable_tick;
+	fork->thread_pool = parent->thread_pool;
+	fork->page_store = parent->page_store;
+	fork->access_tick = parent->access_tick;
+
+	/* The parent's observers are not notified of the fork's events */
+	for (i = 0; i < parent->component_types.length; i++) {
+		component_type = MAYBE_VECTOR_ELEMENT(parent->component_types, maybe_component_type_t, i);
+		component_type.observed_events = 0;
+		for (j = 0; j < MAYBE_OBSERVER_EVENT_COUNT; j++) {
+			component_type.observer_queues[j] = MAYBE_WORLD_NO_OBSERVER_QUEUE;
+		}
+
+		result = maybe_vector_push(&fork->component_types, &component_type);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	/* Every archetype keeps its index, so the parent's records are valid in the fork */
+	for (i = 0; i < parent->archetypes.length; i++) {
+		archetype = MALLOC_T(maybe_archetype_t, 1);
+		if (NULL == archetype) {
+			result = MAYBE_ERROR_ECS_WORLD_ALLOCATION_FAILED;
+			goto l_cleanup;
+		}
+
+		result = maybe_archetype_init_copy_on_write(archetype, MAYBE_VECTOR_ELEMENT(parent->archetypes, maybe_archetype_t*, i));
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		result = maybe_vector_push(&fork->archetypes, &archetype);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		/* The archetype is now owned by the fork */
+		archetype = NULL;
+	}
+
+	/* The systems iterate the fork's archetypes in the same order the parent's systems do */
+	for (i = 0; i < parent->systems.length; i++) {
+		parent_system = &MAYBE_VECTOR_ELEMENT(parent->systems, maybe_system_t, i);
+
+		result = maybe_vector_push(&fork->systems, parent_system);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		/* Until its own storage is allocated, the system must not free the parent's */
+		system = &MAYBE_VECTOR_ELEMENT(fork->systems, maybe_system_t, fork->systems.length - 1);
+		system->component_ids = NULL;
+		system->iterators = NULL;
+		system->archetypes.length = 0;
+		system->archetypes.elements = NULL;
+
+		result = maybe_vector_init(&system->archetypes, sizeof(maybe_system_archetype_info_t), parent_system->archetypes.length);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		system->component_ids = (uint32_t*)malloc(parent_system->component_count * sizeof(uint32_t));
+		system->iterators = MALLOC_T(maybe_system_component_iterator_t, parent_system->component_count);
+		if ((NULL == system->component_ids) || (NULL == system->iterators)) {
+			result = MAYBE_ERROR_ECS_WORLD_ALLOCATION_FAILED;
+			goto l_cleanup;
+		}
+		memcpy(system->component_ids, parent_system->component_ids, parent_system->component_count * sizeof(uint32_t));
+		memcpy(system->iterators, parent_system->iterators, parent_system->component_count * sizeof(maybe_system_component_iterator_t));
+
+		for (j = 0; j < parent_system->archetypes.length; j++) {
+			info = MAYBE_VECTOR_ELEMENT(parent_system->archetypes, maybe_system_archetype_info_t, j);
+			for (archetype_index = 0; archetype_index < parent->archetypes.length; archetype_index++) {
+				if (MAYBE_VECTOR_ELEMENT(parent->archetypes, maybe_archetype_t*, archetype_index) == info.archetype) {
+					break;
+				}
+			}
+
+			info.archetype = MAYBE_VECTOR_ELEMENT(fork->archetypes, maybe_archetype_t*, archetype_index);
+			info.slice_rows = NULL;
+			info.slice_starts = NULL;
+			info.slice_rows_capacity = 0;
+			info.slice_count = 0;
+			info.component_indices = (uint32_t*)malloc(parent_system->component_count * sizeof(uint32_t));
+			if (NULL == info.component_indices) {
+				result = MAYBE_ERROR_ECS_WORLD_ALLOCATION_FAILED;
+				goto l_cleanup;
+			}
+			memcpy(
+				info.component_indices,
+				MAYBE_VECTOR_ELEMENT(parent_system->archetypes, maybe_system_archetype_info_t, j).component_indices,
+				parent_system->component_count * sizeof(uint32_t)
+			);
+
+			result = maybe_vector_push(&system->archetypes, &info);
+			if (IS_FAILURE(result)) {
+				free(info.component_indices);
+				goto l_cleanup;
+			}
+		}
+	}
+
+	fork->fork_parent = parent;
+	parent->fork_count++;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (archetype) {
+		(void)maybe_archetype_free(archetype);
+		free(archetype);
+	}
+
+	if (IS_FAILURE(result) && is_initialized) {
+		/* The fork's shared stores belong to the parent */
+		fork->fork_parent = parent;
+		parent->fork_count++;
+		(void)maybe_world_free(fork);
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_world_free(
+	maybe_world_t* world
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_error_t free_result;
+	uint32_t i = 0;
+
+	if (NULL == world) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* The forks still use the world's columns, records and shared values */
+	if (world->fork_count > 0) {
+		result = MAYBE_ERROR_ECS_WORLD_HAS_FORKS;
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+
+	/* The export outlives the world, and frees the storage that was left in its store with it */
+	if (world->world_export) {
+		world->world_export->world = NULL;
+		world->world_export = NULL;
+	}
+
+	/* The guard outlives the world, the columns freed below are retired to it and freed with it */
+	if (world->read_guard) {
+		world->read_guard->world = NULL;
+		world->read_guard = NULL;
+	}
+
+	for (i = 0; i < world->archetypes.length; i++) {
+		free_result = maybe_archetype_free(MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i));
+		if (IS_FAILURE(free_result)) {
+			result = free_result;
+		}
+
+		free(MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i));
+	}
+
+	free_result = maybe_vector_free(&world->archetypes);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	/* A fork uses the shared stores of the world it was forked from */
+	for (i = 0; (i < world->component_types.length) && (NULL == world->fork_parent); i++) {
+		if (NULL == MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, i).shared_store) {
+			continue;
+		}
+
+		free_result = maybe_shared_store_free(MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, i).shared_store);
+		if (IS_FAILURE(free_result)) {
+			result = free_result;
+		}
+
+		free(MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, i).shared_store);
+	}
+
+	free_result = maybe_vector_free(&world->component_types);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	for (i = 0; i < world->systems.length; i++) {
+		free_result = maybe_system_free(&MAYBE_VECTOR_ELEMENT(world->systems, maybe_system_t, i));
+		if (IS_FAILURE(free_result)) {
+			result = free_result;
+		}
+	}
+
+	free_result = maybe_vector_free(&world->systems);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&world->spatial_indexes);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	for (i = 0; i < world->observer_queues.length; i++) {
+		free_result = maybe_observer_queue_free(&MAYBE_VECTOR_ELEMENT(world->observer_queues, maybe_observer_queue_t, i));
+		if (IS_FAILURE(free_result)) {
+			result = free_result;
+		}
+	}
+
+	free_result = maybe_vector_free(&world->observer_queues);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_map_free(&world->entities);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	if (world->fork_parent) {
+		world->fork_parent->fork_count--;
+		world->fork_parent = NULL;
+	}
+
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_archetype_t* find_matching_archetype(
+	maybe_world_t* world,
+	uint32_t* component_ids,
+	uint32_t component_count,
+	uint32_t* shared_component_ids,
+	void** shared_values,
+	uint32_t shared_count,
+	uint32_t* component_indices,
+	uint32_t* archetype_index
+) {
+	uint32_t i, j, k;
+	bool found_archetype, found_component;
+	maybe_archetype_t* archetype = NULL;
+	void* shared_value;
+	uint64_t mask = maybe_archetype_get_component_mask(component_ids, component_count) |
+					maybe_archetype_get_component_mask(shared_component_ids, shared_count);
+
+	/* @TODO Search smarter (Maybe by making the component IDs prime and multiplying them)  */
+	for (i = 0; i < world->archetypes.length; i++) {
+		archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i);
+
+		/* Equal component sets have equal masks, so most archetypes are ruled out without comparing IDs */
+		if ((archetype->component_mask != mask) ||
+			(archetype->component_types_count != component_count) ||
+			(archetype->shared_component_ids.length != shared_count)) {
+			continue;
+		}
+
+		/* Stored shared values are unique, so equal values have equal addresses */
+		found_archetype = true;
+		for (j = 0; j < shared_count; j++) {
+			if (!maybe_archetype_find_shared_component(archetype, shared_component_ids[j], &shared_value) ||
+				(shared_value != shared_values[j])) {
+				found_archetype = false;
+				break;
+			}
+		}
+
+		if (!found_archetype) {
+			continue;
+		}
+
+		for (j = 0; j < archetype->component_types_count; j++) {
+			found_component = false;
+			for (k = 0; k < component_count; k++) {
+				if (component_ids[k] == MAYBE_VECTOR_ELEMENT(archetype->component_ids, uint32_t, j)) {
+					if (component_indices) {
+						component_indices[k] = j;
+					}
+					found_component = true;
+					break;
+				}
+			}
+
+			if (!found_component) {
+				found_archetype = false;
+				break;
+			}
+		}
+
+		if (found_archetype) {
+			*archetype_index = i;
+			return archetype;
+		}
+	}
+	
+	return NULL;
+}
+
+maybe_error_t get_or_create_archetype(
+	maybe_world_t* world,
+	uint32_t* component_ids,
+	uint32_t component_count,
+	uint32_t* shared_component_ids,
+	void** shared_values,
+	uint32_t shared_count,
+	uint32_t* archetype_index
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_error_t system_result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_archetype_t* archetype = NULL;
+	maybe_archetype_t* new_archetype = NULL;
+	uint32_t i;
+
+	archetype = find_matching_archetype(
+		world,
+		component_ids,
+		component_count,
+		shared_component_ids,
+		shared_values,
+		shared_count,
+		NULL,
+		archetype_index
+	);
+	if (NULL != archetype) {
+		/* An entity is about to be added to the archetype, so systems have to see it again */
+		if (archetype->is_parked) {
+			result = unpark_archetype(world, archetype);
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+		}
+
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	/* No matching archetype was found, create a new one */
+	new_archetype = MALLOC_T(maybe_archetype_t, 1);
+	if (NULL == new_archetype) {
+		result = MAYBE_ERROR_ECS_WORLD_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+
+	archetype = new_archetype;
+	result = maybe_archetype_init(archetype);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* The archetype has no rows yet, so this only moves its empty entities vector */
+	result = maybe_archetype_set_column_allocator(
+		archetype,
+		(NULL != world->read_guard) ? &world->read_guard->allocator : maybe_page_store_get_allocator(world->page_store)
+	);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* A new archetype is about to get an entity, so it counts as touched */
+	archetype->last_access_tick = world->access_tick;
+
+	/* Add the component types to the archetype */
+	for (i = 0; i < component_count; i++) {
+		result = maybe_archetype_add_component_type(
+			archetype, 
+			component_ids[i],
+			MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, component_ids[i]).component_size
+		);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	for (i = 0; i < shared_count; i++) {
+		result = maybe_archetype_add_shared_component(archetype, shared_component_ids[i], shared_values[i]);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = maybe_vector_push(&world->archetypes, &archetype);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* The archetype is now owned by the world */
+	new_archetype = NULL;
+	*archetype_index = world->archetypes.length - 1;
+
+	/* Try to add the new archetype to all systems */
+	for (i = 0; i < world->systems.length; i++) {
+		system_result = maybe_system_add_archetype(&MAYBE_VECTOR_ELEMENT(world->systems, maybe_system_t, i), archetype);
+		if (IS_FAILURE(system_result)) {
+			if (MAYBE_ERROR_SYSTEM_BAD_ARCHETYPE != system_result) {
+				result = system_result;
+				goto l_cleanup;
+			}
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (new_archetype) {
+		(void)maybe_archetype_free(new_archetype);
+		free(new_archetype);
+	}
+
+	return result;
+}
+
+maybe_error_t move_entity(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	maybe_world_record_t* record,
+	uint32_t archetype_index
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_archetype_t* source = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, record->archetype_index);
+	maybe_archetype_t* destination = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, archetype_index);
+	maybe_vector_t* source_vector = NULL;
+	maybe_vector_t* destination_vector = NULL;
+	uint32_t i, component_index, row;
+
+	result = maybe_archetype_add_row(destination, entity_id, &row);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* Changing an entity's components does not enable it */
+	if (!maybe_archetype_is_row_enabled(source, record->row)) {
+		result = maybe_archetype_set_row_enabled(destination, row, false);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	/* Copy every component that exists in both archetypes */
+	for (i = 0; i < source->component_types_count; i++) {
+		if (!maybe_archetype_find_component(destination, MAYBE_VECTOR_ELEMENT(source->component_ids, uint32_t, i), &component_index)) {
+			continue;
+		}
+
+		source_vector = &MAYBE_VECTOR_ELEMENT(source->components, maybe_vector_t, i);
+		destination_vector = &MAYBE_VECTOR_ELEMENT(destination->components, maybe_vector_t, component_index);
+		memcpy(
+			MAYBE_VECTOR_PTR_ELEMENT_VOID_PTR(destination_vector, row),
+			MAYBE_VECTOR_PTR_ELEMENT_VOID_PTR(source_vector, record->row),
+			source_vector->element_size
+		);
+	}
+
+	result = remove_entity_row(world, record);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* A fork may have copied the moved row's record into its map, which can move the map's records */
+	result = find_record(world, entity_id, &record);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	record->archetype_index = archetype_index;
+	record->row = row;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t remove_entity_row(
+	maybe_world_t* world,
+	maybe_world_record_t* record
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_world_record_t* moved_record = NULL;
+	maybe_entity_t moved_entity;
+	uint32_t row = record->row;
+	bool entity_moved = false;
+
+	result = maybe_archetype_remove_row(
+		MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, record->archetype_index),
+		row,
+		&moved_entity,
+		&entity_moved
+	);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* The last row of the archetype took the removed row's place */
+	if (entity_moved) {
+		result = find_record(world, moved_entity, &moved_record);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		if (moved_record) {
+			moved_record->row = row;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t register_system_va_list(
+	maybe_world_t* world,
+	maybe_system_function_t system_function,
+	maybe_system_schedule_t schedule,
+	uint32_t component_count,
+	va_list components
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_error_t system_result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_system_t system;
+	uint32_t i;
+
+	if (NULL == world) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Initialize the new system */
+	if (IS_FAILURE(maybe_system_init_va_list(&system, system_function, component_count, components))) {
+		goto l_cleanup;
+	}
+
+	/* A divider of 0 is the same as running every tick */
+	if (0 == schedule.divider) {
+		schedule.divider = 1;
+	}
+
+	if (MAYBE_SYSTEM_PHASE_AUTO == schedule.phase) {
+		schedule.phase = choose_system_phase(world, &schedule);
+	}
+	schedule.phase %= schedule.divider;
+	system.schedule = schedule;
+
+	/* Add system to vector */
+	if (IS_FAILURE(maybe_vector_push(&world->systems, &system))) {
+		goto l_cleanup;
+	}
+
+	/* Let the system iterate all the archetypes that already exist, parked archetypes are added when they are unparked */
+	for (i = 0; i < world->archetypes.length; i++) {
+		if (MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i)->is_parked) {
+			continue;
+		}
+
+		system_result = maybe_system_add_archetype(
+			&MAYBE_VECTOR_ELEMENT(world->systems, maybe_system_t, world->systems.length - 1),
+			MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i)
+		);
+		if (IS_FAILURE(system_result) && (MAYBE_ERROR_SYSTEM_BAD_ARCHETYPE != system_result)) {
+			result = system_result;
+			goto l_cleanup;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+uint32_t choose_system_phase(
+	maybe_world_t* world,
+	maybe_system_schedule_t* schedule
+) {
+	maybe_system_t* system;
+	uint32_t* phase_loads = NULL;
+	uint32_t i, phase = 0;
+
+	if (1 == schedule->divider) {
+		return 0;
+	}
+
+	phase_loads = (uint32_t*)calloc(schedule->divider, sizeof(uint32_t));
+	if (NULL == phase_loads) {
+		/* Staggering is only an optimization */
+		return 0;
+	}
+
+	/* Count the systems that already run on every phase */
+	for (i = 0; i < world->systems.length; i++) {
+		system = &MAYBE_VECTOR_ELEMENT(world->systems, maybe_system_t, i);
+		if ((system->schedule.rate == schedule->rate) && (system->schedule.divider == schedule->divider)) {
+			phase_loads[system->schedule.phase]++;
+		}
+	}
+
+	for (i = 1; i < schedule->divider; i++) {
+		if (phase_loads[i] < phase_loads[phase]) {
+			phase = i;
+		}
+	}
+
+	free(phase_loads);
+
+	return phase;
+}
+
+void run_scheduled_systems(
+	maybe_world_t* world,
+	maybe_system_rate_t rate,
+	uint64_t tick,
+	double delta_time
+) {
+	maybe_system_t* system;
+	uint32_t i;
+
+	for (i = 0; i < world->systems.length; i++) {
+		system = &MAYBE_VECTOR_ELEMENT(world->systems, maybe_system_t, i);
+		if (system->schedule.rate != rate) {
+			continue;
+		}
+
+		/* Systems that skip ticks get the time of all the ticks they skipped */
+		system->pending_time += delta_time;
+		if ((tick % system->schedule.divider) != system->schedule.phase) {
+			continue;
+		}
+
+		system->delta_time = system->pending_time;
+		system->pending_time = 0.0;
+		touch_system_columns(world, system);
+		maybe_system_run(system);
+	}
+}
+
+maybe_error_t park_archetype(
+	maybe_world_t* world,
+	maybe_archetype_t* archetype
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t i;
+
+	for (i = 0; i < world->systems.length; i++) {
+		result = maybe_system_remove_archetype(&MAYBE_VECTOR_ELEMENT(world->systems, maybe_system_t, i), archetype);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = maybe_archetype_shrink(archetype);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	archetype->is_parked = true;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t unpark_archetype(
+	maybe_world_t* world,
+	maybe_archetype_t* archetype
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_error_t system_result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t i;
+
+	for (i = 0; i < world->systems.length; i++) {
+		system_result = maybe_system_add_archetype(&MAYBE_VECTOR_ELEMENT(world->systems, maybe_system_t, i), archetype);
+		if (IS_FAILURE(system_result) && (MAYBE_ERROR_SYSTEM_BAD_ARCHETYPE != system_result)) {
+			result = system_result;
+			goto l_cleanup;
+		}
+	}
+
+	archetype->is_parked = false;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t transfer_archetype(
+	maybe_world_t* destination,
+	maybe_world_t* source,
+	maybe_archetype_t* source_archetype,
+	uint32_t* component_map,
+	maybe_vector_t* entity_map
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_archetype_t* destination_archetype;
+	maybe_vector_t* source_column;
+	maybe_vector_t* destination_column;
+	maybe_vector_t temp;
+	maybe_world_record_t record;
+	maybe_entity_t source_entity;
+	maybe_component_type_t* shared_type;
+	uint32_t* component_ids = NULL;
+	uint32_t* shared_component_ids = NULL;
+	void** shared_values = NULL;
+	uint32_t i, component_index, first_row;
+	uint32_t row_count = source_archetype->entities.length;
+	uint32_t shared_count = source_archetype->shared_component_ids.length;
+
+	component_ids = (uint32_t*)malloc((source_archetype->component_types_count + 1) * sizeof(uint32_t));
+	shared_component_ids = (uint32_t*)malloc((shared_count + 1) * sizeof(uint32_t));
+	shared_values = (void**)malloc((shared_count + 1) * sizeof(void*));
+	if ((NULL == component_ids) || (NULL == shared_component_ids) || (NULL == shared_values)) {
+		result = MAYBE_ERROR_ECS_WORLD_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+
+	/* Translate the archetype's components to the destination's IDs */
+	for (i = 0; i < source_archetype->component_types_count; i++) {
+		component_ids[i] = MAYBE_VECTOR_ELEMENT(source_archetype->component_ids, uint32_t, i);
+		if (component_map) {
+			component_ids[i] = component_map[component_ids[i]];
+		}
+
+		if ((component_ids[i] >= destination->component_types.length) ||
+			(NULL != MAYBE_VECTOR_ELEMENT(destination->component_types, maybe_component_type_t, component_ids[i]).shared_store) ||
+			(MAYBE_VECTOR_ELEMENT(destination->component_types, maybe_component_type_t, component_ids[i]).component_size !=
+			 MAYBE_VECTOR_ELEMENT(source->component_types, maybe_component_type_t, MAYBE_VECTOR_ELEMENT(source_archetype->component_ids, uint32_t, i)).component_size)) {
+			result = MAYBE_ERROR_ECS_WORLD_COMPONENT_MISMATCH;
+			goto l_cleanup;
+		}
+	}
+
+	/* Shared values are stored by each world, so the destination gets its own copies */
+	for (i = 0; i < shared_count; i++) {
+		shared_component_ids[i] = MAYBE_VECTOR_ELEMENT(source_archetype->shared_component_ids, uint32_t, i);
+		if (component_map) {
+			shared_component_ids[i] = component_map[shared_component_ids[i]];
+		}
+
+		if (shared_component_ids[i] >= destination->component_types.length) {
+			result = MAYBE_ERROR_ECS_WORLD_COMPONENT_MISMATCH;
+			goto l_cleanup;
+		}
+
+		shared_type = &MAYBE_VECTOR_ELEMENT(destination->component_types, maybe_component_type_t, shared_component_ids[i]);
+		if ((NULL == shared_type->shared_store) ||
+			(shared_type->component_size !=
+			 MAYBE_VECTOR_ELEMENT(source->component_types, maybe_component_type_t, MAYBE_VECTOR_ELEMENT(source_archetype->shared_component_ids, uint32_t, i)).component_size)) {
+			result = MAYBE_ERROR_ECS_WORLD_COMPONENT_MISMATCH;
+			goto l_cleanup;
+		}
+
+		result = maybe_shared_store_intern(shared_type->shared_store, MAYBE_VECTOR_ELEMENT(source_archetype->shared_values, void*, i), &shared_values[i]);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = get_or_create_archetype(
+		destination,
+		component_ids,
+		source_archetype->component_types_count,
+		shared_component_ids,
+		shared_values,
+		shared_count,
+		&record.archetype_index
+	);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	destination_archetype = MAYBE_VECTOR_ELEMENT(destination->archetypes, maybe_archetype_t*, record.archetype_index);
+	first_row = destination_archetype->entities.length;
+
+	/* The columns are moved directly, so neither archetype may share them with a fork */
+	result = maybe_archetype_make_writable(source_archetype);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_archetype_make_writable(destination_archetype);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/*
+	 * Reserve everything the move needs before either world is changed, so nothing can fail once it
+	 * starts. An empty destination simply adopts the source's buffers, but a buffer belongs to its
+	 * allocator, such as the source's page store, so it is only swapped with a column of the same one.
+	 * */
+	for (i = 0; i < source_archetype->component_types_count; i++) {
+		source_column = &MAYBE_VECTOR_ELEMENT(source_archetype->components, maybe_vector_t, i);
+		(void)maybe_archetype_find_component(destination_archetype, component_ids[i], &component_index);
+		destination_column = &MAYBE_VECTOR_ELEMENT(destination_archetype->components, maybe_vector_t, component_index);
+
+		if ((0 != first_row) || (source_column->allocator != destination_column->allocator)) {
+			result = maybe_vector_reserve(destination_column, first_row + row_count);
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+		}
+	}
+
+	result = maybe_vector_reserve(&destination_archetype->entities, first_row + row_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_reserve(
+		&destination_archetype->enabled_rows,
+		(first_row + row_count + MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD - 1) / MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD
+	);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_map_reserve(&destination->entities, row_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* A fork copies the records of its parent before it marks them removed */
+	if (NULL != source->fork_parent) {
+		result = maybe_map_reserve(&source->entities, row_count);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	if (entity_map) {
+		result = maybe_vector_reserve(entity_map, entity_map->length + row_count);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	/* The entities' new IDs in the destination, past its last row until they are moved */
+	for (i = 0; i < row_count; i++) {
+		MAYBE_VECTOR_ELEMENT(destination_archetype->entities, maybe_entity_t, first_row + i) = destination->next_entity_id + i;
+	}
+
+	/* The moved entities leave every component in the source, and get every component in the destination */
+	result = queue_archetype_observer_events(
+		source,
+		source_archetype,
+		MAYBE_OBSERVER_EVENT_REMOVE,
+		(const maybe_entity_t*)source_archetype->entities.elements,
+		row_count
+	);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = queue_archetype_observer_events(
+		destination,
+		destination_archetype,
+		MAYBE_OBSERVER_EVENT_ADD,
+		&MAYBE_VECTOR_ELEMENT(destination_archetype->entities, maybe_entity_t, first_row),
+		row_count
+	);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* Nothing below allocates, so the checks only pass on errors that can not happen */
+	for (i = 0; i < source_archetype->component_types_count; i++) {
+		source_column = &MAYBE_VECTOR_ELEMENT(source_archetype->components, maybe_vector_t, i);
+		(void)maybe_archetype_find_component(destination_archetype, component_ids[i], &component_index);
+		destination_column = &MAYBE_VECTOR_ELEMENT(destination_archetype->components, maybe_vector_t, component_index);
+
+		if ((0 == first_row) && (source_column->allocator == destination_column->allocator)) {
+			temp = *destination_column;
+			*destination_column = *source_column;
+			*source_column = temp;
+		} else {
+			memcpy(
+				MAYBE_VECTOR_PTR_ELEMENT_VOID_PTR(destination_column, first_row),
+				source_column->elements,
+				(size_t)row_count * source_column->element_size
+			);
+			destination_column->length += row_count;
+		}
+
+		source_column->length = 0;
+	}
+
+	/* Record the entities in the destination, and forget them in the source */
+	for (i = 0; i < row_count; i++) {
+		source_entity = MAYBE_VECTOR_ELEMENT(source_archetype->entities, maybe_entity_t, i);
+
+		record.row = first_row + i;
+		result = maybe_map_set(&destination->entities, &destination->next_entity_id, sizeof(maybe_entity_t), &record);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		if (entity_map) {
+			result = maybe_vector_push(entity_map, &(maybe_world_entity_mapping_t){ source_entity, destination->next_entity_id });
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+		}
+
+		result = forget_record(source, source_entity);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		destination->next_entity_id++;
+		destination_archetype->entities.length++;
+	}
+
+	/* The moved entities keep their enabled state */
+	result = maybe_archetype_update_enabled_rows(destination_archetype, first_row);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	for (i = 0; (i < row_count) && (source_archetype->disabled_count > 0); i++) {
+		if (!maybe_archetype_is_row_enabled(source_archetype, i)) {
+			result = maybe_archetype_set_row_enabled(destination_archetype, first_row + i, false);
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+		}
+	}
+
+	source_archetype->entities.length = 0;
+	source_archetype->layout_version++;
+	destination_archetype->layout_version++;
+
+	result = maybe_archetype_update_enabled_rows(source_archetype, 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (component_ids) {
+		free(component_ids);
+	}
+
+	if (shared_component_ids) {
+		free(shared_component_ids);
+	}
+
+	if (shared_values) {
+		free(shared_values);
+	}
+
+	return result;
+}
+
+maybe_error_t rebuild_spatial_indexes(
+	maybe_world_t* world,
+	maybe_system_rate_t rate
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_spatial_index_t* index;
+	uint32_t i;
+
+	for (i = 0; i < world->spatial_indexes.length; i++) {
+		index = MAYBE_VECTOR_ELEMENT(world->spatial_indexes, maybe_spatial_index_t*, i);
+		if (index->config.rate != rate) {
+			continue;
+		}
+
+		result = maybe_spatial_index_rebuild(index, world, world->thread_pool);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t queue_observer_events(
+	maybe_world_t* world,
+	uint32_t component_id,
+	maybe_observer_event_t event,
+	const maybe_entity_t* entities,
+	uint32_t entity_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_component_type_t* component_type = &MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, component_id);
+
+	if (0 == (component_type->observed_events & (1u << event))) {
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	result = maybe_observer_queue_push(
+		&MAYBE_VECTOR_ELEMENT(world->observer_queues, maybe_observer_queue_t, component_type->observer_queues[event]),
+		entities,
+		entity_count
+	);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	world->has_pending_observer_events = true;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t queue_archetype_observer_events(
+	maybe_world_t* world,
+	maybe_archetype_t* archetype,
+	maybe_observer_event_t event,
+	const maybe_entity_t* entities,
+	uint32_t entity_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t i;
+
+	/* Worlds without observers do not pay for the loops */
+	if (0 == world->observer_queues.length) {
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < archetype->component_types_count; i++) {
+		result = queue_observer_events(world, MAYBE_VECTOR_ELEMENT(archetype->component_ids, uint32_t, i), event, entities, entity_count);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	for (i = 0; i < archetype->shared_component_ids.length; i++) {
+		result = queue_observer_events(world, MAYBE_VECTOR_ELEMENT(archetype->shared_component_ids, uint32_t, i), event, entities, entity_count);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t check_unshared_components(
+	maybe_world_t* world,
+	uint32_t* component_ids,
+	uint32_t component_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t i;
+
+	for (i = 0; i < component_count; i++) {
+		if (component_ids[i] >= world->component_types.length) {
+			result = MAYBE_ERROR_ECS_WORLD_INVALID_PARAM;
+			goto l_cleanup;
 		}
 
-		if (found_archetype) {
-			return archetype;
+		/* Shared components have no column, their value is set with maybe_world_set_shared_component */
+		if (NULL != MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, component_ids[i]).shared_store) {
+			result = MAYBE_ERROR_ECS_WORLD_INVALID_PARAM;
+			goto l_cleanup;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t find_record(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	maybe_world_record_t** record
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_world_record_t* found_record = NULL;
+	maybe_world_t* ancestor;
+
+	result = maybe_map_get(&world->entities, &entity_id, sizeof(entity_id), (void**)&found_record);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* A fork copies a record from its ancestors the first time it is used, since the caller may change it */
+	for (ancestor = world->fork_parent; (NULL == found_record) && (NULL != ancestor); ancestor = ancestor->fork_parent) {
+		result = maybe_map_get(&ancestor->entities, &entity_id, sizeof(entity_id), (void**)&found_record);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		if (NULL == found_record) {
+			continue;
+		}
+
+		result = maybe_map_set(&world->entities, &entity_id, sizeof(entity_id), found_record);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		result = maybe_map_get(&world->entities, &entity_id, sizeof(entity_id), (void**)&found_record);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	if ((NULL != found_record) && (MAYBE_WORLD_REMOVED_RECORD == found_record->archetype_index)) {
+		found_record = NULL;
+	}
+
+	*record = found_record;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t forget_record(
+	maybe_world_t* world,
+	maybe_entity_t entity_id
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_world_record_t* record = NULL;
+
+	if (NULL == world->fork_parent) {
+		result = maybe_map_remove(&world->entities, &entity_id, sizeof(entity_id));
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	/* A fork keeps the removed record, so the parent's record of the entity is not found */
+	result = find_record(world, entity_id, &record);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	if (record) {
+		record->archetype_index = MAYBE_WORLD_REMOVED_RECORD;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+bool archetype_matches(
+	maybe_archetype_t* archetype,
+	uint32_t* component_ids,
+	uint32_t component_count
+) {
+	uint32_t i, component_index;
+	void* shared_value;
+	uint64_t mask = maybe_archetype_get_component_mask(component_ids, component_count);
+
+	if ((archetype->component_mask & mask) != mask) {
+		return false;
+	}
+
+	for (i = 0; i < component_count; i++) {
+		if (!maybe_archetype_find_component(archetype, component_ids[i], &component_index) &&
+			!maybe_archetype_find_shared_component(archetype, component_ids[i], &shared_value)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+maybe_error_t change_matching_components(
+	maybe_world_t* world,
+	uint32_t component_id,
+	bool add,
+	uint32_t component_count,
+	uint32_t* component_ids,
+	uint32_t* changed_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_archetype_t* source;
+	maybe_archetype_t* destination;
+	uint32_t* new_component_ids = NULL;
+	maybe_entity_t* entities;
+	uint32_t i, j, component_index, new_component_count, destination_index, first_row, row_count;
+	uint32_t count = 0;
+	bool has_component;
+
+	if ((NULL == world) || ((NULL == component_ids) && (0 != component_count))) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (world->fork_count > 0) {
+		result = MAYBE_ERROR_ECS_WORLD_HAS_FORKS;
+		goto l_cleanup;
+	}
+
+	result = check_unshared_components(world, &component_id, 1);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* Archetypes that receive rows below are skipped when reached, since they have the new component set */
+	for (i = 0; i < world->archetypes.length; i++) {
+		source = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i);
+		if ((0 == source->entities.length) || !archetype_matches(source, component_ids, component_count)) {
+			continue;
+		}
+
+		has_component = maybe_archetype_find_component(source, component_id, &component_index);
+		if (has_component == add) {
+			continue;
+		}
+
+		/* The new component set is the current one with the component appended or removed */
+		new_component_ids = (uint32_t*)malloc((source->component_types_count + 1) * sizeof(uint32_t));
+		if (NULL == new_component_ids) {
+			result = MAYBE_ERROR_ECS_WORLD_ALLOCATION_FAILED;
+			goto l_cleanup;
+		}
+
+		new_component_count = 0;
+		for (j = 0; j < source->component_types_count; j++) {
+			if (!has_component || (j != component_index)) {
+				new_component_ids[new_component_count] = MAYBE_VECTOR_ELEMENT(source->component_ids, uint32_t, j);
+				new_component_count++;
+			}
+		}
+
+		if (add) {
+			new_component_ids[new_component_count] = component_id;
+			new_component_count++;
+		}
+
+		destination = find_matching_archetype(
+			world,
+			new_component_ids,
+			new_component_count,
+			(uint32_t*)source->shared_component_ids.elements,
+			(void**)source->shared_values.elements,
+			source->shared_component_ids.length,
+			NULL,
+			&destination_index
+		);
+		free(new_component_ids);
+		new_component_ids = NULL;
+
+		row_count = source->entities.length;
+		if (NULL == destination) {
+			/* No archetype has the new component set, so the source becomes it and no row moves */
+			result = relabel_archetype(world, source, component_id, add, component_index);
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+
+			entities = (maybe_entity_t*)source->entities.elements;
+		} else {
+			if (destination->is_parked) {
+				result = unpark_archetype(world, destination);
+				if (IS_FAILURE(result)) {
+					goto l_cleanup;
+				}
+			}
+
+			first_row = destination->entities.length;
+			result = move_archetype_rows(world, source, destination, destination_index);
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+
+			entities = &MAYBE_VECTOR_ELEMENT(destination->entities, maybe_entity_t, first_row);
+		}
+
+		result = queue_observer_events(world, component_id, add ? MAYBE_OBSERVER_EVENT_ADD : MAYBE_OBSERVER_EVENT_REMOVE, entities, row_count);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		count += row_count;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (new_component_ids) {
+		free(new_component_ids);
+	}
+
+	if (changed_count) {
+		*changed_count = count;
+	}
+
+	return result;
+}
+
+maybe_error_t relabel_archetype(
+	maybe_world_t* world,
+	maybe_archetype_t* archetype,
+	uint32_t component_id,
+	bool add,
+	uint32_t component_index
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_error_t system_result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t i;
+
+	/* The systems saved the archetype's column indices, so they match it again after the change */
+	for (i = 0; i < world->systems.length; i++) {
+		result = maybe_system_remove_archetype(&MAYBE_VECTOR_ELEMENT(world->systems, maybe_system_t, i), archetype);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	if (add) {
+		result = maybe_archetype_add_filled_component_type(
+			archetype,
+			component_id,
+			MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, component_id).component_size
+		);
+	} else {
+		result = maybe_archetype_remove_component_type(archetype, component_index);
+	}
+
+	/* The archetype has to return to the systems even if it could not be changed */
+	system_result = unpark_archetype(world, archetype);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = system_result;
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t move_archetype_rows(
+	maybe_world_t* world,
+	maybe_archetype_t* source,
+	maybe_archetype_t* destination,
+	uint32_t destination_index
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_vector_t* source_column;
+	maybe_vector_t* destination_column;
+	maybe_vector_t temp;
+	maybe_world_record_t* record = NULL;
+	uint32_t i, component_index;
+	uint32_t first_row = destination->entities.length;
+	uint32_t row_count = source->entities.length;
+
+	/* The columns are moved directly, so neither archetype may share them with another world */
+	result = maybe_archetype_make_writable(source);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_archetype_make_writable(destination);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/*
+	 * Reserve everything the move needs before either archetype is changed, so nothing can fail once
+	 * it starts. An empty destination simply adopts the source's buffers instead.
+	 * */
+	for (i = 0; i < destination->component_types_count; i++) {
+		if ((0 == first_row) &&
+			maybe_archetype_find_component(source, MAYBE_VECTOR_ELEMENT(destination->component_ids, uint32_t, i), &component_index)) {
+			continue;
+		}
+
+		result = maybe_vector_reserve(&MAYBE_VECTOR_ELEMENT(destination->components, maybe_vector_t, i), first_row + row_count);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	if (0 != first_row) {
+		result = maybe_vector_reserve(&destination->entities, first_row + row_count);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = maybe_vector_reserve(
+		&destination->enabled_rows,
+		(first_row + row_count + MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD - 1) / MAYBE_ARCHETYPE_ROWS_PER_ENABLED_WORD
+	);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* A fork copies the records of its parent before it changes them */
+	if (NULL != world->fork_parent) {
+		result = maybe_map_reserve(&world->entities, row_count);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	/* Move the columns, nothing below allocates so the checks only pass on errors that can not happen */
+	for (i = 0; i < destination->component_types_count; i++) {
+		destination_column = &MAYBE_VECTOR_ELEMENT(destination->components, maybe_vector_t, i);
+
+		if (!maybe_archetype_find_component(source, MAYBE_VECTOR_ELEMENT(destination->component_ids, uint32_t, i), &component_index)) {
+			/* The added component, zeroed like maybe_archetype_add_filled_component_type does */
+			memset(MAYBE_VECTOR_PTR_ELEMENT_VOID_PTR(destination_column, first_row), 0, (size_t)row_count * destination_column->element_size);
+			destination_column->length += row_count;
+			continue;
+		}
+
+		source_column = &MAYBE_VECTOR_ELEMENT(source->components, maybe_vector_t, component_index);
+		if (0 == first_row) {
+			temp = *destination_column;
+			*destination_column = *source_column;
+			*source_column = temp;
+		} else {
+			memcpy(
+				MAYBE_VECTOR_PTR_ELEMENT_VOID_PTR(destination_column, first_row),
+				source_column->elements,
+				(size_t)row_count * source_column->element_size
+			);
+			destination_column->length += row_count;
+		}
+	}
+
+	if (0 == first_row) {
+		temp = destination->entities;
+		destination->entities = source->entities;
+		source->entities = temp;
+	} else {
+		memcpy(
+			MAYBE_VECTOR_ELEMENT_VOID_PTR(destination->entities, first_row),
+			source->entities.elements,
+			(size_t)row_count * sizeof(maybe_entity_t)
+		);
+		destination->entities.length += row_count;
+	}
+
+	for (i = 0; i < row_count; i++) {
+		result = find_record(world, MAYBE_VECTOR_ELEMENT(destination->entities, maybe_entity_t, first_row + i), &record);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		if (record) {
+			record->archetype_index = destination_index;
+			record->row = first_row + i;
+		}
+	}
+
+	/* The moved entities keep their enabled state */
+	result = maybe_archetype_update_enabled_rows(destination, first_row);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	for (i = 0; (i < row_count) && (source->disabled_count > 0); i++) {
+		if (!maybe_archetype_is_row_enabled(source, i)) {
+			result = maybe_archetype_set_row_enabled(destination, first_row + i, false);
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+		}
+	}
+	destination->layout_version++;
+
+	/* Drops what is left of the source's columns, like the removed component */
+	result = maybe_archetype_clear(source);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+void touch_column(
+	maybe_world_t* world,
+	maybe_archetype_t* archetype,
+	uint32_t column_index
+) {
+	maybe_vector_t* column = &MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, column_index);
+
+	MAYBE_VECTOR_ELEMENT(archetype->column_access_counts, uint32_t, column_index)++;
+
+	if ((NULL == world->page_store) || (column->allocator != &world->page_store->allocator) || (0 == column->length)) {
+		return;
+	}
+
+	/* Prefetching is only advice, the column is read back when it is touched either way */
+	(void)maybe_page_store_prefetch(world->page_store, column->elements, (size_t)column->length * column->element_size);
+}
+
+void touch_system_columns(
+	maybe_world_t* world,
+	maybe_system_t* system
+) {
+	maybe_system_archetype_info_t* info;
+	uint32_t i, j;
+
+	for (i = 0; i < system->archetypes.length; i++) {
+		info = &MAYBE_VECTOR_ELEMENT(system->archetypes, maybe_system_archetype_info_t, i);
+		info->archetype->last_access_tick = world->access_tick;
+		info->archetype->is_paged_out = false;
+
+		for (j = 0; j < system->component_count; j++) {
+			touch_column(world, info->archetype, info->component_indices[j]);
 		}
 	}
-	
-	return NULL;
 }
@@ -1,12 +1,17 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "common/map/map.h"
 #include "common/vector/vector.h"
+#include "common/thread/thread_pool.h"
+#include "common/page_store/page_store.h"
 #include "entity.h"
 #include "archetype.h"
 #include "system.h"
+#include "observer.h"
+#include "shared.h"
 
 /* @TODO Create a typedef for component_id */
 /* @TODO Add a function that adds an entity and initializes its components */
@@ -22,17 +27,56 @@ typedef struct {
 typedef struct {
 	uint32_t id;
 	uint32_t component_size;
+	uint32_t observed_events; /* A bit for every maybe_observer_event_t that has observers, checked before queueing an event */
+	uint32_t observer_queues[MAYBE_OBSERVER_EVENT_COUNT]; /* The index of every event's queue in the world, or MAYBE_WORLD_NO_OBSERVER_QUEUE */
+	maybe_shared_store_t* shared_store; /* The distinct values of a shared component type, NULL for other types */
 } maybe_component_type_t;
 
+#define MAYBE_WORLD_NO_OBSERVER_QUEUE (UINT32_MAX)
+
+/* @brief A component type known at compile time, see MAYBE_DECLARE_COMPONENT_MANIFEST */
+typedef struct {
+	uint32_t id; /* The ID the type must get */
+	uint32_t size;
+	uint32_t alignment;
+	bool is_shared;
+} maybe_component_descriptor_t;
+
+/* @brief The new ID an entity got when it was moved to another world */
 typedef struct {
-	MAYBE_MAP(maybe_entity_id_t, maybe_world_record_t) entities;
+	maybe_entity_t source;
+	maybe_entity_t destination;
+} maybe_world_entity_mapping_t;
+
+typedef struct maybe_world_s {
+	MAYBE_MAP(maybe_entity_id_t, maybe_world_record_t) entities; /* @note A fork only has the records it changed, see maybe_world_fork */
 	uint64_t next_entity_id;
-	MAYBE_VECTOR(maybe_archetype_t) archetypes;
+	MAYBE_VECTOR(maybe_archetype_t*) archetypes; /* @note Archetypes are allocated separately so systems can hold pointers to them */
 	MAYBE_VECTOR(maybe_component_type_t) component_types;
 	uint32_t next_component_id;
 	MAYBE_VECTOR(maybe_system_t) systems;
+	double fixed_timestep; /* The length of a fixed tick in seconds */
+	double accumulator; /* Time passed that was not consumed by fixed ticks yet */
+	uint32_t max_fixed_steps; /* The maximum amount of fixed ticks in a single advance, the rest of the time is dropped */
+	uint64_t fixed_tick; /* The number of fixed ticks run so far */
+	uint64_t variable_tick; /* The number of maybe_world_advance calls so far */
+	uint32_t compact_cursor; /* The archetype the next maybe_world_compact call continues from */
+	maybe_thread_pool_t* thread_pool; /* Used by the world's parallel work, if NULL that work runs on the calling thread */
+	MAYBE_VECTOR(maybe_spatial_index_t*) spatial_indexes; /* Rebuilt by the world before the ticks of their rate, see spatial.h */
+	MAYBE_VECTOR(maybe_observer_queue_t) observer_queues;
+	bool has_pending_observer_events;
+	bool is_flushing_observers;
+	struct maybe_world_s* fork_parent; /* The world this world was forked from, NULL if it is not a fork */
+	uint32_t fork_count; /* The number of forks of this world that were not freed yet */
+	maybe_page_store_t* page_store; /* The archetypes' columns and entities are allocated from it if not NULL, see maybe_world_set_page_store */
+	uint64_t access_tick; /* Incremented by every update and advance, systems stamp the archetypes they touch with it */
+	struct maybe_world_export_s* world_export; /* Published after every update and advance if not NULL, see export.h */
+	struct maybe_world_read_guard_s* read_guard; /* Allocates the columns and is published after every update and advance if not NULL, see read_guard.h */
 } maybe_world_t;
 
+#define MAYBE_WORLD_DEFAULT_FIXED_TIMESTEP (1.0 / 60.0)
+#define MAYBE_WORLD_DEFAULT_MAX_FIXED_STEPS (8)
+
 /*
  * @brief Initialize an ECS world
  *
@@ -55,6 +99,42 @@ maybe_error_t maybe_world_add_component_type(
 	uint32_t* component_id
 );
 
+/*
+ * @brief Add a shared component type to an ECS world
+ *
+ * An entity does not store its own copy of a shared component, only a reference to a value that
+ * is stored once by the world. Entities with the same value are grouped in the same archetypes,
+ * so every archetype holds one value of each of its shared components.
+ *
+ * @param world A pointer to the ECS world
+ * @param component_size The size of an instance of the component
+ * @param component_id The resulting component type ID
+ *
+ * @note Shared components are set with maybe_world_set_shared_component, not when adding entities or components
+ * @note Values are compared bytewise, so padding bytes should be zeroed
+ * */
+maybe_error_t maybe_world_add_shared_component_type(
+	maybe_world_t* world,
+	uint32_t component_size,
+	uint32_t* component_id
+);
+
+/*
+ * @brief Add component types whose IDs were fixed at compile time to an ECS world
+ *
+ * @param world A pointer to the ECS world
+ * @param component_count The number of component types
+ * @param descriptors The component types, ordered by ID
+ *
+ * @note Every ID must be the next ID the world gives, so manifests are registered before any other component type
+ * @note Columns are allocated with malloc, so alignments past alignof(max_align_t) are rejected
+ * */
+maybe_error_t maybe_world_add_component_types(
+	maybe_world_t* world,
+	uint32_t component_count,
+	const maybe_component_descriptor_t* descriptors
+);
+
 /*
  * @brief Add an entity to an ECS world
  *
@@ -71,6 +151,21 @@ maybe_error_t maybe_world_add_entity(
 	...
 );
 
+/*
+ * @brief Add an entity to an ECS world, using an array for the component IDs
+ *
+ * @param world A pointer to the world
+ * @param component_count The number of components the new entity would have
+ * @param component_ids An array of the component IDs the entity should have
+ * @param entity_id The new entity's id
+ * */
+maybe_error_t maybe_world_add_entity_array(
+	maybe_world_t* world,
+	uint32_t component_count,
+	uint32_t* component_ids,
+	maybe_entity_t* entity_id
+);
+
 /*
  * @brief Remove an entity from an ECS world
  *
@@ -82,6 +177,158 @@ maybe_error_t maybe_world_remove_entity(
 	maybe_entity_t entity_id
 );
 
+/*
+ * @brief Get a pointer to one of an entity's components
+ *
+ * @param world A pointer to the world
+ * @param entity_id The id of the entity
+ * @param component_id The id of the component type
+ * @param component A pointer to the component's data
+ *
+ * @note The pointer is only valid until the next structural change in the world
+ * */
+maybe_error_t maybe_world_get_component(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	uint32_t component_id,
+	void** component
+);
+
+/*
+ * @brief Enable or disable an entity
+ *
+ * Disabled entities keep their components and their place in their archetype, but system
+ * iterators and queries skip them. Toggling an entity is a single bit flip, not a structural change.
+ *
+ * @param world A pointer to the world
+ * @param entity_id The id of the entity
+ * @param enabled Whether the entity is enabled
+ *
+ * @note Entities are enabled when they are added, and keep their state when their components change
+ * */
+maybe_error_t maybe_world_set_entity_enabled(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	bool enabled
+);
+
+/*
+ * @brief Check whether an entity is enabled
+ *
+ * @param world A pointer to the world
+ * @param entity_id The id of the entity
+ * @param enabled Set to whether the entity is enabled
+ * */
+maybe_error_t maybe_world_is_entity_enabled(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	bool* enabled
+);
+
+/*
+ * @brief Set the value of one of an entity's components, and queue a MAYBE_OBSERVER_EVENT_SET event for it
+ *
+ * @param world A pointer to the world
+ * @param entity_id The id of the entity
+ * @param component_id The id of the component type
+ * @param value The component's new value, the size of the component type is copied from it
+ *
+ * @note Writing through a pointer from maybe_world_get_component does not queue an event
+ * */
+maybe_error_t maybe_world_set_component(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	uint32_t component_id,
+	const void* value
+);
+
+/*
+ * @brief Add a component to an existing entity, moving it to a matching archetype
+ *
+ * @param world A pointer to the world
+ * @param entity_id The id of the entity
+ * @param component_id The id of the component type to add
+ *
+ * @note The new component is not initialized
+ * */
+maybe_error_t maybe_world_add_component(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	uint32_t component_id
+);
+
+/*
+ * @brief Remove a component from an existing entity, moving it to a matching archetype
+ *
+ * @param world A pointer to the world
+ * @param entity_id The id of the entity
+ * @param component_id The id of the component type to remove
+ * */
+maybe_error_t maybe_world_remove_component(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	uint32_t component_id
+);
+
+/*
+ * Bulk operations
+ *
+ * The functions below change every entity that has all of a list of components, the same entities a
+ * query over the list visits, including disabled ones. They work on whole archetypes instead of single
+ * entities: removed archetypes are truncated, and moved archetypes move all their columns at once. An
+ * archetype whose component set has no archetype yet is relabeled in place, so its rows do not move.
+ * Observers get one batch of events per archetype.
+ * */
+
+/*
+ * @brief Remove every entity that has all of a list of components
+ *
+ * @param world A pointer to the world
+ * @param component_count The number of components in the list
+ * @param component_ids The IDs of the components, shared components are allowed
+ * @param removed_count Set to the number of removed entities, can be NULL
+ * */
+maybe_error_t maybe_world_remove_matching_entities(
+	maybe_world_t* world,
+	uint32_t component_count,
+	uint32_t* component_ids,
+	uint32_t* removed_count
+);
+
+/*
+ * @brief Add a component to every entity that has all of a list of components and does not have it
+ *
+ * @param world A pointer to the world
+ * @param component_id The id of the component type to add, its value is zeroed
+ * @param component_count The number of components in the list
+ * @param component_ids The IDs of the components, shared components are allowed
+ * @param changed_count Set to the number of entities the component was added to, can be NULL
+ * */
+maybe_error_t maybe_world_add_component_to_matching(
+	maybe_world_t* world,
+	uint32_t component_id,
+	uint32_t component_count,
+	uint32_t* component_ids,
+	uint32_t* changed_count
+);
+
+/*
+ * @brief Remove a component from every entity that has all of a list of components and has it
+ *
+ * @param world A pointer to the world
+ * @param component_id The id of the component type to remove
+ * @param component_count The number of components in the list
+ * @param component_ids The IDs of the components, shared components are allowed
+ * @param changed_count Set to the number of entities the component was removed from, can be NULL
+ * */
+maybe_error_t maybe_world_remove_component_from_matching(
+	maybe_world_t* world,
+	uint32_t component_id,
+	uint32_t component_count,
+	uint32_t* component_ids,
+	uint32_t* changed_count
+);
+
 /*
  * @brief Register a system in a world.
  *
@@ -98,19 +345,380 @@ maybe_error_t maybe_world_register_system(
 	...
 );
 
+/*
+ * @brief Register a system in a world, with a schedule used by maybe_world_advance
+ *
+ * @param world A pointer to the world
+ * @param system_function The system logic function
+ * @param schedule When the system should run, and how many slices its entities are split into
+ * @param component_count Number of components the system requires
+ * 
+ * @note The rest of the parameters are the components the system requires
+ * @note Systems with slices are also sliced when run by maybe_world_update
+ * */
+maybe_error_t maybe_world_register_system_with_schedule(
+	maybe_world_t* world,
+	maybe_system_function_t system_function,
+	maybe_system_schedule_t schedule,
+	uint32_t component_count,
+	...
+);
+
+/*
+ * @brief Add an observer for an event on a component type
+ *
+ * Events are queued as they happen, and on the next flush every observer of an event is called
+ * once with all the entities the event happened to since the previous flush.
+ *
+ * @param world A pointer to the world
+ * @param component_id The observed component type
+ * @param event The observed event
+ * @param function The observer function
+ * @param context A pointer passed to the observer function
+ *
+ * @note Events on component types without observers are not queued, so they cost a single bit test
+ * */
+maybe_error_t maybe_world_add_observer(
+	maybe_world_t* world,
+	uint32_t component_id,
+	maybe_observer_event_t event,
+	maybe_observer_function_t function,
+	void* context
+);
+
+/*
+ * @brief Remove an observer added with maybe_world_add_observer
+ *
+ * @param world A pointer to the world
+ * @param component_id The observed component type
+ * @param event The observed event
+ * @param function The observer function
+ * @param context The context the observer was added with
+ *
+ * @note When the last observer of an event is removed, the event's queued entities are dropped
+ * */
+maybe_error_t maybe_world_remove_observer(
+	maybe_world_t* world,
+	uint32_t component_id,
+	maybe_observer_event_t event,
+	maybe_observer_function_t function,
+	void* context
+);
+
+/*
+ * @brief Call the observers of all the events queued since the previous flush
+ *
+ * Queues are flushed in the order their first observer was added. Events queued by observers
+ * are flushed in the same call, after the events that were queued before it.
+ *
+ * @param world A pointer to the world
+ *
+ * @note The world flushes its observers after every tick, so this is only needed for changes made between ticks
+ * @note Calling this from an observer does nothing, the running flush handles the new events
+ * */
+maybe_error_t maybe_world_flush_observers(
+	maybe_world_t* world
+);
+
 /*
  * @brief Run one logic cycle of all systems in a world
  *
  * @param world A pointer to the world
+ *
+ * @note This ignores the systems' schedules, every system runs exactly once, after all the spatial indexes are rebuilt.
+ * 		 The observers are flushed after the systems run
+ * @note Time-sliced systems (schedule.slices > 1) still process only their current slice of the entities
+ * @note An exported world is marked as changing during the update, and its directory is published after it, see export.h
  * */
 maybe_error_t maybe_world_update(
 	maybe_world_t* world
 );
 
+/*
+ * @brief Set the length of a world's fixed tick
+ *
+ * @param world A pointer to the world
+ * @param fixed_timestep The length of a fixed tick in seconds
+ * @param max_fixed_steps The maximum amount of fixed ticks a single advance may run, if 0 a default value is used
+ * */
+maybe_error_t maybe_world_set_fixed_timestep(
+	maybe_world_t* world,
+	double fixed_timestep,
+	uint32_t max_fixed_steps
+);
+
+/*
+ * @brief Set the thread pool a world runs its parallel work on
+ *
+ * @param world A pointer to the world
+ * @param thread_pool A pointer to the thread pool, it must stay valid while the world uses it. If NULL the work runs on the calling thread
+ * */
+maybe_error_t maybe_world_set_thread_pool(
+	maybe_world_t* world,
+	maybe_thread_pool_t* thread_pool
+);
+
+/*
+ * @brief Advance a world by an amount of time, running systems according to their schedules
+ *
+ * Fixed rate systems run once for every whole fixed timestep that has accumulated, and
+ * variable rate systems run once afterwards. A system with a divider only runs on the
+ * ticks that match its phase, and its delta_time covers all the ticks it skipped.
+ * The spatial indexes added to the world are rebuilt before every tick of their rate, and the
+ * observers are flushed after every tick.
+ *
+ * @param world A pointer to the world
+ * @param delta_time The time passed since the previous advance, in seconds
+ *
+ * @note If more than max_fixed_steps ticks have accumulated the extra time is dropped, so
+ * 		 a slow frame can not make the next frames slower
+ * @note An exported world is marked as changing during the advance, and its directory is published after it, see export.h
+ * */
+maybe_error_t maybe_world_advance(
+	maybe_world_t* world,
+	double delta_time
+);
+
+/*
+ * @brief Release memory left unused by removed entities, a bounded amount of work at a time
+ *
+ * Archetypes whose rows fill less than fill_ratio of their capacity are shrunk to fit their rows.
+ * Empty archetypes are shrunk and parked: they are removed from the systems' archetype lists, so
+ * systems do not visit them, until an entity is added to them again.
+ *
+ * @param world A pointer to the world
+ * @param fill_ratio Archetypes with a lower ratio of used rows to allocated rows are shrunk, between 0 and 1
+ * @param time_budget_ns The time after which the pass stops, and continues on the next call. 0 for no limit
+ * @param finished Set to whether all the archetypes were visited since the pass started, can be NULL
+ *
+ * @note Archetypes whose storage is shared with a fork or a parent are skipped, shrinking them would copy it
+ * */
+maybe_error_t maybe_world_compact(
+	maybe_world_t* world,
+	float fill_ratio,
+	uint64_t time_budget_ns,
+	bool* finished
+);
+
+/*
+ * Paging
+ *
+ * A world with a page store allocates its archetypes' columns from the store's file mapping, so the OS
+ * can page columns that are not used out to the file. Every maybe_world_update and maybe_world_advance
+ * increments the world's access tick, and before a system runs, the columns it reads are prefetched and
+ * their archetypes are stamped with the tick. maybe_world_page_out pages out the columns of archetypes
+ * that no system touched for a number of ticks, so the memory a world uses follows the archetypes that
+ * are in use and not the number of entities.
+ *
+ * Code that reads columns outside of systems, such as queries, calls maybe_world_prefetch first so
+ * the archetypes count as used and are read back before they are touched.
+ *
+ * Every column also counts the system runs that read it. maybe_world_split_cold_columns uses the
+ * counts to keep the columns that are read often on the heap and move the rest to the page store, so
+ * rarely read components, like debug names, do not take RAM next to the ones systems stream through.
+ *
+ * 		maybe_page_store_init(&store, "/var/tmp/world.pages", 0);
+ * 		maybe_world_set_page_store(&world, &store);
+ * 		...
+ * 		maybe_world_update(&world);
+ * 		maybe_world_page_out(&world, 600, NULL);
+ * */
+
+/*
+ * @brief Move the columns and entities of a world's archetypes to a page store, or back to the heap
+ *
+ * @param world A pointer to the world
+ * @param store A pointer to the page store, it must stay valid while the world and its forks use it. If NULL the heap is used
+ *
+ * @note Fails with MAYBE_ERROR_ECS_WORLD_HAS_FORKS if the world is a fork or has forks
+ * @note Entities moved from another world are copied to the store, see maybe_world_move_entities
+ * @note Fails with MAYBE_ERROR_ECS_WORLD_INVALID_PARAM if the world has a read guard, see read_guard.h
+ * */
+maybe_error_t maybe_world_set_page_store(
+	maybe_world_t* world,
+	maybe_page_store_t* store
+);
+
+/*
+ * @brief Page out the columns of the archetypes no system touched recently
+ *
+ * @param world A pointer to the world
+ * @param idle_ticks Archetypes that were not touched in this many access ticks are paged out
+ * @param paged_out_count Set to the number of archetypes paged out by this call, can be NULL
+ *
+ * @note The columns keep their content, touching them reads it back from the page store's file
+ * */
+maybe_error_t maybe_world_page_out(
+	maybe_world_t* world,
+	uint64_t idle_ticks,
+	uint32_t* paged_out_count
+);
+
+/*
+ * @brief Move the columns that were read by few system runs to the page store, and the rest to the heap
+ *
+ * @param world A pointer to the world, it must have a page store
+ * @param min_access_count Columns read by fewer system runs since the previous call are cold
+ * @param moved_count Set to the number of columns moved by this call, can be NULL
+ *
+ * @note The access counts are reset, so the next call judges the columns by the runs between the calls
+ * @note Fails with MAYBE_ERROR_ECS_WORLD_HAS_FORKS if the world is a fork or has forks
+ * @note New columns are allocated from the page store until a call finds them hot
+ * */
+maybe_error_t maybe_world_split_cold_columns(
+	maybe_world_t* world,
+	uint32_t min_access_count,
+	uint32_t* moved_count
+);
+
+/*
+ * @brief Prefetch the columns of the archetypes that have a set of components, and count them as touched
+ *
+ * @param world A pointer to the world
+ * @param component_count The number of components
+ * @param component_ids The components an archetype must have, only their columns are prefetched
+ *
+ * @note Systems do this on their own before they run, and both count as an access to the columns
+ * */
+maybe_error_t maybe_world_prefetch(
+	maybe_world_t* world,
+	uint32_t component_count,
+	uint32_t* component_ids
+);
+
+/*
+ * @brief Swap two rows of one of a world's archetypes, keeping the records of their entities
+ *
+ * @param world A pointer to the world
+ * @param archetype_index The index of the archetype in the world
+ * @param row_a The first row
+ * @param row_b The second row
+ *
+ * @note Used to reorder rows for locality, see sort.h
+ * */
+maybe_error_t maybe_world_swap_rows(
+	maybe_world_t* world,
+	uint32_t archetype_index,
+	uint32_t row_a,
+	uint32_t row_b
+);
+
+/*
+ * @brief Move all the entities of a world into another world
+ *
+ * @param destination A pointer to the world the entities are moved to
+ * @param source A pointer to the world the entities are moved from, it is left without entities
+ * @param component_map The destination component ID of every source component ID, if NULL the IDs are the same in both worlds
+ * @param entity_map A vector of maybe_world_entity_mapping_t the new IDs of the entities are pushed to, can be NULL
+ *
+ * @note See maybe_world_move_entities
+ * */
+maybe_error_t maybe_world_merge(
+	maybe_world_t* destination,
+	maybe_world_t* source,
+	uint32_t* component_map,
+	maybe_vector_t* entity_map
+);
+
+/*
+ * @brief Move the entities that have a set of components from one world into another world
+ *
+ * Entities are moved a whole archetype at a time: every component column is appended to the
+ * matching destination archetype with a single copy, and if that archetype is empty and its
+ * columns use the same allocator as the source's, such as the heap, the source columns are
+ * handed over without copying at all.
+ *
+ * @param destination A pointer to the world the entities are moved to
+ * @param source A pointer to the world the entities are moved from
+ * @param component_map The destination component ID of every source component ID, if NULL the IDs are the same in both worlds
+ * @param entity_map A vector of maybe_world_entity_mapping_t the new IDs of the entities are pushed to, can be NULL
+ * @param filter_count The number of components an entity must have to be moved, 0 moves all entities
+ *
+ * @note The final parameters are the source component IDs an entity must have to be moved
+ * @note The moved entities get new IDs in the destination world
+ * */
+maybe_error_t maybe_world_move_entities(
+	maybe_world_t* destination,
+	maybe_world_t* source,
+	uint32_t* component_map,
+	maybe_vector_t* entity_map,
+	uint32_t filter_count,
+	...
+);
+
+/*
+ * @brief Set the value of an entity's shared component, adding the component if the entity does not have it
+ *
+ * @param world A pointer to the world
+ * @param entity_id The entity's ID
+ * @param component_id The ID of a shared component type
+ * @param value The new value, it is copied into the world if no other entity has it
+ *
+ * @note The entity moves to the archetype of its new value
+ * */
+maybe_error_t maybe_world_set_shared_component(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	uint32_t component_id,
+	const void* value
+);
+
+/*
+ * @brief Get the value of an entity's shared component
+ *
+ * @param world A pointer to the world
+ * @param entity_id The entity's ID
+ * @param component_id The ID of a shared component type
+ * @param value The resulting value, shared by all the entities of the entity's archetype
+ * */
+maybe_error_t maybe_world_get_shared_component(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	uint32_t component_id,
+	const void** value
+);
+
+/*
+ * @brief Remove a shared component from an entity
+ *
+ * @param world A pointer to the world
+ * @param entity_id The entity's ID
+ * @param component_id The ID of a shared component type
+ * */
+maybe_error_t maybe_world_remove_shared_component(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	uint32_t component_id
+);
+
+/*
+ * @brief Create a copy-on-write fork of a world, for simulating ahead without changing the world
+ *
+ * The fork starts with the parent's entities, components and systems, without copying any rows:
+ * every column is shared with the parent until either world writes to it, and the first write
+ * copies only that column. Entity records are looked up in the parent until the fork changes them.
+ * Discarding the fork with maybe_world_free frees only what it copied.
+ *
+ * @param fork A pointer to the new world
+ * @param parent A pointer to the world to fork, can be a fork itself
+ *
+ * @note While a world has forks, changing its entities' archetypes fails with MAYBE_ERROR_ECS_WORLD_HAS_FORKS,
+ * 		 writing component values is still allowed
+ * @note Forks must be freed before their parent, and must not be used concurrently with it
+ * @note Forks have no observers or spatial indexes, they share the parent's thread pool and shared component values
+ * @note Fails with MAYBE_ERROR_ECS_WORLD_INVALID_PARAM if the parent has a read guard, see read_guard.h
+ * */
+maybe_error_t maybe_world_fork(
+	maybe_world_t* fork,
+	maybe_world_t* parent
+);
+
 /*
  * @brief Free an ECS world's resources
  *
  * @param world A pointer to the world
+ *
+ * @note A world with forks can not be freed until its forks are freed
  * */
 maybe_error_t maybe_world_free(
 	maybe_world_t* world
@@ -125,3 +733,57 @@ maybe_error_t maybe_world_free(
 	{\
 		maybe_world_add_component_type((world), sizeof(component), &MAYBE_COMPONENT_ID(component)); \
 	}
+
+#define MAYBE_REGISTER_SHARED_COMPONENT_TYPE(world, component) \
+	{\
+		maybe_world_add_shared_component_type((world), sizeof(component), &MAYBE_COMPONENT_ID(component)); \
+	}
+
+/* @brief The bit of a component type in a component mask, a constant for component types from a manifest */
+#define MAYBE_COMPONENT_BIT(component) MAYBE_COMPONENT_MASK_BIT(MAYBE_COMPONENT_ID(component))
+
+/*
+ * Component manifests
+ *
+ * MAYBE_DEFINE_COMPONENT_TYPE defines a variable that gets the component's ID when it is registered, so
+ * IDs depend on the registration order and are unknown to the compiler. A manifest lists the component
+ * types up front instead, and their IDs, sizes and alignments become compile-time constants:
+ *
+ * 		#define GAME_COMPONENTS(COMPONENT, SHARED_COMPONENT) \
+ * 			COMPONENT(position_t) \
+ * 			COMPONENT(velocity_t) \
+ * 			SHARED_COMPONENT(material_t)
+ *
+ * 		MAYBE_DECLARE_COMPONENT_MANIFEST(GAME_COMPONENTS)
+ * 		...
+ * 		MAYBE_REGISTER_COMPONENT_MANIFEST(&world, GAME_COMPONENTS);
+ *
+ * MAYBE_DECLARE_COMPONENT_MANIFEST declares every MAYBE_COMPONENT_ID(component) as an enum constant, in the
+ * order of the manifest, and can be placed in a header. MAYBE_COMPONENT_ID and the query macros are used
+ * as before, and component masks like MAYBE_COMPONENT_BIT(position_t) | MAYBE_COMPONENT_BIT(velocity_t)
+ * fold to constants. The IDs only change when the manifest does, so they are the same across builds
+ * and worlds.
+ * */
+
+#define MAYBE_COMPONENT_MANIFEST__ID(component) MAYBE_COMPONENT_ID(component),
+#define MAYBE_COMPONENT_MANIFEST__DESCRIPTOR(component) \
+	{ MAYBE_COMPONENT_ID(component), sizeof(component), _Alignof(component), false },
+#define MAYBE_COMPONENT_MANIFEST__SHARED_DESCRIPTOR(component) \
+	{ MAYBE_COMPONENT_ID(component), sizeof(component), _Alignof(component), true },
+
+/* @brief The number of component types in a manifest */
+#define MAYBE_COMPONENT_MANIFEST_COUNT(manifest) maybe_component_manifest_count__##manifest
+
+#define MAYBE_DECLARE_COMPONENT_MANIFEST(manifest) \
+	enum { \
+		manifest(MAYBE_COMPONENT_MANIFEST__ID, MAYBE_COMPONENT_MANIFEST__ID) \
+		MAYBE_COMPONENT_MANIFEST_COUNT(manifest) \
+	};
+
+#define MAYBE_REGISTER_COMPONENT_MANIFEST(world, manifest) \
+	{\
+		static const maybe_component_descriptor_t maybe_component_manifest__descriptors[] = { \
+			manifest(MAYBE_COMPONENT_MANIFEST__DESCRIPTOR, MAYBE_COMPONENT_MANIFEST__SHARED_DESCRIPTOR) \
+		}; \
+		maybe_world_add_component_types((world), MAYBE_COMPONENT_MANIFEST_COUNT(manifest), maybe_component_manifest__descriptors); \
+	}
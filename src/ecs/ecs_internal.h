@@ -1,3 +1,5 @@
+#pragma once
+
 #include <stdint.h>
 
 #include "common/common.h"
@@ -5,17 +7,326 @@
 
 #include "ecs.h"
 
+/* @brief The archetype index of the record of an entity a fork removed, which hides the parent's record */
+#define MAYBE_WORLD_REMOVED_RECORD (UINT32_MAX)
+
 /*
- * @brief Find a matching archetype for a list of component types
+ * @brief Find a matching archetype for a list of component types and shared values
  *
  * @param world The world
  * @param components An array of the component type IDs
  * @param component_count The amount of components
+ * @param shared_component_ids An array of the shared component type IDs
+ * @param shared_values An array of the stored value of every shared component type
+ * @param shared_count The amount of shared components
  * @param component_indices An array that will be filled with the indices of every component in the archetype
  * */
 static maybe_archetype_t* find_matching_archetype(
 	maybe_world_t* world,
 	uint32_t* component_ids,
 	uint32_t component_count,
-	uint32_t* component_indices
+	uint32_t* shared_component_ids,
+	void** shared_values,
+	uint32_t shared_count,
+	uint32_t* component_indices,
+	uint32_t* archetype_index
+);
+
+/*
+ * @brief Find an archetype matching a list of component types and shared values, and create it if it does not exist
+ *
+ * @param world The world
+ * @param components An array of the component type IDs
+ * @param component_count The amount of components
+ * @param shared_component_ids An array of the shared component type IDs
+ * @param shared_values An array of the stored value of every shared component type
+ * @param shared_count The amount of shared components
+ * @param archetype_index The index of the archetype in the world
+ * */
+static maybe_error_t get_or_create_archetype(
+	maybe_world_t* world,
+	uint32_t* component_ids,
+	uint32_t component_count,
+	uint32_t* shared_component_ids,
+	void** shared_values,
+	uint32_t shared_count,
+	uint32_t* archetype_index
+);
+
+/*
+ * @brief Check that none of a list of component types is shared
+ *
+ * @param world The world
+ * @param component_ids An array of the component type IDs
+ * @param component_count The amount of components
+ * */
+static maybe_error_t check_unshared_components(
+	maybe_world_t* world,
+	uint32_t* component_ids,
+	uint32_t component_count
+);
+
+/*
+ * @brief Move an entity's row to another archetype, copying all the components both archetypes share
+ *
+ * @param world The world
+ * @param entity_id The entity
+ * @param record The entity's record, the record in the world's map is updated to the new location
+ * @param archetype_index The index of the destination archetype
+ * */
+static maybe_error_t move_entity(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	maybe_world_record_t* record,
+	uint32_t archetype_index
+);
+
+/*
+ * @brief Remove an entity's row from its archetype, and fix the record of the row moved into its place
+ *
+ * @param world The world
+ * @param record The entity's record, a fork's record may move in its map
+ * */
+static maybe_error_t remove_entity_row(
+	maybe_world_t* world,
+	maybe_world_record_t* record
+);
+
+/*
+ * @brief Register a system in a world using a va_list for the component IDs
+ *
+ * @param world The world
+ * @param system_function The system logic function
+ * @param schedule When the system should run
+ * @param component_count Number of components the system requires
+ * @param components A list of the component IDs used by the system
+ * */
+static maybe_error_t register_system_va_list(
+	maybe_world_t* world,
+	maybe_system_function_t system_function,
+	maybe_system_schedule_t schedule,
+	uint32_t component_count,
+	va_list components
+);
+
+/*
+ * @brief Pick the phase with the least systems of the same rate and divider
+ *
+ * @param world The world
+ * @param schedule The schedule of the new system
+ * */
+static uint32_t choose_system_phase(
+	maybe_world_t* world,
+	maybe_system_schedule_t* schedule
+);
+
+/*
+ * @brief Run all the systems of a rate that are scheduled for a tick
+ *
+ * @param world The world
+ * @param rate The rate of the systems to run
+ * @param tick The tick number
+ * @param delta_time The time that passed since the previous tick
+ * */
+static void run_scheduled_systems(
+	maybe_world_t* world,
+	maybe_system_rate_t rate,
+	uint64_t tick,
+	double delta_time
+);
+
+/*
+ * @brief Park an empty archetype, removing it from the systems' archetype lists
+ *
+ * @param world The world
+ * @param archetype The archetype
+ * */
+static maybe_error_t park_archetype(
+	maybe_world_t* world,
+	maybe_archetype_t* archetype
+);
+
+/*
+ * @brief Return a parked archetype to the systems' archetype lists
+ *
+ * @param world The world
+ * @param archetype The archetype
+ * */
+static maybe_error_t unpark_archetype(
+	maybe_world_t* world,
+	maybe_archetype_t* archetype
+);
+
+/*
+ * @brief Move all the rows of an archetype to the matching archetype of another world
+ *
+ * @param destination The world the rows are moved to
+ * @param source The world the rows are moved from
+ * @param source_archetype The archetype in the source world
+ * @param component_map The destination component ID of every source component ID, can be NULL
+ * @param entity_map A vector the new IDs of the entities are pushed to, can be NULL
+ * */
+static maybe_error_t transfer_archetype(
+	maybe_world_t* destination,
+	maybe_world_t* source,
+	maybe_archetype_t* source_archetype,
+	uint32_t* component_map,
+	maybe_vector_t* entity_map
+);
+
+/*
+ * @brief Rebuild the spatial indexes of a world that are rebuilt before ticks of a rate
+ *
+ * @param world The world
+ * @param rate The rate of the tick that is about to run
+ * */
+static maybe_error_t rebuild_spatial_indexes(
+	maybe_world_t* world,
+	maybe_system_rate_t rate
+);
+
+/*
+ * @brief Queue an event on a component for some entities, if the event has observers
+ *
+ * @param world The world
+ * @param component_id The component the event happened to
+ * @param event The event
+ * @param entities The entities the event happened to
+ * @param entity_count The number of entities
+ * */
+static maybe_error_t queue_observer_events(
+	maybe_world_t* world,
+	uint32_t component_id,
+	maybe_observer_event_t event,
+	const maybe_entity_t* entities,
+	uint32_t entity_count
+);
+
+/*
+ * @brief Queue an event on every component of an archetype for some entities, if the events have observers
+ *
+ * @param world The world
+ * @param archetype The archetype
+ * @param event The event
+ * @param entities The entities the event happened to
+ * @param entity_count The number of entities
+ * */
+static maybe_error_t queue_archetype_observer_events(
+	maybe_world_t* world,
+	maybe_archetype_t* archetype,
+	maybe_observer_event_t event,
+	const maybe_entity_t* entities,
+	uint32_t entity_count
+);
+
+/*
+ * @brief Find an entity's record, copying it from the world's ancestors if the world is a fork
+ *
+ * @param world The world
+ * @param entity_id The entity's ID
+ * @param record The record, NULL if the entity was not found
+ * */
+static maybe_error_t find_record(
+	maybe_world_t* world,
+	maybe_entity_t entity_id,
+	maybe_world_record_t** record
+);
+
+/*
+ * @brief Forget an entity's record
+ *
+ * @param world The world
+ * @param entity_id The entity's ID
+ * */
+static maybe_error_t forget_record(
+	maybe_world_t* world,
+	maybe_entity_t entity_id
+);
+
+/*
+ * @brief Check whether an archetype has all of a list of components, shared or not
+ *
+ * @param archetype The archetype
+ * @param component_ids An array of the component type IDs
+ * @param component_count The amount of components
+ * */
+static bool archetype_matches(
+	maybe_archetype_t* archetype,
+	uint32_t* component_ids,
+	uint32_t component_count
+);
+
+/*
+ * @brief Add or remove a component for every entity that has all of a list of components
+ *
+ * @param world The world
+ * @param component_id The component to add or remove
+ * @param add Whether the component is added or removed
+ * @param component_count The amount of components in the list
+ * @param component_ids An array of the component type IDs
+ * @param changed_count Set to the number of changed entities, can be NULL
+ * */
+static maybe_error_t change_matching_components(
+	maybe_world_t* world,
+	uint32_t component_id,
+	bool add,
+	uint32_t component_count,
+	uint32_t* component_ids,
+	uint32_t* changed_count
+);
+
+/*
+ * @brief Add a component to an archetype or remove one from it in place, keeping its rows where they are
+ *
+ * @param world The world
+ * @param archetype The archetype, no other archetype may have its new component set
+ * @param component_id The component to add or remove
+ * @param add Whether the component is added or removed
+ * @param component_index The index of the removed component in the archetype
+ * */
+static maybe_error_t relabel_archetype(
+	maybe_world_t* world,
+	maybe_archetype_t* archetype,
+	uint32_t component_id,
+	bool add,
+	uint32_t component_index
+);
+
+/*
+ * @brief Move all the rows of an archetype to another archetype of the same world, keeping the entities' IDs
+ *
+ * @param world The world
+ * @param source The archetype the rows are moved from
+ * @param destination The archetype the rows are moved to, its components not in the source are zeroed
+ * @param destination_index The index of the destination in the world
+ * */
+static maybe_error_t move_archetype_rows(
+	maybe_world_t* world,
+	maybe_archetype_t* source,
+	maybe_archetype_t* destination,
+	uint32_t destination_index
+);
+
+/*
+ * @brief Count an access to a column, and prefetch it if it is stored in the world's page store
+ *
+ * @param world The world
+ * @param archetype The column's archetype
+ * @param column_index The index of the column in the archetype
+ * */
+static void touch_column(
+	maybe_world_t* world,
+	maybe_archetype_t* archetype,
+	uint32_t column_index
+);
+
+/*
+ * @brief Count an access to the columns a system reads and prefetch them, and stamp its archetypes with the world's access tick
+ *
+ * @param world The world
+ * @param system The system that is about to run
+ * */
+static void touch_system_columns(
+	maybe_world_t* world,
+	maybe_system_t* system
 );
@@ -1,3 +1,5 @@
 #pragma once
 
+#include <stdint.h>
+
 typedef uint64_t maybe_entity_t;
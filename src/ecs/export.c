@@ -0,0 +1,393 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "common/error.h"
+#include "common/common.h"
+#include "common/vector/vector.h"
+#include "common/page_store/page_store.h"
+
+#include "export.h"
+#include "export_internal.h"
+
+maybe_error_t maybe_world_export_init(
+	maybe_world_export_t* world_export,
+	maybe_world_t* world,
+	const char* name,
+	uint64_t reserved_bytes
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	const maybe_vector_allocator_t* allocator;
+	bool is_store_initialized = false;
+
+	if ((NULL == world_export) || (NULL == world) || (NULL == name)) {
+		result = MAYBE_ERROR_WORLD_EXPORT_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if ((NULL != world->fork_parent) || (world->fork_count > 0)) {
+		result = MAYBE_ERROR_ECS_WORLD_HAS_FORKS;
+		goto l_cleanup;
+	}
+
+	if ((NULL != world->page_store) || (NULL != world->world_export)) {
+		result = MAYBE_ERROR_ECS_WORLD_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	result = maybe_page_store_init_shared(&world_export->store, name, reserved_bytes);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	is_store_initialized = true;
+	allocator = maybe_page_store_get_allocator(&world_export->store);
+
+	/* The store is empty, so its first allocation is at the start of the object where readers look for the header */
+	world_export->header = (maybe_world_export_header_t*)allocator->reallocate(allocator->context, NULL, 0, sizeof(maybe_world_export_header_t));
+	if (NULL == world_export->header) {
+		result = MAYBE_ERROR_WORLD_EXPORT_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+
+	memset(world_export->header, 0, sizeof(*world_export->header));
+	world_export->header->magic = MAYBE_WORLD_EXPORT_MAGIC;
+	world_export->header->version = MAYBE_WORLD_EXPORT_VERSION;
+	world_export->header->header_size = sizeof(maybe_world_export_header_t);
+	world_export->header->segment_size = world_export->store.reserved_bytes;
+	world_export->header->component_sizes_offset = MAYBE_WORLD_EXPORT_NOT_EXPORTED;
+	world_export->header->archetypes_offset = MAYBE_WORLD_EXPORT_NOT_EXPORTED;
+	world_export->header->columns_offset = MAYBE_WORLD_EXPORT_NOT_EXPORTED;
+	atomic_init(&world_export->header->epoch, 0);
+
+	result = maybe_vector_init_with_allocator(&world_export->component_sizes, sizeof(uint32_t), 0, allocator);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init_with_allocator(&world_export->archetypes, sizeof(maybe_world_export_archetype_t), 0, allocator);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init_with_allocator(&world_export->columns, sizeof(maybe_world_export_column_t), 0, allocator);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_world_set_page_store(world, &world_export->store);
+	if (IS_FAILURE(result)) {
+		/* Some archetypes may have moved already, so they move back before the store is freed */
+		(void)maybe_world_set_page_store(world, NULL);
+		goto l_cleanup;
+	}
+
+	world_export->world = world;
+	world->world_export = world_export;
+
+	result = maybe_world_export_begin(world_export);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_world_export_publish(world_export);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (IS_FAILURE(result) && is_store_initialized) {
+		if ((NULL != world) && (world_export == world->world_export)) {
+			world->world_export = NULL;
+			(void)maybe_world_set_page_store(world, NULL);
+		}
+
+		/* The vectors and the header are in the store, so freeing it frees them */
+		(void)maybe_page_store_free(&world_export->store);
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_world_export_begin(
+	maybe_world_export_t* world_export
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint64_t epoch;
+
+	if (NULL == world_export) {
+		result = MAYBE_ERROR_WORLD_EXPORT_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Only this process writes the epoch, so it can be read without synchronization */
+	epoch = atomic_load_explicit(&world_export->header->epoch, memory_order_relaxed);
+	if (0 == (epoch & 1)) {
+		atomic_store_explicit(&world_export->header->epoch, epoch + 1, memory_order_relaxed);
+
+		/* The changes that follow must not be seen before the odd epoch */
+		atomic_thread_fence(memory_order_release);
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_export_publish(
+	maybe_world_export_t* world_export
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_world_export_header_t* header;
+	maybe_world_t* world;
+	maybe_archetype_t* archetype;
+	maybe_vector_t* column;
+	maybe_world_export_archetype_t* archetype_entry;
+	maybe_world_export_column_t* column_entry;
+	uint32_t column_count = 0;
+	uint32_t i, j;
+	uint64_t epoch;
+
+	if (NULL == world_export) {
+		result = MAYBE_ERROR_WORLD_EXPORT_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	header = world_export->header;
+	world = world_export->world;
+	if (NULL == world) {
+		result = MAYBE_ERROR_WORLD_EXPORT_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = maybe_world_export_begin(world_export);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < world->archetypes.length; i++) {
+		column_count += MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i)->component_types_count;
+	}
+
+	result = maybe_vector_reserve(&world_export->component_sizes, world->component_types.length);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_reserve(&world_export->archetypes, world->archetypes.length);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_reserve(&world_export->columns, column_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	world_export->component_sizes.length = world->component_types.length;
+	for (i = 0; i < world->component_types.length; i++) {
+		MAYBE_VECTOR_ELEMENT(world_export->component_sizes, uint32_t, i) =
+			MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, i).component_size;
+	}
+
+	world_export->archetypes.length = world->archetypes.length;
+	world_export->columns.length = column_count;
+	column_count = 0;
+	for (i = 0; i < world->archetypes.length; i++) {
+		archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i);
+		archetype_entry = &MAYBE_VECTOR_ELEMENT(world_export->archetypes, maybe_world_export_archetype_t, i);
+		archetype_entry->entities_offset = get_offset(world_export, archetype->entities.elements);
+		archetype_entry->row_count = archetype->entities.length;
+		archetype_entry->column_count = archetype->component_types_count;
+		archetype_entry->first_column = column_count;
+		archetype_entry->padding = 0;
+
+		for (j = 0; j < archetype->component_types_count; j++) {
+			column = &MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, j);
+			column_entry = &MAYBE_VECTOR_ELEMENT(world_export->columns, maybe_world_export_column_t, column_count);
+			column_entry->offset = get_offset(world_export, column->elements);
+			column_entry->component_id = MAYBE_VECTOR_ELEMENT(archetype->component_ids, uint32_t, j);
+			column_entry->element_size = column->element_size;
+			column_count++;
+		}
+	}
+
+	/* The tables may have moved when they grew */
+	header->tick = world->access_tick;
+	header->component_type_count = world_export->component_sizes.length;
+	header->archetype_count = world_export->archetypes.length;
+	header->column_count = world_export->columns.length;
+	header->component_sizes_offset = get_offset(world_export, world_export->component_sizes.elements);
+	header->archetypes_offset = get_offset(world_export, world_export->archetypes.elements);
+	header->columns_offset = get_offset(world_export, world_export->columns.elements);
+
+	/* Readers that see the even epoch see everything written before it */
+	epoch = atomic_load_explicit(&header->epoch, memory_order_relaxed);
+	atomic_store_explicit(&header->epoch, epoch + 1, memory_order_release);
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_export_free(
+	maybe_world_export_t* world_export
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_error_t free_result;
+
+	if (NULL == world_export) {
+		result = MAYBE_ERROR_WORLD_EXPORT_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* The world's storage is in the store, so it has to move out before the store is unmapped */
+	if (NULL != world_export->world) {
+		result = maybe_world_set_page_store(world_export->world, NULL);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		world_export->world->world_export = NULL;
+		world_export->world = NULL;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+
+	free_result = maybe_vector_free(&world_export->component_sizes);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&world_export->archetypes);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&world_export->columns);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_page_store_free(&world_export->store);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	world_export->header = NULL;
+
+	/* If any free operation failed, return an error */
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_export_reader_open(
+	maybe_world_export_reader_t* reader,
+	const char* name
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	const maybe_world_export_header_t* header;
+	struct stat file_stat;
+	void* base;
+
+	if ((NULL == reader) || (NULL == name)) {
+		result = MAYBE_ERROR_WORLD_EXPORT_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	reader->base = NULL;
+	reader->size = 0;
+
+	reader->file = shm_open(name, O_RDONLY, 0);
+	if (-1 == reader->file) {
+		result = MAYBE_ERROR_WORLD_EXPORT_OPEN_FAILED;
+		goto l_cleanup;
+	}
+
+	if ((0 != fstat(reader->file, &file_stat)) || ((size_t)file_stat.st_size < sizeof(maybe_world_export_header_t))) {
+		result = MAYBE_ERROR_WORLD_EXPORT_OPEN_FAILED;
+		goto l_cleanup;
+	}
+
+	base = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_SHARED, reader->file, 0);
+	if (MAP_FAILED == base) {
+		result = MAYBE_ERROR_WORLD_EXPORT_OPEN_FAILED;
+		goto l_cleanup;
+	}
+
+	reader->base = (const uint8_t*)base;
+	reader->size = (size_t)file_stat.st_size;
+
+	header = (const maybe_world_export_header_t*)reader->base;
+	if ((MAYBE_WORLD_EXPORT_MAGIC != header->magic) || (MAYBE_WORLD_EXPORT_VERSION != header->version)) {
+		result = MAYBE_ERROR_WORLD_EXPORT_BAD_SEGMENT;
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (IS_FAILURE(result) && (NULL != reader) && (NULL != name)) {
+		(void)maybe_world_export_reader_close(reader);
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_world_export_reader_close(
+	maybe_world_export_reader_t* reader
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if (NULL == reader) {
+		result = MAYBE_ERROR_WORLD_EXPORT_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+
+	if (NULL != reader->base) {
+		if (0 != munmap((void*)reader->base, reader->size)) {
+			result = MAYBE_ERROR_WORLD_EXPORT_OPEN_FAILED;
+		}
+		reader->base = NULL;
+		reader->size = 0;
+	}
+
+	if (-1 != reader->file) {
+		if (0 != close(reader->file)) {
+			result = MAYBE_ERROR_WORLD_EXPORT_OPEN_FAILED;
+		}
+		reader->file = -1;
+	}
+
+	/* If any free operation failed, return an error */
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+uint64_t get_offset(
+	const maybe_world_export_t* world_export,
+	const void* memory
+) {
+	if (!maybe_page_store_contains(&world_export->store, memory)) {
+		return MAYBE_WORLD_EXPORT_NOT_EXPORTED;
+	}
+
+	return (uint64_t)((const uint8_t*)memory - world_export->store.base);
+}
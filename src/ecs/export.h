@@ -0,0 +1,220 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include "common/error.h"
+#include "common/vector/vector.h"
+#include "common/page_store/page_store.h"
+#include "ecs.h"
+
+/*
+ * World export
+ *
+ * An exported world allocates its archetypes' columns and entities in a POSIX shared memory object, see
+ * maybe_page_store_init_shared, and publishes a directory of them in the same object. A process that maps
+ * the object, such as an entity inspector, reads the world in place without pausing or copying it.
+ *
+ * The header at the start of the object holds an epoch that works like a seqlock: it is odd while the
+ * world is being changed, and is made even once the directory is published again. maybe_world_update
+ * and maybe_world_advance do this on their own, and publish even when they fail, so readers are not left
+ * waiting on an odd epoch. Changes made outside of them, like adding entities,
+ * must be wrapped with maybe_world_export_begin and maybe_world_export_publish, or readers may see them
+ * half done.
+ *
+ * Everything in the object is found by offsets from its start, since every process maps it at another
+ * address. A reader takes a snapshot like this:
+ *
+ * 		do {
+ * 			epoch = maybe_world_export_reader_begin(&reader);
+ * 			if (epoch & 1) {
+ * 				continue;
+ * 			}
+ * 			... read the directory and the columns through maybe_world_export_reader_get ...
+ * 		} while (!maybe_world_export_reader_validate(&reader, epoch));
+ *
+ * The reader may see torn data before it validates the epoch, but every offset it reads is checked
+ * against the size of the object, so it never reads outside of it.
+ * */
+
+/* @brief The value of the first 8 bytes of an exported world's shared memory object */
+#define MAYBE_WORLD_EXPORT_MAGIC (0x505845454259414Dull) /* "MAYBEEXP" */
+#define MAYBE_WORLD_EXPORT_VERSION (1)
+
+/* @brief The offset of storage that is not in the shared memory object, such as an empty column or a directory that was not published yet */
+#define MAYBE_WORLD_EXPORT_NOT_EXPORTED (UINT64_MAX)
+
+/* @brief The start of an exported world's shared memory object */
+typedef struct {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t header_size;
+	_Atomic uint64_t epoch; /* Odd while the world is changed, even when the directory matches the world */
+	uint64_t segment_size; /* The size of the shared memory object */
+	uint64_t tick; /* The world's access tick when the directory was published */
+	uint32_t component_type_count;
+	uint32_t archetype_count;
+	uint32_t column_count;
+	uint32_t padding;
+	uint64_t component_sizes_offset; /* A uint32_t size for every component type, by ID */
+	uint64_t archetypes_offset; /* A maybe_world_export_archetype_t for every archetype, by index */
+	uint64_t columns_offset; /* A maybe_world_export_column_t for every column of every archetype */
+} maybe_world_export_header_t;
+
+/* @brief An archetype in an exported world's directory */
+typedef struct {
+	uint64_t entities_offset; /* A maybe_entity_t for every row */
+	uint32_t row_count;
+	uint32_t column_count;
+	uint32_t first_column; /* The index of the archetype's first column in the columns table */
+	uint32_t padding;
+} maybe_world_export_archetype_t;
+
+/* @brief A column in an exported world's directory */
+typedef struct {
+	uint64_t offset; /* The rows of the column, row_count elements of element_size bytes */
+	uint32_t component_id;
+	uint32_t element_size;
+} maybe_world_export_column_t;
+
+/* @brief The state of a world's export */
+typedef struct maybe_world_export_s {
+	maybe_page_store_t store; /* The shared memory object, the world's page store */
+	maybe_world_t* world; /* NULL once the world is freed */
+	maybe_world_export_header_t* header;
+	MAYBE_VECTOR(uint32_t) component_sizes; /* The directory's tables, allocated in the shared memory object */
+	MAYBE_VECTOR(maybe_world_export_archetype_t) archetypes;
+	MAYBE_VECTOR(maybe_world_export_column_t) columns;
+} maybe_world_export_t;
+
+/* @brief A read-only mapping of an exported world in another process */
+typedef struct {
+	int file;
+	const uint8_t* base;
+	size_t size;
+} maybe_world_export_reader_t;
+
+/*
+ * @brief Export a world through a POSIX shared memory object
+ *
+ * @param world_export A pointer to the new export, it must stay valid while the world is exported
+ * @param world A pointer to the world, its columns and entities are moved to the shared memory object
+ * @param name The name of the shared memory object, like "/name"
+ * @param reserved_bytes The size of the object, see maybe_page_store_init_shared. If 0 the default is used
+ *
+ * @note Fails with MAYBE_ERROR_ECS_WORLD_HAS_FORKS if the world is a fork or has forks
+ * @note The world must not have a page store already, and maybe_world_split_cold_columns must not be used on it
+ * */
+maybe_error_t maybe_world_export_init(
+	maybe_world_export_t* world_export,
+	maybe_world_t* world,
+	const char* name,
+	uint64_t reserved_bytes
+);
+
+/*
+ * @brief Mark an exported world as being changed, so readers retry their snapshots
+ *
+ * @param world_export A pointer to the export
+ * */
+maybe_error_t maybe_world_export_begin(
+	maybe_world_export_t* world_export
+);
+
+/*
+ * @brief Publish the directory of an exported world, and mark it as consistent
+ *
+ * @param world_export A pointer to the export
+ * */
+maybe_error_t maybe_world_export_publish(
+	maybe_world_export_t* world_export
+);
+
+/*
+ * @brief Stop exporting a world and free the export's resources
+ *
+ * @param world_export A pointer to the export
+ *
+ * @note If the world was not freed yet its storage moves back to the heap, and it must not have forks
+ * */
+maybe_error_t maybe_world_export_free(
+	maybe_world_export_t* world_export
+);
+
+/*
+ * @brief Map an exported world for reading
+ *
+ * @param reader A pointer to the new reader
+ * @param name The name of the world's shared memory object
+ * */
+maybe_error_t maybe_world_export_reader_open(
+	maybe_world_export_reader_t* reader,
+	const char* name
+);
+
+/*
+ * @brief Unmap an exported world
+ *
+ * @param reader A pointer to the reader
+ * */
+maybe_error_t maybe_world_export_reader_close(
+	maybe_world_export_reader_t* reader
+);
+
+/*
+ * @brief Get a pointer to a range of an exported world's shared memory object
+ *
+ * @param reader A pointer to the reader
+ * @param offset The offset of the range
+ * @param size The size of the range in bytes
+ *
+ * @return The range, or NULL if it is not inside the object
+ * */
+static inline const void* maybe_world_export_reader_get(
+	const maybe_world_export_reader_t* reader,
+	uint64_t offset,
+	uint64_t size
+) {
+	if ((offset > reader->size) || (size > reader->size - offset)) {
+		return NULL;
+	}
+
+	return reader->base + offset;
+}
+
+/*
+ * @brief Start a snapshot of an exported world
+ *
+ * @param reader A pointer to the reader
+ *
+ * @return The epoch the snapshot is read at, if it is odd the world is being changed and the snapshot must be retried
+ * */
+static inline uint64_t maybe_world_export_reader_begin(
+	const maybe_world_export_reader_t* reader
+) {
+	const maybe_world_export_header_t* header = (const maybe_world_export_header_t*)reader->base;
+
+	return atomic_load_explicit((_Atomic uint64_t*)&header->epoch, memory_order_acquire);
+}
+
+/*
+ * @brief Check that a snapshot of an exported world is consistent, after all of it was read
+ *
+ * @param reader A pointer to the reader
+ * @param epoch The epoch from maybe_world_export_reader_begin
+ *
+ * @return Whether the world did not change while the snapshot was read
+ * */
+static inline bool maybe_world_export_reader_validate(
+	const maybe_world_export_reader_t* reader,
+	uint64_t epoch
+) {
+	const maybe_world_export_header_t* header = (const maybe_world_export_header_t*)reader->base;
+
+	/* The reads of the snapshot must not move after the second read of the epoch */
+	atomic_thread_fence(memory_order_acquire);
+
+	return (0 == (epoch & 1)) && (epoch == atomic_load_explicit((_Atomic uint64_t*)&header->epoch, memory_order_relaxed));
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "export.h"
+
+/*
+ * @brief Get the offset of storage in an export's shared memory object
+ *
+ * @param world_export The export
+ * @param memory The storage
+ *
+ * @return The offset, or MAYBE_WORLD_EXPORT_NOT_EXPORTED if the storage is not in the object
+ * */
+static uint64_t get_offset(
+	const maybe_world_export_t* world_export,
+	const void* memory
+);
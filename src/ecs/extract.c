@@ -0,0 +1,436 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "common/error.h"
+#include "common/common.h"
+#include "common/vector/vector.h"
+
+#include "extract.h"
+#include "extract_internal.h"
+
+maybe_error_t maybe_frame_extractor_init(
+	maybe_frame_extractor_t* extractor,
+	maybe_world_t* world,
+	uint32_t component_count,
+	const uint32_t* component_ids
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_component_type_t* component_type;
+	maybe_vector_t column;
+	uint32_t i, j;
+
+	if ((NULL == extractor) || (NULL == world) || ((component_count > 0) && (NULL == component_ids))) {
+		result = MAYBE_ERROR_FRAME_EXTRACTOR_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	memset(extractor, 0, sizeof(*extractor));
+	pthread_mutex_init(&extractor->mutex, NULL);
+	pthread_cond_init(&extractor->ready_condition, NULL);
+	pthread_cond_init(&extractor->released_condition, NULL);
+
+	/* Zero sized arrays are not allocated, so allocate at least one element */
+	extractor->component_ids = MALLOC_T(uint32_t, component_count + 1);
+	extractor->component_sizes = MALLOC_T(uint32_t, component_count + 1);
+	extractor->component_indices = MALLOC_T(uint32_t, component_count + 1);
+	if ((NULL == extractor->component_ids) || (NULL == extractor->component_sizes) || (NULL == extractor->component_indices)) {
+		result = MAYBE_ERROR_FRAME_EXTRACTOR_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < component_count; i++) {
+		if (component_ids[i] >= world->component_types.length) {
+			result = MAYBE_ERROR_FRAME_EXTRACTOR_INVALID_PARAM;
+			goto l_cleanup;
+		}
+
+		component_type = &MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, component_ids[i]);
+		if (NULL != component_type->shared_store) {
+			result = MAYBE_ERROR_FRAME_EXTRACTOR_INVALID_PARAM;
+			goto l_cleanup;
+		}
+
+		extractor->component_ids[i] = component_ids[i];
+		extractor->component_sizes[i] = component_type->component_size;
+		extractor->component_count++;
+	}
+
+	for (i = 0; i < MAYBE_FRAME_EXTRACTOR_PACKET_COUNT; i++) {
+		result = maybe_vector_init(&extractor->packets[i].entities, sizeof(maybe_entity_t), 0);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		result = maybe_vector_init(&extractor->packets[i].columns, sizeof(maybe_vector_t), component_count);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		for (j = 0; j < component_count; j++) {
+			result = maybe_vector_init(&column, extractor->component_sizes[j], 0);
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+
+			result = maybe_vector_push(&extractor->packets[i].columns, &column);
+			if (IS_FAILURE(result)) {
+				(void)maybe_vector_free(&column);
+				goto l_cleanup;
+			}
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (IS_FAILURE(result) && (MAYBE_ERROR_FRAME_EXTRACTOR_NULL_PARAM != result)) {
+		(void)maybe_frame_extractor_free(extractor);
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_frame_extractor_start(
+	maybe_frame_extractor_t* extractor,
+	maybe_frame_consumer_t consumer,
+	void* context
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if ((NULL == extractor) || (NULL == consumer)) {
+		result = MAYBE_ERROR_FRAME_EXTRACTOR_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (extractor->has_consumer_thread || extractor->stopping) {
+		result = MAYBE_ERROR_FRAME_EXTRACTOR_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	extractor->consumer = consumer;
+	extractor->consumer_context = context;
+
+	if (0 != pthread_create(&extractor->consumer_thread, NULL, consumer_main, extractor)) {
+		result = MAYBE_ERROR_FRAME_EXTRACTOR_THREAD_CREATION_FAILED;
+		goto l_cleanup;
+	}
+	extractor->has_consumer_thread = true;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_frame_extractor_extract(
+	maybe_frame_extractor_t* extractor,
+	maybe_world_t* world
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_frame_packet_t* packet;
+	uint32_t row_count, i;
+	bool stopping;
+
+	if ((NULL == extractor) || (NULL == world)) {
+		result = MAYBE_ERROR_FRAME_EXTRACTOR_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Only this function changes extracted_count, so the packet can be picked before locking */
+	packet = &extractor->packets[extractor->extracted_count % MAYBE_FRAME_EXTRACTOR_PACKET_COUNT];
+
+	pthread_mutex_lock(&extractor->mutex);
+	while (packet->is_ready && !extractor->stopping) {
+		pthread_cond_wait(&extractor->released_condition, &extractor->mutex);
+	}
+	stopping = extractor->stopping;
+	pthread_mutex_unlock(&extractor->mutex);
+
+	if (stopping) {
+		result = MAYBE_ERROR_FRAME_EXTRACTOR_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	/* The consumer does not look at a packet that is not ready, so it is filled without the lock */
+	row_count = count_rows(extractor, world);
+
+	result = maybe_vector_reserve(&packet->entities, row_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < extractor->component_count; i++) {
+		result = maybe_vector_reserve(&MAYBE_VECTOR_ELEMENT(packet->columns, maybe_vector_t, i), row_count);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	copy_rows(extractor, world, packet);
+
+	pthread_mutex_lock(&extractor->mutex);
+	packet->frame = extractor->extracted_count;
+	packet->is_ready = true;
+	extractor->extracted_count++;
+	pthread_cond_signal(&extractor->ready_condition);
+	pthread_mutex_unlock(&extractor->mutex);
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_frame_extractor_acquire(
+	maybe_frame_extractor_t* extractor,
+	const maybe_frame_packet_t** packet
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_frame_packet_t* next;
+
+	if ((NULL == extractor) || (NULL == packet)) {
+		result = MAYBE_ERROR_FRAME_EXTRACTOR_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	pthread_mutex_lock(&extractor->mutex);
+	next = &extractor->packets[extractor->consumed_count % MAYBE_FRAME_EXTRACTOR_PACKET_COUNT];
+	while (!next->is_ready && !extractor->stopping) {
+		pthread_cond_wait(&extractor->ready_condition, &extractor->mutex);
+	}
+	/* Packets extracted before the extractor stopped are still consumed */
+	*packet = next->is_ready ? next : NULL;
+	pthread_mutex_unlock(&extractor->mutex);
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_frame_extractor_release(
+	maybe_frame_extractor_t* extractor,
+	const maybe_frame_packet_t* packet
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if ((NULL == extractor) || (NULL == packet)) {
+		result = MAYBE_ERROR_FRAME_EXTRACTOR_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	pthread_mutex_lock(&extractor->mutex);
+	if ((packet != &extractor->packets[extractor->consumed_count % MAYBE_FRAME_EXTRACTOR_PACKET_COUNT]) || !packet->is_ready) {
+		pthread_mutex_unlock(&extractor->mutex);
+		result = MAYBE_ERROR_FRAME_EXTRACTOR_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	extractor->packets[extractor->consumed_count % MAYBE_FRAME_EXTRACTOR_PACKET_COUNT].is_ready = false;
+	extractor->consumed_count++;
+	pthread_cond_signal(&extractor->released_condition);
+	pthread_mutex_unlock(&extractor->mutex);
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_frame_extractor_stop(
+	maybe_frame_extractor_t* extractor
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if (NULL == extractor) {
+		result = MAYBE_ERROR_FRAME_EXTRACTOR_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	pthread_mutex_lock(&extractor->mutex);
+	extractor->stopping = true;
+	pthread_cond_broadcast(&extractor->ready_condition);
+	pthread_cond_broadcast(&extractor->released_condition);
+	pthread_mutex_unlock(&extractor->mutex);
+
+	if (extractor->has_consumer_thread) {
+		pthread_join(extractor->consumer_thread, NULL);
+		extractor->has_consumer_thread = false;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_frame_extractor_free(
+	maybe_frame_extractor_t* extractor
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_error_t free_result;
+	maybe_frame_packet_t* packet;
+	uint32_t i, j;
+
+	if (NULL == extractor) {
+		result = MAYBE_ERROR_FRAME_EXTRACTOR_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = maybe_frame_extractor_stop(extractor);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+
+	for (i = 0; i < MAYBE_FRAME_EXTRACTOR_PACKET_COUNT; i++) {
+		packet = &extractor->packets[i];
+
+		for (j = 0; j < packet->columns.length; j++) {
+			free_result = maybe_vector_free(&MAYBE_VECTOR_ELEMENT(packet->columns, maybe_vector_t, j));
+			if (IS_FAILURE(free_result)) {
+				result = free_result;
+			}
+		}
+
+		free_result = maybe_vector_free(&packet->columns);
+		if (IS_FAILURE(free_result)) {
+			result = free_result;
+		}
+
+		free_result = maybe_vector_free(&packet->entities);
+		if (IS_FAILURE(free_result)) {
+			result = free_result;
+		}
+	}
+
+	free(extractor->component_indices);
+	free(extractor->component_sizes);
+	free(extractor->component_ids);
+	extractor->component_indices = NULL;
+	extractor->component_sizes = NULL;
+	extractor->component_ids = NULL;
+
+	pthread_cond_destroy(&extractor->released_condition);
+	pthread_cond_destroy(&extractor->ready_condition);
+	pthread_mutex_destroy(&extractor->mutex);
+
+	/* If any free operation failed, return an error */
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+void* consumer_main(
+	void* extractor_pointer
+) {
+	maybe_frame_extractor_t* extractor = (maybe_frame_extractor_t*)extractor_pointer;
+	const maybe_frame_packet_t* packet;
+
+	for (;;) {
+		if (IS_FAILURE(maybe_frame_extractor_acquire(extractor, &packet)) || (NULL == packet)) {
+			break;
+		}
+
+		extractor->consumer(extractor->consumer_context, packet);
+
+		if (IS_FAILURE(maybe_frame_extractor_release(extractor, packet))) {
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+bool find_columns(
+	maybe_frame_extractor_t* extractor,
+	maybe_archetype_t* archetype
+) {
+	uint64_t mask = maybe_archetype_get_component_mask(extractor->component_ids, extractor->component_count);
+	uint32_t i;
+
+	if ((archetype->component_mask & mask) != mask) {
+		return false;
+	}
+
+	for (i = 0; i < extractor->component_count; i++) {
+		if (!maybe_archetype_find_component(archetype, extractor->component_ids[i], &extractor->component_indices[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+uint32_t count_rows(
+	maybe_frame_extractor_t* extractor,
+	maybe_world_t* world
+) {
+	maybe_archetype_t* archetype;
+	uint32_t row_count = 0;
+	uint32_t i;
+
+	for (i = 0; i < world->archetypes.length; i++) {
+		archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i);
+
+		if ((0 == archetype->entities.length) || !find_columns(extractor, archetype)) {
+			continue;
+		}
+
+		row_count += archetype->entities.length - archetype->disabled_count;
+	}
+
+	return row_count;
+}
+
+void copy_rows(
+	maybe_frame_extractor_t* extractor,
+	maybe_world_t* world,
+	maybe_frame_packet_t* packet
+) {
+	maybe_archetype_t* archetype;
+	maybe_vector_t* column;
+	uint32_t first_row, end_row, row_count;
+	uint32_t entity_count = 0;
+	uint32_t i, j;
+
+	for (i = 0; i < world->archetypes.length; i++) {
+		archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i);
+
+		if ((0 == archetype->entities.length) || !find_columns(extractor, archetype)) {
+			continue;
+		}
+
+		/* Ranges of enabled rows are copied whole, an archetype without disabled entities is a single range */
+		end_row = 0;
+		while (maybe_archetype_find_enabled_rows(archetype, end_row, &first_row, &end_row)) {
+			row_count = end_row - first_row;
+
+			memcpy(
+				MAYBE_VECTOR_ELEMENT_VOID_PTR(packet->entities, entity_count),
+				MAYBE_VECTOR_ELEMENT_VOID_PTR(archetype->entities, first_row),
+				(size_t)row_count * sizeof(maybe_entity_t)
+			);
+
+			for (j = 0; j < extractor->component_count; j++) {
+				column = &MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, extractor->component_indices[j]);
+
+				memcpy(
+					MAYBE_VECTOR_ELEMENT_VOID_PTR(MAYBE_VECTOR_ELEMENT(packet->columns, maybe_vector_t, j), entity_count),
+					MAYBE_VECTOR_PTR_ELEMENT_VOID_PTR(column, first_row),
+					(size_t)row_count * extractor->component_sizes[j]
+				);
+			}
+
+			entity_count += row_count;
+		}
+	}
+
+	packet->entity_count = entity_count;
+	packet->entities.length = entity_count;
+	for (j = 0; j < extractor->component_count; j++) {
+		MAYBE_VECTOR_ELEMENT(packet->columns, maybe_vector_t, j).length = entity_count;
+	}
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "common/error.h"
+#include "common/vector/vector.h"
+#include "entity.h"
+#include "ecs.h"
+
+/*
+ * Frame extraction
+ *
+ * A frame extractor copies the components a renderer needs out of a world after every update, into a
+ * frame packet the world does not touch again. A consumer thread reads the packet while the world
+ * simulates the next frame, so simulation and rendering overlap instead of running in lockstep:
+ *
+ * 		maybe_frame_extractor_start(&extractor, draw_frame, renderer);
+ * 		for (;;) {
+ * 			maybe_world_update(&world);
+ * 			maybe_frame_extractor_extract(&extractor, &world);
+ * 		}
+ *
+ * There are two packets. The world fills one while the consumer reads the other, and extraction waits
+ * for the consumer when both are taken, so the world is never more than a frame ahead of it.
+ *
+ * A packet holds every enabled entity that has all of the extractor's components, in archetype order,
+ * with one array per component. The arrays are copied rather than aliased, since the world is free to
+ * write to its columns and move its rows as soon as extraction returns.
+ *
+ * Packets can also be taken on any thread with maybe_frame_extractor_acquire and
+ * maybe_frame_extractor_release, instead of starting a consumer thread.
+ * */
+
+/* @brief The number of packets an extractor fills in turn */
+#define MAYBE_FRAME_EXTRACTOR_PACKET_COUNT (2)
+
+/* @brief The render data of one frame */
+typedef struct {
+	uint64_t frame; /* The number of packets extracted before this one */
+	uint32_t entity_count;
+	MAYBE_VECTOR(maybe_entity_t) entities;
+	MAYBE_VECTOR(maybe_vector_t) columns; /* An array of entity_count values for every one of the extractor's components, in its order */
+	bool is_ready; /* Set when the packet was extracted and was not released yet */
+} maybe_frame_packet_t;
+
+/*
+ * @brief A prototype for a frame consumer, called on the consumer thread for every packet in order
+ *
+ * @param context The context given to maybe_frame_extractor_start
+ * @param packet The packet, valid until the consumer returns
+ * */
+typedef void (*maybe_frame_consumer_t)(void* context, const maybe_frame_packet_t* packet);
+
+/* @brief Copies a world's render data into double-buffered frame packets */
+typedef struct {
+	uint32_t component_count;
+	uint32_t* component_ids; /* The extracted components, none of them shared */
+	uint32_t* component_sizes;
+	uint32_t* component_indices; /* The index of every component in the archetype being extracted */
+	maybe_frame_packet_t packets[MAYBE_FRAME_EXTRACTOR_PACKET_COUNT];
+	uint64_t extracted_count; /* The number of packets extracted so far, the next one goes to packets[extracted_count % 2] */
+	uint64_t consumed_count; /* The number of packets released so far, the next one is read from packets[consumed_count % 2] */
+	bool stopping;
+	pthread_mutex_t mutex;
+	pthread_cond_t ready_condition; /* Signaled when a packet is extracted or the extractor stops */
+	pthread_cond_t released_condition; /* Signaled when a packet is released */
+	pthread_t consumer_thread;
+	bool has_consumer_thread;
+	maybe_frame_consumer_t consumer;
+	void* consumer_context;
+} maybe_frame_extractor_t;
+
+/*
+ * @brief Initialize a frame extractor
+ *
+ * @param extractor A pointer to the new extractor
+ * @param world A pointer to the world the components are registered in
+ * @param component_count The number of components to extract
+ * @param component_ids The IDs of the components, entities without all of them are not extracted
+ *
+ * @note Shared components can not be extracted, their values are not stored per entity
+ * */
+maybe_error_t maybe_frame_extractor_init(
+	maybe_frame_extractor_t* extractor,
+	maybe_world_t* world,
+	uint32_t component_count,
+	const uint32_t* component_ids
+);
+
+/*
+ * @brief Start a thread that passes every extracted packet to a consumer, in order
+ *
+ * @param extractor A pointer to the extractor
+ * @param consumer The consumer function
+ * @param context A pointer passed to the consumer
+ *
+ * @note Packets must not be acquired on other threads while the consumer thread runs
+ * */
+maybe_error_t maybe_frame_extractor_start(
+	maybe_frame_extractor_t* extractor,
+	maybe_frame_consumer_t consumer,
+	void* context
+);
+
+/*
+ * @brief Copy a world's render data into the next packet and hand it to the consumer
+ *
+ * @param extractor A pointer to the extractor
+ * @param world A pointer to the world, usually right after maybe_world_update
+ *
+ * @note Waits while the consumer still holds the packet, which happens when it is a whole frame behind
+ * */
+maybe_error_t maybe_frame_extractor_extract(
+	maybe_frame_extractor_t* extractor,
+	maybe_world_t* world
+);
+
+/*
+ * @brief Wait for the next extracted packet
+ *
+ * @param extractor A pointer to the extractor
+ * @param packet Set to the packet, or to NULL if the extractor stopped and no packets are left
+ *
+ * @note The packet must be released before the next one is acquired
+ * */
+maybe_error_t maybe_frame_extractor_acquire(
+	maybe_frame_extractor_t* extractor,
+	const maybe_frame_packet_t** packet
+);
+
+/*
+ * @brief Give an acquired packet back, so the world can extract into it again
+ *
+ * @param extractor A pointer to the extractor
+ * @param packet The packet from maybe_frame_extractor_acquire
+ * */
+maybe_error_t maybe_frame_extractor_release(
+	maybe_frame_extractor_t* extractor,
+	const maybe_frame_packet_t* packet
+);
+
+/*
+ * @brief Stop extracting, and wait for the consumer thread to consume the packets that are left
+ *
+ * @param extractor A pointer to the extractor
+ *
+ * @note Acquiring a packet once none are left returns NULL instead of waiting
+ * */
+maybe_error_t maybe_frame_extractor_stop(
+	maybe_frame_extractor_t* extractor
+);
+
+/*
+ * @brief Stop a frame extractor and free its resources
+ *
+ * @param extractor A pointer to the extractor
+ * */
+maybe_error_t maybe_frame_extractor_free(
+	maybe_frame_extractor_t* extractor
+);
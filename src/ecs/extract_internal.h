@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "extract.h"
+
+/*
+ * @brief The function of the consumer thread, passing packets to the consumer until the extractor stops
+ *
+ * @param extractor The extractor
+ * */
+static void* consumer_main(
+	void* extractor
+);
+
+/*
+ * @brief Find the columns of an extractor's components in an archetype
+ *
+ * @param extractor The extractor
+ * @param archetype The archetype
+ *
+ * @return Whether the archetype has all of the components, their indices are set in the extractor's component_indices
+ * */
+static bool find_columns(
+	maybe_frame_extractor_t* extractor,
+	maybe_archetype_t* archetype
+);
+
+/*
+ * @brief Count the enabled rows of the archetypes that have all of an extractor's components
+ *
+ * @param extractor The extractor
+ * @param world The world
+ * */
+static uint32_t count_rows(
+	maybe_frame_extractor_t* extractor,
+	maybe_world_t* world
+);
+
+/*
+ * @brief Copy the enabled rows of the matching archetypes into a packet, which has room for all of them
+ *
+ * @param extractor The extractor
+ * @param world The world
+ * @param packet The packet
+ * */
+static void copy_rows(
+	maybe_frame_extractor_t* extractor,
+	maybe_world_t* world,
+	maybe_frame_packet_t* packet
+);
@@ -0,0 +1,118 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "common/error.h"
+#include "common/common.h"
+#include "common/vector/vector.h"
+
+#include "observer.h"
+
+maybe_error_t maybe_observer_queue_init(
+	maybe_observer_queue_t* queue,
+	uint32_t component_id,
+	maybe_observer_event_t event
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if (NULL == queue) {
+		result = MAYBE_ERROR_OBSERVER_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	queue->component_id = component_id;
+	queue->event = event;
+
+	result = maybe_vector_init(&queue->observers, sizeof(maybe_observer_t), 1);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&queue->entities, sizeof(maybe_entity_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&queue->flushing_entities, sizeof(maybe_entity_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_observer_queue_push(
+	maybe_observer_queue_t* queue,
+	const maybe_entity_t* entities,
+	uint32_t entity_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t capacity;
+
+	if ((NULL == queue) || ((NULL == entities) && (0 != entity_count))) {
+		result = MAYBE_ERROR_OBSERVER_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Grow like maybe_vector_push does, since most pushes are of a single entity */
+	capacity = queue->entities.capacity;
+	while (capacity < queue->entities.length + entity_count) {
+		capacity *= 2;
+	}
+
+	result = maybe_vector_reserve(&queue->entities, capacity);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	memcpy(
+		MAYBE_VECTOR_ELEMENT_VOID_PTR(queue->entities, queue->entities.length),
+		entities,
+		(size_t)entity_count * sizeof(maybe_entity_t)
+	);
+	queue->entities.length += entity_count;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_observer_queue_free(
+	maybe_observer_queue_t* queue
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_error_t free_result;
+
+	if (NULL == queue) {
+		result = MAYBE_ERROR_OBSERVER_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+
+	free_result = maybe_vector_free(&queue->observers);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&queue->entities);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&queue->flushing_entities);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	/* If any free operation failed, return an error */
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "common/error.h"
+#include "common/vector/vector.h"
+#include "entity.h"
+
+/* @brief The structural events observers can react to */
+typedef enum {
+	MAYBE_OBSERVER_EVENT_ADD = 0, /* A component was added to an entity, including when the entity was created with it */
+	MAYBE_OBSERVER_EVENT_REMOVE, /* A component was removed from an entity, including when the entity was removed */
+	MAYBE_OBSERVER_EVENT_SET, /* A component's value was set with maybe_world_set_component */
+	MAYBE_OBSERVER_EVENT_COUNT
+} maybe_observer_event_t;
+
+/*
+ * @brief A prototype for an observer function, called once per flush with all the entities an event happened to
+ *
+ * @param world A pointer to the world
+ * @param component_id The observed component
+ * @param event The observed event
+ * @param entities The entities the event happened to, in the order it happened. Only valid during the call
+ * @param entity_count The number of entities
+ * @param context The context the observer was added with
+ * */
+typedef void (*maybe_observer_function_t)(
+	void* world,
+	uint32_t component_id,
+	maybe_observer_event_t event,
+	const maybe_entity_t* entities,
+	uint32_t entity_count,
+	void* context
+);
+
+/* @brief A registered observer */
+typedef struct {
+	maybe_observer_function_t function;
+	void* context;
+} maybe_observer_t;
+
+/* @brief The observers of one event on one component, and the entities waiting for the next flush */
+typedef struct {
+	uint32_t component_id;
+	maybe_observer_event_t event;
+	MAYBE_VECTOR(maybe_observer_t) observers;
+	MAYBE_VECTOR(maybe_entity_t) entities; /* Entities the event happened to since the last flush */
+	MAYBE_VECTOR(maybe_entity_t) flushing_entities; /* The entities being passed to the observers, swapped with entities on flush */
+} maybe_observer_queue_t;
+
+/*
+ * @brief Initialize an observer queue
+ *
+ * @param queue A pointer to the new queue
+ * @param component_id The observed component
+ * @param event The observed event
+ * */
+maybe_error_t maybe_observer_queue_init(
+	maybe_observer_queue_t* queue,
+	uint32_t component_id,
+	maybe_observer_event_t event
+);
+
+/*
+ * @brief Add entities to the ones waiting for the next flush of a queue
+ *
+ * @param queue A pointer to the queue
+ * @param entities The entities
+ * @param entity_count The number of entities
+ * */
+maybe_error_t maybe_observer_queue_push(
+	maybe_observer_queue_t* queue,
+	const maybe_entity_t* entities,
+	uint32_t entity_count
+);
+
+/*
+ * @brief Free an observer queue's resources
+ *
+ * @param queue A pointer to the queue
+ * */
+maybe_error_t maybe_observer_queue_free(
+	maybe_observer_queue_t* queue
+);
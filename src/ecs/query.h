@@ -0,0 +1,335 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "common/common.h"
+#include "common/vector/vector.h"
+#include "archetype.h"
+#include "system.h"
+#include "ecs.h"
+
+/*
+ * Typed queries
+ *
+ * MAYBE_QUERY_EACH expands to a loop over every entity that has a set of components, with a typed
+ * pointer to each of its components:
+ *
+ * 		MAYBE_QUERY_EACH(&world, (position_t, p), (velocity_t, v)) {
+ * 			p->x += v->x;
+ * 			p->y += v->y;
+ * 		}
+ *
+ * Every pair is a component type registered with MAYBE_REGISTER_COMPONENT_TYPE and the name of the
+ * pointer the body uses. The archetypes are matched once per archetype, and the rows of an archetype are
+ * walked with typed column pointers, so the stride of every column is known at compile time and the
+ * body can be inlined and vectorized.
+ *
+ * MAYBE_SYSTEM_QUERY_EACH does the same inside a system function, over the archetypes the system already
+ * matched. Its components must be a subset of the system's components.
+ *
+ * MAYBE_QUERY_EACH_SHARED also takes a shared component (registered with MAYBE_REGISTER_SHARED_COMPONENT_TYPE)
+ * as its first pair. Every archetype holds a single value of each shared component, so the pointer to it
+ * is declared once per archetype, outside the row loop:
+ *
+ * 		MAYBE_QUERY_EACH_SHARED(&world, (material_t, material), (position_t, p)) {
+ * 			draw(material, p);
+ * 		}
+ *
+ * Disabled entities are skipped. The rows of an archetype are walked in ranges of consecutive
+ * enabled rows, so an archetype without disabled entities is a single plain loop. System queries of
+ * time-sliced systems only visit the entities of the system's current slice, see maybe_system_find_rows.
+ *
+ * In a world that shares columns with forks (see maybe_world_fork), the queried columns are copied
+ * the first time they are queried, since the body may write to them.
+ *
+ * The body runs in nested loops, so break and continue both only skip to the next entity. To stop the
+ * whole loop early, the body uses MAYBE_QUERY_BREAK():
+ *
+ * 		MAYBE_QUERY_EACH(&world, (health_t, h)) {
+ * 			if (h->value <= 0.0f) {
+ * 				found_dead = true;
+ * 				MAYBE_QUERY_BREAK();
+ * 			}
+ * 		}
+ *
+ * @note The body must not make structural changes to the world (add or remove entities or components)
+ * */
+
+#define MAYBE_QUERY_MAX_COMPONENTS (8)
+
+/* @brief The state of a typed query loop, used by the query macros */
+typedef struct {
+	maybe_world_t* world;
+	maybe_system_t* system;
+	uint32_t archetype_index; /* The index of the next archetype to check */
+	maybe_archetype_t* archetype; /* The current archetype */
+	uint32_t first_row; /* The first row of the current range of enabled rows */
+	uint32_t end_row; /* The row after the current range of enabled rows */
+	void* columns[MAYBE_QUERY_MAX_COMPONENTS]; /* The storage of every queried component in the current archetype */
+	bool is_stopped; /* Set by MAYBE_QUERY_BREAK, no more rows or archetypes are found after it */
+} maybe_query_state_t;
+
+/*
+ * @brief Move a query to the next archetype that has entities and all the queried components
+ *
+ * @param state The query's state
+ * @param component_count The number of queried components
+ * @param component_ids The IDs of the queried components
+ * @param shared_count The number of IDs, at the start of component_ids, which are shared components
+ *
+ * @return Whether an archetype was found, false also if a column could not be made writable
+ * */
+static inline bool maybe_query_next_archetype(
+	maybe_query_state_t* state,
+	uint32_t component_count,
+	const uint32_t* component_ids,
+	uint32_t shared_count
+) {
+	maybe_archetype_t* archetype;
+	maybe_system_archetype_info_t* info;
+	uint32_t component_indices[MAYBE_QUERY_MAX_COMPONENTS];
+	uint32_t i, j, component_index = 0;
+	uint64_t mask = maybe_archetype_get_component_mask(component_ids, component_count);
+	bool matches;
+
+	if (state->is_stopped) {
+		return false;
+	}
+
+	for (;;) {
+		info = NULL;
+
+		/* A system already knows which of the world's archetypes it iterates */
+		if (state->system) {
+			if (state->archetype_index >= state->system->archetypes.length) {
+				return false;
+			}
+
+			info = &MAYBE_VECTOR_ELEMENT(state->system->archetypes, maybe_system_archetype_info_t, state->archetype_index);
+			archetype = info->archetype;
+		} else {
+			if (state->archetype_index >= state->world->archetypes.length) {
+				return false;
+			}
+
+			archetype = MAYBE_VECTOR_ELEMENT(state->world->archetypes, maybe_archetype_t*, state->archetype_index);
+		}
+
+		state->archetype_index++;
+
+		if ((0 == archetype->entities.length) || ((archetype->component_mask & mask) != mask)) {
+			continue;
+		}
+
+		matches = true;
+		for (i = 0; (i < shared_count) && matches; i++) {
+			matches = maybe_archetype_find_shared_component(archetype, component_ids[i], &state->columns[i]);
+		}
+
+		for (; (i < component_count) && matches; i++) {
+			matches = false;
+
+			if (info) {
+				for (j = 0; j < state->system->component_count; j++) {
+					if (state->system->component_ids[j] == component_ids[i]) {
+						component_index = info->component_indices[j];
+						matches = true;
+						break;
+					}
+				}
+			} else {
+				matches = maybe_archetype_find_component(archetype, component_ids[i], &component_index);
+			}
+
+			component_indices[i] = component_index;
+		}
+
+		if (matches) {
+			for (i = shared_count; i < component_count; i++) {
+				/* Writing a column a fork shares copies it first */
+				if ((NULL != MAYBE_VECTOR_ELEMENT(archetype->column_reference_counts, uint32_t*, component_indices[i])) &&
+					IS_FAILURE(maybe_archetype_make_column_writable(archetype, component_indices[i]))) {
+					return false;
+				}
+
+				state->columns[i] = MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, component_indices[i]).elements;
+			}
+
+			state->archetype = archetype;
+			state->first_row = 0;
+			state->end_row = 0;
+			return true;
+		}
+	}
+}
+
+/*
+ * @brief Move a query to the next range of enabled rows in its current archetype, in the system's slice for system queries
+ *
+ * @param state The query's state
+ *
+ * @return Whether a range was found
+ * */
+static inline bool maybe_query_next_rows(
+	maybe_query_state_t* state
+) {
+	if (state->is_stopped) {
+		return false;
+	}
+
+	if (state->system) {
+		/* The archetype index was moved past the current archetype when it was found */
+		return maybe_system_find_rows(
+			state->system,
+			&MAYBE_VECTOR_ELEMENT(state->system->archetypes, maybe_system_archetype_info_t, state->archetype_index - 1),
+			state->end_row,
+			&state->first_row,
+			&state->end_row
+		);
+	}
+
+	return maybe_archetype_find_enabled_rows(state->archetype, state->end_row, &state->first_row, &state->end_row);
+}
+
+/*
+ * @brief Stop a query loop, used by MAYBE_QUERY_BREAK
+ *
+ * @param state The query's state
+ *
+ * @return Always true, so the macro can test it before breaking out of the current entity
+ * */
+static inline bool maybe_query_stop(
+	maybe_query_state_t* state
+) {
+	/* Ending the current range stops the row loop, which already checks the range's end every row */
+	state->end_row = 0;
+	state->is_stopped = true;
+
+	return true;
+}
+
+/* Helpers for applying a macro to every (type, name) pair, with the pair's index */
+#define MAYBE_QUERY__TYPE(type, name) type
+#define MAYBE_QUERY__NAME(type, name) name
+
+#define MAYBE_QUERY__COUNT(...) MAYBE_QUERY__COUNT_N(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define MAYBE_QUERY__COUNT_N(_1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+
+#define MAYBE_QUERY__CONCAT(a, b) MAYBE_QUERY__CONCAT_INNER(a, b)
+#define MAYBE_QUERY__CONCAT_INNER(a, b) a##b
+
+#define MAYBE_QUERY__FOR_EACH(macro, ...) MAYBE_QUERY__CONCAT(MAYBE_QUERY__FOR_EACH_, MAYBE_QUERY__COUNT(__VA_ARGS__))(macro, __VA_ARGS__)
+#define MAYBE_QUERY__FOR_EACH_1(m, p1) m(0, p1)
+#define MAYBE_QUERY__FOR_EACH_2(m, p1, p2) m(0, p1) m(1, p2)
+#define MAYBE_QUERY__FOR_EACH_3(m, p1, p2, p3) m(0, p1) m(1, p2) m(2, p3)
+#define MAYBE_QUERY__FOR_EACH_4(m, p1, p2, p3, p4) m(0, p1) m(1, p2) m(2, p3) m(3, p4)
+#define MAYBE_QUERY__FOR_EACH_5(m, p1, p2, p3, p4, p5) m(0, p1) m(1, p2) m(2, p3) m(3, p4) m(4, p5)
+#define MAYBE_QUERY__FOR_EACH_6(m, p1, p2, p3, p4, p5, p6) m(0, p1) m(1, p2) m(2, p3) m(3, p4) m(4, p5) m(5, p6)
+#define MAYBE_QUERY__FOR_EACH_7(m, p1, p2, p3, p4, p5, p6, p7) m(0, p1) m(1, p2) m(2, p3) m(3, p4) m(4, p5) m(5, p6) m(6, p7)
+#define MAYBE_QUERY__FOR_EACH_8(m, p1, p2, p3, p4, p5, p6, p7, p8) m(0, p1) m(1, p2) m(2, p3) m(3, p4) m(4, p5) m(5, p6) m(6, p7) m(7, p8)
+
+/* The component ID of a pair, as an element of the IDs array. The type is expanded before MAYBE_COMPONENT_ID pastes it */
+#define MAYBE_QUERY__ID(index, pair) MAYBE_QUERY__COMPONENT_ID(MAYBE_QUERY__TYPE pair),
+#define MAYBE_QUERY__COMPONENT_ID(type) MAYBE_COMPONENT_ID(type)
+
+/* A typed pointer to the column of a pair, declared once per archetype */
+#define MAYBE_QUERY__COLUMN(index, pair) \
+	for (MAYBE_QUERY__TYPE pair* restrict MAYBE_QUERY__CONCAT(maybe_query__column_, MAYBE_QUERY__NAME pair) = \
+			(MAYBE_QUERY__TYPE pair*)maybe_query__state.columns[index], \
+		 * MAYBE_QUERY__CONCAT(maybe_query__guard_, MAYBE_QUERY__NAME pair) = MAYBE_QUERY__CONCAT(maybe_query__column_, MAYBE_QUERY__NAME pair); \
+		 MAYBE_QUERY__CONCAT(maybe_query__guard_, MAYBE_QUERY__NAME pair); \
+		 MAYBE_QUERY__CONCAT(maybe_query__guard_, MAYBE_QUERY__NAME pair) = NULL)
+
+/* A pointer to the value of a shared pair, declared once per archetype. It is always the first queried component */
+#define MAYBE_QUERY__SHARED(pair) \
+	for (const MAYBE_QUERY__TYPE pair* MAYBE_QUERY__NAME pair = (const MAYBE_QUERY__TYPE pair*)maybe_query__state.columns[0], \
+		 * MAYBE_QUERY__CONCAT(maybe_query__guard_, MAYBE_QUERY__NAME pair) = MAYBE_QUERY__NAME pair; \
+		 MAYBE_QUERY__CONCAT(maybe_query__guard_, MAYBE_QUERY__NAME pair); \
+		 MAYBE_QUERY__CONCAT(maybe_query__guard_, MAYBE_QUERY__NAME pair) = NULL)
+
+/* The column of a pair which follows a shared pair */
+#define MAYBE_QUERY__COLUMN_AFTER_SHARED(index, pair) MAYBE_QUERY__COLUMN((index) + 1, pair)
+
+/* The pointer the body uses, declared once per row. The loop runs once, using a constant flag the optimizer can remove */
+#define MAYBE_QUERY__ELEMENT(index, pair) \
+	for (MAYBE_QUERY__TYPE pair* MAYBE_QUERY__NAME pair = &MAYBE_QUERY__CONCAT(maybe_query__column_, MAYBE_QUERY__NAME pair)[maybe_query__row]; \
+		 maybe_query__once; \
+		 maybe_query__once = false)
+
+#define MAYBE_QUERY__EACH(world_pointer, system_pointer, ...) \
+	for (maybe_query_state_t maybe_query__state = { (world_pointer), (system_pointer), 0, NULL, 0, 0, { NULL }, false }; \
+		 maybe_query_next_archetype( \
+			&maybe_query__state, \
+			MAYBE_QUERY__COUNT(__VA_ARGS__), \
+			(const uint32_t[]){ MAYBE_QUERY__FOR_EACH(MAYBE_QUERY__ID, __VA_ARGS__) }, \
+			0 \
+		 );) \
+		MAYBE_QUERY__FOR_EACH(MAYBE_QUERY__COLUMN, __VA_ARGS__) \
+		while (maybe_query_next_rows(&maybe_query__state)) \
+			for (uint32_t maybe_query__row = maybe_query__state.first_row; maybe_query__row < maybe_query__state.end_row; maybe_query__row++) \
+				for (bool maybe_query__once = true; maybe_query__once; maybe_query__once = false) \
+					MAYBE_QUERY__FOR_EACH(MAYBE_QUERY__ELEMENT, __VA_ARGS__)
+
+/*
+ * @brief Stop the innermost query loop, after the current entity's body is left
+ *
+ * @note Use it directly in the query's body, not in a loop or switch of its own, which it would only break out of
+ * */
+#define MAYBE_QUERY_BREAK() if (maybe_query_stop(&maybe_query__state)) break; else (void)0
+
+/*
+ * @brief Loop over every entity in a world that has all the given components
+ *
+ * @param world A pointer to the world
+ *
+ * @note The rest of the parameters are (component_type, pointer_name) pairs, up to MAYBE_QUERY_MAX_COMPONENTS
+ * */
+#define MAYBE_QUERY_EACH(world, ...) MAYBE_QUERY__EACH((world), NULL, __VA_ARGS__)
+
+/*
+ * @brief Loop over every entity a system iterates that has all the given components
+ *
+ * @param system A pointer to the system
+ *
+ * @note The rest of the parameters are (component_type, pointer_name) pairs, up to MAYBE_QUERY_MAX_COMPONENTS
+ * */
+#define MAYBE_SYSTEM_QUERY_EACH(system, ...) MAYBE_QUERY__EACH(NULL, (maybe_system_t*)(system), __VA_ARGS__)
+
+#define MAYBE_QUERY__EACH_SHARED(world_pointer, system_pointer, shared_pair, ...) \
+	for (maybe_query_state_t maybe_query__state = { (world_pointer), (system_pointer), 0, NULL, 0, 0, { NULL }, false }; \
+		 maybe_query_next_archetype( \
+			&maybe_query__state, \
+			MAYBE_QUERY__COUNT(__VA_ARGS__) + 1, \
+			(const uint32_t[]){ MAYBE_QUERY__ID(0, shared_pair) MAYBE_QUERY__FOR_EACH(MAYBE_QUERY__ID, __VA_ARGS__) }, \
+			1 \
+		 );) \
+		MAYBE_QUERY__SHARED(shared_pair) \
+		MAYBE_QUERY__FOR_EACH(MAYBE_QUERY__COLUMN_AFTER_SHARED, __VA_ARGS__) \
+		while (maybe_query_next_rows(&maybe_query__state)) \
+			for (uint32_t maybe_query__row = maybe_query__state.first_row; maybe_query__row < maybe_query__state.end_row; maybe_query__row++) \
+				for (bool maybe_query__once = true; maybe_query__once; maybe_query__once = false) \
+					MAYBE_QUERY__FOR_EACH(MAYBE_QUERY__ELEMENT, __VA_ARGS__)
+
+/*
+ * @brief Loop over every entity in a world that has a shared component and all the given components
+ *
+ * @param world A pointer to the world
+ * @param shared_pair A (shared_component_type, pointer_name) pair, the pointer is constant for each archetype
+ *
+ * @note The rest of the parameters are (component_type, pointer_name) pairs, up to MAYBE_QUERY_MAX_COMPONENTS - 1
+ * */
+#define MAYBE_QUERY_EACH_SHARED(world, shared_pair, ...) MAYBE_QUERY__EACH_SHARED((world), NULL, shared_pair, __VA_ARGS__)
+
+/*
+ * @brief Loop over every entity a system iterates that has a shared component and all the given components
+ *
+ * @param system A pointer to the system
+ * @param shared_pair A (shared_component_type, pointer_name) pair, the pointer is constant for each archetype
+ *
+ * @note The rest of the parameters are (component_type, pointer_name) pairs, up to MAYBE_QUERY_MAX_COMPONENTS - 1
+ * @note Systems match archetypes by their column components only, so the shared component is checked per archetype
+ * */
+#define MAYBE_SYSTEM_QUERY_EACH_SHARED(system, shared_pair, ...) \
+	MAYBE_QUERY__EACH_SHARED(NULL, (maybe_system_t*)(system), shared_pair, __VA_ARGS__)
@@ -0,0 +1,415 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+#include "common/error.h"
+#include "common/common.h"
+#include "common/vector/vector.h"
+#include "archetype.h"
+
+#include "read_guard.h"
+#include "read_guard_internal.h"
+
+/* Published in place of the view when storage has to be freed right away, see retire */
+static maybe_world_read_view_t g_empty_view = { 0 };
+
+maybe_error_t maybe_world_read_guard_init(
+	maybe_world_read_guard_t* guard,
+	maybe_world_t* world
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t i;
+
+	if ((NULL == guard) || (NULL == world)) {
+		result = MAYBE_ERROR_READ_GUARD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	memset(guard, 0, sizeof(*guard));
+	guard->allocator.reallocate = guard_reallocate;
+	guard->allocator.free = guard_free;
+	guard->allocator.context = guard;
+	atomic_init(&guard->epoch, 1);
+	atomic_init(&guard->view, &g_empty_view);
+	for (i = 0; i < MAYBE_WORLD_READ_GUARD_MAX_READERS; i++) {
+		atomic_init(&guard->readers[i].epoch, 0);
+		atomic_init(&guard->readers[i].is_used, false);
+	}
+
+	result = maybe_vector_init(&guard->retired, sizeof(maybe_world_retired_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* Forks share columns and the stores allocate their own, neither can be retired */
+	if ((NULL != world->fork_parent) || (world->fork_count > 0)) {
+		result = MAYBE_ERROR_ECS_WORLD_HAS_FORKS;
+		goto l_cleanup;
+	}
+
+	if ((NULL != world->page_store) || (NULL != world->world_export) || (NULL != world->read_guard)) {
+		result = MAYBE_ERROR_ECS_WORLD_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	/* New archetypes are allocated from the guard even if moving an existing one fails */
+	guard->world = world;
+	world->read_guard = guard;
+
+	for (i = 0; i < world->archetypes.length; i++) {
+		result = maybe_archetype_set_column_allocator(MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i), &guard->allocator);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = maybe_world_read_guard_publish(guard);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (IS_FAILURE(result) && (MAYBE_ERROR_READ_GUARD_NULL_PARAM != result)) {
+		(void)maybe_world_read_guard_free(guard);
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_world_read_guard_add_reader(
+	maybe_world_read_guard_t* guard,
+	uint32_t* reader
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	bool is_used;
+	uint32_t i;
+
+	if ((NULL == guard) || (NULL == reader)) {
+		result = MAYBE_ERROR_READ_GUARD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < MAYBE_WORLD_READ_GUARD_MAX_READERS; i++) {
+		is_used = false;
+		if (atomic_compare_exchange_strong(&guard->readers[i].is_used, &is_used, true)) {
+			*reader = i;
+			result = MAYBE_ERROR_SUCCESS;
+			goto l_cleanup;
+		}
+	}
+
+	result = MAYBE_ERROR_READ_GUARD_NO_FREE_READERS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_read_guard_remove_reader(
+	maybe_world_read_guard_t* guard,
+	uint32_t reader
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if (NULL == guard) {
+		result = MAYBE_ERROR_READ_GUARD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (reader >= MAYBE_WORLD_READ_GUARD_MAX_READERS) {
+		result = MAYBE_ERROR_READ_GUARD_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	atomic_store_explicit(&guard->readers[reader].epoch, 0, memory_order_release);
+	atomic_store_explicit(&guard->readers[reader].is_used, false, memory_order_release);
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_read_guard_publish(
+	maybe_world_read_guard_t* guard
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_world_read_view_t* view = NULL;
+	maybe_world_read_view_t* old_view;
+
+	if (NULL == guard) {
+		result = MAYBE_ERROR_READ_GUARD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (NULL == guard->world) {
+		result = MAYBE_ERROR_READ_GUARD_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	result = build_view(guard, &view);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	old_view = atomic_exchange(&guard->view, view);
+	if (&g_empty_view != old_view) {
+		retire(guard, old_view);
+	}
+
+	/*
+	 * Readers that pin the new epoch load the view after this, so they only see the new view.
+	 * Everything retired so far is only reachable from older epochs.
+	 * */
+	(void)atomic_fetch_add(&guard->epoch, 1);
+
+	reclaim(guard);
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_read_guard_free(
+	maybe_world_read_guard_t* guard
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_error_t free_result;
+	maybe_world_read_view_t* view;
+	uint32_t i;
+
+	if (NULL == guard) {
+		result = MAYBE_ERROR_READ_GUARD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+
+	/* The columns move back to the heap while the guard can still retire their storage */
+	if ((NULL != guard->world) && (guard == guard->world->read_guard)) {
+		guard->world->read_guard = NULL;
+
+		for (i = 0; i < guard->world->archetypes.length; i++) {
+			free_result = maybe_archetype_set_column_allocator(MAYBE_VECTOR_ELEMENT(guard->world->archetypes, maybe_archetype_t*, i), NULL);
+			if (IS_FAILURE(free_result)) {
+				result = free_result;
+			}
+		}
+	}
+	guard->world = NULL;
+
+	/* No reader is reading, so everything can be freed */
+	for (i = 0; i < guard->retired.length; i++) {
+		free(MAYBE_VECTOR_ELEMENT(guard->retired, maybe_world_retired_t, i).memory);
+	}
+	guard->retired.length = 0;
+
+	view = atomic_exchange(&guard->view, &g_empty_view);
+	if (&g_empty_view != view) {
+		free(view);
+	}
+
+	free_result = maybe_vector_free(&guard->retired);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	/* If any free operation failed, return an error */
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+void* guard_reallocate(
+	void* context,
+	void* memory,
+	size_t old_size,
+	size_t new_size
+) {
+	maybe_world_read_guard_t* guard = (maybe_world_read_guard_t*)context;
+	void* new_memory;
+
+	/* Readers may still be reading the old storage, so it is never resized in place */
+	new_memory = malloc((0 == new_size) ? 1 : new_size);
+	if (NULL == new_memory) {
+		return NULL;
+	}
+
+	if (NULL != memory) {
+		memcpy(new_memory, memory, (old_size < new_size) ? old_size : new_size);
+		retire(guard, memory);
+	}
+
+	return new_memory;
+}
+
+void guard_free(
+	void* context,
+	void* memory,
+	size_t size
+) {
+	(void)size;
+
+	retire((maybe_world_read_guard_t*)context, memory);
+}
+
+void retire(
+	maybe_world_read_guard_t* guard,
+	void* memory
+) {
+	maybe_world_retired_t retired;
+	maybe_world_read_view_t* view;
+
+	if (NULL == memory) {
+		return;
+	}
+
+	/* Only the world's thread changes the epoch, so it can be read without synchronization */
+	retired.memory = memory;
+	retired.epoch = atomic_load_explicit(&guard->epoch, memory_order_relaxed);
+
+	if (MAYBE_ERROR_SUCCESS == maybe_vector_push(&guard->retired, &retired)) {
+		return;
+	}
+
+	/*
+	 * Without room to retire the storage it is freed right away. The view may point to it, so
+	 * readers are given an empty view until the next publish, and the readers that may have the
+	 * old view are waited for.
+	 * */
+	view = atomic_exchange(&guard->view, &g_empty_view);
+	wait_for_readers(guard);
+
+	free(memory);
+	if ((memory != view) && (&g_empty_view != view)) {
+		free(view);
+	}
+}
+
+void wait_for_readers(
+	maybe_world_read_guard_t* guard
+) {
+	uint64_t epoch = atomic_fetch_add(&guard->epoch, 1) + 1;
+	uint64_t reader_epoch;
+	uint32_t i;
+
+	for (i = 0; i < MAYBE_WORLD_READ_GUARD_MAX_READERS; i++) {
+		for (;;) {
+			reader_epoch = atomic_load(&guard->readers[i].epoch);
+			if ((0 == reader_epoch) || (reader_epoch >= epoch)) {
+				break;
+			}
+
+			(void)sched_yield();
+		}
+	}
+}
+
+uint64_t get_oldest_epoch(
+	maybe_world_read_guard_t* guard
+) {
+	uint64_t oldest = atomic_load(&guard->epoch);
+	uint64_t reader_epoch;
+	uint32_t i;
+
+	for (i = 0; i < MAYBE_WORLD_READ_GUARD_MAX_READERS; i++) {
+		reader_epoch = atomic_load(&guard->readers[i].epoch);
+		if ((0 != reader_epoch) && (reader_epoch < oldest)) {
+			oldest = reader_epoch;
+		}
+	}
+
+	return oldest;
+}
+
+maybe_error_t build_view(
+	maybe_world_read_guard_t* guard,
+	maybe_world_read_view_t** view
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_world_t* world = guard->world;
+	maybe_world_read_view_t* new_view;
+	maybe_world_read_archetype_t* archetypes;
+	maybe_archetype_t* archetype;
+	void** columns;
+	uint32_t* component_ids;
+	uint32_t column_count = 0;
+	uint32_t i, j;
+
+	for (i = 0; i < world->archetypes.length; i++) {
+		column_count += MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i)->component_types_count;
+	}
+
+	/* The header, the archetypes, the column pointers and the component ids, in order of alignment */
+	new_view = (maybe_world_read_view_t*)malloc(
+		sizeof(maybe_world_read_view_t) +
+		(size_t)world->archetypes.length * sizeof(maybe_world_read_archetype_t) +
+		(size_t)column_count * (sizeof(void*) + sizeof(uint32_t))
+	);
+	if (NULL == new_view) {
+		result = MAYBE_ERROR_READ_GUARD_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+
+	archetypes = (maybe_world_read_archetype_t*)(new_view + 1);
+	columns = (void**)(archetypes + world->archetypes.length);
+	component_ids = (uint32_t*)(columns + column_count);
+
+	new_view->tick = world->access_tick;
+	new_view->archetype_count = world->archetypes.length;
+	new_view->archetypes = archetypes;
+
+	for (i = 0; i < world->archetypes.length; i++) {
+		archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i);
+
+		archetypes[i].component_mask = archetype->component_mask;
+		archetypes[i].row_count = archetype->entities.length;
+		archetypes[i].column_count = archetype->component_types_count;
+		archetypes[i].entities = (const maybe_entity_t*)archetype->entities.elements;
+		archetypes[i].component_ids = component_ids;
+		archetypes[i].columns = columns;
+
+		for (j = 0; j < archetype->component_types_count; j++) {
+			component_ids[j] = MAYBE_VECTOR_ELEMENT(archetype->component_ids, uint32_t, j);
+			columns[j] = MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, j).elements;
+		}
+
+		component_ids += archetype->component_types_count;
+		columns += archetype->component_types_count;
+	}
+
+	*view = new_view;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+void reclaim(
+	maybe_world_read_guard_t* guard
+) {
+	maybe_world_retired_t* retired;
+	uint64_t oldest = get_oldest_epoch(guard);
+	uint32_t i, kept = 0;
+
+	/* The storage was retired in the order of its epochs, so the freed items are a prefix */
+	for (i = 0; i < guard->retired.length; i++) {
+		retired = &MAYBE_VECTOR_ELEMENT(guard->retired, maybe_world_retired_t, i);
+		if (retired->epoch >= oldest) {
+			break;
+		}
+
+		free(retired->memory);
+	}
+
+	for (; i < guard->retired.length; i++) {
+		MAYBE_VECTOR_ELEMENT(guard->retired, maybe_world_retired_t, kept) = MAYBE_VECTOR_ELEMENT(guard->retired, maybe_world_retired_t, i);
+		kept++;
+	}
+
+	guard->retired.length = kept;
+}
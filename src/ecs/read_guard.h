@@ -0,0 +1,203 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include "common/error.h"
+#include "common/vector/vector.h"
+#include "entity.h"
+#include "ecs.h"
+
+/*
+ * World read guard
+ *
+ * A read guard lets other threads, like analytics or replication encoders, read a world's columns while
+ * the world's thread keeps changing it. After every update and advance the world publishes a view: the
+ * columns, entities and row counts of every archetype. A reader pins the current epoch and reads the
+ * view without taking a lock:
+ *
+ * 		maybe_world_read_guard_add_reader(&guard, &reader);	... once per reader thread ...
+ *
+ * 		view = maybe_world_read_begin(&guard, reader);
+ * 		for (i = 0; i < view->archetype_count; i++) {
+ * 			if (maybe_world_read_find_column(&view->archetypes[i], MAYBE_COMPONENT_ID(position_t), &column)) {
+ * 				... read view->archetypes[i].row_count rows of the column ...
+ * 			}
+ * 		}
+ * 		maybe_world_read_end(&guard, reader);
+ *
+ * While the guard is set, the world allocates its columns and entities through it. Storage the world
+ * grows, shrinks or frees is not freed right away but retired, and the guard frees it once every reader
+ * that could still see it has ended its read. So every pointer in a view stays valid until the read
+ * ends, even if the world reallocated the column since.
+ *
+ * The guard keeps the memory valid, not the values: rows the world changes during a read may be seen
+ * half written, rows past a view's row count may be in use again, and a removed entity's row may hold
+ * another entity by the time it is read. Disabled entities are in the view like any other.
+ *
+ * A world with a read guard can not use a page store or be forked, since their storage is not retired.
+ * */
+
+/* @brief The number of readers a guard can have at once */
+#define MAYBE_WORLD_READ_GUARD_MAX_READERS (64)
+
+/* @brief The size readers are padded to, so readers on different threads do not share a cache line */
+#define MAYBE_WORLD_READ_GUARD_CACHE_LINE (64)
+
+/* @brief A reader's slot in a read guard */
+typedef struct {
+	_Atomic uint64_t epoch; /* The epoch the reader's current read started in, 0 while it is not reading */
+	atomic_bool is_used;
+	uint8_t padding[MAYBE_WORLD_READ_GUARD_CACHE_LINE - sizeof(uint64_t) - sizeof(atomic_bool)];
+} maybe_world_reader_t;
+
+/* @brief Storage that was freed by the world and may still be read */
+typedef struct {
+	void* memory;
+	uint64_t epoch; /* The epoch it was retired in, readers that started later can not see it */
+} maybe_world_retired_t;
+
+/* @brief An archetype in a view */
+typedef struct {
+	uint64_t component_mask;
+	uint32_t row_count;
+	uint32_t column_count;
+	const maybe_entity_t* entities; /* The entity of every row */
+	const uint32_t* component_ids; /* The component of every column */
+	void* const* columns; /* The rows of every column */
+} maybe_world_read_archetype_t;
+
+/* @brief The world's archetypes as of the end of an update or advance */
+typedef struct {
+	uint64_t tick; /* The world's access tick when the view was published */
+	uint32_t archetype_count;
+	const maybe_world_read_archetype_t* archetypes;
+} maybe_world_read_view_t;
+
+/* @brief Lets other threads read a world while it changes */
+typedef struct maybe_world_read_guard_s {
+	maybe_world_t* world;
+	maybe_vector_allocator_t allocator; /* Allocates from the heap and retires what it frees */
+	_Atomic uint64_t epoch; /* Advanced on every publish, starts at 1 */
+	_Atomic(maybe_world_read_view_t*) view;
+	MAYBE_VECTOR(maybe_world_retired_t) retired; /* Only used by the world's thread */
+	maybe_world_reader_t readers[MAYBE_WORLD_READ_GUARD_MAX_READERS];
+} maybe_world_read_guard_t;
+
+/*
+ * @brief Initialize a read guard, move a world's columns to it and publish the first view
+ *
+ * @param guard A pointer to the new guard, it must stay valid until it is freed
+ * @param world A pointer to the world, without a page store or forks
+ *
+ * @note The world must not have readers of another guard, since its current columns are moved
+ * */
+maybe_error_t maybe_world_read_guard_init(
+	maybe_world_read_guard_t* guard,
+	maybe_world_t* world
+);
+
+/*
+ * @brief Get a reader slot, can be called from any thread
+ *
+ * @param guard A pointer to the guard
+ * @param reader Set to the reader's slot, used by a single thread at a time
+ * */
+maybe_error_t maybe_world_read_guard_add_reader(
+	maybe_world_read_guard_t* guard,
+	uint32_t* reader
+);
+
+/*
+ * @brief Release a reader slot, the reader must not be reading
+ *
+ * @param guard A pointer to the guard
+ * @param reader The reader's slot
+ * */
+maybe_error_t maybe_world_read_guard_remove_reader(
+	maybe_world_read_guard_t* guard,
+	uint32_t reader
+);
+
+/*
+ * @brief Publish a view of the world and free the retired storage no reader can see anymore
+ *
+ * @param guard A pointer to the guard
+ *
+ * @note The world publishes after every update and advance, so this is only needed for changes made between them
+ * */
+maybe_error_t maybe_world_read_guard_publish(
+	maybe_world_read_guard_t* guard
+);
+
+/*
+ * @brief Move the world's columns back to the heap and free a guard's resources
+ *
+ * @param guard A pointer to the guard, it must not have readers that are reading
+ *
+ * @note Can be called after the world was freed
+ * */
+maybe_error_t maybe_world_read_guard_free(
+	maybe_world_read_guard_t* guard
+);
+
+/*
+ * @brief Start a read, the view and everything it points to stay valid until maybe_world_read_end
+ *
+ * @param guard A pointer to the guard
+ * @param reader The reader's slot
+ *
+ * @return The last published view
+ * */
+static inline const maybe_world_read_view_t* maybe_world_read_begin(
+	maybe_world_read_guard_t* guard,
+	uint32_t reader
+) {
+	/*
+	 * The pin is sequentially consistent with the load of the view: either the world sees the pin
+	 * before freeing, or the view loaded here was published after that storage was retired.
+	 * */
+	atomic_store(&guard->readers[reader].epoch, atomic_load(&guard->epoch));
+	return atomic_load(&guard->view);
+}
+
+/*
+ * @brief End a read started with maybe_world_read_begin
+ *
+ * @param guard A pointer to the guard
+ * @param reader The reader's slot
+ * */
+static inline void maybe_world_read_end(
+	maybe_world_read_guard_t* guard,
+	uint32_t reader
+) {
+	atomic_store_explicit(&guard->readers[reader].epoch, 0, memory_order_release);
+}
+
+/*
+ * @brief Find the column of a component in an archetype of a view
+ *
+ * @param archetype The archetype
+ * @param component_id The component
+ * @param column Set to the column's rows, if it was found
+ *
+ * @return Whether the archetype has the component
+ * */
+static inline bool maybe_world_read_find_column(
+	const maybe_world_read_archetype_t* archetype,
+	uint32_t component_id,
+	const void** column
+) {
+	uint32_t i;
+
+	for (i = 0; i < archetype->column_count; i++) {
+		if (archetype->component_ids[i] == component_id) {
+			*column = archetype->columns[i];
+			return true;
+		}
+	}
+
+	return false;
+}
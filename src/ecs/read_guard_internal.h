@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "read_guard.h"
+
+/*
+ * @brief The guard's allocator, allocates new storage on the heap and retires the old storage instead of freeing it
+ * */
+static void* guard_reallocate(
+	void* context,
+	void* memory,
+	size_t old_size,
+	size_t new_size
+);
+
+/*
+ * @brief The guard's allocator, retires storage instead of freeing it
+ * */
+static void guard_free(
+	void* context,
+	void* memory,
+	size_t size
+);
+
+/*
+ * @brief Free storage once no reader can see it, or right away after waiting for the readers if it can't be queued
+ *
+ * @param guard The guard
+ * @param memory The storage, can be NULL
+ * */
+static void retire(
+	maybe_world_read_guard_t* guard,
+	void* memory
+);
+
+/*
+ * @brief Wait until every reader that started before now ended its read
+ *
+ * @param guard The guard
+ * */
+static void wait_for_readers(
+	maybe_world_read_guard_t* guard
+);
+
+/*
+ * @brief Get the oldest epoch a reader is reading in
+ *
+ * @param guard The guard
+ *
+ * @return The oldest epoch, the current epoch if no reader is reading
+ * */
+static uint64_t get_oldest_epoch(
+	maybe_world_read_guard_t* guard
+);
+
+/*
+ * @brief Build a view of the guard's world, in a single allocation
+ *
+ * @param guard The guard
+ * @param view Set to the view
+ * */
+static maybe_error_t build_view(
+	maybe_world_read_guard_t* guard,
+	maybe_world_read_view_t** view
+);
+
+/*
+ * @brief Free the retired storage of epochs older than every reader's
+ *
+ * @param guard The guard
+ * */
+static void reclaim(
+	maybe_world_read_guard_t* guard
+);
@@ -0,0 +1,486 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "common/error.h"
+#include "common/common.h"
+#include "common/vector/vector.h"
+#include "common/thread/thread_pool.h"
+
+#include "reduction.h"
+#include "reduction_internal.h"
+
+maybe_error_t maybe_reduction_init(
+	maybe_reduction_t* reduction,
+	maybe_world_t* world,
+	const maybe_reduction_config_t* config
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_component_type_t* component_type;
+	uint32_t i;
+
+	if ((NULL == reduction) || (NULL == world) || (NULL == config) ||
+		(NULL == config->identity) || (NULL == config->accumulate) || (NULL == config->combine)) {
+		result = MAYBE_ERROR_REDUCTION_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	memset(reduction, 0, sizeof(*reduction));
+	reduction->config = *config;
+
+	if ((0 == config->component_count) || (config->component_count > MAYBE_REDUCTION_MAX_COMPONENTS) ||
+		(0 == config->accumulator_size)) {
+		result = MAYBE_ERROR_REDUCTION_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < config->component_count; i++) {
+		if (config->component_ids[i] >= world->component_types.length) {
+			result = MAYBE_ERROR_REDUCTION_INVALID_PARAM;
+			goto l_cleanup;
+		}
+
+		component_type = &MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, config->component_ids[i]);
+		if (NULL != component_type->shared_store) {
+			result = MAYBE_ERROR_REDUCTION_INVALID_PARAM;
+			goto l_cleanup;
+		}
+	}
+
+	result = maybe_vector_init(&reduction->identity, 1, config->accumulator_size);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* The caller's identity does not have to outlive init */
+	memcpy(reduction->identity.elements, config->identity, config->accumulator_size);
+	reduction->identity.length = config->accumulator_size;
+	reduction->config.identity = reduction->identity.elements;
+
+	result = maybe_vector_init(&reduction->chunks, sizeof(maybe_reduction_chunk_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&reduction->accumulators, config->accumulator_size, 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (IS_FAILURE(result) && (MAYBE_ERROR_REDUCTION_NULL_PARAM != result)) {
+		(void)maybe_reduction_free(reduction);
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_reduction_init_field(
+	maybe_reduction_t* reduction,
+	maybe_world_t* world,
+	uint32_t component_id,
+	uint32_t offset,
+	maybe_reduction_field_t field,
+	maybe_reduction_operation_t operation
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_reduction_config_t config = { 0 };
+	uint32_t component_size, field_size;
+	int64_t int_identity;
+	double float_identity;
+
+	if ((NULL == reduction) || (NULL == world)) {
+		result = MAYBE_ERROR_REDUCTION_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if ((component_id >= world->component_types.length) ||
+		((MAYBE_REDUCTION_SUM != operation) && (MAYBE_REDUCTION_MIN != operation) && (MAYBE_REDUCTION_MAX != operation))) {
+		result = MAYBE_ERROR_REDUCTION_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	config.component_count = 1;
+	config.component_ids[0] = component_id;
+	config.context = reduction;
+
+	switch (field) {
+	case MAYBE_REDUCTION_FIELD_INT32:
+		field_size = sizeof(int32_t);
+		config.accumulate = accumulate_int32;
+		break;
+	case MAYBE_REDUCTION_FIELD_INT64:
+		field_size = sizeof(int64_t);
+		config.accumulate = accumulate_int64;
+		break;
+	case MAYBE_REDUCTION_FIELD_FLOAT:
+		field_size = sizeof(float);
+		config.accumulate = accumulate_float;
+		break;
+	case MAYBE_REDUCTION_FIELD_DOUBLE:
+		field_size = sizeof(double);
+		config.accumulate = accumulate_double;
+		break;
+	default:
+		result = MAYBE_ERROR_REDUCTION_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	component_size = MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, component_id).component_size;
+	if ((uint64_t)offset + field_size > component_size) {
+		result = MAYBE_ERROR_REDUCTION_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	if ((MAYBE_REDUCTION_FIELD_INT32 == field) || (MAYBE_REDUCTION_FIELD_INT64 == field)) {
+		int_identity = (MAYBE_REDUCTION_SUM == operation) ? 0 : ((MAYBE_REDUCTION_MIN == operation) ? INT64_MAX : INT64_MIN);
+		config.accumulator_size = sizeof(int64_t);
+		config.identity = &int_identity;
+		config.combine = combine_int64;
+	} else {
+		float_identity = (MAYBE_REDUCTION_SUM == operation) ? 0.0 : ((MAYBE_REDUCTION_MIN == operation) ? INFINITY : -INFINITY);
+		config.accumulator_size = sizeof(double);
+		config.identity = &float_identity;
+		config.combine = combine_double;
+	}
+
+	result = maybe_reduction_init(reduction, world, &config);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	reduction->field_offset = offset;
+	reduction->component_size = component_size;
+	reduction->operation = operation;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_reduction_run(
+	maybe_reduction_t* reduction,
+	maybe_world_t* world,
+	void* value
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t chunk_count, stride, i;
+
+	if ((NULL == reduction) || (NULL == world) || (NULL == value)) {
+		result = MAYBE_ERROR_REDUCTION_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = collect_chunks(reduction, world);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	chunk_count = reduction->chunks.length;
+
+	result = maybe_vector_reserve(&reduction->accumulators, chunk_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	reduction->accumulators.length = chunk_count;
+
+	result = maybe_thread_pool_run(world->thread_pool, reduce_chunk, reduction, chunk_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* The accumulators are combined in a tree fixed by the chunks, not by the threads that folded them */
+	for (stride = 1; stride < chunk_count; stride *= 2) {
+		for (i = 0; i + stride < chunk_count; i += 2 * stride) {
+			reduction->config.combine(
+				MAYBE_VECTOR_ELEMENT_VOID_PTR(reduction->accumulators, i),
+				MAYBE_VECTOR_ELEMENT_VOID_PTR(reduction->accumulators, (i + stride)),
+				reduction->config.context
+			);
+		}
+	}
+
+	reduction->row_count = 0;
+	for (i = 0; i < chunk_count; i++) {
+		reduction->row_count += MAYBE_VECTOR_ELEMENT(reduction->chunks, maybe_reduction_chunk_t, i).row_count;
+	}
+
+	memcpy(
+		value,
+		(chunk_count > 0) ? MAYBE_VECTOR_ELEMENT_VOID_PTR(reduction->accumulators, 0) : reduction->identity.elements,
+		reduction->config.accumulator_size
+	);
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_reduction_free(
+	maybe_reduction_t* reduction
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_error_t free_result;
+
+	if (NULL == reduction) {
+		result = MAYBE_ERROR_REDUCTION_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+
+	free_result = maybe_vector_free(&reduction->identity);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&reduction->chunks);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&reduction->accumulators);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	/* If any free operation failed, return an error */
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t collect_chunks(
+	maybe_reduction_t* reduction,
+	maybe_world_t* world
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_archetype_t* archetype;
+	maybe_reduction_chunk_t chunk;
+	uint64_t mask = maybe_archetype_get_component_mask(reduction->config.component_ids, reduction->config.component_count);
+	uint32_t component_index;
+	uint32_t i, j;
+	bool matches;
+
+	reduction->chunks.length = 0;
+
+	for (i = 0; i < world->archetypes.length; i++) {
+		archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i);
+
+		if ((archetype->entities.length == archetype->disabled_count) || ((archetype->component_mask & mask) != mask)) {
+			continue;
+		}
+
+		memset(&chunk, 0, sizeof(chunk));
+		chunk.archetype = archetype;
+
+		matches = true;
+		for (j = 0; (j < reduction->config.component_count) && matches; j++) {
+			matches = maybe_archetype_find_component(archetype, reduction->config.component_ids[j], &component_index);
+			if (matches) {
+				chunk.columns[j] = MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, component_index).elements;
+			}
+		}
+
+		if (!matches) {
+			continue;
+		}
+
+		/* Chunks only depend on the rows, so every run with the same rows folds and combines them the same way */
+		for (chunk.first_row = 0; chunk.first_row < archetype->entities.length; chunk.first_row += MAYBE_REDUCTION_CHUNK_ROWS) {
+			chunk.end_row = chunk.first_row + MAYBE_REDUCTION_CHUNK_ROWS;
+			if (chunk.end_row > archetype->entities.length) {
+				chunk.end_row = archetype->entities.length;
+			}
+
+			result = maybe_vector_push(&reduction->chunks, &chunk);
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+void reduce_chunk(
+	void* context,
+	uint32_t job_index
+) {
+	maybe_reduction_t* reduction = (maybe_reduction_t*)context;
+	maybe_reduction_chunk_t* chunk = &MAYBE_VECTOR_ELEMENT(reduction->chunks, maybe_reduction_chunk_t, job_index);
+	void* accumulator = MAYBE_VECTOR_ELEMENT_VOID_PTR(reduction->accumulators, job_index);
+	uint32_t first_row, end_row = chunk->first_row;
+
+	memcpy(accumulator, reduction->identity.elements, reduction->config.accumulator_size);
+	chunk->row_count = 0;
+
+	while (maybe_archetype_find_enabled_rows(chunk->archetype, end_row, &first_row, &end_row) && (first_row < chunk->end_row)) {
+		if (end_row > chunk->end_row) {
+			end_row = chunk->end_row;
+		}
+
+		reduction->config.accumulate(accumulator, chunk->columns, first_row, end_row, reduction->config.context);
+		chunk->row_count += end_row - first_row;
+	}
+}
+
+void accumulate_int32(
+	void* accumulator,
+	void* const* columns,
+	uint32_t first_row,
+	uint32_t end_row,
+	void* context
+) {
+	maybe_reduction_t* reduction = (maybe_reduction_t*)context;
+	const uint8_t* field = (const uint8_t*)columns[0] + (size_t)first_row * reduction->component_size + reduction->field_offset;
+	int64_t value = *(int64_t*)accumulator;
+	int32_t element;
+	uint32_t row;
+
+	for (row = first_row; row < end_row; row++, field += reduction->component_size) {
+		memcpy(&element, field, sizeof(element));
+
+		if (MAYBE_REDUCTION_SUM == reduction->operation) {
+			value += element;
+		} else if (MAYBE_REDUCTION_MIN == reduction->operation) {
+			value = (element < value) ? element : value;
+		} else {
+			value = (element > value) ? element : value;
+		}
+	}
+
+	*(int64_t*)accumulator = value;
+}
+
+void accumulate_int64(
+	void* accumulator,
+	void* const* columns,
+	uint32_t first_row,
+	uint32_t end_row,
+	void* context
+) {
+	maybe_reduction_t* reduction = (maybe_reduction_t*)context;
+	const uint8_t* field = (const uint8_t*)columns[0] + (size_t)first_row * reduction->component_size + reduction->field_offset;
+	int64_t value = *(int64_t*)accumulator;
+	int64_t element;
+	uint32_t row;
+
+	for (row = first_row; row < end_row; row++, field += reduction->component_size) {
+		memcpy(&element, field, sizeof(element));
+
+		if (MAYBE_REDUCTION_SUM == reduction->operation) {
+			value += element;
+		} else if (MAYBE_REDUCTION_MIN == reduction->operation) {
+			value = (element < value) ? element : value;
+		} else {
+			value = (element > value) ? element : value;
+		}
+	}
+
+	*(int64_t*)accumulator = value;
+}
+
+void accumulate_float(
+	void* accumulator,
+	void* const* columns,
+	uint32_t first_row,
+	uint32_t end_row,
+	void* context
+) {
+	maybe_reduction_t* reduction = (maybe_reduction_t*)context;
+	const uint8_t* field = (const uint8_t*)columns[0] + (size_t)first_row * reduction->component_size + reduction->field_offset;
+	double value = *(double*)accumulator;
+	float element;
+	uint32_t row;
+
+	for (row = first_row; row < end_row; row++, field += reduction->component_size) {
+		memcpy(&element, field, sizeof(element));
+
+		if (MAYBE_REDUCTION_SUM == reduction->operation) {
+			value += element;
+		} else if (MAYBE_REDUCTION_MIN == reduction->operation) {
+			value = (element < value) ? element : value;
+		} else {
+			value = (element > value) ? element : value;
+		}
+	}
+
+	*(double*)accumulator = value;
+}
+
+void accumulate_double(
+	void* accumulator,
+	void* const* columns,
+	uint32_t first_row,
+	uint32_t end_row,
+	void* context
+) {
+	maybe_reduction_t* reduction = (maybe_reduction_t*)context;
+	const uint8_t* field = (const uint8_t*)columns[0] + (size_t)first_row * reduction->component_size + reduction->field_offset;
+	double value = *(double*)accumulator;
+	double element;
+	uint32_t row;
+
+	for (row = first_row; row < end_row; row++, field += reduction->component_size) {
+		memcpy(&element, field, sizeof(element));
+
+		if (MAYBE_REDUCTION_SUM == reduction->operation) {
+			value += element;
+		} else if (MAYBE_REDUCTION_MIN == reduction->operation) {
+			value = (element < value) ? element : value;
+		} else {
+			value = (element > value) ? element : value;
+		}
+	}
+
+	*(double*)accumulator = value;
+}
+
+void combine_int64(
+	void* accumulator,
+	const void* other,
+	void* context
+) {
+	maybe_reduction_t* reduction = (maybe_reduction_t*)context;
+	int64_t value = *(int64_t*)accumulator;
+	int64_t other_value = *(const int64_t*)other;
+
+	if (MAYBE_REDUCTION_SUM == reduction->operation) {
+		value += other_value;
+	} else if (MAYBE_REDUCTION_MIN == reduction->operation) {
+		value = (other_value < value) ? other_value : value;
+	} else {
+		value = (other_value > value) ? other_value : value;
+	}
+
+	*(int64_t*)accumulator = value;
+}
+
+void combine_double(
+	void* accumulator,
+	const void* other,
+	void* context
+) {
+	maybe_reduction_t* reduction = (maybe_reduction_t*)context;
+	double value = *(double*)accumulator;
+	double other_value = *(const double*)other;
+
+	if (MAYBE_REDUCTION_SUM == reduction->operation) {
+		value += other_value;
+	} else if (MAYBE_REDUCTION_MIN == reduction->operation) {
+		value = (other_value < value) ? other_value : value;
+	} else {
+		value = (other_value > value) ? other_value : value;
+	}
+
+	*(double*)accumulator = value;
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "common/error.h"
+#include "common/vector/vector.h"
+#include "archetype.h"
+#include "ecs.h"
+
+/*
+ * Reductions
+ *
+ * A reduction folds the components of every entity that has a set of components into one value,
+ * like a total, a bounding box or a count per faction, in parallel on the world's thread pool:
+ *
+ * 		maybe_reduction_init_field(&total_mass, &world, MAYBE_COMPONENT_ID(mass_t), offsetof(mass_t, value),
+ * 			MAYBE_REDUCTION_FIELD_FLOAT, MAYBE_REDUCTION_SUM);
+ * 		...
+ * 		double mass;
+ * 		maybe_reduction_run(&total_mass, &world, &mass);
+ *
+ * The rows are split into chunks of MAYBE_REDUCTION_CHUNK_ROWS rows of one archetype. Every chunk is
+ * folded into an accumulator of its own by whichever thread claims it, and the accumulators are then
+ * combined pairwise in a fixed tree: chunk 0 with chunk 1, chunk 2 with chunk 3, and so on up. The
+ * chunks and the tree only depend on the world's archetypes and rows, so the result is the same for
+ * any number of threads, even for floating point sums.
+ *
+ * Custom reductions give the size and starting value of their accumulator, a function that folds a
+ * range of rows into an accumulator and a function that combines two accumulators. The combine
+ * function must be associative for the result to mean the same as a serial fold, it does not have to
+ * be commutative since the accumulators are always combined in row order.
+ *
+ * Disabled entities are skipped. The functions must not make changes to the world.
+ * */
+
+/* @brief The number of components a reduction can read */
+#define MAYBE_REDUCTION_MAX_COMPONENTS (8)
+
+/* @brief The number of rows of a chunk, folded by a single job */
+#define MAYBE_REDUCTION_CHUNK_ROWS (4096)
+
+/*
+ * @brief A prototype for a function that folds a range of rows into an accumulator
+ *
+ * @param accumulator The chunk's accumulator
+ * @param columns The storage of every component of the reduction in the rows' archetype, in the reduction's order
+ * @param first_row The first row
+ * @param end_row The row after the last row
+ * @param context The reduction's context
+ * */
+typedef void (*maybe_reduction_accumulate_t)(
+	void* accumulator,
+	void* const* columns,
+	uint32_t first_row,
+	uint32_t end_row,
+	void* context
+);
+
+/*
+ * @brief A prototype for a function that combines the accumulator of later rows into the accumulator of earlier rows
+ *
+ * @param accumulator The accumulator of the earlier rows, set to the combination
+ * @param other The accumulator of the later rows
+ * @param context The reduction's context
+ * */
+typedef void (*maybe_reduction_combine_t)(
+	void* accumulator,
+	const void* other,
+	void* context
+);
+
+/* @brief The operations of field reductions */
+typedef enum {
+	MAYBE_REDUCTION_SUM,
+	MAYBE_REDUCTION_MIN,
+	MAYBE_REDUCTION_MAX
+} maybe_reduction_operation_t;
+
+/* @brief The type of a reduced field, integer fields are reduced into an int64_t and floating point fields into a double */
+typedef enum {
+	MAYBE_REDUCTION_FIELD_INT32,
+	MAYBE_REDUCTION_FIELD_INT64,
+	MAYBE_REDUCTION_FIELD_FLOAT,
+	MAYBE_REDUCTION_FIELD_DOUBLE
+} maybe_reduction_field_t;
+
+/* @brief What a reduction reads and how it folds it */
+typedef struct {
+	uint32_t component_count;
+	uint32_t component_ids[MAYBE_REDUCTION_MAX_COMPONENTS];
+	uint32_t accumulator_size;
+	const void* identity; /* The value every accumulator starts from, accumulator_size bytes. Copied by init */
+	maybe_reduction_accumulate_t accumulate;
+	maybe_reduction_combine_t combine;
+	void* context; /* Passed to the functions */
+} maybe_reduction_config_t;
+
+/* @brief A range of rows of one archetype, folded by a single job */
+typedef struct {
+	maybe_archetype_t* archetype;
+	uint32_t first_row;
+	uint32_t end_row;
+	uint32_t row_count; /* The number of enabled rows the job folded */
+	void* columns[MAYBE_REDUCTION_MAX_COMPONENTS];
+} maybe_reduction_chunk_t;
+
+/* @brief A reduction over the components of a world's entities */
+typedef struct {
+	maybe_reduction_config_t config;
+	MAYBE_VECTOR(uint8_t) identity;
+	MAYBE_VECTOR(maybe_reduction_chunk_t) chunks;
+	maybe_vector_t accumulators; /* The accumulator of every chunk, accumulator_size bytes each */
+	uint32_t field_offset; /* The field's byte offset in the component, for field reductions */
+	uint32_t component_size; /* The size of the component, for field reductions */
+	maybe_reduction_operation_t operation; /* For field reductions */
+	uint64_t row_count; /* The number of entities the last run folded */
+} maybe_reduction_t;
+
+/*
+ * @brief Initialize a custom reduction
+ *
+ * @param reduction A pointer to the new reduction
+ * @param world A pointer to the world the components are registered in
+ * @param config The reduced components and the reduction's functions, shared components are not allowed
+ * */
+maybe_error_t maybe_reduction_init(
+	maybe_reduction_t* reduction,
+	maybe_world_t* world,
+	const maybe_reduction_config_t* config
+);
+
+/*
+ * @brief Initialize the sum, minimum or maximum of a field of a component
+ *
+ * @param reduction A pointer to the new reduction, it is the context of the reduction's functions so it must not be moved
+ * @param world A pointer to the world the component is registered in
+ * @param component_id The component
+ * @param offset The byte offset of the field in the component
+ * @param field The type of the field
+ * @param operation The operation
+ *
+ * @note The minimum of no entities is INT64_MAX or infinity, and their maximum INT64_MIN or minus infinity
+ * */
+maybe_error_t maybe_reduction_init_field(
+	maybe_reduction_t* reduction,
+	maybe_world_t* world,
+	uint32_t component_id,
+	uint32_t offset,
+	maybe_reduction_field_t field,
+	maybe_reduction_operation_t operation
+);
+
+/*
+ * @brief Fold the components of a world's entities, on the world's thread pool
+ *
+ * @param reduction A pointer to the reduction
+ * @param world A pointer to the world
+ * @param value Set to the combined accumulator, accumulator_size bytes. An int64_t or a double for field reductions
+ * */
+maybe_error_t maybe_reduction_run(
+	maybe_reduction_t* reduction,
+	maybe_world_t* world,
+	void* value
+);
+
+/*
+ * @brief Free a reduction's resources
+ *
+ * @param reduction A pointer to the reduction
+ * */
+maybe_error_t maybe_reduction_free(
+	maybe_reduction_t* reduction
+);
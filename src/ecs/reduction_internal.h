@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "reduction.h"
+
+/*
+ * @brief Split the rows of the archetypes that have the reduction's components into chunks
+ *
+ * @param reduction The reduction
+ * @param world The world
+ * */
+static maybe_error_t collect_chunks(
+	maybe_reduction_t* reduction,
+	maybe_world_t* world
+);
+
+/*
+ * @brief A thread pool job that folds the enabled rows of a chunk into its accumulator
+ * */
+static void reduce_chunk(
+	void* context,
+	uint32_t job_index
+);
+
+/*
+ * @brief Fold int32_t fields into an int64_t, the context is the reduction
+ * */
+static void accumulate_int32(
+	void* accumulator,
+	void* const* columns,
+	uint32_t first_row,
+	uint32_t end_row,
+	void* context
+);
+
+/*
+ * @brief Fold int64_t fields into an int64_t, the context is the reduction
+ * */
+static void accumulate_int64(
+	void* accumulator,
+	void* const* columns,
+	uint32_t first_row,
+	uint32_t end_row,
+	void* context
+);
+
+/*
+ * @brief Fold float fields into a double, the context is the reduction
+ * */
+static void accumulate_float(
+	void* accumulator,
+	void* const* columns,
+	uint32_t first_row,
+	uint32_t end_row,
+	void* context
+);
+
+/*
+ * @brief Fold double fields into a double, the context is the reduction
+ * */
+static void accumulate_double(
+	void* accumulator,
+	void* const* columns,
+	uint32_t first_row,
+	uint32_t end_row,
+	void* context
+);
+
+/*
+ * @brief Combine int64_t accumulators of a field reduction, the context is the reduction
+ * */
+static void combine_int64(
+	void* accumulator,
+	const void* other,
+	void* context
+);
+
+/*
+ * @brief Combine double accumulators of a field reduction, the context is the reduction
+ * */
+static void combine_double(
+	void* accumulator,
+	const void* other,
+	void* context
+);
@@ -0,0 +1,1487 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/error.h"
+#include "common/common.h"
+#include "common/vector/vector.h"
+#include "common/map/map.h"
+
+#include "replication.h"
+#include "replication_internal.h"
+
+maybe_error_t maybe_replication_server_init(
+	maybe_replication_server_t* server,
+	maybe_world_t* world,
+	uint32_t component_count,
+	const uint32_t* component_ids
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t i;
+
+	if ((NULL == server) || (NULL == world) || (NULL == component_ids)) {
+		result = MAYBE_ERROR_REPLICATION_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	memset(server, 0, sizeof(*server));
+
+	result = init_layout(&server->layout, world, component_count, component_ids);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < MAYBE_REPLICATION_HISTORY; i++) {
+		result = init_snapshot(&server->snapshots[i], &server->layout);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = init_snapshot(&server->unsorted, &server->layout);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&server->peers, sizeof(maybe_replication_peer_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&server->sort_entries, sizeof(maybe_replication_sort_entry_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < server->layout.component_count; i++) {
+		result = maybe_vector_init(&server->changes[i], sizeof(uint8_t), 0);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		result = maybe_vector_init(&server->removals[i], sizeof(uint8_t), 0);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = maybe_vector_init(&server->removed_entities, sizeof(uint8_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (IS_FAILURE(result) && (MAYBE_ERROR_REPLICATION_NULL_PARAM != result)) {
+		(void)maybe_replication_server_free(server);
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_replication_server_add_peer(
+	maybe_replication_server_t* server,
+	uint32_t* peer_index
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_replication_peer_t peer;
+
+	if ((NULL == server) || (NULL == peer_index)) {
+		result = MAYBE_ERROR_REPLICATION_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	memset(&peer, 0, sizeof(peer));
+
+	result = maybe_vector_push(&server->peers, &peer);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	*peer_index = server->peers.length - 1;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_replication_server_capture(
+	maybe_replication_server_t* server,
+	maybe_world_t* world
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_replication_layout_t* layout;
+	maybe_replication_snapshot_t* unsorted;
+	maybe_replication_snapshot_t* snapshot;
+	maybe_replication_sort_entry_t* entries;
+	maybe_archetype_t* archetype;
+	uint32_t component_indices[MAYBE_REPLICATION_MAX_COMPONENTS];
+	uint32_t row_count = 0;
+	uint32_t mask, row, i, j;
+	uint8_t* values;
+	bool is_sorted = true;
+
+	if ((NULL == server) || (NULL == world)) {
+		result = MAYBE_ERROR_REPLICATION_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	layout = &server->layout;
+	unsorted = &server->unsorted;
+
+	for (i = 0; i < world->archetypes.length; i++) {
+		archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i);
+
+		for (j = 0; j < layout->component_count; j++) {
+			if (maybe_archetype_find_component(archetype, layout->component_ids[j], &component_indices[j])) {
+				row_count += archetype->entities.length;
+				break;
+			}
+		}
+	}
+
+	result = reset_snapshot(unsorted, row_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_reserve(&server->sort_entries, row_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* Gather the rows in archetype order, every row is the entity's replicated components side by side */
+	entries = (maybe_replication_sort_entry_t*)server->sort_entries.elements;
+	for (i = 0; i < world->archetypes.length; i++) {
+		archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i);
+
+		mask = 0;
+		for (j = 0; j < layout->component_count; j++) {
+			if (maybe_archetype_find_component(archetype, layout->component_ids[j], &component_indices[j])) {
+				mask |= 1u << j;
+			}
+		}
+
+		if ((0 == mask) || (0 == archetype->entities.length)) {
+			continue;
+		}
+
+		for (row = 0; row < archetype->entities.length; row++) {
+			values = (uint8_t*)MAYBE_VECTOR_ELEMENT_VOID_PTR(unsorted->values, unsorted->entities.length);
+			memset(values, 0, unsorted->values.element_size);
+
+			for (j = 0; j < layout->component_count; j++) {
+				if (mask & (1u << j)) {
+					memcpy(
+						values + layout->component_offsets[j],
+						MAYBE_VECTOR_ELEMENT_VOID_PTR(MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, component_indices[j]), row),
+						layout->component_sizes[j]
+					);
+				}
+			}
+
+			entries[unsorted->entities.length].entity = MAYBE_VECTOR_ELEMENT(archetype->entities, maybe_entity_t, row);
+			entries[unsorted->entities.length].row = unsorted->entities.length;
+			if ((unsorted->entities.length > 0) && (entries[unsorted->entities.length - 1].entity > entries[unsorted->entities.length].entity)) {
+				is_sorted = false;
+			}
+
+			MAYBE_VECTOR_ELEMENT(unsorted->entities, maybe_entity_t, unsorted->entities.length) = entries[unsorted->entities.length].entity;
+			MAYBE_VECTOR_ELEMENT(unsorted->masks, uint32_t, unsorted->entities.length) = mask;
+			unsorted->entities.length++;
+		}
+	}
+	unsorted->masks.length = unsorted->entities.length;
+	unsorted->values.length = unsorted->entities.length;
+	server->sort_entries.length = unsorted->entities.length;
+
+	/* Snapshots are sorted by entity so the encoder can walk two of them side by side */
+	if (!is_sorted) {
+		qsort(entries, server->sort_entries.length, sizeof(*entries), compare_sort_entries);
+	}
+
+	snapshot = &server->snapshots[(server->tick + 1) % MAYBE_REPLICATION_HISTORY];
+
+	result = reset_snapshot(snapshot, unsorted->entities.length);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < unsorted->entities.length; i++) {
+		row = entries[i].row;
+
+		MAYBE_VECTOR_ELEMENT(snapshot->entities, maybe_entity_t, i) = entries[i].entity;
+		MAYBE_VECTOR_ELEMENT(snapshot->masks, uint32_t, i) = MAYBE_VECTOR_ELEMENT(unsorted->masks, uint32_t, row);
+		memcpy(
+			MAYBE_VECTOR_ELEMENT_VOID_PTR(snapshot->values, i),
+			MAYBE_VECTOR_ELEMENT_VOID_PTR(unsorted->values, row),
+			snapshot->values.element_size
+		);
+	}
+	snapshot->entities.length = unsorted->entities.length;
+	snapshot->masks.length = unsorted->entities.length;
+	snapshot->values.length = unsorted->entities.length;
+
+	server->tick++;
+	snapshot->tick = server->tick;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_replication_server_encode(
+	maybe_replication_server_t* server,
+	uint32_t peer_index,
+	maybe_vector_t* stream
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_replication_peer_t* peer;
+	maybe_replication_snapshot_t* current;
+	maybe_replication_snapshot_t* baseline;
+	maybe_replication_stats_t stats;
+	uint32_t change_counts[MAYBE_REPLICATION_MAX_COMPONENTS];
+	uint32_t removal_counts[MAYBE_REPLICATION_MAX_COMPONENTS];
+	uint32_t removed_entity_count;
+	uint32_t i;
+
+	if ((NULL == server) || (NULL == stream)) {
+		result = MAYBE_ERROR_REPLICATION_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if ((peer_index >= server->peers.length) || (1 != stream->element_size)) {
+		result = MAYBE_ERROR_REPLICATION_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Nothing was captured yet */
+	current = find_snapshot(server->snapshots, server->tick);
+	if (NULL == current) {
+		result = MAYBE_ERROR_REPLICATION_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	peer = &MAYBE_VECTOR_ELEMENT(server->peers, maybe_replication_peer_t, peer_index);
+
+	/* A baseline that dropped out of the history is replaced by an empty one, so everything is sent */
+	baseline = find_snapshot(server->snapshots, peer->acknowledged_tick);
+
+	stats = peer->stats;
+	stats.tick = server->tick;
+	stats.baseline_tick = baseline ? baseline->tick : 0;
+
+	result = encode_changes(server, current, baseline, &stats, change_counts, removal_counts, &removed_entity_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	stream->length = 0;
+
+	result = write_varint(stream, stats.tick);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = write_varint(stream, stats.baseline_tick);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = write_varint(stream, server->layout.component_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = write_varint(stream, current->entities.length);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = write_varint(stream, removed_entity_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = write_bytes(stream, server->removed_entities.elements, server->removed_entities.length);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < server->layout.component_count; i++) {
+		result = write_varint(stream, change_counts[i]);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		result = write_bytes(stream, server->changes[i].elements, server->changes[i].length);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		result = write_varint(stream, removal_counts[i]);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		result = write_bytes(stream, server->removals[i].elements, server->removals[i].length);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	stats.encoded_bytes = stream->length;
+	stats.full_bytes = current->entities.length * (uint32_t)(sizeof(maybe_entity_t) + server->layout.row_size);
+	stats.total_encoded_bytes += stats.encoded_bytes;
+	stats.total_full_bytes += stats.full_bytes;
+	stats.stream_count++;
+	peer->stats = stats;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_replication_server_acknowledge(
+	maybe_replication_server_t* server,
+	uint32_t peer_index,
+	uint64_t tick
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_replication_peer_t* peer;
+
+	if (NULL == server) {
+		result = MAYBE_ERROR_REPLICATION_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if ((peer_index >= server->peers.length) || (tick > server->tick)) {
+		result = MAYBE_ERROR_REPLICATION_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Acknowledgements can arrive out of order, only the newest one counts */
+	peer = &MAYBE_VECTOR_ELEMENT(server->peers, maybe_replication_peer_t, peer_index);
+	if (tick > peer->acknowledged_tick) {
+		peer->acknowledged_tick = tick;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_replication_server_free(
+	maybe_replication_server_t* server
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_error_t free_result;
+	uint32_t i;
+
+	if (NULL == server) {
+		result = MAYBE_ERROR_REPLICATION_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+
+	for (i = 0; i < MAYBE_REPLICATION_HISTORY; i++) {
+		free_result = free_snapshot(&server->snapshots[i]);
+		if (IS_FAILURE(free_result)) {
+			result = free_result;
+		}
+	}
+
+	free_result = free_snapshot(&server->unsorted);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	for (i = 0; i < server->layout.component_count; i++) {
+		free_result = maybe_vector_free(&server->changes[i]);
+		if (IS_FAILURE(free_result)) {
+			result = free_result;
+		}
+
+		free_result = maybe_vector_free(&server->removals[i]);
+		if (IS_FAILURE(free_result)) {
+			result = free_result;
+		}
+	}
+
+	free_result = maybe_vector_free(&server->removed_entities);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&server->sort_entries);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&server->peers);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	/* If any free operation failed, return an error */
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_replication_client_init(
+	maybe_replication_client_t* client,
+	maybe_world_t* world,
+	uint32_t component_count,
+	const uint32_t* component_ids
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t i;
+
+	if ((NULL == client) || (NULL == world) || (NULL == component_ids)) {
+		result = MAYBE_ERROR_REPLICATION_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	memset(client, 0, sizeof(*client));
+	client->world = world;
+
+	result = init_layout(&client->layout, world, component_count, component_ids);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < MAYBE_REPLICATION_HISTORY; i++) {
+		result = init_snapshot(&client->snapshots[i], &client->layout);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = init_snapshot(&client->decoded, &client->layout);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&client->removed_entities, sizeof(maybe_entity_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&client->changes, sizeof(maybe_replication_change_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_map_init(&client->entities, sizeof(maybe_entity_t), sizeof(maybe_entity_t), 0, maybe_map_default_hash_function);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	client->is_map_initialized = true;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (IS_FAILURE(result) && (MAYBE_ERROR_REPLICATION_NULL_PARAM != result)) {
+		(void)maybe_replication_client_free(client);
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_replication_client_decode(
+	maybe_replication_client_t* client,
+	const uint8_t* data,
+	size_t size,
+	uint64_t* acknowledged_tick
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_replication_snapshot_t* baseline = NULL;
+	maybe_replication_snapshot_t* slot;
+	maybe_replication_snapshot_t swapped;
+	uint64_t tick, baseline_tick, component_count, entity_count;
+	size_t position = 0;
+
+	if ((NULL == client) || ((NULL == data) && (size > 0)) || (NULL == acknowledged_tick)) {
+		result = MAYBE_ERROR_REPLICATION_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (!read_varint(data, size, &position, &tick) ||
+		!read_varint(data, size, &position, &baseline_tick) ||
+		!read_varint(data, size, &position, &component_count) ||
+		!read_varint(data, size, &position, &entity_count) ||
+		(0 == tick) ||
+		(baseline_tick >= tick) ||
+		(component_count != client->layout.component_count)) {
+		result = MAYBE_ERROR_REPLICATION_BAD_STREAM;
+		goto l_cleanup;
+	}
+
+	/* The world already has this state or a newer one */
+	if (tick <= client->applied_tick) {
+		*acknowledged_tick = client->applied_tick;
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	if (0 != baseline_tick) {
+		baseline = find_snapshot(client->snapshots, baseline_tick);
+		if (NULL == baseline) {
+			result = MAYBE_ERROR_REPLICATION_MISSING_BASELINE;
+			goto l_cleanup;
+		}
+	}
+
+	result = read_changes(client, data, size, &position);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	if (position != size) {
+		result = MAYBE_ERROR_REPLICATION_BAD_STREAM;
+		goto l_cleanup;
+	}
+
+	result = build_snapshot(client, baseline, data, size, entity_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = apply_snapshot(client, find_snapshot(client->snapshots, client->applied_tick), &client->decoded);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* The decoded snapshot takes the place of the one it overwrites in the history, which is reused for the next decode */
+	slot = &client->snapshots[tick % MAYBE_REPLICATION_HISTORY];
+	swapped = *slot;
+	*slot = client->decoded;
+	client->decoded = swapped;
+	slot->tick = tick;
+	client->decoded.tick = 0;
+
+	client->applied_tick = tick;
+	*acknowledged_tick = tick;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_replication_client_free(
+	maybe_replication_client_t* client
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_error_t free_result;
+	uint32_t i;
+
+	if (NULL == client) {
+		result = MAYBE_ERROR_REPLICATION_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+
+	for (i = 0; i < MAYBE_REPLICATION_HISTORY; i++) {
+		free_result = free_snapshot(&client->snapshots[i]);
+		if (IS_FAILURE(free_result)) {
+			result = free_result;
+		}
+	}
+
+	free_result = free_snapshot(&client->decoded);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&client->removed_entities);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&client->changes);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	if (client->is_map_initialized) {
+		free_result = maybe_map_free(&client->entities);
+		if (IS_FAILURE(free_result)) {
+			result = free_result;
+		}
+		client->is_map_initialized = false;
+	}
+
+	/* If any free operation failed, return an error */
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t init_layout(
+	maybe_replication_layout_t* layout,
+	maybe_world_t* world,
+	uint32_t component_count,
+	const uint32_t* component_ids
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_component_type_t* component_type;
+	uint32_t i;
+
+	if ((0 == component_count) || (component_count > MAYBE_REPLICATION_MAX_COMPONENTS)) {
+		result = MAYBE_ERROR_REPLICATION_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	layout->component_count = component_count;
+	layout->row_size = 0;
+
+	for (i = 0; i < component_count; i++) {
+		if (component_ids[i] >= world->component_types.length) {
+			result = MAYBE_ERROR_REPLICATION_INVALID_PARAM;
+			goto l_cleanup;
+		}
+
+		component_type = &MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, component_ids[i]);
+		if (NULL != component_type->shared_store) {
+			result = MAYBE_ERROR_REPLICATION_INVALID_PARAM;
+			goto l_cleanup;
+		}
+
+		layout->component_ids[i] = component_ids[i];
+		layout->component_sizes[i] = component_type->component_size;
+		layout->component_offsets[i] = layout->row_size;
+		layout->row_size += component_type->component_size;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t init_snapshot(
+	maybe_replication_snapshot_t* snapshot,
+	const maybe_replication_layout_t* layout
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	snapshot->tick = 0;
+
+	result = maybe_vector_init(&snapshot->entities, sizeof(maybe_entity_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&snapshot->masks, sizeof(uint32_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* Rows of only empty components still need an element size */
+	result = maybe_vector_init(&snapshot->values, (layout->row_size > 0) ? layout->row_size : 1, 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t reset_snapshot(
+	maybe_replication_snapshot_t* snapshot,
+	uint32_t entity_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	snapshot->tick = 0;
+	snapshot->entities.length = 0;
+	snapshot->masks.length = 0;
+	snapshot->values.length = 0;
+
+	result = maybe_vector_reserve(&snapshot->entities, entity_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_reserve(&snapshot->masks, entity_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_reserve(&snapshot->values, entity_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t free_snapshot(
+	maybe_replication_snapshot_t* snapshot
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_error_t free_result;
+
+	result = MAYBE_ERROR_SUCCESS;
+
+	free_result = maybe_vector_free(&snapshot->entities);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&snapshot->masks);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&snapshot->values);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	/* If any free operation failed, return an error */
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	memset(snapshot, 0, sizeof(*snapshot));
+
+	return result;
+}
+
+maybe_replication_snapshot_t* find_snapshot(
+	maybe_replication_snapshot_t* snapshots,
+	uint64_t tick
+) {
+	maybe_replication_snapshot_t* snapshot = &snapshots[tick % MAYBE_REPLICATION_HISTORY];
+
+	if ((0 == tick) || (snapshot->tick != tick)) {
+		return NULL;
+	}
+
+	return snapshot;
+}
+
+int compare_sort_entries(
+	const void* first,
+	const void* second
+) {
+	const maybe_replication_sort_entry_t* first_entry = (const maybe_replication_sort_entry_t*)first;
+	const maybe_replication_sort_entry_t* second_entry = (const maybe_replication_sort_entry_t*)second;
+
+	return (first_entry->entity > second_entry->entity) - (first_entry->entity < second_entry->entity);
+}
+
+int compare_changes(
+	const void* first,
+	const void* second
+) {
+	const maybe_replication_change_t* first_change = (const maybe_replication_change_t*)first;
+	const maybe_replication_change_t* second_change = (const maybe_replication_change_t*)second;
+
+	if (first_change->entity != second_change->entity) {
+		return (first_change->entity > second_change->entity) ? 1 : -1;
+	}
+
+	return (first_change->component_index > second_change->component_index) - (first_change->component_index < second_change->component_index);
+}
+
+maybe_error_t write_bytes(
+	maybe_vector_t* stream,
+	const void* data,
+	size_t size
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t capacity;
+
+	if (0 == size) {
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	if ((size_t)stream->length + size > UINT32_MAX / 2) {
+		result = MAYBE_ERROR_REPLICATION_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+
+	if (stream->length + size > stream->capacity) {
+		capacity = stream->capacity * 2;
+		if (capacity < stream->length + size) {
+			capacity = stream->length + (uint32_t)size;
+		}
+
+		result = maybe_vector_reserve(stream, capacity);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	memcpy((uint8_t*)stream->elements + stream->length, data, size);
+	stream->length += (uint32_t)size;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t write_varint(
+	maybe_vector_t* stream,
+	uint64_t value
+) {
+	uint8_t bytes[MAX_VARINT_BYTES];
+	uint32_t count = 0;
+
+	while (value >= 0x80) {
+		bytes[count] = (uint8_t)(value | 0x80);
+		value >>= 7;
+		count++;
+	}
+	bytes[count] = (uint8_t)value;
+	count++;
+
+	return write_bytes(stream, bytes, count);
+}
+
+maybe_error_t write_xor(
+	maybe_vector_t* stream,
+	const uint8_t* value,
+	const uint8_t* baseline,
+	uint32_t size
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint8_t bytes[sizeof(uint32_t)];
+	uint32_t word, baseline_word;
+	uint32_t i;
+
+	/* Small changes to numbers only flip their low bits, so most of the high bits of the XOR are zero and the varint is short */
+	for (i = 0; i + sizeof(uint32_t) <= size; i += sizeof(uint32_t)) {
+		memcpy(&word, value + i, sizeof(word));
+		memcpy(&baseline_word, baseline + i, sizeof(baseline_word));
+
+		result = write_varint(stream, word ^ baseline_word);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	for (word = 0; i < size; i++, word++) {
+		bytes[word] = value[i] ^ baseline[i];
+	}
+
+	result = write_bytes(stream, bytes, word);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+bool read_varint(
+	const uint8_t* data,
+	size_t size,
+	size_t* position,
+	uint64_t* value
+) {
+	uint64_t read_value = 0;
+	uint32_t shift = 0;
+	uint8_t byte;
+
+	do {
+		if ((*position >= size) || (shift >= 64)) {
+			return false;
+		}
+
+		byte = data[*position];
+		(*position)++;
+
+		read_value |= (uint64_t)(byte & 0x7f) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+
+	*value = read_value;
+
+	return true;
+}
+
+bool read_xor(
+	const uint8_t* data,
+	size_t size,
+	size_t* position,
+	uint8_t* value,
+	uint32_t value_size
+) {
+	uint64_t read_word;
+	uint32_t word;
+	uint32_t i;
+
+	for (i = 0; i + sizeof(uint32_t) <= value_size; i += sizeof(uint32_t)) {
+		if (!read_varint(data, size, position, &read_word) || (read_word > UINT32_MAX)) {
+			return false;
+		}
+
+		if (value) {
+			memcpy(&word, value + i, sizeof(word));
+			word ^= (uint32_t)read_word;
+			memcpy(value + i, &word, sizeof(word));
+		}
+	}
+
+	if (value_size - i > size - *position) {
+		return false;
+	}
+
+	for (; i < value_size; i++) {
+		if (value) {
+			value[i] ^= data[*position];
+		}
+		(*position)++;
+	}
+
+	return true;
+}
+
+maybe_error_t encode_changes(
+	maybe_replication_server_t* server,
+	const maybe_replication_snapshot_t* current,
+	const maybe_replication_snapshot_t* baseline,
+	maybe_replication_stats_t* stats,
+	uint32_t* change_counts,
+	uint32_t* removal_counts,
+	uint32_t* removed_entity_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_replication_layout_t* layout = &server->layout;
+	maybe_entity_t last_changes[MAYBE_REPLICATION_MAX_COMPONENTS];
+	maybe_entity_t last_removals[MAYBE_REPLICATION_MAX_COMPONENTS];
+	maybe_entity_t last_removed_entity = 0;
+	maybe_entity_t entity;
+	const uint8_t* values;
+	const uint8_t* baseline_values;
+	uint8_t zeros[64] = { 0 };
+	const uint8_t* zero_values;
+	uint8_t* allocated_zeros = NULL;
+	uint32_t current_count = current->entities.length;
+	uint32_t baseline_count = baseline ? baseline->entities.length : 0;
+	uint32_t mask, baseline_mask;
+	uint32_t i = 0;
+	uint32_t j = 0;
+	uint32_t c;
+
+	/* New components are compared with zeros, so their XOR is the value itself */
+	zero_values = zeros;
+	if (layout->row_size > sizeof(zeros)) {
+		allocated_zeros = (uint8_t*)calloc(layout->row_size, 1);
+		if (NULL == allocated_zeros) {
+			result = MAYBE_ERROR_REPLICATION_ALLOCATION_FAILED;
+			goto l_cleanup;
+		}
+		zero_values = allocated_zeros;
+	}
+
+	for (c = 0; c < layout->component_count; c++) {
+		server->changes[c].length = 0;
+		server->removals[c].length = 0;
+		change_counts[c] = 0;
+		removal_counts[c] = 0;
+		last_changes[c] = 0;
+		last_removals[c] = 0;
+	}
+	server->removed_entities.length = 0;
+	*removed_entity_count = 0;
+	stats->changed_count = 0;
+	stats->removed_count = 0;
+
+	/* Both snapshots are sorted by entity, so they are walked side by side */
+	while ((i < current_count) || (j < baseline_count)) {
+		if ((j < baseline_count) &&
+			((i >= current_count) || (MAYBE_VECTOR_ELEMENT(baseline->entities, maybe_entity_t, j) < MAYBE_VECTOR_ELEMENT(current->entities, maybe_entity_t, i)))) {
+			entity = MAYBE_VECTOR_ELEMENT(baseline->entities, maybe_entity_t, j);
+
+			result = write_varint(&server->removed_entities, entity - last_removed_entity);
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+
+			last_removed_entity = entity;
+			(*removed_entity_count)++;
+			stats->removed_count++;
+			j++;
+			continue;
+		}
+
+		entity = MAYBE_VECTOR_ELEMENT(current->entities, maybe_entity_t, i);
+		mask = MAYBE_VECTOR_ELEMENT(current->masks, uint32_t, i);
+		values = (const uint8_t*)MAYBE_VECTOR_ELEMENT_VOID_PTR(current->values, i);
+
+		if ((j < baseline_count) && (MAYBE_VECTOR_ELEMENT(baseline->entities, maybe_entity_t, j) == entity)) {
+			baseline_mask = MAYBE_VECTOR_ELEMENT(baseline->masks, uint32_t, j);
+			baseline_values = (const uint8_t*)MAYBE_VECTOR_ELEMENT_VOID_PTR(baseline->values, j);
+			j++;
+		} else {
+			baseline_mask = 0;
+			baseline_values = zero_values;
+		}
+		i++;
+
+		for (c = 0; c < layout->component_count; c++) {
+			if (mask & (1u << c)) {
+				/* Unchanged values are not sent */
+				if ((baseline_mask & (1u << c)) &&
+					(0 == memcmp(values + layout->component_offsets[c], baseline_values + layout->component_offsets[c], layout->component_sizes[c]))) {
+					continue;
+				}
+
+				result = write_varint(&server->changes[c], entity - last_changes[c]);
+				if (IS_FAILURE(result)) {
+					goto l_cleanup;
+				}
+
+				result = write_xor(
+					&server->changes[c],
+					values + layout->component_offsets[c],
+					(baseline_mask & (1u << c)) ? (baseline_values + layout->component_offsets[c]) : zero_values,
+					layout->component_sizes[c]
+				);
+				if (IS_FAILURE(result)) {
+					goto l_cleanup;
+				}
+
+				last_changes[c] = entity;
+				change_counts[c]++;
+				stats->changed_count++;
+			} else if (baseline_mask & (1u << c)) {
+				result = write_varint(&server->removals[c], entity - last_removals[c]);
+				if (IS_FAILURE(result)) {
+					goto l_cleanup;
+				}
+
+				last_removals[c] = entity;
+				removal_counts[c]++;
+				stats->removed_count++;
+			}
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (allocated_zeros) {
+		free(allocated_zeros);
+	}
+
+	return result;
+}
+
+maybe_error_t read_changes(
+	maybe_replication_client_t* client,
+	const uint8_t* data,
+	size_t size,
+	size_t* position
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_replication_change_t change;
+	maybe_entity_t entity;
+	uint64_t count, delta, i;
+	uint32_t c;
+
+	client->removed_entities.length = 0;
+	client->changes.length = 0;
+
+	/* Every entry takes at least a byte, which bounds the counts before anything is allocated for them */
+	if (!read_varint(data, size, position, &count) || (count > size - *position)) {
+		result = MAYBE_ERROR_REPLICATION_BAD_STREAM;
+		goto l_cleanup;
+	}
+
+	entity = 0;
+	for (i = 0; i < count; i++) {
+		if (!read_varint(data, size, position, &delta)) {
+			result = MAYBE_ERROR_REPLICATION_BAD_STREAM;
+			goto l_cleanup;
+		}
+		entity += delta;
+
+		result = maybe_vector_push(&client->removed_entities, &entity);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	for (c = 0; c < client->layout.component_count; c++) {
+		if (!read_varint(data, size, position, &count) || (count > size - *position)) {
+			result = MAYBE_ERROR_REPLICATION_BAD_STREAM;
+			goto l_cleanup;
+		}
+
+		entity = 0;
+		for (i = 0; i < count; i++) {
+			if (!read_varint(data, size, position, &delta)) {
+				result = MAYBE_ERROR_REPLICATION_BAD_STREAM;
+				goto l_cleanup;
+			}
+			entity += delta;
+
+			/* The XOR is applied once the snapshot is built, only its position is kept */
+			change.entity = entity;
+			change.component_index = c;
+			change.position = *position;
+
+			if (!read_xor(data, size, position, NULL, client->layout.component_sizes[c])) {
+				result = MAYBE_ERROR_REPLICATION_BAD_STREAM;
+				goto l_cleanup;
+			}
+
+			result = maybe_vector_push(&client->changes, &change);
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+		}
+
+		if (!read_varint(data, size, position, &count) || (count > size - *position)) {
+			result = MAYBE_ERROR_REPLICATION_BAD_STREAM;
+			goto l_cleanup;
+		}
+
+		entity = 0;
+		for (i = 0; i < count; i++) {
+			if (!read_varint(data, size, position, &delta)) {
+				result = MAYBE_ERROR_REPLICATION_BAD_STREAM;
+				goto l_cleanup;
+			}
+			entity += delta;
+
+			change.entity = entity;
+			change.component_index = c;
+			change.position = MAYBE_REPLICATION_REMOVED;
+
+			result = maybe_vector_push(&client->changes, &change);
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t build_snapshot(
+	maybe_replication_client_t* client,
+	const maybe_replication_snapshot_t* baseline,
+	const uint8_t* data,
+	size_t size,
+	uint64_t entity_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_replication_layout_t* layout = &client->layout;
+	maybe_replication_snapshot_t* decoded = &client->decoded;
+	maybe_replication_change_t* changes = (maybe_replication_change_t*)client->changes.elements;
+	const maybe_entity_t* removed = (const maybe_entity_t*)client->removed_entities.elements;
+	uint32_t baseline_count = baseline ? baseline->entities.length : 0;
+	uint32_t change_count = client->changes.length;
+	uint32_t removed_count = client->removed_entities.length;
+	uint32_t i = 0;
+	uint32_t k = 0;
+	uint32_t r = 0;
+	uint32_t length = 0;
+	maybe_entity_t entity;
+	maybe_entity_t baseline_entity;
+	size_t position;
+	uint8_t* values;
+	uint32_t* mask;
+	bool from_baseline;
+
+	/* Every entity of the snapshot is either kept from the baseline or has a change */
+	if (entity_count > (uint64_t)baseline_count + change_count) {
+		result = MAYBE_ERROR_REPLICATION_BAD_STREAM;
+		goto l_cleanup;
+	}
+
+	qsort(changes, change_count, sizeof(*changes), compare_changes);
+
+	result = reset_snapshot(decoded, (uint32_t)entity_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* The baseline's entities that were not removed, merged with the entities that have changes, in order */
+	for (;;) {
+		while (i < baseline_count) {
+			baseline_entity = MAYBE_VECTOR_ELEMENT(baseline->entities, maybe_entity_t, i);
+			while ((r < removed_count) && (removed[r] < baseline_entity)) {
+				r++;
+			}
+
+			if ((r < removed_count) && (removed[r] == baseline_entity)) {
+				i++;
+				continue;
+			}
+
+			break;
+		}
+
+		if ((i >= baseline_count) && (k >= change_count)) {
+			break;
+		}
+
+		from_baseline = (i < baseline_count) &&
+			((k >= change_count) || (MAYBE_VECTOR_ELEMENT(baseline->entities, maybe_entity_t, i) <= changes[k].entity));
+		entity = from_baseline ? MAYBE_VECTOR_ELEMENT(baseline->entities, maybe_entity_t, i) : changes[k].entity;
+
+		if (length >= entity_count) {
+			result = MAYBE_ERROR_REPLICATION_BAD_STREAM;
+			goto l_cleanup;
+		}
+
+		MAYBE_VECTOR_ELEMENT(decoded->entities, maybe_entity_t, length) = entity;
+		values = (uint8_t*)MAYBE_VECTOR_ELEMENT_VOID_PTR(decoded->values, length);
+		mask = &MAYBE_VECTOR_ELEMENT(decoded->masks, uint32_t, length);
+
+		if (from_baseline) {
+			*mask = MAYBE_VECTOR_ELEMENT(baseline->masks, uint32_t, i);
+			memcpy(values, MAYBE_VECTOR_ELEMENT_VOID_PTR(baseline->values, i), decoded->values.element_size);
+			i++;
+		} else {
+			*mask = 0;
+			memset(values, 0, decoded->values.element_size);
+		}
+
+		for (; (k < change_count) && (changes[k].entity == entity); k++) {
+			if (MAYBE_REPLICATION_REMOVED == changes[k].position) {
+				*mask &= ~(1u << changes[k].component_index);
+				memset(values + layout->component_offsets[changes[k].component_index], 0, layout->component_sizes[changes[k].component_index]);
+				continue;
+			}
+
+			/* Components the baseline did not have are XORed with zeros */
+			if (0 == (*mask & (1u << changes[k].component_index))) {
+				memset(values + layout->component_offsets[changes[k].component_index], 0, layout->component_sizes[changes[k].component_index]);
+			}
+
+			position = changes[k].position;
+			(void)read_xor(
+				data,
+				size,
+				&position,
+				values + layout->component_offsets[changes[k].component_index],
+				layout->component_sizes[changes[k].component_index]
+			);
+			*mask |= 1u << changes[k].component_index;
+		}
+
+		length++;
+	}
+
+	if (length != entity_count) {
+		result = MAYBE_ERROR_REPLICATION_BAD_STREAM;
+		goto l_cleanup;
+	}
+
+	decoded->entities.length = length;
+	decoded->masks.length = length;
+	decoded->values.length = length;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t apply_snapshot(
+	maybe_replication_client_t* client,
+	const maybe_replication_snapshot_t* previous,
+	const maybe_replication_snapshot_t* next
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t previous_count = previous ? previous->entities.length : 0;
+	uint32_t next_count = next->entities.length;
+	maybe_entity_t previous_entity, next_entity;
+	uint32_t i = 0;
+	uint32_t j = 0;
+
+	while ((i < previous_count) || (j < next_count)) {
+		previous_entity = (i < previous_count) ? MAYBE_VECTOR_ELEMENT(previous->entities, maybe_entity_t, i) : 0;
+		next_entity = (j < next_count) ? MAYBE_VECTOR_ELEMENT(next->entities, maybe_entity_t, j) : 0;
+
+		if ((i < previous_count) && ((j >= next_count) || (previous_entity < next_entity))) {
+			result = remove_entity(client, previous_entity);
+			i++;
+		} else if ((j < next_count) && ((i >= previous_count) || (next_entity < previous_entity))) {
+			result = add_entity(client, next, j);
+			j++;
+		} else {
+			result = update_entity(client, previous, i, next, j);
+			i++;
+			j++;
+		}
+
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t add_entity(
+	maybe_replication_client_t* client,
+	const maybe_replication_snapshot_t* snapshot,
+	uint32_t index
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_replication_layout_t* layout = &client->layout;
+	maybe_entity_t server_entity = MAYBE_VECTOR_ELEMENT(snapshot->entities, maybe_entity_t, index);
+	uint32_t mask = MAYBE_VECTOR_ELEMENT(snapshot->masks, uint32_t, index);
+	const uint8_t* values = (const uint8_t*)MAYBE_VECTOR_ELEMENT_VOID_PTR(snapshot->values, index);
+	uint32_t component_ids[MAYBE_REPLICATION_MAX_COMPONENTS];
+	uint32_t component_count = 0;
+	maybe_entity_t entity;
+	uint32_t c;
+
+	for (c = 0; c < layout->component_count; c++) {
+		if (mask & (1u << c)) {
+			component_ids[component_count] = layout->component_ids[c];
+			component_count++;
+		}
+	}
+
+	result = maybe_world_add_entity_array(client->world, component_count, component_ids, &entity);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	for (c = 0; c < layout->component_count; c++) {
+		if (mask & (1u << c)) {
+			result = maybe_world_set_component(client->world, entity, layout->component_ids[c], values + layout->component_offsets[c]);
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+		}
+	}
+
+	result = maybe_map_set(&client->entities, &server_entity, sizeof(server_entity), &entity);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t update_entity(
+	maybe_replication_client_t* client,
+	const maybe_replication_snapshot_t* previous,
+	uint32_t previous_index,
+	const maybe_replication_snapshot_t* next,
+	uint32_t next_index
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_replication_layout_t* layout = &client->layout;
+	maybe_entity_t server_entity = MAYBE_VECTOR_ELEMENT(next->entities, maybe_entity_t, next_index);
+	uint32_t previous_mask = MAYBE_VECTOR_ELEMENT(previous->masks, uint32_t, previous_index);
+	uint32_t next_mask = MAYBE_VECTOR_ELEMENT(next->masks, uint32_t, next_index);
+	const uint8_t* previous_values = (const uint8_t*)MAYBE_VECTOR_ELEMENT_VOID_PTR(previous->values, previous_index);
+	const uint8_t* next_values = (const uint8_t*)MAYBE_VECTOR_ELEMENT_VOID_PTR(next->values, next_index);
+	maybe_entity_t* entity;
+	uint32_t c;
+
+	/* Most entities did not change at all */
+	if ((previous_mask == next_mask) && (0 == memcmp(previous_values, next_values, next->values.element_size))) {
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	result = maybe_map_get(&client->entities, &server_entity, sizeof(server_entity), (void**)&entity);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	if (NULL == entity) {
+		result = MAYBE_ERROR_ECS_WORLD_ENTITY_NOT_FOUND;
+		goto l_cleanup;
+	}
+
+	for (c = 0; c < layout->component_count; c++) {
+		if ((previous_mask & (1u << c)) && !(next_mask & (1u << c))) {
+			result = maybe_world_remove_component(client->world, *entity, layout->component_ids[c]);
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+			continue;
+		}
+
+		if (!(next_mask & (1u << c))) {
+			continue;
+		}
+
+		if (!(previous_mask & (1u << c))) {
+			result = maybe_world_add_component(client->world, *entity, layout->component_ids[c]);
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+		} else if (0 == memcmp(previous_values + layout->component_offsets[c], next_values + layout->component_offsets[c], layout->component_sizes[c])) {
+			continue;
+		}
+
+		result = maybe_world_set_component(client->world, *entity, layout->component_ids[c], next_values + layout->component_offsets[c]);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t remove_entity(
+	maybe_replication_client_t* client,
+	maybe_entity_t server_entity
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_entity_t* entity;
+
+	result = maybe_map_get(&client->entities, &server_entity, sizeof(server_entity), (void**)&entity);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	if (NULL == entity) {
+		result = MAYBE_ERROR_ECS_WORLD_ENTITY_NOT_FOUND;
+		goto l_cleanup;
+	}
+
+	result = maybe_world_remove_entity(client->world, *entity);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_map_remove(&client->entities, &server_entity, sizeof(server_entity));
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "common/error.h"
+#include "common/vector/vector.h"
+#include "common/map/map.h"
+#include "entity.h"
+#include "ecs.h"
+
+/*
+ * Replication
+ *
+ * A replication server sends the state of a world to clients, which apply it to worlds of their own.
+ * Every tick the server captures a snapshot of the replicated components, and encodes for every peer
+ * only what changed since the last snapshot the peer acknowledged, its baseline:
+ *
+ * 		maybe_world_update(&world);
+ * 		maybe_replication_server_capture(&server, &world);
+ * 		maybe_replication_server_encode(&server, peer, &stream);	... sent to the peer ...
+ *
+ * 		maybe_replication_client_decode(&client, data, size, &tick);	... tick sent back ...
+ * 		maybe_replication_server_acknowledge(&server, peer, tick);
+ *
+ * An entity is replicated while it has at least one of the replicated components. For every column
+ * the stream holds the rows that changed, as the XOR of the new value and the baseline value, which is
+ * mostly zero bits for small changes. Entity IDs are written as the difference from the previous ID,
+ * and both are packed into varints (7 bits per byte, the high bit set when more bytes follow).
+ *
+ * Streams may be lost or arrive out of order. A lost stream is covered by the next one, since it is
+ * encoded against the same baseline until the peer acknowledges a newer tick, and streams older than
+ * the client's state are dropped. Both sides keep the last MAYBE_REPLICATION_HISTORY snapshots, and a
+ * peer whose baseline is older than that gets its next stream encoded without a baseline.
+ *
+ * The server and its clients must replicate the same component IDs in the same order, and the IDs
+ * must be registered in every world with the same sizes, see MAYBE_DECLARE_COMPONENT_MANIFEST.
+ * */
+
+/* @brief The number of components a server or client can replicate */
+#define MAYBE_REPLICATION_MAX_COMPONENTS (32)
+
+/* @brief The number of snapshots a server or client keeps, baselines older than that are dropped */
+#define MAYBE_REPLICATION_HISTORY (32)
+
+/* @brief The replicated components and how they are laid out in a snapshot row */
+typedef struct {
+	uint32_t component_count;
+	uint32_t component_ids[MAYBE_REPLICATION_MAX_COMPONENTS];
+	uint32_t component_sizes[MAYBE_REPLICATION_MAX_COMPONENTS];
+	uint32_t component_offsets[MAYBE_REPLICATION_MAX_COMPONENTS]; /* The offset of every component in a row */
+	uint32_t row_size;
+} maybe_replication_layout_t;
+
+/* @brief The replicated state of a world at one tick */
+typedef struct {
+	uint64_t tick; /* 0 if the snapshot is empty */
+	MAYBE_VECTOR(maybe_entity_t) entities; /* Sorted by ID */
+	MAYBE_VECTOR(uint32_t) masks; /* A bit for every replicated component the entity has, by its index in the layout */
+	maybe_vector_t values; /* A row of the layout's size for every entity, components the entity does not have are zeroed */
+} maybe_replication_snapshot_t;
+
+/* @brief A row of a capture, sorted by its entity */
+typedef struct {
+	maybe_entity_t entity;
+	uint32_t row; /* The row in the unsorted capture */
+} maybe_replication_sort_entry_t;
+
+/* @brief A change to a column read from a stream */
+typedef struct {
+	maybe_entity_t entity;
+	uint32_t component_index; /* The index of the component in the layout */
+	size_t position; /* The offset of the XOR of the value in the stream, MAYBE_REPLICATION_REMOVED if the component was removed */
+} maybe_replication_change_t;
+
+#define MAYBE_REPLICATION_REMOVED (SIZE_MAX)
+
+/* @brief The amount of data sent to a peer */
+typedef struct {
+	uint64_t tick; /* The tick of the last stream */
+	uint64_t baseline_tick; /* The baseline of the last stream, 0 if it had none */
+	uint32_t encoded_bytes; /* The size of the last stream */
+	uint32_t full_bytes; /* The size the last tick would have without delta compression, every entity with every replicated component */
+	uint32_t changed_count; /* The number of component values in the last stream */
+	uint32_t removed_count; /* The number of entities and components removed by the last stream */
+	uint64_t total_encoded_bytes; /* The sizes of all the streams so far */
+	uint64_t total_full_bytes;
+	uint64_t stream_count;
+} maybe_replication_stats_t;
+
+/* @brief A client a server replicates to */
+typedef struct {
+	uint64_t acknowledged_tick; /* The newest tick the peer applied, 0 before the first acknowledgement */
+	maybe_replication_stats_t stats;
+} maybe_replication_peer_t;
+
+/* @brief Captures a world's state and encodes it for every peer */
+typedef struct {
+	maybe_replication_layout_t layout;
+	uint64_t tick; /* The tick of the last capture, 0 before the first one */
+	maybe_replication_snapshot_t snapshots[MAYBE_REPLICATION_HISTORY]; /* The snapshot of every tick is at tick % MAYBE_REPLICATION_HISTORY */
+	MAYBE_VECTOR(maybe_replication_peer_t) peers;
+	maybe_replication_snapshot_t unsorted; /* A capture in archetype order, before it is sorted */
+	MAYBE_VECTOR(maybe_replication_sort_entry_t) sort_entries;
+	maybe_vector_t changes[MAYBE_REPLICATION_MAX_COMPONENTS]; /* The changed rows of every column, while encoding */
+	maybe_vector_t removals[MAYBE_REPLICATION_MAX_COMPONENTS]; /* The rows every column was removed from, while encoding */
+	maybe_vector_t removed_entities; /* The removed entities, while encoding */
+} maybe_replication_server_t;
+
+/* @brief Decodes streams from a server and applies them to a world */
+typedef struct {
+	maybe_replication_layout_t layout;
+	maybe_world_t* world;
+	uint64_t applied_tick; /* The tick of the world's current state, 0 before the first stream */
+	maybe_replication_snapshot_t snapshots[MAYBE_REPLICATION_HISTORY];
+	maybe_replication_snapshot_t decoded; /* The snapshot being decoded, swapped into the history once it is applied */
+	MAYBE_MAP(maybe_entity_t, maybe_entity_t) entities; /* The client's entity of every server entity */
+	bool is_map_initialized;
+	MAYBE_VECTOR(maybe_entity_t) removed_entities; /* Used while decoding */
+	MAYBE_VECTOR(maybe_replication_change_t) changes;
+} maybe_replication_client_t;
+
+/*
+ * @brief Initialize a replication server
+ *
+ * @param server A pointer to the new server
+ * @param world A pointer to the world the components are registered in
+ * @param component_count The number of replicated components, at most MAYBE_REPLICATION_MAX_COMPONENTS
+ * @param component_ids The IDs of the replicated components, shared components are not allowed
+ * */
+maybe_error_t maybe_replication_server_init(
+	maybe_replication_server_t* server,
+	maybe_world_t* world,
+	uint32_t component_count,
+	const uint32_t* component_ids
+);
+
+/*
+ * @brief Add a peer to a replication server, its first stream has no baseline
+ *
+ * @param server A pointer to the server
+ * @param peer_index Set to the index of the new peer
+ * */
+maybe_error_t maybe_replication_server_add_peer(
+	maybe_replication_server_t* server,
+	uint32_t* peer_index
+);
+
+/*
+ * @brief Capture the replicated state of a world as the server's next tick
+ *
+ * @param server A pointer to the server
+ * @param world A pointer to the world, usually right after maybe_world_update
+ * */
+maybe_error_t maybe_replication_server_capture(
+	maybe_replication_server_t* server,
+	maybe_world_t* world
+);
+
+/*
+ * @brief Encode the last captured tick for a peer, against the newest tick it acknowledged
+ *
+ * @param server A pointer to the server
+ * @param peer_index The index of the peer
+ * @param stream A vector of bytes, its previous content is replaced with the stream
+ * */
+maybe_error_t maybe_replication_server_encode(
+	maybe_replication_server_t* server,
+	uint32_t peer_index,
+	maybe_vector_t* stream
+);
+
+/*
+ * @brief Record that a peer applied a tick, so later streams to it are encoded against it
+ *
+ * @param server A pointer to the server
+ * @param peer_index The index of the peer
+ * @param tick The tick from maybe_replication_client_decode, older ticks than the peer's are ignored
+ * */
+maybe_error_t maybe_replication_server_acknowledge(
+	maybe_replication_server_t* server,
+	uint32_t peer_index,
+	uint64_t tick
+);
+
+/*
+ * @brief Free a replication server's resources
+ *
+ * @param server A pointer to the server
+ * */
+maybe_error_t maybe_replication_server_free(
+	maybe_replication_server_t* server
+);
+
+/*
+ * @brief Initialize a replication client
+ *
+ * @param client A pointer to the new client
+ * @param world A pointer to the world the streams are applied to, it must stay valid while the client uses it
+ * @param component_count The number of replicated components
+ * @param component_ids The IDs of the replicated components, the same as the server's
+ * */
+maybe_error_t maybe_replication_client_init(
+	maybe_replication_client_t* client,
+	maybe_world_t* world,
+	uint32_t component_count,
+	const uint32_t* component_ids
+);
+
+/*
+ * @brief Decode a stream from a server and apply it to the client's world
+ *
+ * @param client A pointer to the client
+ * @param data The stream
+ * @param size The size of the stream in bytes
+ * @param acknowledged_tick Set to the tick of the world's state, to be sent back to the server
+ *
+ * @note Streams older than the world's state are ignored
+ * @note Fails with MAYBE_ERROR_REPLICATION_MISSING_BASELINE if the client no longer has the stream's baseline
+ * */
+maybe_error_t maybe_replication_client_decode(
+	maybe_replication_client_t* client,
+	const uint8_t* data,
+	size_t size,
+	uint64_t* acknowledged_tick
+);
+
+/*
+ * @brief Free a replication client's resources
+ *
+ * @param client A pointer to the client
+ *
+ * @note The replicated entities stay in the world
+ * */
+maybe_error_t maybe_replication_client_free(
+	maybe_replication_client_t* client
+);
@@ -0,0 +1,267 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "replication.h"
+
+/* The most bytes a 64 bit varint takes */
+#define MAX_VARINT_BYTES (10)
+
+/*
+ * @brief Check the replicated components and compute the layout of their rows
+ *
+ * @param layout The layout
+ * @param world The world the components are registered in
+ * @param component_count The number of components
+ * @param component_ids The IDs of the components
+ * */
+static maybe_error_t init_layout(
+	maybe_replication_layout_t* layout,
+	maybe_world_t* world,
+	uint32_t component_count,
+	const uint32_t* component_ids
+);
+
+/*
+ * @brief Initialize an empty snapshot
+ *
+ * @param snapshot The snapshot
+ * @param layout The layout of its rows
+ * */
+static maybe_error_t init_snapshot(
+	maybe_replication_snapshot_t* snapshot,
+	const maybe_replication_layout_t* layout
+);
+
+/*
+ * @brief Make sure a snapshot has room for a number of entities, and empty it
+ *
+ * @param snapshot The snapshot
+ * @param entity_count The number of entities
+ * */
+static maybe_error_t reset_snapshot(
+	maybe_replication_snapshot_t* snapshot,
+	uint32_t entity_count
+);
+
+/*
+ * @brief Free a snapshot's resources
+ *
+ * @param snapshot The snapshot
+ * */
+static maybe_error_t free_snapshot(
+	maybe_replication_snapshot_t* snapshot
+);
+
+/*
+ * @brief Find the snapshot of a tick in a history
+ *
+ * @param snapshots The history, MAYBE_REPLICATION_HISTORY snapshots
+ * @param tick The tick
+ *
+ * @return The snapshot, or NULL if the tick is 0 or was overwritten
+ * */
+static maybe_replication_snapshot_t* find_snapshot(
+	maybe_replication_snapshot_t* snapshots,
+	uint64_t tick
+);
+
+/*
+ * @brief Compare capture rows by entity, for qsort
+ * */
+static int compare_sort_entries(
+	const void* first,
+	const void* second
+);
+
+/*
+ * @brief Compare decoded changes by entity, for qsort
+ * */
+static int compare_changes(
+	const void* first,
+	const void* second
+);
+
+/*
+ * @brief Append bytes to a stream, growing it geometrically
+ *
+ * @param stream A vector of bytes
+ * @param data The bytes
+ * @param size The number of bytes
+ * */
+static maybe_error_t write_bytes(
+	maybe_vector_t* stream,
+	const void* data,
+	size_t size
+);
+
+/*
+ * @brief Append a varint to a stream
+ *
+ * @param stream A vector of bytes
+ * @param value The value
+ * */
+static maybe_error_t write_varint(
+	maybe_vector_t* stream,
+	uint64_t value
+);
+
+/*
+ * @brief Append the XOR of two values to a stream, as a varint for every 4 bytes and the bytes that are left as they are
+ *
+ * @param stream A vector of bytes
+ * @param value The new value
+ * @param baseline The value it is compared with
+ * @param size The size of the values
+ * */
+static maybe_error_t write_xor(
+	maybe_vector_t* stream,
+	const uint8_t* value,
+	const uint8_t* baseline,
+	uint32_t size
+);
+
+/*
+ * @brief Read a varint from a stream
+ *
+ * @param data The stream
+ * @param size The size of the stream
+ * @param position The offset of the varint, moved past it
+ * @param value Set to the value
+ *
+ * @return Whether a whole varint was read
+ * */
+static bool read_varint(
+	const uint8_t* data,
+	size_t size,
+	size_t* position,
+	uint64_t* value
+);
+
+/*
+ * @brief Read the XOR of a value written by write_xor, and apply it to a value
+ *
+ * @param data The stream
+ * @param size The size of the stream
+ * @param position The offset of the XOR, moved past it
+ * @param value The value to XOR, if NULL the XOR is only skipped
+ * @param value_size The size of the value
+ *
+ * @return Whether the XOR was read whole
+ * */
+static bool read_xor(
+	const uint8_t* data,
+	size_t size,
+	size_t* position,
+	uint8_t* value,
+	uint32_t value_size
+);
+
+/*
+ * @brief Encode the differences between a snapshot and a peer's baseline into the server's scratch streams
+ *
+ * @param server The server
+ * @param current The snapshot being sent
+ * @param baseline The peer's baseline, NULL to send everything
+ * @param stats Counts of the changes are set in it
+ * @param change_counts Set to the number of changed rows of every column
+ * @param removal_counts Set to the number of rows every column was removed from
+ * @param removed_entity_count Set to the number of removed entities
+ * */
+static maybe_error_t encode_changes(
+	maybe_replication_server_t* server,
+	const maybe_replication_snapshot_t* current,
+	const maybe_replication_snapshot_t* baseline,
+	maybe_replication_stats_t* stats,
+	uint32_t* change_counts,
+	uint32_t* removal_counts,
+	uint32_t* removed_entity_count
+);
+
+/*
+ * @brief Read the removed entities and the column changes of a stream into the client's scratch vectors
+ *
+ * @param client The client
+ * @param data The stream
+ * @param size The size of the stream
+ * @param position The offset of the changes, moved past them
+ * */
+static maybe_error_t read_changes(
+	maybe_replication_client_t* client,
+	const uint8_t* data,
+	size_t size,
+	size_t* position
+);
+
+/*
+ * @brief Build the client's decoded snapshot from a baseline and the changes read by read_changes
+ *
+ * @param client The client
+ * @param baseline The baseline, NULL if the stream has none
+ * @param data The stream
+ * @param size The size of the stream
+ * @param entity_count The number of entities the stream says the snapshot has
+ * */
+static maybe_error_t build_snapshot(
+	maybe_replication_client_t* client,
+	const maybe_replication_snapshot_t* baseline,
+	const uint8_t* data,
+	size_t size,
+	uint64_t entity_count
+);
+
+/*
+ * @brief Change the client's world from the state of one snapshot to another
+ *
+ * @param client The client
+ * @param previous The snapshot the world matches, NULL if it has no replicated entities yet
+ * @param next The new snapshot
+ * */
+static maybe_error_t apply_snapshot(
+	maybe_replication_client_t* client,
+	const maybe_replication_snapshot_t* previous,
+	const maybe_replication_snapshot_t* next
+);
+
+/*
+ * @brief Add a server entity to the client's world
+ *
+ * @param client The client
+ * @param snapshot The snapshot the entity is in
+ * @param index The index of the entity in the snapshot
+ * */
+static maybe_error_t add_entity(
+	maybe_replication_client_t* client,
+	const maybe_replication_snapshot_t* snapshot,
+	uint32_t index
+);
+
+/*
+ * @brief Update the components of a server entity in the client's world
+ *
+ * @param client The client
+ * @param previous The snapshot the world matches
+ * @param previous_index The index of the entity in it
+ * @param next The new snapshot
+ * @param next_index The index of the entity in it
+ * */
+static maybe_error_t update_entity(
+	maybe_replication_client_t* client,
+	const maybe_replication_snapshot_t* previous,
+	uint32_t previous_index,
+	const maybe_replication_snapshot_t* next,
+	uint32_t next_index
+);
+
+/*
+ * @brief Remove a server entity from the client's world
+ *
+ * @param client The client
+ * @param entity The server's entity
+ * */
+static maybe_error_t remove_entity(
+	maybe_replication_client_t* client,
+	maybe_entity_t entity
+);
@@ -0,0 +1,158 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/error.h"
+#include "common/common.h"
+#include "common/map/map.h"
+#include "common/vector/vector.h"
+
+#include "shared.h"
+
+maybe_error_t maybe_shared_store_init(
+	maybe_shared_store_t* store,
+	uint32_t value_size
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if (NULL == store) {
+		result = MAYBE_ERROR_SHARED_STORE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	store->value_size = value_size;
+
+	result = maybe_map_init(&store->lookup, value_size, sizeof(void*), 0, maybe_map_default_hash_function);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&store->values, sizeof(void*), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_shared_store_intern(
+	maybe_shared_store_t* store,
+	const void* value,
+	void** stored_value
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	void** found_value = NULL;
+	void* new_value = NULL;
+
+	if ((NULL == store) || (NULL == value) || (NULL == stored_value)) {
+		result = MAYBE_ERROR_SHARED_STORE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = maybe_map_get(&store->lookup, (void*)value, store->value_size, (void**)&found_value);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	if (NULL != found_value) {
+		*stored_value = *found_value;
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	new_value = malloc(store->value_size);
+	if (NULL == new_value) {
+		result = MAYBE_ERROR_SHARED_STORE_ALLOCATION_FAILED;
+		goto l_cleanup;
+	}
+	memcpy(new_value, value, store->value_size);
+
+	result = maybe_vector_push(&store->values, &new_value);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* The store owns the value from here, even if the lookup fails */
+	*stored_value = new_value;
+	new_value = NULL;
+
+	result = maybe_map_set(&store->lookup, (void*)value, store->value_size, stored_value);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	if (new_value) {
+		free(new_value);
+	}
+
+	return result;
+}
+
+maybe_error_t maybe_shared_store_get_memory_usage(
+	maybe_shared_store_t* store,
+	uint64_t* bytes
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint64_t lookup_bytes = 0;
+
+	if ((NULL == store) || (NULL == bytes)) {
+		result = MAYBE_ERROR_SHARED_STORE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = maybe_map_get_memory_usage(&store->lookup, &lookup_bytes);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	*bytes = sizeof(*store) + lookup_bytes +
+			 ((uint64_t)store->values.capacity * sizeof(void*)) +
+			 ((uint64_t)store->values.length * store->value_size);
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_shared_store_free(
+	maybe_shared_store_t* store
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_error_t free_result;
+	uint32_t i;
+
+	if (NULL == store) {
+		result = MAYBE_ERROR_SHARED_STORE_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+
+	for (i = 0; i < store->values.length; i++) {
+		free(MAYBE_VECTOR_ELEMENT(store->values, void*, i));
+	}
+
+	free_result = maybe_vector_free(&store->values);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_map_free(&store->lookup);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	/* If any free operation failed, return an error */
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
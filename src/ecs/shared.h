@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "common/error.h"
+#include "common/map/map.h"
+#include "common/vector/vector.h"
+
+/*
+ * Shared components
+ *
+ * A shared component type stores every distinct value once. Entities do not have a row for it,
+ * instead every archetype references one value of each of its shared component types, so entities
+ * with different values of a shared component are in different archetypes. Iterating an archetype
+ * reads the shared value once for all its rows, see MAYBE_QUERY_EACH_SHARED.
+ * */
+
+/* @brief The distinct values of a shared component type */
+typedef struct {
+	uint32_t value_size;
+	MAYBE_MAP(value, void*) lookup; /* From a value's bytes to its stored copy */
+	MAYBE_VECTOR(void*) values; /* Every stored value, each allocated separately so its address never changes */
+} maybe_shared_store_t;
+
+/*
+ * @brief Initialize a shared value store
+ *
+ * @param store A pointer to the new store
+ * @param value_size The size of a value
+ * */
+maybe_error_t maybe_shared_store_init(
+	maybe_shared_store_t* store,
+	uint32_t value_size
+);
+
+/*
+ * @brief Get the stored copy of a value, storing it if no equal value was stored yet
+ *
+ * @param store A pointer to the store
+ * @param value The value, values are equal if their bytes are equal
+ * @param stored_value The address of the stored copy, valid until the store is freed
+ * */
+maybe_error_t maybe_shared_store_intern(
+	maybe_shared_store_t* store,
+	const void* value,
+	void** stored_value
+);
+
+/*
+ * @brief Get the amount of memory used by a shared value store
+ *
+ * @param store A pointer to the store
+ * @param bytes The amount of bytes allocated by the store
+ * */
+maybe_error_t maybe_shared_store_get_memory_usage(
+	maybe_shared_store_t* store,
+	uint64_t* bytes
+);
+
+/*
+ * @brief Free a shared value store and all its values
+ *
+ * @param store A pointer to the store
+ * */
+maybe_error_t maybe_shared_store_free(
+	maybe_shared_store_t* store
+);
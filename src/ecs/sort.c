@@ -0,0 +1,275 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "common/error.h"
+#include "common/common.h"
+#include "common/vector/vector.h"
+#include "time/time.h"
+
+#include "sort.h"
+#include "sort_internal.h"
+
+maybe_error_t maybe_row_sorter_init(
+	maybe_row_sorter_t* sorter,
+	uint32_t component_id,
+	maybe_row_sort_key_function_t key_function,
+	void* context
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if ((NULL == sorter) || (NULL == key_function)) {
+		result = MAYBE_ERROR_ROW_SORTER_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	sorter->component_id = component_id;
+	sorter->key_function = key_function;
+	sorter->context = context;
+	sorter->archetype_index = 0;
+	sorter->archetype = NULL;
+	sorter->layout_version = 0;
+	sorter->next_row = 0;
+
+	result = maybe_vector_init(&sorter->entries, sizeof(maybe_row_sort_entry_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&sorter->current_rows, sizeof(uint32_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&sorter->original_rows, sizeof(uint32_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_row_sorter_step(
+	maybe_row_sorter_t* sorter,
+	maybe_world_t* world,
+	uint64_t time_budget_ns,
+	bool* finished
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint64_t start = maybe_time_get_monotonic_ns();
+	maybe_archetype_t* archetype;
+	maybe_row_sort_entry_t* entries;
+	uint32_t* current_rows;
+	uint32_t* original_rows;
+	uint32_t column_index;
+	uint32_t original_row;
+	uint32_t displaced_row;
+	uint32_t row;
+	uint32_t moved_rows = 0;
+	bool is_sorted = false;
+	bool out_of_time = false;
+
+	if ((NULL == sorter) || (NULL == world)) {
+		result = MAYBE_ERROR_ROW_SORTER_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (finished) {
+		*finished = false;
+	}
+
+	while (!out_of_time && (sorter->archetype_index < world->archetypes.length)) {
+		archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, sorter->archetype_index);
+
+		if ((archetype->entities.length < 2) || !maybe_archetype_find_component(archetype, sorter->component_id, &column_index)) {
+			sorter->archetype = NULL;
+			sorter->archetype_index++;
+			continue;
+		}
+
+		/* Rows were added, removed or moved since the order was computed, so the saved rows are stale */
+		if ((sorter->archetype != archetype) || (sorter->layout_version != archetype->layout_version)) {
+			result = compute_order(sorter, archetype, column_index, &is_sorted);
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+
+			if (is_sorted) {
+				sorter->archetype = NULL;
+				sorter->archetype_index++;
+				continue;
+			}
+
+			sorter->archetype = archetype;
+			sorter->layout_version = archetype->layout_version;
+			sorter->next_row = 0;
+		}
+
+		entries = (maybe_row_sort_entry_t*)sorter->entries.elements;
+		current_rows = (uint32_t*)sorter->current_rows.elements;
+		original_rows = (uint32_t*)sorter->original_rows.elements;
+
+		while (sorter->next_row < sorter->entries.length) {
+			/* Move the row that belongs here into place, and the row that was here to where it was */
+			original_row = entries[sorter->next_row].row;
+			row = current_rows[original_row];
+			if (row != sorter->next_row) {
+				result = maybe_world_swap_rows(world, sorter->archetype_index, sorter->next_row, row);
+				if (IS_FAILURE(result)) {
+					goto l_cleanup;
+				}
+
+				displaced_row = original_rows[sorter->next_row];
+				original_rows[sorter->next_row] = original_row;
+				original_rows[row] = displaced_row;
+				current_rows[original_row] = sorter->next_row;
+				current_rows[displaced_row] = row;
+
+				sorter->layout_version = archetype->layout_version;
+			}
+
+			sorter->next_row++;
+			moved_rows++;
+
+			if ((0 != time_budget_ns) && (0 == (moved_rows % MAYBE_ROW_SORTER_ROWS_PER_TIME_CHECK)) &&
+				((maybe_time_get_monotonic_ns() - start) >= time_budget_ns)) {
+				out_of_time = true;
+				break;
+			}
+		}
+
+		/* Continue from the same archetype on the next call */
+		if (sorter->next_row < sorter->entries.length) {
+			break;
+		}
+
+		sorter->archetype = NULL;
+		sorter->archetype_index++;
+	}
+
+	if (sorter->archetype_index >= world->archetypes.length) {
+		sorter->archetype_index = 0;
+		if (finished) {
+			*finished = true;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_row_sorter_free(
+	maybe_row_sorter_t* sorter
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_error_t free_result;
+
+	if (NULL == sorter) {
+		result = MAYBE_ERROR_ROW_SORTER_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+
+	free_result = maybe_vector_free(&sorter->entries);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&sorter->current_rows);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&sorter->original_rows);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	sorter->archetype = NULL;
+
+	/* If any free operation failed, return an error */
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+int compare_entries(
+	const void* first,
+	const void* second
+) {
+	const maybe_row_sort_entry_t* first_entry = (const maybe_row_sort_entry_t*)first;
+	const maybe_row_sort_entry_t* second_entry = (const maybe_row_sort_entry_t*)second;
+
+	if (first_entry->key != second_entry->key) {
+		return (first_entry->key < second_entry->key) ? -1 : 1;
+	}
+
+	if (first_entry->row != second_entry->row) {
+		return (first_entry->row < second_entry->row) ? -1 : 1;
+	}
+
+	return 0;
+}
+
+maybe_error_t compute_order(
+	maybe_row_sorter_t* sorter,
+	maybe_archetype_t* archetype,
+	uint32_t column_index,
+	bool* is_sorted
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_vector_t* column = &MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, column_index);
+	uint32_t row_count = archetype->entities.length;
+	maybe_row_sort_entry_t* entries;
+	uint32_t row;
+
+	result = maybe_vector_reserve(&sorter->entries, row_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_reserve(&sorter->current_rows, row_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_reserve(&sorter->original_rows, row_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	sorter->entries.length = row_count;
+	sorter->current_rows.length = row_count;
+	sorter->original_rows.length = row_count;
+
+	entries = (maybe_row_sort_entry_t*)sorter->entries.elements;
+	for (row = 0; row < row_count; row++) {
+		entries[row].key = sorter->key_function(MAYBE_VECTOR_ELEMENT_VOID_PTR(*column, row), sorter->context);
+		entries[row].row = row;
+		MAYBE_VECTOR_ELEMENT(sorter->current_rows, uint32_t, row) = row;
+		MAYBE_VECTOR_ELEMENT(sorter->original_rows, uint32_t, row) = row;
+	}
+
+	qsort(entries, row_count, sizeof(*entries), compare_entries);
+
+	*is_sorted = true;
+	for (row = 0; row < row_count; row++) {
+		if (entries[row].row != row) {
+			*is_sorted = false;
+			break;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
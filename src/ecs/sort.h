@@ -0,0 +1,200 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "common/error.h"
+#include "common/vector/vector.h"
+#include "archetype.h"
+#include "ecs.h"
+
+/*
+ * Row sorting
+ *
+ * Rows are added to archetypes in spawn order, so entities that are close in the world can be far
+ * apart in memory. A row sorter reorders the rows of every archetype that has a component by a key
+ * computed from that component, such as the Morton code of a position, so that rows with close keys
+ * end up close in memory.
+ *
+ * The sort is incremental: every step does as much work as its time budget allows, and the next step
+ * continues from the same place, so it can run between maybe_world_update calls. The order of an
+ * archetype is computed at once, and its rows are then moved into place by swaps that keep the entity
+ * records up to date, so the world is consistent between steps. If rows are added to or removed from
+ * the archetype between steps, its order is computed again.
+ *
+ * 		uint64_t position_key(const void* component, void* context) {
+ * 			const position_t* position = (const position_t*)component;
+ * 			return maybe_morton_code_2d(position->x, position->y, 4.0f);
+ * 		}
+ *
+ * 		maybe_row_sorter_init(&sorter, MAYBE_COMPONENT_ID(position_t), position_key, NULL);
+ * 		...
+ * 		maybe_world_update(&world);
+ * 		maybe_row_sorter_step(&sorter, &world, 500000, NULL);
+ * */
+
+/* @brief The number of rows a step moves between checks of its time budget */
+#define MAYBE_ROW_SORTER_ROWS_PER_TIME_CHECK (64)
+
+/* @brief A function that computes the sort key of a row from one of its components */
+typedef uint64_t (*maybe_row_sort_key_function_t)(const void* component, void* context);
+
+/* @brief A row of the archetype being sorted, with its key */
+typedef struct {
+	uint64_t key;
+	uint32_t row; /* The row the entry had when the order was computed */
+} maybe_row_sort_entry_t;
+
+/* @brief The state of an incremental sort of a world's rows */
+typedef struct {
+	uint32_t component_id; /* Archetypes with this component are sorted */
+	maybe_row_sort_key_function_t key_function;
+	void* context; /* Passed to the key function */
+	uint32_t archetype_index; /* The archetype the next step continues from */
+	maybe_archetype_t* archetype; /* The archetype whose order was computed, NULL if there is none */
+	uint32_t layout_version; /* The archetype's layout version after the sorter's last swap */
+	uint32_t next_row; /* The next row to move into place */
+	MAYBE_VECTOR(maybe_row_sort_entry_t) entries; /* The archetype's rows ordered by key */
+	MAYBE_VECTOR(uint32_t) current_rows; /* The current row of every row the entries refer to */
+	MAYBE_VECTOR(uint32_t) original_rows; /* The row the entries refer to of every current row */
+} maybe_row_sorter_t;
+
+/*
+ * @brief Initialize a row sorter
+ *
+ * @param sorter A pointer to the new sorter
+ * @param component_id The component the keys are computed from
+ * @param key_function The function that computes the key of a row
+ * @param context Passed to the key function
+ * */
+maybe_error_t maybe_row_sorter_init(
+	maybe_row_sorter_t* sorter,
+	uint32_t component_id,
+	maybe_row_sort_key_function_t key_function,
+	void* context
+);
+
+/*
+ * @brief Continue sorting the rows of a world
+ *
+ * @param sorter A pointer to the sorter
+ * @param world A pointer to the world, the same world on every step
+ * @param time_budget_ns The time after which the step stops, and continues on the next call. 0 for no limit
+ * @param finished Set to whether all the archetypes were sorted since the pass started, can be NULL
+ *
+ * @note Must not be called while a system runs, or while the world has forks
+ * */
+maybe_error_t maybe_row_sorter_step(
+	maybe_row_sorter_t* sorter,
+	maybe_world_t* world,
+	uint64_t time_budget_ns,
+	bool* finished
+);
+
+/*
+ * @brief Free a row sorter's resources
+ *
+ * @param sorter A pointer to the sorter
+ * */
+maybe_error_t maybe_row_sorter_free(
+	maybe_row_sorter_t* sorter
+);
+
+/* @brief The largest cell coordinate of a Morton code, in every dimension */
+#define MAYBE_MORTON_MAX_CELL_2D (INT32_MAX)
+#define MAYBE_MORTON_MAX_CELL_3D ((1 << 20) - 1)
+
+/*
+ * @brief Get the cell of a coordinate, as an unsigned value where the cell around 0 is in the middle of the range
+ *
+ * @param coordinate The coordinate
+ * @param cell_size The length of a cell's side
+ * @param max_cell The largest cell, cells are clamped to [-max_cell - 1, max_cell]
+ * */
+static inline uint32_t maybe_morton_get_cell(
+	float coordinate,
+	float cell_size,
+	int32_t max_cell
+) {
+	float scaled = coordinate / cell_size;
+	int32_t cell;
+
+	/* This also catches NaN, which fails every comparison */
+	if (!(scaled > (float)-max_cell)) {
+		cell = -max_cell - 1;
+	} else if (scaled >= (float)max_cell) {
+		cell = max_cell;
+	} else {
+		cell = (int32_t)scaled;
+		if ((float)cell > scaled) {
+			cell--;
+		}
+	}
+
+	return (uint32_t)cell + (uint32_t)max_cell + 1u;
+}
+
+/* @brief Spread the bits of a value so there is 1 zero bit between every 2 bits */
+static inline uint64_t maybe_morton_spread_2d(
+	uint32_t value
+) {
+	uint64_t bits = value;
+
+	bits = (bits | (bits << 16)) & 0x0000FFFF0000FFFFull;
+	bits = (bits | (bits << 8)) & 0x00FF00FF00FF00FFull;
+	bits = (bits | (bits << 4)) & 0x0F0F0F0F0F0F0F0Full;
+	bits = (bits | (bits << 2)) & 0x3333333333333333ull;
+	bits = (bits | (bits << 1)) & 0x5555555555555555ull;
+
+	return bits;
+}
+
+/* @brief Spread the lower 21 bits of a value so there are 2 zero bits between every 2 bits */
+static inline uint64_t maybe_morton_spread_3d(
+	uint32_t value
+) {
+	uint64_t bits = value & 0x1FFFFFu;
+
+	bits = (bits | (bits << 32)) & 0x001F00000000FFFFull;
+	bits = (bits | (bits << 16)) & 0x001F0000FF0000FFull;
+	bits = (bits | (bits << 8)) & 0x100F00F00F00F00Full;
+	bits = (bits | (bits << 4)) & 0x10C30C30C30C30C3ull;
+	bits = (bits | (bits << 2)) & 0x1249249249249249ull;
+
+	return bits;
+}
+
+/*
+ * @brief Get the Morton code of a 2D position, which orders positions along a Z-order curve
+ *
+ * @param x The first coordinate
+ * @param y The second coordinate
+ * @param cell_size Positions in the same cell get the same code
+ * */
+static inline uint64_t maybe_morton_code_2d(
+	float x,
+	float y,
+	float cell_size
+) {
+	return maybe_morton_spread_2d(maybe_morton_get_cell(x, cell_size, MAYBE_MORTON_MAX_CELL_2D)) |
+		   (maybe_morton_spread_2d(maybe_morton_get_cell(y, cell_size, MAYBE_MORTON_MAX_CELL_2D)) << 1);
+}
+
+/*
+ * @brief Get the Morton code of a 3D position, which orders positions along a Z-order curve
+ *
+ * @param x The first coordinate
+ * @param y The second coordinate
+ * @param z The third coordinate
+ * @param cell_size Positions in the same cell get the same code
+ * */
+static inline uint64_t maybe_morton_code_3d(
+	float x,
+	float y,
+	float z,
+	float cell_size
+) {
+	return maybe_morton_spread_3d(maybe_morton_get_cell(x, cell_size, MAYBE_MORTON_MAX_CELL_3D)) |
+		   (maybe_morton_spread_3d(maybe_morton_get_cell(y, cell_size, MAYBE_MORTON_MAX_CELL_3D)) << 1) |
+		   (maybe_morton_spread_3d(maybe_morton_get_cell(z, cell_size, MAYBE_MORTON_MAX_CELL_3D)) << 2);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sort.h"
+
+/*
+ * @brief Compare two sort entries by key, and by row for equal keys so the order is deterministic
+ *
+ * @param first The first entry
+ * @param second The second entry
+ * */
+static int compare_entries(
+	const void* first,
+	const void* second
+);
+
+/*
+ * @brief Compute the order of an archetype's rows, and reset the maps between current and original rows
+ *
+ * @param sorter The sorter
+ * @param archetype The archetype
+ * @param column_index The index of the sorter's component in the archetype
+ * @param is_sorted Set to whether the rows are already in order
+ * */
+static maybe_error_t compute_order(
+	maybe_row_sorter_t* sorter,
+	maybe_archetype_t* archetype,
+	uint32_t column_index,
+	bool* is_sorted
+);
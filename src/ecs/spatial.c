@@ -0,0 +1,614 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/error.h"
+#include "common/common.h"
+#include "common/vector/vector.h"
+
+#include "spatial.h"
+#include "spatial_internal.h"
+
+maybe_error_t maybe_spatial_index_init(
+	maybe_spatial_index_t* index,
+	maybe_spatial_index_config_t config
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if (NULL == index) {
+		result = MAYBE_ERROR_SPATIAL_INDEX_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if ((config.dimensions < 2) || (config.dimensions > MAYBE_SPATIAL_INDEX_MAX_DIMENSIONS) || !(config.cell_size > 0.0f)) {
+		result = MAYBE_ERROR_SPATIAL_INDEX_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	index->config = config;
+	index->inverse_cell_size = 1.0f / config.cell_size;
+	index->world = NULL;
+	index->bucket_count = 0;
+	index->bucket_starts = NULL;
+	index->bucket_cursors = NULL;
+
+	result = maybe_vector_init(&index->entries, sizeof(maybe_spatial_entry_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&index->unsorted_entries, sizeof(maybe_spatial_entry_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&index->chunks, sizeof(maybe_spatial_chunk_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* An empty index still has a bucket, so queries never need to check for one */
+	result = prepare_buckets(index, 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+	index->bucket_starts[0] = 0;
+	index->bucket_starts[1] = 0;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_spatial_index_rebuild(
+	maybe_spatial_index_t* index,
+	maybe_world_t* world,
+	maybe_thread_pool_t* pool
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t entry_count = 0;
+	uint32_t i, start;
+
+	if ((NULL == index) || (NULL == world)) {
+		result = MAYBE_ERROR_SPATIAL_INDEX_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	index->world = world;
+
+	result = collect_chunks(index, world, &entry_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = prepare_buckets(index, entry_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_reserve(&index->unsorted_entries, entry_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_reserve(&index->entries, entry_count);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	index->unsorted_entries.length = entry_count;
+	index->entries.length = entry_count;
+
+	/* Read the positions and count the entries of every bucket */
+	result = maybe_thread_pool_run(pool, gather_chunk, index, index->chunks.length);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* Turn the counts into the buckets' first entries */
+	start = 0;
+	for (i = 0; i < index->bucket_count; i++) {
+		index->bucket_starts[i] = start;
+		start += atomic_load_explicit(&index->bucket_cursors[i], memory_order_relaxed);
+		atomic_store_explicit(&index->bucket_cursors[i], index->bucket_starts[i], memory_order_relaxed);
+	}
+	index->bucket_starts[index->bucket_count] = start;
+
+	result = maybe_thread_pool_run(pool, scatter_chunk, index, index->chunks.length);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	/* The scatter order depends on the threads, sorting makes it deterministic */
+	result = maybe_thread_pool_run(
+		pool,
+		sort_buckets,
+		index,
+		(index->bucket_count + BUCKETS_PER_SORT_JOB - 1) / BUCKETS_PER_SORT_JOB
+	);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_spatial_index_query_radius(
+	maybe_spatial_index_t* index,
+	const float* center,
+	float radius,
+	maybe_vector_t* results
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	query_shape_t shape = { 0 };
+	uint32_t i;
+
+	if ((NULL == index) || (NULL == center) || (NULL == results)) {
+		result = MAYBE_ERROR_SPATIAL_INDEX_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	if (radius < 0.0f) {
+		result = MAYBE_ERROR_SPATIAL_INDEX_INVALID_PARAM;
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < index->config.dimensions; i++) {
+		shape.center[i] = center[i];
+		shape.min[i] = center[i] - radius;
+		shape.max[i] = center[i] + radius;
+	}
+	shape.radius_squared = radius * radius;
+
+	result = run_query(index, &shape, results);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_spatial_index_query_aabb(
+	maybe_spatial_index_t* index,
+	const float* min,
+	const float* max,
+	maybe_vector_t* results
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	query_shape_t shape = { 0 };
+	uint32_t i;
+
+	if ((NULL == index) || (NULL == min) || (NULL == max) || (NULL == results)) {
+		result = MAYBE_ERROR_SPATIAL_INDEX_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < index->config.dimensions; i++) {
+		if (min[i] > max[i]) {
+			result = MAYBE_ERROR_SPATIAL_INDEX_INVALID_PARAM;
+			goto l_cleanup;
+		}
+
+		shape.min[i] = min[i];
+		shape.max[i] = max[i];
+	}
+	shape.radius_squared = -1.0f;
+
+	result = run_query(index, &shape, results);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_spatial_index_free(
+	maybe_spatial_index_t* index
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_error_t free_result;
+
+	if (NULL == index) {
+		result = MAYBE_ERROR_SPATIAL_INDEX_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+
+	free_result = maybe_vector_free(&index->entries);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&index->unsorted_entries);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&index->chunks);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free(index->bucket_starts);
+	free(index->bucket_cursors);
+	index->bucket_starts = NULL;
+	index->bucket_cursors = NULL;
+	index->bucket_count = 0;
+
+	/* If any free operation failed, return an error */
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_add_spatial_index(
+	maybe_world_t* world,
+	maybe_spatial_index_t* index
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if ((NULL == world) || (NULL == index)) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_push(&world->spatial_indexes, &index);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_remove_spatial_index(
+	maybe_world_t* world,
+	maybe_spatial_index_t* index
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t i;
+
+	if ((NULL == world) || (NULL == index)) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < world->spatial_indexes.length; i++) {
+		if (MAYBE_VECTOR_ELEMENT(world->spatial_indexes, maybe_spatial_index_t*, i) == index) {
+			result = maybe_vector_remove(&world->spatial_indexes, i);
+			goto l_cleanup;
+		}
+	}
+
+	result = MAYBE_ERROR_ECS_WORLD_INVALID_PARAM;
+l_cleanup:
+	return result;
+}
+
+int32_t get_cell(
+	maybe_spatial_index_t* index,
+	float coordinate
+) {
+	float scaled = coordinate * index->inverse_cell_size;
+	int32_t cell;
+
+	/* This also catches NaN, which fails every comparison */
+	if (!(scaled > -MAX_CELL_COORDINATE)) {
+		return -MAX_CELL_COORDINATE;
+	}
+
+	if (scaled > MAX_CELL_COORDINATE) {
+		return MAX_CELL_COORDINATE;
+	}
+
+	/* Round towards negative infinity, so the cell around 0 is not twice as large */
+	cell = (int32_t)scaled;
+	if ((float)cell > scaled) {
+		cell--;
+	}
+
+	return cell;
+}
+
+uint32_t get_bucket(
+	maybe_spatial_index_t* index,
+	const int32_t* cell
+) {
+	uint32_t hash;
+
+	hash = ((uint32_t)cell[0] * 73856093u) ^ ((uint32_t)cell[1] * 19349663u) ^ ((uint32_t)cell[2] * 83492791u);
+
+	/* Mix the high bits into the low bits the mask keeps */
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+
+	return hash & (index->bucket_count - 1);
+}
+
+maybe_error_t collect_chunks(
+	maybe_spatial_index_t* index,
+	maybe_world_t* world,
+	uint32_t* entry_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_archetype_t* archetype;
+	maybe_spatial_chunk_t chunk;
+	uint32_t component_index;
+	uint32_t i, row, first_row, end_row;
+
+	index->chunks.length = 0;
+	*entry_count = 0;
+
+	for (i = 0; i < world->archetypes.length; i++) {
+		archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i);
+		if (!maybe_archetype_find_component(archetype, index->config.component_id, &component_index)) {
+			continue;
+		}
+
+		/* Chunks only cover enabled rows, so disabled entities are skipped like in queries */
+		end_row = 0;
+		while (maybe_archetype_find_enabled_rows(archetype, end_row, &first_row, &end_row)) {
+			for (row = first_row; row < end_row; row += MAYBE_SPATIAL_INDEX_CHUNK_ROWS) {
+				chunk.archetype_index = i;
+				chunk.component_index = component_index;
+				chunk.first_row = row;
+				chunk.row_count = end_row - row;
+				if (chunk.row_count > MAYBE_SPATIAL_INDEX_CHUNK_ROWS) {
+					chunk.row_count = MAYBE_SPATIAL_INDEX_CHUNK_ROWS;
+				}
+				chunk.first_entry = *entry_count;
+
+				result = maybe_vector_push(&index->chunks, &chunk);
+				if (IS_FAILURE(result)) {
+					goto l_cleanup;
+				}
+
+				*entry_count += chunk.row_count;
+			}
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t prepare_buckets(
+	maybe_spatial_index_t* index,
+	uint32_t entry_count
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	uint32_t bucket_count = 1;
+	uint32_t* bucket_starts;
+	atomic_uint* bucket_cursors;
+	uint32_t i;
+
+	/* About one entry per bucket keeps the buckets short without wasting much memory */
+	while ((bucket_count < entry_count) && (bucket_count < (1u << 31))) {
+		bucket_count <<= 1;
+	}
+
+	if (bucket_count > index->bucket_count) {
+		bucket_starts = MALLOC_T(uint32_t, (bucket_count + 1));
+		bucket_cursors = MALLOC_T(atomic_uint, bucket_count);
+		if ((NULL == bucket_starts) || (NULL == bucket_cursors)) {
+			free(bucket_starts);
+			free(bucket_cursors);
+			result = MAYBE_ERROR_SPATIAL_INDEX_ALLOCATION_FAILED;
+			goto l_cleanup;
+		}
+
+		free(index->bucket_starts);
+		free(index->bucket_cursors);
+		index->bucket_starts = bucket_starts;
+		index->bucket_cursors = bucket_cursors;
+	}
+
+	/* The bucket count only follows the entries, the allocation is kept for when they grow again */
+	index->bucket_count = bucket_count;
+
+	for (i = 0; i < bucket_count; i++) {
+		atomic_init(&index->bucket_cursors[i], 0);
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+void gather_chunk(
+	void* context,
+	uint32_t job_index
+) {
+	maybe_spatial_index_t* index = (maybe_spatial_index_t*)context;
+	maybe_spatial_chunk_t* chunk = &MAYBE_VECTOR_ELEMENT(index->chunks, maybe_spatial_chunk_t, job_index);
+	maybe_archetype_t* archetype = MAYBE_VECTOR_ELEMENT(index->world->archetypes, maybe_archetype_t*, chunk->archetype_index);
+	maybe_vector_t* column = &MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, chunk->component_index);
+	maybe_spatial_entry_t* entry = &MAYBE_VECTOR_ELEMENT(index->unsorted_entries, maybe_spatial_entry_t, chunk->first_entry);
+	const uint8_t* position;
+	uint32_t i, j, row;
+
+	for (i = 0; i < chunk->row_count; i++, entry++) {
+		row = chunk->first_row + i;
+		position = (const uint8_t*)column->elements + ((size_t)row * column->element_size) + index->config.offset;
+
+		for (j = 0; j < MAYBE_SPATIAL_INDEX_MAX_DIMENSIONS; j++) {
+			if (j < index->config.dimensions) {
+				memcpy(&entry->position[j], position + (j * sizeof(float)), sizeof(float));
+				entry->cell[j] = get_cell(index, entry->position[j]);
+			} else {
+				entry->position[j] = 0.0f;
+				entry->cell[j] = 0;
+			}
+		}
+
+		entry->bucket = get_bucket(index, entry->cell);
+		entry->reference.entity = MAYBE_VECTOR_ELEMENT(archetype->entities, maybe_entity_t, row);
+		entry->reference.archetype_index = chunk->archetype_index;
+		entry->reference.row = row;
+
+		atomic_fetch_add_explicit(&index->bucket_cursors[entry->bucket], 1, memory_order_relaxed);
+	}
+}
+
+void scatter_chunk(
+	void* context,
+	uint32_t job_index
+) {
+	maybe_spatial_index_t* index = (maybe_spatial_index_t*)context;
+	maybe_spatial_chunk_t* chunk = &MAYBE_VECTOR_ELEMENT(index->chunks, maybe_spatial_chunk_t, job_index);
+	maybe_spatial_entry_t* entry = &MAYBE_VECTOR_ELEMENT(index->unsorted_entries, maybe_spatial_entry_t, chunk->first_entry);
+	uint32_t i, position;
+
+	for (i = 0; i < chunk->row_count; i++, entry++) {
+		position = atomic_fetch_add_explicit(&index->bucket_cursors[entry->bucket], 1, memory_order_relaxed);
+		MAYBE_VECTOR_ELEMENT(index->entries, maybe_spatial_entry_t, position) = *entry;
+	}
+}
+
+void sort_buckets(
+	void* context,
+	uint32_t job_index
+) {
+	maybe_spatial_index_t* index = (maybe_spatial_index_t*)context;
+	maybe_spatial_entry_t* entries = (maybe_spatial_entry_t*)index->entries.elements;
+	maybe_spatial_entry_t entry;
+	uint32_t first_bucket = job_index * BUCKETS_PER_SORT_JOB;
+	uint32_t last_bucket = first_bucket + BUCKETS_PER_SORT_JOB;
+	uint32_t bucket, i, j;
+
+	if (last_bucket > index->bucket_count) {
+		last_bucket = index->bucket_count;
+	}
+
+	/* Buckets hold about one entry on average, so insertion sort is the fastest choice */
+	for (bucket = first_bucket; bucket < last_bucket; bucket++) {
+		for (i = index->bucket_starts[bucket] + 1; i < index->bucket_starts[bucket + 1]; i++) {
+			entry = entries[i];
+
+			for (j = i; (j > index->bucket_starts[bucket]) && (entries[j - 1].reference.entity > entry.reference.entity); j--) {
+				entries[j] = entries[j - 1];
+			}
+
+			entries[j] = entry;
+		}
+	}
+}
+
+bool is_entry_in_shape(
+	maybe_spatial_index_t* index,
+	maybe_spatial_entry_t* entry,
+	query_shape_t* shape
+) {
+	float distance_squared = 0.0f;
+	float difference;
+	uint32_t i;
+
+	if (shape->radius_squared < 0.0f) {
+		for (i = 0; i < index->config.dimensions; i++) {
+			if ((entry->position[i] < shape->min[i]) || (entry->position[i] > shape->max[i])) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	for (i = 0; i < index->config.dimensions; i++) {
+		difference = entry->position[i] - shape->center[i];
+		distance_squared += difference * difference;
+	}
+
+	return distance_squared <= shape->radius_squared;
+}
+
+maybe_error_t run_query(
+	maybe_spatial_index_t* index,
+	query_shape_t* shape,
+	maybe_vector_t* results
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_spatial_entry_t* entry;
+	int32_t min_cell[MAYBE_SPATIAL_INDEX_MAX_DIMENSIONS] = { 0 };
+	int32_t max_cell[MAYBE_SPATIAL_INDEX_MAX_DIMENSIONS] = { 0 };
+	int32_t cell[MAYBE_SPATIAL_INDEX_MAX_DIMENSIONS];
+	uint64_t cell_count = 1;
+	uint32_t bucket, i, j;
+
+	results->length = 0;
+
+	for (i = 0; i < index->config.dimensions; i++) {
+		min_cell[i] = get_cell(index, shape->min[i]);
+		max_cell[i] = get_cell(index, shape->max[i]);
+		cell_count *= (uint64_t)((int64_t)max_cell[i] - min_cell[i] + 1);
+	}
+
+	/* When the shape covers more cells than there are buckets, going over all the entries is faster */
+	if (cell_count > index->bucket_count) {
+		for (i = 0; i < index->entries.length; i++) {
+			entry = &MAYBE_VECTOR_ELEMENT(index->entries, maybe_spatial_entry_t, i);
+			if (is_entry_in_shape(index, entry, shape)) {
+				result = maybe_vector_push(results, &entry->reference);
+				if (IS_FAILURE(result)) {
+					goto l_cleanup;
+				}
+			}
+		}
+
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	memcpy(cell, min_cell, sizeof(cell));
+	for (;;) {
+		bucket = get_bucket(index, cell);
+
+		/* Different cells can share a bucket, only the entries of the visited cell are checked so none is found twice */
+		for (i = index->bucket_starts[bucket]; i < index->bucket_starts[bucket + 1]; i++) {
+			entry = &MAYBE_VECTOR_ELEMENT(index->entries, maybe_spatial_entry_t, i);
+			if ((entry->cell[0] != cell[0]) || (entry->cell[1] != cell[1]) || (entry->cell[2] != cell[2])) {
+				continue;
+			}
+
+			if (is_entry_in_shape(index, entry, shape)) {
+				result = maybe_vector_push(results, &entry->reference);
+				if (IS_FAILURE(result)) {
+					goto l_cleanup;
+				}
+			}
+		}
+
+		/* Move to the next cell, like an odometer */
+		for (j = 0; j < index->config.dimensions; j++) {
+			if (cell[j] < max_cell[j]) {
+				cell[j]++;
+				break;
+			}
+
+			cell[j] = min_cell[j];
+		}
+
+		if (j == index->config.dimensions) {
+			break;
+		}
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include "common/error.h"
+#include "common/vector/vector.h"
+#include "common/thread/thread_pool.h"
+#include "entity.h"
+#include "system.h"
+#include "ecs.h"
+
+/*
+ * Spatial index
+ *
+ * A spatial hash over the enabled entities that have a position component. Space is split into cubic
+ * cells of a fixed size, and every cell is hashed into a bucket, so the index only needs memory
+ * for the entities and not for the space they span. A radius or box query only visits the
+ * buckets of the cells it overlaps.
+ *
+ * The index is rebuilt from scratch, in parallel on the world's thread pool, by counting the
+ * entities of every bucket and then scattering them into one contiguous array ordered by bucket.
+ * A rebuild costs about as much as one pass over the positions, which is cheaper than tracking
+ * every moved entity when most entities move every tick.
+ * */
+
+#define MAYBE_SPATIAL_INDEX_MAX_DIMENSIONS (3)
+
+/* @brief The number of rows a single rebuild job handles */
+#define MAYBE_SPATIAL_INDEX_CHUNK_ROWS (4096)
+
+/* @brief Which component holds the positions, and how the space is split */
+typedef struct {
+	uint32_t component_id; /* The position component */
+	uint32_t offset; /* The byte offset of the first coordinate in the component, the coordinates are consecutive floats */
+	uint32_t dimensions; /* The number of coordinates, 2 or 3 */
+	float cell_size; /* The length of a cell's side, ideally close to the common query radius */
+	maybe_system_rate_t rate; /* The ticks before which the world rebuilds the index, see maybe_world_advance */
+} maybe_spatial_index_config_t;
+
+/* @brief An entity found by a query */
+typedef struct {
+	maybe_entity_t entity;
+	uint32_t archetype_index;
+	uint32_t row; /* The entity's row in its archetype, valid until the next structural change in the world */
+} maybe_spatial_result_t;
+
+/* @brief An entity in the index, with its position as of the last rebuild */
+typedef struct {
+	float position[MAYBE_SPATIAL_INDEX_MAX_DIMENSIONS];
+	int32_t cell[MAYBE_SPATIAL_INDEX_MAX_DIMENSIONS];
+	uint32_t bucket;
+	maybe_spatial_result_t reference;
+} maybe_spatial_entry_t;
+
+/* @brief A range of enabled rows of one archetype, handled by a single rebuild job */
+typedef struct {
+	uint32_t archetype_index;
+	uint32_t component_index;
+	uint32_t first_row;
+	uint32_t row_count;
+	uint32_t first_entry; /* The index of the chunk's first entry in the unsorted entries */
+} maybe_spatial_chunk_t;
+
+/* @brief A spatial hash index over a world's positions */
+typedef struct {
+	maybe_spatial_index_config_t config;
+	float inverse_cell_size;
+	maybe_world_t* world; /* The world of the last rebuild */
+	MAYBE_VECTOR(maybe_spatial_entry_t) entries; /* Ordered by bucket */
+	MAYBE_VECTOR(maybe_spatial_entry_t) unsorted_entries; /* Ordered by archetype and row, used while rebuilding */
+	MAYBE_VECTOR(maybe_spatial_chunk_t) chunks;
+	uint32_t bucket_count; /* A power of two */
+	uint32_t* bucket_starts; /* The first entry of every bucket, with an extra element for the end of the last one */
+	atomic_uint* bucket_cursors; /* Used while rebuilding, to count and then place the entries of every bucket */
+} maybe_spatial_index_t;
+
+/*
+ * @brief Initialize a spatial index
+ *
+ * @param index A pointer to the new spatial index
+ * @param config The position component and cell size
+ * */
+maybe_error_t maybe_spatial_index_init(
+	maybe_spatial_index_t* index,
+	maybe_spatial_index_config_t config
+);
+
+/*
+ * @brief Rebuild a spatial index from a world's current positions
+ *
+ * @param index A pointer to the spatial index
+ * @param world A pointer to the world
+ * @param pool The thread pool the rebuild runs on, if NULL it runs on the calling thread
+ *
+ * @note Entities in the same bucket are ordered by ID, so query results do not depend on the number of threads
+ * @note Disabled entities are left out, an entity enabled or disabled after a rebuild is only found or
+ * 		 dropped by the next one
+ * */
+maybe_error_t maybe_spatial_index_rebuild(
+	maybe_spatial_index_t* index,
+	maybe_world_t* world,
+	maybe_thread_pool_t* pool
+);
+
+/*
+ * @brief Find the entities within a distance from a point
+ *
+ * @param index A pointer to the spatial index
+ * @param center The point, with as many coordinates as the index's dimensions
+ * @param radius The distance, entities exactly at the distance are included
+ * @param results A vector of maybe_spatial_result_t, its previous content is replaced
+ *
+ * @note Queries use the positions as of the last rebuild
+ * */
+maybe_error_t maybe_spatial_index_query_radius(
+	maybe_spatial_index_t* index,
+	const float* center,
+	float radius,
+	maybe_vector_t* results
+);
+
+/*
+ * @brief Find the entities inside an axis aligned box
+ *
+ * @param index A pointer to the spatial index
+ * @param min The box's minimal corner, with as many coordinates as the index's dimensions
+ * @param max The box's maximal corner, with as many coordinates as the index's dimensions
+ * @param results A vector of maybe_spatial_result_t, its previous content is replaced
+ *
+ * @note Queries use the positions as of the last rebuild
+ * */
+maybe_error_t maybe_spatial_index_query_aabb(
+	maybe_spatial_index_t* index,
+	const float* min,
+	const float* max,
+	maybe_vector_t* results
+);
+
+/*
+ * @brief Free a spatial index's resources
+ *
+ * @param index A pointer to the spatial index
+ * */
+maybe_error_t maybe_spatial_index_free(
+	maybe_spatial_index_t* index
+);
+
+/*
+ * @brief Let a world rebuild a spatial index before every tick of the index's rate
+ *
+ * @param world A pointer to the world
+ * @param index A pointer to the spatial index, it must stay valid until it is removed or the world is freed
+ * */
+maybe_error_t maybe_world_add_spatial_index(
+	maybe_world_t* world,
+	maybe_spatial_index_t* index
+);
+
+/*
+ * @brief Stop a world from rebuilding a spatial index
+ *
+ * @param world A pointer to the world
+ * @param index A pointer to the spatial index
+ * */
+maybe_error_t maybe_world_remove_spatial_index(
+	maybe_world_t* world,
+	maybe_spatial_index_t* index
+);
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "spatial.h"
+
+/* The number of buckets a single sorting job orders */
+#define BUCKETS_PER_SORT_JOB (1024)
+
+/* Cells are clamped to this range, so coordinates far away from the origin do not overflow */
+#define MAX_CELL_COORDINATE (1 << 30)
+
+/* @brief The arguments of a query, shared by the radius and box queries */
+typedef struct {
+	float min[MAYBE_SPATIAL_INDEX_MAX_DIMENSIONS];
+	float max[MAYBE_SPATIAL_INDEX_MAX_DIMENSIONS];
+	float center[MAYBE_SPATIAL_INDEX_MAX_DIMENSIONS];
+	float radius_squared; /* Negative for box queries */
+} query_shape_t;
+
+/*
+ * @brief Get the cell a coordinate falls in
+ *
+ * @param index The spatial index
+ * @param coordinate The coordinate
+ * */
+static int32_t get_cell(
+	maybe_spatial_index_t* index,
+	float coordinate
+);
+
+/*
+ * @brief Get the bucket a cell is hashed to
+ *
+ * @param index The spatial index
+ * @param cell The cell's coordinates
+ * */
+static uint32_t get_bucket(
+	maybe_spatial_index_t* index,
+	const int32_t* cell
+);
+
+/*
+ * @brief Split the archetypes that have the position component into chunks of rows
+ *
+ * @param index The spatial index
+ * @param world The world
+ * @param entry_count The total number of rows in the chunks
+ * */
+static maybe_error_t collect_chunks(
+	maybe_spatial_index_t* index,
+	maybe_world_t* world,
+	uint32_t* entry_count
+);
+
+/*
+ * @brief Make sure the index has enough buckets for a number of entries, and clear their counts
+ *
+ * @param index The spatial index
+ * @param entry_count The number of entries
+ * */
+static maybe_error_t prepare_buckets(
+	maybe_spatial_index_t* index,
+	uint32_t entry_count
+);
+
+/*
+ * @brief A rebuild job that reads the positions of a chunk and counts the entries of every bucket
+ *
+ * @param context The spatial index
+ * @param job_index The chunk's index
+ * */
+static void gather_chunk(
+	void* context,
+	uint32_t job_index
+);
+
+/*
+ * @brief A rebuild job that places the entries of a chunk in their buckets
+ *
+ * @param context The spatial index
+ * @param job_index The chunk's index
+ * */
+static void scatter_chunk(
+	void* context,
+	uint32_t job_index
+);
+
+/*
+ * @brief A rebuild job that orders the entries of a range of buckets by entity ID
+ *
+ * @param context The spatial index
+ * @param job_index The index of the range of buckets
+ * */
+static void sort_buckets(
+	void* context,
+	uint32_t job_index
+);
+
+/*
+ * @brief Whether an entry is inside a query's shape
+ *
+ * @param index The spatial index
+ * @param entry The entry
+ * @param shape The query's shape
+ * */
+static bool is_entry_in_shape(
+	maybe_spatial_index_t* index,
+	maybe_spatial_entry_t* entry,
+	query_shape_t* shape
+);
+
+/*
+ * @brief Find the entries inside a query's shape, visiting only the buckets of the cells it overlaps
+ *
+ * @param index The spatial index
+ * @param shape The query's shape
+ * @param results A vector of maybe_spatial_result_t, its previous content is replaced
+ * */
+static maybe_error_t run_query(
+	maybe_spatial_index_t* index,
+	query_shape_t* shape,
+	maybe_vector_t* results
+);
@@ -0,0 +1,202 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "common/error.h"
+#include "common/common.h"
+#include "common/map/map.h"
+#include "common/vector/vector.h"
+
+#include "stats.h"
+
+maybe_error_t maybe_world_stats_init(
+	maybe_world_stats_t* stats
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+
+	if (NULL == stats) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&stats->archetypes, sizeof(maybe_world_archetype_stats_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = maybe_vector_init(&stats->components, sizeof(maybe_world_component_stats_t), 0);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_get_stats(
+	maybe_world_t* world,
+	maybe_world_stats_t* stats
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_world_archetype_stats_t* archetype_stats;
+	maybe_world_component_stats_t* component_stats;
+	maybe_component_type_t* component_type;
+	maybe_archetype_t* archetype;
+	maybe_vector_t* column;
+	maybe_system_t* system;
+	uint64_t column_used, column_wasted, shared_store_bytes;
+	uint32_t i, j;
+
+	if ((NULL == world) || (NULL == stats)) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	/* Reuse the vectors of the previous poll */
+	stats->archetypes.length = 0;
+	stats->components.length = 0;
+	stats->archetype_count = world->archetypes.length;
+	stats->empty_archetype_count = 0;
+	stats->entity_count = 0;
+	stats->bytes_used = 0;
+	stats->bytes_wasted = 0;
+	stats->paged_bytes = 0;
+	stats->paged_out_archetype_count = 0;
+	stats->archetype_overhead_bytes = (uint64_t)world->archetypes.capacity * sizeof(maybe_archetype_t*);
+	stats->system_bytes = (uint64_t)world->systems.capacity * sizeof(maybe_system_t);
+	stats->shared_value_bytes = 0;
+
+	for (i = 0; i < world->component_types.length; i++) {
+		component_type = &MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, i);
+		if (component_type->shared_store) {
+			result = maybe_shared_store_get_memory_usage(component_type->shared_store, &shared_store_bytes);
+			if (IS_FAILURE(result)) {
+				goto l_cleanup;
+			}
+
+			stats->shared_value_bytes += shared_store_bytes;
+		}
+
+		result = maybe_vector_push(&stats->components, &(maybe_world_component_stats_t){
+			i,
+			MAYBE_VECTOR_ELEMENT(world->component_types, maybe_component_type_t, i).component_size,
+			0, 0, 0, 0, 0, 0
+		});
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+	}
+
+	for (i = 0; i < world->archetypes.length; i++) {
+		archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, i);
+
+		result = maybe_vector_push(&stats->archetypes, NULL);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		/* The row's entity is part of the row */
+		archetype_stats = &MAYBE_VECTOR_ELEMENT(stats->archetypes, maybe_world_archetype_stats_t, i);
+		archetype_stats->archetype_index = i;
+		archetype_stats->component_count = archetype->component_types_count;
+		archetype_stats->row_count = archetype->entities.length;
+		archetype_stats->row_capacity = archetype->entities.capacity;
+		archetype_stats->bytes_used = (uint64_t)archetype->entities.length * archetype->entities.element_size;
+		archetype_stats->bytes_wasted = (uint64_t)(archetype->entities.capacity - archetype->entities.length) * archetype->entities.element_size;
+
+		for (j = 0; j < archetype->component_types_count; j++) {
+			column = &MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, j);
+			column_used = (uint64_t)column->length * column->element_size;
+			column_wasted = (uint64_t)(column->capacity - column->length) * column->element_size;
+
+			archetype_stats->bytes_used += column_used;
+			archetype_stats->bytes_wasted += column_wasted;
+
+			component_stats = &MAYBE_VECTOR_ELEMENT(stats->components, maybe_world_component_stats_t, MAYBE_VECTOR_ELEMENT(archetype->component_ids, uint32_t, j));
+			component_stats->archetype_count++;
+			component_stats->instance_count += column->length;
+			component_stats->bytes_used += column_used;
+			component_stats->bytes_wasted += column_wasted;
+			component_stats->access_count += MAYBE_VECTOR_ELEMENT(archetype->column_access_counts, uint32_t, j);
+
+			if ((NULL != world->page_store) && (column->allocator == &world->page_store->allocator)) {
+				stats->paged_bytes += column_used + column_wasted;
+				component_stats->paged_bytes += column_used + column_wasted;
+			}
+		}
+
+		if (0 == archetype->entities.length) {
+			stats->empty_archetype_count++;
+		}
+
+		if (archetype->is_paged_out) {
+			stats->paged_out_archetype_count++;
+		}
+
+		stats->entity_count += archetype->entities.length;
+		stats->bytes_used += archetype_stats->bytes_used;
+		stats->bytes_wasted += archetype_stats->bytes_wasted;
+		stats->archetype_overhead_bytes += sizeof(maybe_archetype_t);
+		stats->archetype_overhead_bytes += (uint64_t)archetype->components.capacity * archetype->components.element_size;
+		stats->archetype_overhead_bytes += (uint64_t)archetype->component_ids.capacity * archetype->component_ids.element_size;
+		stats->archetype_overhead_bytes += (uint64_t)archetype->enabled_rows.capacity * archetype->enabled_rows.element_size;
+		stats->archetype_overhead_bytes += (uint64_t)archetype->shared_component_ids.capacity * archetype->shared_component_ids.element_size;
+		stats->archetype_overhead_bytes += (uint64_t)archetype->shared_values.capacity * archetype->shared_values.element_size;
+		stats->archetype_overhead_bytes += (uint64_t)archetype->column_reference_counts.capacity * archetype->column_reference_counts.element_size;
+	}
+
+	for (i = 0; i < world->systems.length; i++) {
+		system = &MAYBE_VECTOR_ELEMENT(world->systems, maybe_system_t, i);
+
+		/* The component IDs, iterators, archetype infos and the component indices of every archetype info */
+		stats->system_bytes += (uint64_t)system->component_count * (sizeof(uint32_t) + sizeof(maybe_system_component_iterator_t));
+		stats->system_bytes += (uint64_t)system->archetypes.capacity * system->archetypes.element_size;
+		stats->system_bytes += (uint64_t)system->archetypes.length * system->component_count * sizeof(uint32_t*);
+	}
+
+	result = maybe_map_get_memory_usage(&world->entities, &stats->entity_map_bytes);
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	stats->total_bytes = stats->bytes_used + stats->bytes_wasted + stats->archetype_overhead_bytes + stats->entity_map_bytes + stats->system_bytes + stats->shared_value_bytes;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+maybe_error_t maybe_world_stats_free(
+	maybe_world_stats_t* stats
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_error_t free_result;
+
+	if (NULL == stats) {
+		result = MAYBE_ERROR_ECS_WORLD_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+
+	free_result = maybe_vector_free(&stats->archetypes);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	free_result = maybe_vector_free(&stats->components);
+	if (IS_FAILURE(free_result)) {
+		result = free_result;
+	}
+
+	/* If any free operation failed, return an error */
+	if (IS_FAILURE(result)) {
+		goto l_cleanup;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
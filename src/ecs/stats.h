@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "common/error.h"
+#include "common/vector/vector.h"
+#include "ecs.h"
+
+/* @brief Memory statistics of a single archetype */
+typedef struct {
+	uint32_t archetype_index;
+	uint32_t component_count;
+	uint32_t row_count;
+	uint32_t row_capacity;
+	uint64_t bytes_used; /* Bytes of rows in use, including the row's entity */
+	uint64_t bytes_wasted; /* Bytes of allocated rows that are not used */
+} maybe_world_archetype_stats_t;
+
+/* @brief Memory statistics of a single component type, over all archetypes */
+typedef struct {
+	uint32_t component_id;
+	uint32_t component_size;
+	uint32_t archetype_count; /* The number of archetypes that store the component */
+	uint64_t instance_count;
+	uint64_t bytes_used;
+	uint64_t bytes_wasted;
+	uint64_t access_count; /* System runs that read the component's columns since the counts were reset, see maybe_world_split_cold_columns */
+	uint64_t paged_bytes; /* Bytes of the component's columns in the world's page store */
+} maybe_world_component_stats_t;
+
+/* @brief Memory statistics of a world */
+typedef struct {
+	MAYBE_VECTOR(maybe_world_archetype_stats_t) archetypes;
+	MAYBE_VECTOR(maybe_world_component_stats_t) components; /* Indexed by component ID */
+	uint32_t archetype_count;
+	uint32_t empty_archetype_count;
+	uint64_t entity_count;
+	uint64_t bytes_used; /* Bytes used by all the archetypes' rows */
+	uint64_t bytes_wasted; /* Bytes allocated for archetype rows that are not used */
+	uint64_t paged_bytes; /* Bytes of columns allocated from the world's page store, part of the used and wasted bytes */
+	uint32_t paged_out_archetype_count; /* The number of archetypes whose columns are paged out, see maybe_world_page_out */
+	uint64_t archetype_overhead_bytes; /* Bytes used by the archetypes' bookkeeping */
+	uint64_t entity_map_bytes; /* Bytes used by the entity records map */
+	uint64_t system_bytes; /* Bytes used by the systems and their archetype lists */
+	uint64_t shared_value_bytes; /* Bytes used by the stored values of shared components */
+	uint64_t total_bytes; /* All of the above */
+} maybe_world_stats_t;
+
+/*
+ * @brief Initialize a world statistics struct
+ *
+ * @param stats A pointer to the statistics
+ *
+ * @note The same statistics struct should be reused for polling, so it only allocates when the world grows
+ * */
+maybe_error_t maybe_world_stats_init(
+	maybe_world_stats_t* stats
+);
+
+/*
+ * @brief Collect the memory statistics of a world
+ *
+ * @param world A pointer to the world
+ * @param stats A pointer to an initialized statistics struct, its previous content is replaced
+ *
+ * @note This only walks the archetypes, component types and systems, never the entities
+ * */
+maybe_error_t maybe_world_get_stats(
+	maybe_world_t* world,
+	maybe_world_stats_t* stats
+);
+
+/*
+ * @brief Free a world statistics struct's resources
+ *
+ * @param stats A pointer to the statistics
+ * */
+maybe_error_t maybe_world_stats_free(
+	maybe_world_stats_t* stats
+);
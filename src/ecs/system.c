@@ -3,11 +3,13 @@
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "common/common.h"
 #include "common/vector/vector.h"
 
 #include "system.h"
+#include "system_internal.h"
 
 maybe_error_t maybe_system_init_va_list(
 	maybe_system_t* system,
@@ -26,6 +28,10 @@ maybe_error_t maybe_system_init_va_list(
 	/* Initialize struct with parameters */
 	system->function = function;
 	system->component_count = component_count;
+	system->schedule = (maybe_system_schedule_t){ MAYBE_SYSTEM_RATE_VARIABLE, 1, 0 };
+	system->delta_time = 0.0;
+	system->pending_time = 0.0;
+	system->slice = 0;
 	system->component_ids = (uint32_t*)malloc(component_count * sizeof(uint32_t));
 	if (NULL == system->component_ids) {
 		result = MAYBE_ERROR_SYSTEM_ALLOCATION_FAILED;
@@ -47,6 +53,7 @@ maybe_error_t maybe_system_init_va_list(
 		system->iterators[i].component_id = component_id;
 		system->iterators[i].component_id_index = i;
 	}
+	system->component_mask = maybe_archetype_get_component_mask(system->component_ids, component_count);
 
 	result = MAYBE_ERROR_SUCCESS;
 l_cleanup:
@@ -87,7 +94,7 @@ maybe_error_t maybe_system_add_archetype(
 	}
 	
 	/* Verify that there are enough components in the archetype */
-	if (archetype->component_types_count< system->component_count) {
+	if ((archetype->component_types_count < system->component_count) || ((archetype->component_mask & system->component_mask) != system->component_mask)) {
 		result = MAYBE_ERROR_SYSTEM_BAD_ARCHETYPE;
 		goto l_cleanup;
 	}
@@ -137,15 +144,133 @@ l_cleanup:
 	return result;
 }
 
+maybe_error_t maybe_system_remove_archetype(
+	maybe_system_t* system,
+	maybe_archetype_t* archetype
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_system_archetype_info_t* info;
+	uint32_t i;
+
+	if ((NULL == system) || (NULL == archetype)) {
+		result = MAYBE_ERROR_SYSTEM_NULL_PARAM;
+		goto l_cleanup;
+	}
+
+	for (i = 0; i < system->archetypes.length; i++) {
+		info = &MAYBE_VECTOR_ELEMENT(system->archetypes, maybe_system_archetype_info_t, i);
+		if (info->archetype != archetype) {
+			continue;
+		}
+
+		free(info->component_indices);
+		free(info->slice_rows);
+		free(info->slice_starts);
+
+		/* Keep the iteration order of the rest of the archetypes */
+		result = maybe_vector_remove(&system->archetypes, i);
+		if (IS_FAILURE(result)) {
+			goto l_cleanup;
+		}
+
+		break;
+	}
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
+void maybe_system_run(
+	maybe_system_t* system
+) {
+	system->function((void*)system);
+
+	if (system->schedule.slices > 1) {
+		system->slice = (system->slice + 1) % system->schedule.slices;
+	}
+}
+
+maybe_error_t maybe_system_update_slice_rows(
+	maybe_system_t* system,
+	maybe_system_archetype_info_t* info
+) {
+	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
+	maybe_archetype_t* archetype = info->archetype;
+	const maybe_entity_t* entities = (const maybe_entity_t*)archetype->entities.elements;
+	uint32_t slices = system->schedule.slices;
+	uint32_t row_count = archetype->entities.length;
+	uint32_t* slice_rows;
+	uint32_t* slice_starts;
+	uint32_t i, slice;
+
+	if ((info->slice_count == slices) && (info->slice_layout_version == archetype->layout_version)) {
+		result = MAYBE_ERROR_SUCCESS;
+		goto l_cleanup;
+	}
+
+	if (info->slice_count != slices) {
+		slice_starts = MALLOC_T(uint32_t, ((size_t)slices + 1));
+		if (NULL == slice_starts) {
+			result = MAYBE_ERROR_SYSTEM_ALLOCATION_FAILED;
+			goto l_cleanup;
+		}
+
+		free(info->slice_starts);
+		info->slice_starts = slice_starts;
+		info->slice_count = 0;
+	}
+
+	/* The rows are kept for when the archetype grows back, and an empty archetype still gets a buffer */
+	if ((NULL == info->slice_rows) || (info->slice_rows_capacity < row_count)) {
+		slice_rows = MALLOC_T(uint32_t, (row_count + 1));
+		if (NULL == slice_rows) {
+			result = MAYBE_ERROR_SYSTEM_ALLOCATION_FAILED;
+			goto l_cleanup;
+		}
+
+		free(info->slice_rows);
+		info->slice_rows = slice_rows;
+		info->slice_rows_capacity = row_count + 1;
+	}
+
+	/* A counting sort by slice, which keeps the rows of every slice in order */
+	memset(info->slice_starts, 0, ((size_t)slices + 1) * sizeof(uint32_t));
+	for (i = 0; i < row_count; i++) {
+		info->slice_starts[maybe_system_get_slice(entities[i], slices) + 1]++;
+	}
+
+	for (slice = 0; slice < slices; slice++) {
+		info->slice_starts[slice + 1] += info->slice_starts[slice];
+	}
+
+	/* Every slice's start is used as its cursor, which leaves it at the start of the next slice */
+	for (i = 0; i < row_count; i++) {
+		info->slice_rows[info->slice_starts[maybe_system_get_slice(entities[i], slices)]++] = i;
+	}
+
+	for (slice = slices; slice > 0; slice--) {
+		info->slice_starts[slice] = info->slice_starts[slice - 1];
+	}
+	info->slice_starts[0] = 0;
+
+	info->slice_count = slices;
+	info->slice_layout_version = archetype->layout_version;
+	info->slice_cursor = 0;
+
+	result = MAYBE_ERROR_SUCCESS;
+l_cleanup:
+	return result;
+}
+
 maybe_error_t maybe_system_init_component_iterator(
 	maybe_system_t* system,
 	uint32_t component_id,
 	maybe_system_component_iterator_t* iterator
 ) {
 	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
-	uint32_t i, component_id_index;
-	maybe_system_archetype_info_t* archetype_info;
-	maybe_archetype_t* archetype;
+	uint32_t i;
+	bool found_component = false;
 
 	if ((NULL == system) || (NULL == iterator)) {
 		result = MAYBE_ERROR_SYSTEM_NULL_PARAM;
@@ -156,24 +281,25 @@ maybe_error_t maybe_system_init_component_iterator(
 	iterator->component_id = component_id;
 	for (i = 0; i < system->component_count; i++) {
 		if (system->component_ids[i] == component_id) {
-			component_id_index = i;
 			iterator->component_id_index = i;
+			found_component = true;
 			break;
 		}
 	}
 
 	iterator->current_archetype_index = 0;
 	iterator->current_component_index = 0;
+	iterator->current_component_vector = NULL;
+	iterator->current_component_pointer = NULL;
 
-	if (system->archetypes.length == 0) {
-		iterator->current_component_pointer = NULL;
-	} else {
-		archetype_info = &MAYBE_VECTOR_ELEMENT(system->archetypes, maybe_system_archetype_info_t, 0);
-		archetype = archetype_info->archetype; 
-		iterator->current_component_vector = &MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, archetype_info->component_indices[component_id_index]);
-		iterator->current_component_pointer = MAYBE_VECTOR_PTR_ELEMENT_VOID_PTR(iterator->current_component_vector, 0);
+	if (!found_component) {
+		result = MAYBE_ERROR_SYSTEM_BAD_ARCHETYPE;
+		goto l_cleanup;
 	}
 
+	/* Point to the first component of the first non empty archetype */
+	(void)start_archetype(system, iterator);
+
 	result = MAYBE_ERROR_SUCCESS;
 l_cleanup:
 	return result;
@@ -186,14 +312,28 @@ maybe_error_t maybe_system_component_iterator_get_next_component(
 	maybe_error_t result = MAYBE_ERROR_UNINITIALIZED;
 	maybe_system_archetype_info_t* archetype_info;
 	maybe_archetype_t* archetype;
+	uint32_t end;
 	
 	if ((NULL == system) || (NULL == iterator)) {
 		result = MAYBE_ERROR_SYSTEM_NULL_PARAM;
 		goto l_cleanup;
 	}
 
+	if (NULL == iterator->current_component_pointer) {
+		result = MAYBE_ERROR_SYSTEM_COMPONENT_ITERATOR_LAST_COMPONENT_REACHED;
+		goto l_cleanup;
+	}
+
 	iterator->current_component_index++;
 
+	/* Skip disabled rows and rows of other slices, checking them only if there are any */
+	archetype_info = &MAYBE_VECTOR_ELEMENT(system->archetypes, maybe_system_archetype_info_t, iterator->current_archetype_index);
+	archetype = archetype_info->archetype;
+	if (((archetype->disabled_count > 0) || (system->schedule.slices > 1)) &&
+		!maybe_system_find_rows(system, archetype_info, iterator->current_component_index, &iterator->current_component_index, &end)) {
+		iterator->current_component_index = archetype->entities.length;
+	}
+
 	/* If the next component is in the same archetype, Advance the component pointer. Else, reset the component index 
 	 * and point to the next archetype. If the archetypes are over, set the component pointer to NULL, and return an error */
 	if (iterator->current_component_index < iterator->current_component_vector->length) {
@@ -203,16 +343,10 @@ maybe_error_t maybe_system_component_iterator_get_next_component(
 		iterator->current_component_index = 0;
 
 		/* Last component reached */
-		if (iterator->current_archetype_index >= system->archetypes.length) {
-			iterator->current_component_pointer = NULL;
+		if (!start_archetype(system, iterator)) {
 			result = MAYBE_ERROR_SYSTEM_COMPONENT_ITERATOR_LAST_COMPONENT_REACHED;
 			goto l_cleanup;
 		}
-
-		/* Start new archetype */
-		archetype_info = &MAYBE_VECTOR_ELEMENT(system->archetypes, maybe_system_archetype_info_t, iterator->current_archetype_index);
-		archetype = archetype_info->archetype; 
-		iterator->current_component_vector = &MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, archetype_info->component_indices[iterator->component_id_index]);
 	}
 
 	result = MAYBE_ERROR_SUCCESS;
@@ -220,6 +354,42 @@ l_cleanup:
 	return result;
 }
 
+bool start_archetype(
+	maybe_system_t* system,
+	maybe_system_component_iterator_t* iterator
+) {
+	maybe_system_archetype_info_t* archetype_info;
+	maybe_archetype_t* archetype;
+	uint32_t first, end, column_index;
+
+	/* Skip archetypes that have no enabled entities in the system's slice */
+	for (; iterator->current_archetype_index < system->archetypes.length; iterator->current_archetype_index++) {
+		archetype_info = &MAYBE_VECTOR_ELEMENT(system->archetypes, maybe_system_archetype_info_t, iterator->current_archetype_index);
+		archetype = archetype_info->archetype; 
+
+		if (!maybe_system_find_rows(system, archetype_info, 0, &first, &end)) {
+			continue;
+		}
+
+		/* The iterator hands out pointers the system may write through, so a column a fork shares is copied first */
+		column_index = archetype_info->component_indices[iterator->component_id_index];
+		if ((NULL != MAYBE_VECTOR_ELEMENT(archetype->column_reference_counts, uint32_t*, column_index)) &&
+			IS_FAILURE(maybe_archetype_make_column_writable(archetype, column_index))) {
+			break;
+		}
+
+		iterator->current_component_index = first;
+		iterator->current_component_vector = &MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, column_index);
+		iterator->current_component_pointer = MAYBE_VECTOR_PTR_ELEMENT_VOID_PTR(iterator->current_component_vector, first);
+
+		return true;
+	}
+
+	iterator->current_component_pointer = NULL;
+
+	return false;
+}
+
 maybe_error_t maybe_system_free(
 	maybe_system_t* system
 ) {
@@ -239,10 +409,13 @@ maybe_error_t maybe_system_free(
 		free(system->iterators);
 	}
 
-	for (i = 0; i < system->component_count; i++) {
+	for (i = 0; i < system->archetypes.length; i++) {
 		if (MAYBE_VECTOR_ELEMENT(system->archetypes, maybe_system_archetype_info_t, i).component_indices) {
 			free(MAYBE_VECTOR_ELEMENT(system->archetypes, maybe_system_archetype_info_t, i).component_indices);
 		}
+
+		free(MAYBE_VECTOR_ELEMENT(system->archetypes, maybe_system_archetype_info_t, i).slice_rows);
+		free(MAYBE_VECTOR_ELEMENT(system->archetypes, maybe_system_archetype_info_t, i).slice_starts);
 	}
 
 	maybe_vector_free(&system->archetypes);
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdarg.h>
+#include <stdbool.h>
 
 #include "common/common.h"
 #include "common/vector/vector.h"
@@ -11,10 +13,33 @@
 /* @brief A prototype for a system function */
 typedef void (*maybe_system_function_t)(void* system);
 
+/* @brief How often a system runs when the world is advanced with maybe_world_advance */
+typedef enum {
+	MAYBE_SYSTEM_RATE_VARIABLE = 0, /* Runs once per maybe_world_advance call */
+	MAYBE_SYSTEM_RATE_FIXED, /* Runs once per fixed timestep, zero or more times per maybe_world_advance call */
+} maybe_system_rate_t;
+
+/* @brief Let the world choose a phase that spreads systems with the same divider over different ticks */
+#define MAYBE_SYSTEM_PHASE_AUTO (UINT32_MAX)
+
+/* @brief When a system runs, relative to the world's ticks */
+typedef struct {
+	maybe_system_rate_t rate;
+	uint32_t divider; /* The system runs every divider-th tick, 0 and 1 both mean every tick */
+	uint32_t phase; /* The tick (modulo divider) the system runs on, or MAYBE_SYSTEM_PHASE_AUTO */
+	uint32_t slices; /* Every run processes one of this many slices of the entities, 0 and 1 both mean all of them. See maybe_system_find_rows */
+} maybe_system_schedule_t;
+
 /* @brief The needed info for a system about an archetype it needs to iterate */
 typedef struct {
 	maybe_archetype_t* archetype;
 	uint32_t* component_indices;
+	uint32_t* slice_rows; /* The archetype's rows grouped by slice, for time-sliced systems. See maybe_system_update_slice_rows */
+	uint32_t* slice_starts; /* The first element of every slice in slice_rows, with an extra element for the end of the last one */
+	uint32_t slice_rows_capacity;
+	uint32_t slice_count; /* The slice count slice_rows was built for, 0 if it was not built */
+	uint32_t slice_layout_version; /* The archetype's layout version slice_rows was built for */
+	uint32_t slice_cursor; /* The element of slice_rows after the last range found, where the next search usually starts */
 } maybe_system_archetype_info_t;
 
 /* @brief An iterator used in systems to iterate through its requested components */
@@ -27,13 +52,21 @@ typedef struct {
 	void* current_component_pointer; 
 } maybe_system_component_iterator_t;
 
+/* @brief The number of consecutive IDs which are always in the same slice of a time-sliced system, see maybe_system_get_slice */
+#define MAYBE_SYSTEM_SLICE_BLOCK_IDS (16)
+
 /* @brief The state of a system */
 typedef struct {
 	maybe_system_function_t function;
 	MAYBE_VECTOR(maybe_system_archetype_info_t) archetypes;
 	uint32_t* component_ids;
 	uint32_t component_count;
+	uint64_t component_mask; /* The mask of the component IDs, see MAYBE_COMPONENT_MASK_BIT */
 	maybe_system_component_iterator_t* iterators;
+	maybe_system_schedule_t schedule;
+	double delta_time; /* The time in seconds since the system's previous run, valid while the system runs */
+	double pending_time; /* The time accumulated since the system's previous run */
+	uint32_t slice; /* The slice of the entities the system's current run processes, below schedule.slices */
 } maybe_system_t;
 
 /*
@@ -77,12 +110,200 @@ maybe_error_t maybe_system_add_archetype(
 	maybe_archetype_t* archetype
 );
 
+/*
+ * @brief Remove an archetype from the system's iteration list, if it is there
+ *
+ * @param system A pointer to the system
+ * @param archetype The archetype to remove
+ * */
+maybe_error_t maybe_system_remove_archetype(
+	maybe_system_t* system,
+	maybe_archetype_t* archetype
+);
+
+/*
+ * @brief Run a system's function once, and move it to its next slice
+ *
+ * @param system A pointer to the system
+ * */
+void maybe_system_run(
+	maybe_system_t* system
+);
+
+/*
+ * @brief Get the slice of an entity in a time-sliced system
+ *
+ * Blocks of MAYBE_SYSTEM_SLICE_BLOCK_IDS consecutive IDs share a slice, so entities added together,
+ * which usually sit in consecutive rows, are processed in runs of rows. The block is hashed, so IDs that
+ * follow a pattern, like every 4th entity, are still spread over all the slices, and the hash's top bits
+ * are scaled to the slice count instead of taking a remainder.
+ *
+ * @param entity The entity's ID
+ * @param slices The system's slice count
+ * */
+static inline uint32_t maybe_system_get_slice(
+	maybe_entity_t entity,
+	uint32_t slices
+) {
+	uint64_t hash = ((entity / MAYBE_SYSTEM_SLICE_BLOCK_IDS) * 0x9e3779b97f4a7c15ull) >> 32;
+
+	return (uint32_t)((hash * slices) >> 32);
+}
+
+/*
+ * @brief Group an archetype's rows by slice for a time-sliced system, if they changed since they were last grouped
+ *
+ * @param system A pointer to the system
+ * @param info The system's info of the archetype
+ *
+ * @note The rows are grouped again only after the archetype's layout version changes, so a slice's run
+ * 		 costs about its share of the rows
+ * */
+maybe_error_t maybe_system_update_slice_rows(
+	maybe_system_t* system,
+	maybe_system_archetype_info_t* info
+);
+
+/*
+ * @brief Find the next range of rows of the system's slice in an archetype by checking every enabled row
+ *
+ * @param system A pointer to the system
+ * @param archetype The archetype
+ * @param start The row the search starts from
+ * @param first The first row of the range
+ * @param end The row after the last row of the range
+ *
+ * @return Whether a row was found at or after start
+ *
+ * @note Used when the archetype's rows could not be grouped by slice
+ * */
+static inline bool maybe_system_scan_slice_rows(
+	maybe_system_t* system,
+	maybe_archetype_t* archetype,
+	uint32_t start,
+	uint32_t* first,
+	uint32_t* end
+) {
+	const maybe_entity_t* entities = (const maybe_entity_t*)archetype->entities.elements;
+	uint32_t row, enabled_end;
+
+	while (maybe_archetype_find_enabled_rows(archetype, start, first, &enabled_end)) {
+		for (row = *first; row < enabled_end; row++) {
+			if (maybe_system_get_slice(entities[row], system->schedule.slices) == system->slice) {
+				break;
+			}
+		}
+
+		if (row < enabled_end) {
+			*first = row;
+			for (row++; row < enabled_end; row++) {
+				if (maybe_system_get_slice(entities[row], system->schedule.slices) != system->slice) {
+					break;
+				}
+			}
+			*end = row;
+
+			return true;
+		}
+
+		start = enabled_end;
+	}
+
+	return false;
+}
+
+/*
+ * @brief Find the next range of rows a system processes in an archetype
+ *
+ * A time-sliced system (schedule.slices > 1) processes the entities whose hashed ID falls in its current
+ * slice (see maybe_system_get_slice), and moves to the next slice every run, so every entity is processed
+ * once every slices runs. The slice depends only on the ID, so entities that move between archetypes or
+ * rows in the middle of a cycle are neither skipped nor processed twice.
+ *
+ * The rows of every slice are kept in the system's archetype info, so a run only visits the rows of its
+ * slice, and ranges are the longest runs of consecutive enabled rows of the slice.
+ *
+ * @param system A pointer to the system
+ * @param info The system's info of the archetype
+ * @param start The row the search starts from
+ * @param first The first row of the range
+ * @param end The row after the last row of the range
+ *
+ * @return Whether a row was found at or after start
+ * */
+static inline bool maybe_system_find_rows(
+	maybe_system_t* system,
+	maybe_system_archetype_info_t* info,
+	uint32_t start,
+	uint32_t* first,
+	uint32_t* end
+) {
+	maybe_archetype_t* archetype = info->archetype;
+	const uint32_t* rows;
+	uint32_t low, high, middle, i;
+
+	if (system->schedule.slices <= 1) {
+		return maybe_archetype_find_enabled_rows(archetype, start, first, end);
+	}
+
+	/* The rows are grouped again only after the archetype's rows changed */
+	if (((info->slice_count != system->schedule.slices) || (info->slice_layout_version != archetype->layout_version)) &&
+		IS_FAILURE(maybe_system_update_slice_rows(system, info))) {
+		return maybe_system_scan_slice_rows(system, archetype, start, first, end);
+	}
+
+	rows = info->slice_rows;
+	low = info->slice_starts[system->slice];
+	high = info->slice_starts[system->slice + 1];
+
+	/* Iteration continues where the last range ended, other starts are searched for */
+	i = info->slice_cursor;
+	if ((i < low) || (i > high) || ((i > low) && (rows[i - 1] >= start)) || ((i < high) && (rows[i] < start))) {
+		while (low < high) {
+			middle = low + ((high - low) / 2);
+			if (rows[middle] < start) {
+				low = middle + 1;
+			} else {
+				high = middle;
+			}
+		}
+
+		i = low;
+		high = info->slice_starts[system->slice + 1];
+	}
+
+	while ((i < high) && (archetype->disabled_count > 0) && !maybe_archetype_is_row_enabled(archetype, rows[i])) {
+		i++;
+	}
+
+	if (i >= high) {
+		info->slice_cursor = i;
+		return false;
+	}
+
+	*first = rows[i];
+	*end = rows[i] + 1;
+	for (i++; (i < high) && (rows[i] == *end); i++) {
+		if ((archetype->disabled_count > 0) && !maybe_archetype_is_row_enabled(archetype, rows[i])) {
+			break;
+		}
+
+		(*end)++;
+	}
+
+	info->slice_cursor = i;
+
+	return true;
+}
+
 /*
  * @brief Initialize a component iterator used by the system function
  *
  * @param system A pointer to the system
  * @param component_id The ID of the component type the iterator should iterate
  * @param iterator The new iterator
+ *
+ * @note In a world that shares columns with forks, a column is copied when the iterator reaches it
  * */
 maybe_error_t maybe_system_init_component_iterator(
 	maybe_system_t* system,
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "system.h"
+
+/*
+ * @brief Point an iterator to the first enabled component of the first archetype that has one, starting from its current archetype
+ *
+ * @param system A pointer to the system
+ * @param iterator A pointer to the iterator
+ *
+ * @return Whether a non empty archetype was found, false also if its column could not be made writable
+ * */
+static bool start_archetype(
+	maybe_system_t* system,
+	maybe_system_component_iterator_t* iterator
+);
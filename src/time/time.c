@@ -42,3 +42,11 @@ uint64_t maybe_time_get_time_since_init_seconds() {
 uint64_t maybe_time_get_time_since_init_minutes() {
 	return (maybe_time_get_time_since_epoch_seconds() - init_time_seconds) / 60;
 }
+
+uint64_t maybe_time_get_monotonic_ns() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
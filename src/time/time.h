@@ -35,3 +35,10 @@ uint64_t maybe_time_get_time_since_init_seconds(void);
  * @brief Get the current time since init in minutes (rounded down)
  * */
 uint64_t maybe_time_get_time_since_init_minutes(void);
+
+/*
+ * @brief Get a monotonic timestamp in nanoseconds, used for measuring durations
+ *
+ * @note The value has no relation to the epoch, only differences between two timestamps are meaningful
+ * */
+uint64_t maybe_time_get_monotonic_ns(void);
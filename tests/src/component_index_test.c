@@ -0,0 +1,105 @@
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <common/error.h>
+#include <ecs/ecs.h>
+#include <ecs/component_index.h>
+
+#include "test.h"
+
+typedef struct {
+	float score;
+} score_t;
+
+MAYBE_DEFINE_COMPONENT_TYPE(score_t)
+
+/* @brief Check that a lookup of a value finds exactly the expected entities */
+static void check_find(
+	maybe_component_index_t* index,
+	float value,
+	const maybe_entity_t* expected,
+	uint32_t expected_count
+) {
+	const maybe_entity_t* entities = NULL;
+	uint32_t entity_count = 0;
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_component_index_find(index, &value, &entities, &entity_count));
+	TEST_CHECK(expected_count == entity_count);
+	for (uint32_t i = 0; i < expected_count; i++) {
+		uint32_t found = 0;
+		for (uint32_t j = 0; j < entity_count; j++) {
+			found += (expected[i] == entities[j]);
+		}
+		TEST_CHECK(1 == found);
+	}
+}
+
+/* @brief Both zeros have one key, and keys order like the values with NaNs beyond the infinities */
+static void test_float_keys(
+	maybe_component_index_t* index
+) {
+	const float values[] = { -INFINITY, -1.0f, -0.0f, 0.0f, 1e-30f, 1.0f, INFINITY };
+	const float positive_nan = NAN;
+	const float negative_nan = -NAN;
+
+	TEST_CHECK(maybe_component_index_get_key(index, &values[2]) == maybe_component_index_get_key(index, &values[3]));
+	for (uint32_t i = 0; i + 1 < sizeof(values) / sizeof(values[0]); i++) {
+		if (values[i] < values[i + 1]) {
+			TEST_CHECK(maybe_component_index_get_key(index, &values[i]) < maybe_component_index_get_key(index, &values[i + 1]));
+		}
+	}
+	TEST_CHECK(maybe_component_index_get_key(index, &positive_nan) > maybe_component_index_get_key(index, &values[6]));
+	TEST_CHECK(maybe_component_index_get_key(index, &negative_nan) < maybe_component_index_get_key(index, &values[0]));
+}
+
+/* @brief Entities set to -0.0f and +0.0f are found by a lookup of either zero, in both kinds of index */
+static void test_signed_zeros(void) {
+	maybe_world_t world;
+	maybe_component_index_t hash_index;
+	maybe_component_index_t sorted_index;
+	maybe_entity_t entities[3];
+	const float scores[] = { -0.0f, 0.0f, 1.0f };
+	const float zero = 0.0f;
+	const float negative_zero = -0.0f;
+	const maybe_entity_t* found = NULL;
+	uint32_t found_count = 0;
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_init(&world));
+	MAYBE_REGISTER_COMPONENT_TYPE(&world, score_t);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_component_index_init(&hash_index, &world, (maybe_component_index_config_t){
+		MAYBE_COMPONENT_ID(score_t), offsetof(score_t, score), MAYBE_COMPONENT_INDEX_FIELD_FLOAT, MAYBE_COMPONENT_INDEX_HASH
+	}));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_component_index_init(&sorted_index, &world, (maybe_component_index_config_t){
+		MAYBE_COMPONENT_ID(score_t), offsetof(score_t, score), MAYBE_COMPONENT_INDEX_FIELD_FLOAT, MAYBE_COMPONENT_INDEX_SORTED
+	}));
+
+	for (uint32_t i = 0; i < 3; i++) {
+		score_t score = { scores[i] };
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_add_entity(&world, 1, &entities[i], MAYBE_COMPONENT_ID(score_t)));
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_set_component(&world, entities[i], MAYBE_COMPONENT_ID(score_t), &score));
+	}
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_flush_observers(&world));
+
+	check_find(&hash_index, zero, entities, 2);
+	check_find(&hash_index, negative_zero, entities, 2);
+	check_find(&sorted_index, zero, entities, 2);
+	check_find(&sorted_index, negative_zero, entities, 2);
+
+	/* A range from -0.0f to +0.0f holds both zeros */
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_component_index_find_range(&sorted_index, &negative_zero, &zero, &found, &found_count));
+	TEST_CHECK(2 == found_count);
+
+	test_float_keys(&sorted_index);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_component_index_free(&hash_index));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_component_index_free(&sorted_index));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&world));
+}
+
+int main(void) {
+	test_signed_zeros();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,322 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <common/error.h>
+#include <ecs/ecs.h>
+#include <ecs/system.h>
+#include <ecs/query.h>
+
+#include "test.h"
+
+#define FORK_TEST_ENTITIES (100000)
+#define FORK_TEST_CHANGED_ENTITIES (1000)
+
+typedef struct {
+	uint32_t value;
+} value_t;
+
+typedef struct {
+	uint32_t value;
+} other_t;
+
+MAYBE_DEFINE_COMPONENT_TYPE(value_t)
+MAYBE_DEFINE_COMPONENT_TYPE(other_t)
+
+void do_nothing(void* system) {
+	(void)system;
+}
+
+void increment_values(void* system) {
+	MAYBE_SYSTEM_QUERY_EACH(system, (value_t, value)) {
+		value->value++;
+	}
+}
+
+void increment_values_with_iterator(void* system) {
+	maybe_system_component_iterator_t values;
+
+	maybe_system_init_component_iterator(system, MAYBE_COMPONENT_ID(value_t), &values);
+
+	while (values.current_component_pointer) {
+		((value_t*)values.current_component_pointer)->value++;
+
+		maybe_system_component_iterator_get_next_component(system, &values);
+	}
+}
+
+/* @brief Get the storage of the first column of a world's archetype, to check whether two worlds share it */
+static void* get_column_storage(
+	maybe_world_t* world,
+	uint32_t archetype_index
+) {
+	maybe_archetype_t* archetype = MAYBE_VECTOR_ELEMENT(world->archetypes, maybe_archetype_t*, archetype_index);
+
+	return MAYBE_VECTOR_ELEMENT(archetype->components, maybe_vector_t, 0).elements;
+}
+
+/* @brief Add entities whose value is their ID, and return the index of their archetype */
+static uint32_t add_entities(
+	maybe_world_t* world,
+	uint32_t count
+) {
+	maybe_entity_t entity;
+	value_t value;
+
+	for (uint32_t i = 0; i < count; i++) {
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_add_entity(world, 1, &entity, MAYBE_COMPONENT_ID(value_t)));
+		value.value = (uint32_t)entity;
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_set_component(world, entity, MAYBE_COMPONENT_ID(value_t), &value));
+	}
+
+	return world->archetypes.length - 1;
+}
+
+/* @brief Check that the value of every entity is its ID plus an offset */
+static void check_values(
+	maybe_world_t* world,
+	uint32_t count,
+	uint32_t offset
+) {
+	value_t* value;
+	uint32_t wrong_count = 0;
+
+	for (maybe_entity_t entity = 0; entity < count; entity++) {
+		value = NULL;
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_get_component(world, entity, MAYBE_COMPONENT_ID(value_t), (void**)&value));
+		wrong_count += (NULL == value) || (value->value != (uint32_t)entity + offset);
+	}
+
+	TEST_CHECK(0 == wrong_count);
+}
+
+/* @brief Updates of a fork and of its parent do not copy columns that no system writes, and neither does compacting */
+static void test_updates_keep_columns_shared(void) {
+	maybe_world_t parent;
+	maybe_world_t fork;
+	uint32_t archetype_index;
+	bool finished = false;
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_init(&parent));
+	MAYBE_REGISTER_COMPONENT_TYPE(&parent, value_t);
+	archetype_index = add_entities(&parent, FORK_TEST_ENTITIES);
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_register_system(&parent, do_nothing, 1, MAYBE_COMPONENT_ID(value_t)));
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_fork(&fork, &parent));
+	TEST_CHECK(get_column_storage(&fork, archetype_index) == get_column_storage(&parent, archetype_index));
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_update(&fork));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_advance(&fork, 0.0));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_update(&parent));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_advance(&parent, 0.0));
+	TEST_CHECK(get_column_storage(&fork, archetype_index) == get_column_storage(&parent, archetype_index));
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_compact(&parent, 1.0f, 0, &finished));
+	TEST_CHECK(finished);
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_compact(&fork, 1.0f, 0, &finished));
+	TEST_CHECK(finished);
+	TEST_CHECK(get_column_storage(&fork, archetype_index) == get_column_storage(&parent, archetype_index));
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&fork));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&parent));
+}
+
+/* @brief A writing system copies the columns it iterates only on the ticks it runs */
+static void test_skipped_systems_keep_columns_shared(void) {
+	maybe_world_t parent;
+	maybe_world_t fork;
+	const maybe_system_schedule_t every_other_tick = { MAYBE_SYSTEM_RATE_VARIABLE, 2, 1, 0 };
+	uint32_t archetype_index;
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_init(&parent));
+	MAYBE_REGISTER_COMPONENT_TYPE(&parent, value_t);
+	archetype_index = add_entities(&parent, FORK_TEST_ENTITIES);
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_register_system_with_schedule(
+		&parent, increment_values, every_other_tick, 1, MAYBE_COMPONENT_ID(value_t)
+	));
+
+	/* The first advance is tick 0, where the system does not run */
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_fork(&fork, &parent));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_advance(&fork, 0.0));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_advance(&parent, 0.0));
+	TEST_CHECK(get_column_storage(&fork, archetype_index) == get_column_storage(&parent, archetype_index));
+
+	/* On tick 1 it runs, and the fork gets its own copy */
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_advance(&fork, 0.0));
+	TEST_CHECK(get_column_storage(&fork, archetype_index) != get_column_storage(&parent, archetype_index));
+	check_values(&fork, FORK_TEST_ENTITIES, 1);
+	check_values(&parent, FORK_TEST_ENTITIES, 0);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&fork));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&parent));
+}
+
+/* @brief A system that writes through a component iterator in a fork does not change the parent */
+static void test_iterator_writes_copy(void) {
+	maybe_world_t parent;
+	maybe_world_t fork;
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_init(&parent));
+	MAYBE_REGISTER_COMPONENT_TYPE(&parent, value_t);
+	(void)add_entities(&parent, FORK_TEST_ENTITIES);
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_register_system(&parent, increment_values_with_iterator, 1, MAYBE_COMPONENT_ID(value_t)));
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_fork(&fork, &parent));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_update(&fork));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_update(&fork));
+	check_values(&fork, FORK_TEST_ENTITIES, 2);
+	check_values(&parent, FORK_TEST_ENTITIES, 0);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_update(&parent));
+	check_values(&fork, FORK_TEST_ENTITIES, 2);
+	check_values(&parent, FORK_TEST_ENTITIES, 1);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&fork));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&parent));
+}
+
+/*
+ * @brief Change the entities of a world the way the fork tests do, by their ID modulo 4
+ *
+ * Level 1 adds 1000 to the value of 0, removes 1, gives 2 an other_t, and leaves 3 alone.
+ * Level 2 adds 1000 to the value of 0 again, and removes 3. Both add an entity with only an other_t.
+ *
+ * @return The ID of the added entity
+ * */
+static maybe_entity_t change_entities(
+	maybe_world_t* world,
+	uint32_t level
+) {
+	maybe_entity_t entity;
+	value_t* value;
+	other_t other;
+
+	for (entity = 0; entity < FORK_TEST_CHANGED_ENTITIES; entity++) {
+		switch (entity % 4) {
+		case 0:
+			TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_get_component(world, entity, MAYBE_COMPONENT_ID(value_t), (void**)&value));
+			value->value += 1000;
+			break;
+		case 1:
+			if (1 == level) {
+				TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_remove_entity(world, entity));
+			}
+			break;
+		case 2:
+			if (1 == level) {
+				other.value = (uint32_t)entity * 2;
+				TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_add_component(world, entity, MAYBE_COMPONENT_ID(other_t)));
+				TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_set_component(world, entity, MAYBE_COMPONENT_ID(other_t), &other));
+			}
+			break;
+		default:
+			if (2 == level) {
+				TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_remove_entity(world, entity));
+			}
+			break;
+		}
+	}
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_add_entity(world, 1, &entity, MAYBE_COMPONENT_ID(other_t)));
+
+	return entity;
+}
+
+/* @brief Check that a world has the changes of change_entities up to a level, 0 for none */
+static void check_changes(
+	maybe_world_t* world,
+	uint32_t levels,
+	maybe_entity_t added_entity
+) {
+	maybe_entity_t entity;
+	value_t* value;
+	other_t* other;
+	uint32_t wrong_count = 0;
+	maybe_error_t result;
+
+	for (entity = 0; entity < FORK_TEST_CHANGED_ENTITIES; entity++) {
+		value = NULL;
+		other = NULL;
+		result = maybe_world_get_component(world, entity, MAYBE_COMPONENT_ID(value_t), (void**)&value);
+
+		switch (entity % 4) {
+		case 0:
+			wrong_count += (MAYBE_ERROR_SUCCESS != result) || (value->value != (uint32_t)entity + (1000 * levels));
+			break;
+		case 1:
+			wrong_count += (MAYBE_ERROR_ECS_WORLD_ENTITY_NOT_FOUND != result) && (0 != levels);
+			wrong_count += (MAYBE_ERROR_SUCCESS != result) && (0 == levels);
+			break;
+		case 2:
+			wrong_count += (MAYBE_ERROR_SUCCESS != result) || (value->value != (uint32_t)entity);
+			result = maybe_world_get_component(world, entity, MAYBE_COMPONENT_ID(other_t), (void**)&other);
+			wrong_count += (MAYBE_ERROR_SUCCESS != result) && (0 != levels);
+			wrong_count += (MAYBE_ERROR_SUCCESS == result) && (other->value != (uint32_t)entity * 2);
+			wrong_count += (MAYBE_ERROR_ECS_WORLD_COMPONENT_NOT_FOUND != result) && (0 == levels);
+			break;
+		default:
+			wrong_count += (MAYBE_ERROR_ECS_WORLD_ENTITY_NOT_FOUND != result) && (levels >= 2);
+			wrong_count += ((MAYBE_ERROR_SUCCESS != result) || (value->value != (uint32_t)entity)) && (levels < 2);
+			break;
+		}
+	}
+
+	TEST_CHECK(0 == wrong_count);
+
+	result = maybe_world_get_component(world, added_entity, MAYBE_COMPONENT_ID(other_t), (void**)&other);
+	TEST_CHECK((0 == levels) ? (MAYBE_ERROR_ECS_WORLD_ENTITY_NOT_FOUND == result) : (MAYBE_ERROR_SUCCESS == result));
+}
+
+/* @brief Writes, removals and added components stay in the fork that made them, also for a fork of a fork */
+static void test_changes_stay_in_fork(void) {
+	maybe_world_t parent;
+	maybe_world_t fork;
+	maybe_world_t nested_fork;
+	maybe_entity_t added_entity;
+	maybe_entity_t nested_added_entity;
+	other_t* other;
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_init(&parent));
+	MAYBE_REGISTER_COMPONENT_TYPE(&parent, value_t);
+	MAYBE_REGISTER_COMPONENT_TYPE(&parent, other_t);
+	(void)add_entities(&parent, FORK_TEST_CHANGED_ENTITIES);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_fork(&fork, &parent));
+	added_entity = change_entities(&fork, 1);
+	check_changes(&fork, 1, added_entity);
+	check_changes(&parent, 0, added_entity);
+
+	/* The parent's archetypes can not change while it has forks */
+	TEST_CHECK(MAYBE_ERROR_ECS_WORLD_HAS_FORKS == maybe_world_remove_entity(&parent, 3));
+
+	/* A fork of the fork starts from the fork's records, which it copies from the chain when it changes them */
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_fork(&nested_fork, &fork));
+	check_changes(&nested_fork, 1, added_entity);
+	nested_added_entity = change_entities(&nested_fork, 2);
+	TEST_CHECK(nested_added_entity != added_entity);
+	check_changes(&nested_fork, 2, added_entity);
+	check_changes(&fork, 1, added_entity);
+	TEST_CHECK(MAYBE_ERROR_ECS_WORLD_ENTITY_NOT_FOUND == maybe_world_get_component(&fork, nested_added_entity, MAYBE_COMPONENT_ID(other_t), (void**)&other));
+	check_changes(&parent, 0, added_entity);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&nested_fork));
+	check_changes(&fork, 1, added_entity);
+	check_changes(&parent, 0, added_entity);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&fork));
+	check_changes(&parent, 0, added_entity);
+
+	/* Without forks the parent can change again */
+	added_entity = change_entities(&parent, 1);
+	check_changes(&parent, 1, added_entity);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&parent));
+}
+
+int main(void) {
+	test_updates_keep_columns_shared();
+	test_skipped_systems_keep_columns_shared();
+	test_iterator_writes_copy();
+	test_changes_stay_in_fork();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,435 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <common/error.h>
+#include <common/map/map.h>
+
+#include "test.h"
+
+#define MAP_TEST_KEY_SPACE (20000)
+#define MAP_TEST_OPERATIONS (600000)
+
+/* The control bytes of empty and deleted slots, full slots have the top bit set */
+#define MAP_TEST_CONTROL_EMPTY (0)
+#define MAP_TEST_CONTROL_DELETED (1)
+
+#define MAP_TEST_MAX_LOAD(capacity) ((capacity) - (capacity) / 8)
+
+/* @brief The keys and values a map should have */
+typedef struct {
+	bool is_present[MAP_TEST_KEY_SPACE];
+	uint64_t values[MAP_TEST_KEY_SPACE];
+	uint32_t count;
+} reference_t;
+
+static reference_t reference;
+
+/* @brief A small deterministic random number generator, so a failure can be reproduced */
+static uint32_t next_random(
+	uint64_t* state
+) {
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+
+	return (uint32_t)(*state >> 32);
+}
+
+/* @brief A hash function that puts keys with the same upper 16 bits, their class, in the same probe sequence */
+static uint32_t class_hash(
+	uint8_t* buffer,
+	uint32_t size
+) {
+	(void)size;
+
+	return *(uint32_t*)buffer >> 16;
+}
+
+/* @brief Check every key of the key space against the reference */
+static void check_reference(
+	maybe_map_t* map
+) {
+	uint64_t* value;
+	uint32_t wrong_count = 0;
+
+	for (uint32_t key = 0; key < MAP_TEST_KEY_SPACE; key++) {
+		value = NULL;
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_get(map, &key, sizeof(key), (void**)&value));
+		if (reference.is_present[key]) {
+			wrong_count += (NULL == value) || (*value != reference.values[key]);
+		} else {
+			wrong_count += (NULL != value);
+		}
+	}
+
+	TEST_CHECK(0 == wrong_count);
+	TEST_CHECK(reference.count == map->count);
+}
+
+/* @brief Set a key in a map and in the reference */
+static void set_key(
+	maybe_map_t* map,
+	uint32_t key,
+	uint64_t value
+) {
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_set(map, &key, sizeof(key), &value));
+	reference.count += !reference.is_present[key];
+	reference.is_present[key] = true;
+	reference.values[key] = value;
+}
+
+/* @brief Remove a key from a map and from the reference */
+static void remove_key(
+	maybe_map_t* map,
+	uint32_t key
+) {
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_remove(map, &key, sizeof(key)));
+	reference.count -= reference.is_present[key];
+	reference.is_present[key] = false;
+}
+
+/* @brief Set new keys until the map starts an incremental rehash, and return the next new key */
+static uint32_t start_migration(
+	maybe_map_t* map
+) {
+	uint32_t key;
+
+	memset(&reference, 0, sizeof(reference));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_init(map, sizeof(uint32_t), sizeof(uint64_t), 0, maybe_map_default_hash_function));
+
+	for (key = 0; (key < MAP_TEST_KEY_SPACE) && (NULL == map->old_table.control); key++) {
+		set_key(map, key, key);
+	}
+
+	TEST_CHECK(NULL != map->old_table.control);
+	TEST_CHECK(map->old_table.capacity >= MAYBE_MAP_INCREMENTAL_CAPACITY);
+	TEST_CHECK(0 == map->migrate_cursor);
+
+	return key;
+}
+
+/* @brief Find the key of the last full slot of the old table, which the rehash migrates last */
+static uint32_t find_last_old_key(
+	maybe_map_t* map
+) {
+	uint32_t index = map->old_table.capacity;
+
+	while ((index > map->migrate_cursor) && (map->old_table.control[index - 1] >= 0)) {
+		index--;
+	}
+	TEST_CHECK(index > map->migrate_cursor);
+
+	return *(uint32_t*)(map->old_table.slots + (size_t)(index - 1) * map->slot_size);
+}
+
+/* @brief Set, replace, get and remove random keys, growing the map and then mostly emptying it */
+static void test_random_operations(void) {
+	maybe_map_t map;
+	uint64_t state = 0x2545F4914F6CDD1Dull;
+	uint64_t* found;
+	uint64_t value;
+	uint32_t i, key, operation, set_percent;
+	uint32_t wrong_count = 0;
+
+	memset(&reference, 0, sizeof(reference));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_init(&map, sizeof(uint32_t), sizeof(uint64_t), 0, maybe_map_default_hash_function));
+
+	for (i = 0; i < MAP_TEST_OPERATIONS; i++) {
+		/* A third of the operations mostly set, a third mostly remove, and a third do both equally */
+		set_percent = (i < (MAP_TEST_OPERATIONS / 3)) ? 80 : ((i < (2 * MAP_TEST_OPERATIONS / 3)) ? 20 : 50);
+		key = next_random(&state) % MAP_TEST_KEY_SPACE;
+		operation = next_random(&state) % 100;
+
+		if (operation < set_percent) {
+			value = ((uint64_t)key << 32) | i;
+			TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_set(&map, &key, sizeof(key), &value));
+			reference.count += !reference.is_present[key];
+			reference.is_present[key] = true;
+			reference.values[key] = value;
+		} else if (operation < 95) {
+			TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_remove(&map, &key, sizeof(key)));
+			reference.count -= reference.is_present[key];
+			reference.is_present[key] = false;
+		} else {
+			found = NULL;
+			TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_get(&map, &key, sizeof(key), (void**)&found));
+			wrong_count += reference.is_present[key] ? ((NULL == found) || (*found != reference.values[key])) : (NULL != found);
+		}
+
+		if (0 == (i % (MAP_TEST_OPERATIONS / 12))) {
+			check_reference(&map);
+		}
+	}
+
+	TEST_CHECK(0 == wrong_count);
+	check_reference(&map);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_free(&map));
+}
+
+/* @brief A removed key's slot is deleted only if its group is full, and a new key reuses the deleted slot */
+static void test_tombstones(void) {
+	maybe_map_t map;
+	uint64_t value = 7;
+	uint64_t* found;
+	uint32_t key;
+
+	/* 2 groups, every key is of class 0 and starts probing at the same one, so the first 16 keys fill it */
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_init(&map, sizeof(uint32_t), sizeof(uint64_t), MAP_TEST_MAX_LOAD(32), class_hash));
+	TEST_CHECK(2 * MAYBE_MAP_GROUP_WIDTH == map.table.capacity);
+	for (key = 0; key < 20; key++) {
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_set(&map, &key, sizeof(key), &value));
+	}
+
+	/* Slot 3 is in the full group, so lookups of the keys after it still have to probe past it */
+	key = 3;
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_remove(&map, &key, sizeof(key)));
+	TEST_CHECK(1 == map.deleted_count);
+	TEST_CHECK(MAP_TEST_CONTROL_DELETED == map.table.control[3]);
+
+	/* Slot 16 is in the group that has empty slots, so no lookup probes past it */
+	key = 16;
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_remove(&map, &key, sizeof(key)));
+	TEST_CHECK(1 == map.deleted_count);
+	TEST_CHECK(MAP_TEST_CONTROL_EMPTY == map.table.control[16]);
+
+	for (key = 0; key < 20; key++) {
+		found = NULL;
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_get(&map, &key, sizeof(key), (void**)&found));
+		TEST_CHECK(((3 == key) || (16 == key)) ? (NULL == found) : ((NULL != found) && (7 == *found)));
+	}
+
+	/* The first free slot of the probe sequence is the deleted one */
+	key = 100;
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_set(&map, &key, sizeof(key), &value));
+	TEST_CHECK(0 == map.deleted_count);
+	TEST_CHECK(map.table.control[3] < 0);
+	TEST_CHECK(19 == map.count);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_free(&map));
+}
+
+/* @brief Find the first group whose slots are all empty */
+static uint32_t find_empty_group(
+	maybe_map_table_t* table
+) {
+	uint32_t group, slot;
+
+	for (group = 0; group < (table->capacity / MAYBE_MAP_GROUP_WIDTH); group++) {
+		for (slot = 0; (slot < MAYBE_MAP_GROUP_WIDTH) && (MAP_TEST_CONTROL_EMPTY == table->control[group * MAYBE_MAP_GROUP_WIDTH + slot]); slot++) {
+		}
+		if (MAYBE_MAP_GROUP_WIDTH == slot) {
+			break;
+		}
+	}
+
+	return group;
+}
+
+/* @brief Find a key class whose probe sequence starts at a group of a table with a capacity */
+static uint32_t find_class_starting_at(
+	uint32_t capacity,
+	uint32_t group
+) {
+	maybe_map_t map;
+	uint64_t value = 0;
+	uint32_t key_class, key, index;
+
+	for (key_class = 1; key_class < 1000; key_class++) {
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_init(&map, sizeof(uint32_t), sizeof(uint64_t), MAP_TEST_MAX_LOAD(capacity), class_hash));
+		key = key_class << 16;
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_set(&map, &key, sizeof(key), &value));
+		for (index = 0; (index < map.table.capacity) && (map.table.control[index] >= 0); index++) {
+		}
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_free(&map));
+
+		if ((index / MAYBE_MAP_GROUP_WIDTH) == group) {
+			break;
+		}
+	}
+
+	return key_class;
+}
+
+/* @brief A table whose used slots are mostly deleted is rehashed without growing */
+static void test_same_size_rehash(void) {
+	maybe_map_t map;
+	uint64_t value;
+	uint64_t* found;
+	int8_t* control;
+	uint32_t key, key_class, i;
+
+	/* 4 groups, the first 48 keys of class 0 fill 3 of them */
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_init(&map, sizeof(uint32_t), sizeof(uint64_t), MAP_TEST_MAX_LOAD(64), class_hash));
+	TEST_CHECK(64 == map.table.capacity);
+	for (key = 0; key < 48; key++) {
+		value = key;
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_set(&map, &key, sizeof(key), &value));
+	}
+
+	/* The groups stay without empty slots, so every removed key leaves a deleted slot behind */
+	for (key = 0; key < 48; key++) {
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_remove(&map, &key, sizeof(key)));
+	}
+	TEST_CHECK(0 == map.count);
+	TEST_CHECK(48 == map.deleted_count);
+
+	/* Keys that start probing at the empty group never reach the deleted slots, so the table fills up */
+	key_class = find_class_starting_at(map.table.capacity, find_empty_group(&map.table));
+	control = map.table.control;
+	for (i = 0; i < 8; i++) {
+		key = (key_class << 16) | i;
+		value = key;
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_set(&map, &key, sizeof(key), &value));
+	}
+	TEST_CHECK(control == map.table.control);
+	TEST_CHECK(48 == map.deleted_count);
+
+	/* 8 pairs in a table with room for 56, so it is rehashed at the same size */
+	key = (key_class << 16) | 8;
+	value = key;
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_set(&map, &key, sizeof(key), &value));
+	TEST_CHECK(control != map.table.control);
+	TEST_CHECK(64 == map.table.capacity);
+	TEST_CHECK(0 == map.deleted_count);
+	TEST_CHECK(NULL == map.old_table.control);
+	TEST_CHECK(9 == map.count);
+
+	for (i = 0; i < 9; i++) {
+		key = (key_class << 16) | i;
+		found = NULL;
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_get(&map, &key, sizeof(key), (void**)&found));
+		TEST_CHECK((NULL != found) && (key == *found));
+	}
+	for (key = 0; key < 48; key++) {
+		found = NULL;
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_get(&map, &key, sizeof(key), (void**)&found));
+		TEST_CHECK(NULL == found);
+	}
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_free(&map));
+}
+
+/* @brief Gets, removes and overwrites of keys the rehash has not migrated yet */
+static void test_migration(void) {
+	maybe_map_t map;
+	uint64_t* found;
+	uint32_t next_key, key, old_count, i;
+	uint32_t wrong_count = 0;
+
+	next_key = start_migration(&map);
+
+	/* Gets find the keys in either table, and do not move the rehash along */
+	old_count = map.old_count;
+	check_reference(&map);
+	TEST_CHECK(0 == map.migrate_cursor);
+	TEST_CHECK(old_count == map.old_count);
+
+	/* A removed key is deleted in the old table, so the rehash does not bring it back */
+	key = find_last_old_key(&map);
+	remove_key(&map, key);
+	TEST_CHECK(old_count - 1 == map.old_count);
+	found = NULL;
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_get(&map, &key, sizeof(key), (void**)&found));
+	TEST_CHECK(NULL == found);
+
+	/* An overwritten key keeps its slot in the old table, and the rehash moves the new value */
+	key = find_last_old_key(&map);
+	set_key(&map, key, 123456789);
+	TEST_CHECK(NULL != map.old_table.control);
+	TEST_CHECK(old_count - 1 - MAYBE_MAP_MIGRATE_SLOTS <= map.old_count);
+	check_reference(&map);
+
+	/* Interleave new keys with removes and overwrites of keys on both sides of the cursor */
+	for (i = 0; NULL != map.old_table.control; i++) {
+		set_key(&map, next_key++, i);
+		if (NULL != map.old_table.control) {
+			remove_key(&map, find_last_old_key(&map));
+			set_key(&map, find_last_old_key(&map), (uint64_t)i << 32);
+		}
+		remove_key(&map, i * 7);
+		set_key(&map, i * 7 + 1, i);
+
+		found = NULL;
+		key = i * 7 + 2;
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_get(&map, &key, sizeof(key), (void**)&found));
+		wrong_count += (NULL == found) || (*found != reference.values[key]);
+	}
+
+	TEST_CHECK(0 == wrong_count);
+	TEST_CHECK(0 == map.old_count);
+	TEST_CHECK(0 == map.migrate_cursor);
+	check_reference(&map);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_free(&map));
+}
+
+/* @brief Reserving more room than the table has left finishes the rehash before growing */
+static void test_reserve_during_migration(void) {
+	maybe_map_t map;
+	int8_t* control;
+	uint32_t next_key, capacity, i;
+
+	next_key = start_migration(&map);
+	capacity = map.table.capacity;
+
+	/* Room the table already has does not touch the rehash */
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_reserve(&map, 10));
+	TEST_CHECK(NULL != map.old_table.control);
+	TEST_CHECK(capacity == map.table.capacity);
+
+	/* The table fills up before the rehash ends, so it migrates every old pair at once and starts a new rehash from the table */
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_reserve(&map, capacity));
+	TEST_CHECK(capacity == map.old_table.capacity);
+	TEST_CHECK(map.count == map.old_count);
+	TEST_CHECK(0 == map.migrate_cursor);
+	TEST_CHECK(capacity < map.table.capacity);
+	check_reference(&map);
+
+	/* Setting the reserved keys does not resize the table again */
+	control = map.table.control;
+	for (i = 0; i < capacity; i++) {
+		set_key(&map, next_key++, i);
+	}
+	TEST_CHECK(control == map.table.control);
+	check_reference(&map);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_free(&map));
+}
+
+/* @brief Keys of another size are rejected without changing the map */
+static void test_key_size_mismatch(void) {
+	maybe_map_t map;
+	uint64_t key = 5;
+	uint64_t value = 9;
+	uint64_t* found = NULL;
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_init(&map, sizeof(uint32_t), sizeof(uint64_t), 0, maybe_map_default_hash_function));
+
+	TEST_CHECK(MAYBE_ERROR_MAP_INVALID_PARAM == maybe_map_set(&map, &key, sizeof(key), &value));
+	TEST_CHECK(0 == map.count);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_set(&map, &key, sizeof(uint32_t), &value));
+	TEST_CHECK(MAYBE_ERROR_MAP_INVALID_PARAM == maybe_map_get(&map, &key, sizeof(key), (void**)&found));
+	TEST_CHECK(MAYBE_ERROR_MAP_INVALID_PARAM == maybe_map_remove(&map, &key, sizeof(key)));
+	TEST_CHECK(1 == map.count);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_get(&map, &key, sizeof(uint32_t), (void**)&found));
+	TEST_CHECK((NULL != found) && (9 == *found));
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_map_free(&map));
+
+	TEST_CHECK(MAYBE_ERROR_MAP_INVALID_PARAM == maybe_map_init(&map, 0, sizeof(uint64_t), 0, maybe_map_default_hash_function));
+}
+
+int main(void) {
+	test_random_operations();
+	test_tombstones();
+	test_same_size_rehash();
+	test_migration();
+	test_reserve_during_migration();
+	test_key_size_mismatch();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,186 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <common/error.h>
+#include <common/page_store/page_store.h>
+#include <common/vector/vector.h>
+#include <ecs/ecs.h>
+
+#include "test.h"
+
+#define MERGE_TEST_ENTITIES (5000)
+
+typedef struct {
+	uint32_t value;
+} value_t;
+
+MAYBE_DEFINE_COMPONENT_TYPE(value_t)
+
+/* @brief Check that every mapped entity kept its value in the destination */
+static void check_values(
+	maybe_world_t* world,
+	maybe_vector_t* entity_map
+) {
+	maybe_world_entity_mapping_t* mapping;
+	value_t* value;
+
+	TEST_CHECK(MERGE_TEST_ENTITIES == entity_map->length);
+	for (uint32_t i = 0; i < entity_map->length; i++) {
+		mapping = &MAYBE_VECTOR_ELEMENT(*entity_map, maybe_world_entity_mapping_t, i);
+		value = NULL;
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_get_component(world, mapping->destination, MAYBE_COMPONENT_ID(value_t), (void**)&value));
+		TEST_CHECK((NULL != value) && ((uint32_t)mapping->source * 3 == value->value));
+	}
+}
+
+/* @brief Fill a world with entities whose value is three times their ID */
+static void add_entities(
+	maybe_world_t* world
+) {
+	maybe_entity_t entity;
+	value_t value;
+
+	for (uint32_t i = 0; i < MERGE_TEST_ENTITIES; i++) {
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_add_entity(world, 1, &entity, MAYBE_COMPONENT_ID(value_t)));
+		value.value = (uint32_t)entity * 3;
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_set_component(world, entity, MAYBE_COMPONENT_ID(value_t), &value));
+	}
+}
+
+/* @brief Columns merged out of a world with a page store do not stay in its store */
+static void test_merge_from_page_store(void) {
+	maybe_world_t source;
+	maybe_world_t destination;
+	maybe_page_store_t store;
+	maybe_vector_t entity_map;
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_page_store_init(&store, "/var/tmp/maybe_merge_test.pages", 0));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_init(&source));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_init(&destination));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_vector_init(&entity_map, sizeof(maybe_world_entity_mapping_t), 0));
+	MAYBE_REGISTER_COMPONENT_TYPE(&source, value_t);
+	MAYBE_REGISTER_COMPONENT_TYPE(&destination, value_t);
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_set_page_store(&source, &store));
+
+	add_entities(&source);
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_merge(&destination, &source, NULL, &entity_map));
+
+	/* The destination must not read the store after it is gone */
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&source));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_page_store_free(&store));
+	check_values(&destination, &entity_map);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_vector_free(&entity_map));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&destination));
+}
+
+/* @brief Columns merged into a world with a page store are moved to its store */
+static void test_merge_into_page_store(void) {
+	maybe_world_t source;
+	maybe_world_t destination;
+	maybe_page_store_t store;
+	maybe_vector_t entity_map;
+	maybe_world_entity_mapping_t* mapping;
+	value_t* value = NULL;
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_page_store_init(&store, "/var/tmp/maybe_merge_test.pages", 0));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_init(&source));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_init(&destination));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_vector_init(&entity_map, sizeof(maybe_world_entity_mapping_t), 0));
+	MAYBE_REGISTER_COMPONENT_TYPE(&source, value_t);
+	MAYBE_REGISTER_COMPONENT_TYPE(&destination, value_t);
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_set_page_store(&destination, &store));
+
+	add_entities(&source);
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_merge(&destination, &source, NULL, &entity_map));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&source));
+	check_values(&destination, &entity_map);
+
+	mapping = &MAYBE_VECTOR_ELEMENT(entity_map, maybe_world_entity_mapping_t, 0);
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_get_component(&destination, mapping->destination, MAYBE_COMPONENT_ID(value_t), (void**)&value));
+	TEST_CHECK(maybe_page_store_contains(&store, value));
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_vector_free(&entity_map));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&destination));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_page_store_free(&store));
+}
+
+/* @brief Merging into an archetype with rows appends to it, and the entities keep their enabled state */
+static void test_merge_into_rows(void) {
+	maybe_world_t source;
+	maybe_world_t destination;
+	maybe_vector_t entity_map;
+	maybe_world_entity_mapping_t* mapping;
+	maybe_entity_t entity;
+	bool enabled;
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_init(&source));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_init(&destination));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_vector_init(&entity_map, sizeof(maybe_world_entity_mapping_t), 0));
+	MAYBE_REGISTER_COMPONENT_TYPE(&source, value_t);
+	MAYBE_REGISTER_COMPONENT_TYPE(&destination, value_t);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_add_entity(&destination, 1, &entity, MAYBE_COMPONENT_ID(value_t)));
+	add_entities(&source);
+	for (maybe_entity_t i = 0; i < MERGE_TEST_ENTITIES; i += 3) {
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_set_entity_enabled(&source, i, false));
+	}
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_merge(&destination, &source, NULL, &entity_map));
+	check_values(&destination, &entity_map);
+
+	for (uint32_t i = 0; i < entity_map.length; i++) {
+		mapping = &MAYBE_VECTOR_ELEMENT(entity_map, maybe_world_entity_mapping_t, i);
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_is_entity_enabled(&destination, mapping->destination, &enabled));
+		TEST_CHECK(enabled == (0 != (mapping->source % 3)));
+		TEST_CHECK(MAYBE_ERROR_ECS_WORLD_ENTITY_NOT_FOUND == maybe_world_is_entity_enabled(&source, mapping->source, &enabled));
+	}
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_vector_free(&entity_map));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&source));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&destination));
+}
+
+/* @brief Merging out of a fork leaves its parent's entities alone */
+static void test_merge_from_fork(void) {
+	maybe_world_t parent;
+	maybe_world_t fork;
+	maybe_world_t destination;
+	maybe_vector_t entity_map;
+	maybe_world_entity_mapping_t* mapping;
+	value_t* value;
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_init(&parent));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_init(&destination));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_vector_init(&entity_map, sizeof(maybe_world_entity_mapping_t), 0));
+	MAYBE_REGISTER_COMPONENT_TYPE(&parent, value_t);
+	MAYBE_REGISTER_COMPONENT_TYPE(&destination, value_t);
+
+	add_entities(&parent);
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_fork(&fork, &parent));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_merge(&destination, &fork, NULL, &entity_map));
+	check_values(&destination, &entity_map);
+
+	for (uint32_t i = 0; i < entity_map.length; i++) {
+		mapping = &MAYBE_VECTOR_ELEMENT(entity_map, maybe_world_entity_mapping_t, i);
+		TEST_CHECK(MAYBE_ERROR_ECS_WORLD_ENTITY_NOT_FOUND == maybe_world_get_component(&fork, mapping->source, MAYBE_COMPONENT_ID(value_t), (void**)&value));
+
+		value = NULL;
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_get_component(&parent, mapping->source, MAYBE_COMPONENT_ID(value_t), (void**)&value));
+		TEST_CHECK((NULL != value) && ((uint32_t)mapping->source * 3 == value->value));
+	}
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&fork));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_vector_free(&entity_map));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&parent));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&destination));
+}
+
+int main(void) {
+	test_merge_from_page_store();
+	test_merge_into_page_store();
+	test_merge_into_rows();
+	test_merge_from_fork();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,131 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <common/error.h>
+#include <ecs/ecs.h>
+#include <ecs/system.h>
+#include <ecs/query.h>
+
+#include "test.h"
+
+#define QUERY_TEST_ENTITIES (300)
+#define QUERY_TEST_STOP_AFTER (150)
+
+typedef struct {
+	uint32_t visits;
+} visits_t;
+
+typedef struct {
+	uint32_t value;
+} tag_t;
+
+typedef struct {
+	uint32_t value;
+} material_t;
+
+MAYBE_DEFINE_COMPONENT_TYPE(visits_t)
+MAYBE_DEFINE_COMPONENT_TYPE(tag_t)
+MAYBE_DEFINE_COMPONENT_TYPE(material_t)
+
+static uint32_t system_visited_count = 0;
+
+/* @brief Count the visited entities and count the visits of every entity, for the entities of all the archetypes */
+static uint32_t count_visits(
+	maybe_world_t* world,
+	uint32_t* total_visits
+) {
+	uint32_t visited_count = 0;
+
+	*total_visits = 0;
+	MAYBE_QUERY_EACH(world, (visits_t, visits)) {
+		visited_count += (visits->visits > 0);
+		*total_visits += visits->visits;
+		visits->visits = 0;
+	}
+
+	return visited_count;
+}
+
+void stop_system_query(void* system) {
+	system_visited_count = 0;
+
+	MAYBE_SYSTEM_QUERY_EACH(system, (visits_t, visits)) {
+		if (QUERY_TEST_STOP_AFTER == system_visited_count) {
+			MAYBE_QUERY_BREAK();
+		}
+
+		visits->visits++;
+		system_visited_count++;
+	}
+}
+
+/* @brief MAYBE_QUERY_BREAK stops every kind of query loop after the current entity, also across archetypes */
+static void test_break(void) {
+	maybe_world_t world;
+	maybe_entity_t entity;
+	uint32_t visited_count, total_visits;
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_init(&world));
+	MAYBE_REGISTER_COMPONENT_TYPE(&world, visits_t);
+	MAYBE_REGISTER_COMPONENT_TYPE(&world, tag_t);
+	MAYBE_REGISTER_SHARED_COMPONENT_TYPE(&world, material_t);
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_register_system(&world, stop_system_query, 1, MAYBE_COMPONENT_ID(visits_t)));
+
+	/* Three archetypes of 100 entities, so the loops stop in the middle of the second one */
+	for (uint32_t i = 0; i < QUERY_TEST_ENTITIES; i++) {
+		if (i < 100) {
+			TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_add_entity(&world, 1, &entity, MAYBE_COMPONENT_ID(visits_t)));
+		} else {
+			TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_add_entity(&world, 2, &entity, MAYBE_COMPONENT_ID(visits_t), MAYBE_COMPONENT_ID(tag_t)));
+			TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_set_shared_component(&world, entity, MAYBE_COMPONENT_ID(material_t), &(material_t){ i / 200 }));
+		}
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_set_component(&world, entity, MAYBE_COMPONENT_ID(visits_t), &(visits_t){ 0 }));
+	}
+
+	visited_count = 0;
+	MAYBE_QUERY_EACH(&world, (visits_t, visits)) {
+		if (QUERY_TEST_STOP_AFTER == visited_count) {
+			MAYBE_QUERY_BREAK();
+		} else {
+			visits->visits++;
+		}
+
+		visited_count++;
+	}
+	TEST_CHECK(QUERY_TEST_STOP_AFTER == visited_count);
+	TEST_CHECK(QUERY_TEST_STOP_AFTER == count_visits(&world, &total_visits));
+	TEST_CHECK(QUERY_TEST_STOP_AFTER == total_visits);
+
+	visited_count = 0;
+	MAYBE_QUERY_EACH_SHARED(&world, (material_t, material), (visits_t, visits)) {
+		(void)material;
+		if (QUERY_TEST_STOP_AFTER / 2 == visited_count) {
+			MAYBE_QUERY_BREAK();
+		}
+
+		visits->visits++;
+		visited_count++;
+	}
+	TEST_CHECK(QUERY_TEST_STOP_AFTER / 2 == count_visits(&world, &total_visits));
+	TEST_CHECK(QUERY_TEST_STOP_AFTER / 2 == total_visits);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_update(&world));
+	TEST_CHECK(QUERY_TEST_STOP_AFTER == system_visited_count);
+	TEST_CHECK(QUERY_TEST_STOP_AFTER == count_visits(&world, &total_visits));
+
+	/* A plain break only skips to the next entity */
+	MAYBE_QUERY_EACH(&world, (visits_t, visits)) {
+		visits->visits++;
+		break;
+	}
+	TEST_CHECK(QUERY_TEST_ENTITIES == count_visits(&world, &total_visits));
+	TEST_CHECK(QUERY_TEST_ENTITIES == total_visits);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&world));
+}
+
+int main(void) {
+	test_break();
+
+	return TEST_RESULT();
+}
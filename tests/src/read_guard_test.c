@@ -0,0 +1,319 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <common/error.h>
+#include <common/vector/vector.h>
+#include <ecs/ecs.h>
+#include <ecs/read_guard.h>
+
+#include "test.h"
+
+#define READ_GUARD_TEST_ENTITIES (2000)
+#define READ_GUARD_TEST_GROWTH (5000)
+
+typedef struct {
+	uint32_t value;
+} value_t;
+
+typedef struct {
+	uint32_t value;
+} other_t;
+
+typedef struct {
+	uint32_t value;
+} third_t;
+
+MAYBE_DEFINE_COMPONENT_TYPE(value_t)
+MAYBE_DEFINE_COMPONENT_TYPE(other_t)
+MAYBE_DEFINE_COMPONENT_TYPE(third_t)
+
+/* @brief The steps the world's thread and the reader thread wait for each other at */
+typedef enum {
+	READ_GUARD_TEST_STAGE_STARTED,
+	READ_GUARD_TEST_STAGE_PINNED, /* The reader started its read */
+	READ_GUARD_TEST_STAGE_CHANGED, /* The world changed its archetypes */
+	READ_GUARD_TEST_STAGE_ENDED, /* The reader checked the rows of its view and ended its read */
+	READ_GUARD_TEST_STAGE_PUBLISHED, /* The world published a new view */
+	READ_GUARD_TEST_STAGE_DONE,
+} read_guard_test_stage_t;
+
+typedef struct {
+	maybe_world_read_guard_t* guard;
+	atomic_int stage;
+	uint32_t first_row_count; /* The rows of the view the reader held while the world changed */
+	uint32_t first_wrong_count; /* The rows of that view whose value does not match their entity */
+	uint32_t empty_archetype_count; /* The archetypes of the view a read got while the world was waiting for it */
+	uint32_t second_row_count;
+	uint32_t second_wrong_count;
+} read_guard_test_reader_t;
+
+/* @brief Wait until the other thread reaches a stage */
+static void wait_for_stage(
+	read_guard_test_reader_t* test,
+	read_guard_test_stage_t stage
+) {
+	while (atomic_load(&test->stage) < (int)stage) {
+		(void)sched_yield();
+	}
+}
+
+/* @brief Count the rows of a view and the rows whose value is not three times their entity */
+static void check_view(
+	const maybe_world_read_view_t* view,
+	uint32_t* row_count,
+	uint32_t* wrong_count
+) {
+	const value_t* values;
+	uint32_t i, row;
+
+	*row_count = 0;
+	*wrong_count = 0;
+	for (i = 0; i < view->archetype_count; i++) {
+		if (!maybe_world_read_find_column(&view->archetypes[i], MAYBE_COMPONENT_ID(value_t), (const void**)&values)) {
+			continue;
+		}
+
+		for (row = 0; row < view->archetypes[i].row_count; row++) {
+			*wrong_count += (values[row].value != (uint32_t)view->archetypes[i].entities[row] * 3);
+		}
+		*row_count += view->archetypes[i].row_count;
+	}
+}
+
+/* @brief Hold a view while the world changes, then read it and the view published after the change */
+static void* hold_view(
+	void* context
+) {
+	read_guard_test_reader_t* test = (read_guard_test_reader_t*)context;
+	const maybe_world_read_view_t* view;
+	uint32_t reader;
+
+	if (IS_FAILURE(maybe_world_read_guard_add_reader(test->guard, &reader))) {
+		atomic_store(&test->stage, READ_GUARD_TEST_STAGE_DONE);
+		return NULL;
+	}
+
+	view = maybe_world_read_begin(test->guard, reader);
+	atomic_store(&test->stage, READ_GUARD_TEST_STAGE_PINNED);
+	wait_for_stage(test, READ_GUARD_TEST_STAGE_CHANGED);
+
+	check_view(view, &test->first_row_count, &test->first_wrong_count);
+	maybe_world_read_end(test->guard, reader);
+	atomic_store(&test->stage, READ_GUARD_TEST_STAGE_ENDED);
+	wait_for_stage(test, READ_GUARD_TEST_STAGE_PUBLISHED);
+
+	view = maybe_world_read_begin(test->guard, reader);
+	check_view(view, &test->second_row_count, &test->second_wrong_count);
+	maybe_world_read_end(test->guard, reader);
+
+	(void)maybe_world_read_guard_remove_reader(test->guard, reader);
+	atomic_store(&test->stage, READ_GUARD_TEST_STAGE_DONE);
+
+	return NULL;
+}
+
+/* @brief Hold a view until the world gives up on retiring and waits for the read to end */
+static void* hold_view_until_waited_for(
+	void* context
+) {
+	read_guard_test_reader_t* test = (read_guard_test_reader_t*)context;
+	const maybe_world_read_view_t* view;
+	uint32_t reader;
+
+	if (IS_FAILURE(maybe_world_read_guard_add_reader(test->guard, &reader))) {
+		atomic_store(&test->stage, READ_GUARD_TEST_STAGE_DONE);
+		return NULL;
+	}
+
+	view = maybe_world_read_begin(test->guard, reader);
+	atomic_store(&test->stage, READ_GUARD_TEST_STAGE_PINNED);
+
+	/* The world publishes the empty view before it waits, and frees nothing the read can see until it ends */
+	while (0 != atomic_load(&test->guard->view)->archetype_count) {
+		(void)sched_yield();
+	}
+	check_view(view, &test->first_row_count, &test->first_wrong_count);
+	maybe_world_read_end(test->guard, reader);
+	wait_for_stage(test, READ_GUARD_TEST_STAGE_CHANGED);
+
+	/* Reads that start before the next publish get the empty view */
+	view = maybe_world_read_begin(test->guard, reader);
+	test->empty_archetype_count = view->archetype_count;
+	maybe_world_read_end(test->guard, reader);
+	atomic_store(&test->stage, READ_GUARD_TEST_STAGE_ENDED);
+	wait_for_stage(test, READ_GUARD_TEST_STAGE_PUBLISHED);
+
+	view = maybe_world_read_begin(test->guard, reader);
+	check_view(view, &test->second_row_count, &test->second_wrong_count);
+	maybe_world_read_end(test->guard, reader);
+
+	(void)maybe_world_read_guard_remove_reader(test->guard, reader);
+	atomic_store(&test->stage, READ_GUARD_TEST_STAGE_DONE);
+
+	return NULL;
+}
+
+/* @brief Add entities with a component and value_t, whose value is three times their ID */
+static void add_entities(
+	maybe_world_t* world,
+	uint32_t component_id,
+	uint32_t count,
+	maybe_entity_t* entities
+) {
+	maybe_entity_t entity;
+	value_t value;
+
+	for (uint32_t i = 0; i < count; i++) {
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_add_entity(world, 2, &entity, MAYBE_COMPONENT_ID(value_t), component_id));
+		value.value = (uint32_t)entity * 3;
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_set_component(world, entity, MAYBE_COMPONENT_ID(value_t), &value));
+		if (NULL != entities) {
+			entities[i] = entity;
+		}
+	}
+}
+
+/* @brief A world with READ_GUARD_TEST_ENTITIES entities in each of three archetypes */
+static void init_world(
+	maybe_world_t* world
+) {
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_init(world));
+	MAYBE_REGISTER_COMPONENT_TYPE(world, value_t);
+	MAYBE_REGISTER_COMPONENT_TYPE(world, other_t);
+	MAYBE_REGISTER_COMPONENT_TYPE(world, third_t);
+
+	add_entities(world, MAYBE_COMPONENT_ID(other_t), READ_GUARD_TEST_ENTITIES, NULL);
+	add_entities(world, MAYBE_COMPONENT_ID(third_t), READ_GUARD_TEST_ENTITIES, NULL);
+}
+
+/* @brief Storage the world grows, shrinks and frees stays readable until the reads that can see it end */
+static void test_retired_storage_stays_readable(void) {
+	maybe_world_t world;
+	maybe_world_read_guard_t guard;
+	read_guard_test_reader_t test = { 0 };
+	pthread_t thread;
+	maybe_entity_t* entities;
+	uint32_t component_id;
+	uint32_t i;
+
+	entities = (maybe_entity_t*)malloc((READ_GUARD_TEST_ENTITIES + READ_GUARD_TEST_GROWTH) * sizeof(maybe_entity_t));
+	TEST_CHECK(NULL != entities);
+
+	init_world(&world);
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_read_guard_init(&guard, &world));
+
+	test.guard = &guard;
+	atomic_init(&test.stage, READ_GUARD_TEST_STAGE_STARTED);
+	TEST_CHECK(0 == pthread_create(&thread, NULL, hold_view, &test));
+	wait_for_stage(&test, READ_GUARD_TEST_STAGE_PINNED);
+
+	/* Growing past their capacity moves every column and entity list the view points to */
+	add_entities(&world, MAYBE_COMPONENT_ID(other_t), READ_GUARD_TEST_GROWTH, entities);
+	add_entities(&world, MAYBE_COMPONENT_ID(third_t), READ_GUARD_TEST_GROWTH, NULL);
+
+	/* Shrink the first archetype, and empty and park the second */
+	for (i = 0; i < READ_GUARD_TEST_GROWTH - 100; i++) {
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_remove_entity(&world, entities[i]));
+	}
+	component_id = MAYBE_COMPONENT_ID(third_t);
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_remove_matching_entities(&world, 1, &component_id, NULL));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_compact(&world, 0.5f, 0, NULL));
+
+	/* Publishing frees only what no read can see, and the held view sees all of it */
+	for (i = 0; i < 3; i++) {
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_update(&world));
+	}
+	TEST_CHECK(guard.retired.length > 0);
+
+	atomic_store(&test.stage, READ_GUARD_TEST_STAGE_CHANGED);
+	wait_for_stage(&test, READ_GUARD_TEST_STAGE_ENDED);
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_update(&world));
+	TEST_CHECK(0 == guard.retired.length);
+	atomic_store(&test.stage, READ_GUARD_TEST_STAGE_PUBLISHED);
+
+	TEST_CHECK(0 == pthread_join(thread, NULL));
+	TEST_CHECK(2 * READ_GUARD_TEST_ENTITIES == test.first_row_count);
+	TEST_CHECK(0 == test.first_wrong_count);
+	TEST_CHECK(READ_GUARD_TEST_ENTITIES + 100 == test.second_row_count);
+	TEST_CHECK(0 == test.second_wrong_count);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&world));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_read_guard_free(&guard));
+	free(entities);
+}
+
+/* @brief Fails every allocation, so the guard can not retire storage */
+static void* fail_reallocate(
+	void* context,
+	void* memory,
+	size_t old_size,
+	size_t new_size
+) {
+	(void)context;
+	(void)memory;
+	(void)old_size;
+	(void)new_size;
+
+	return NULL;
+}
+
+static void heap_free(
+	void* context,
+	void* memory,
+	size_t size
+) {
+	(void)context;
+	(void)size;
+
+	free(memory);
+}
+
+/* @brief Storage that can not be retired is freed after the world waits for the reads that can see it */
+static void test_retire_fallback(void) {
+	maybe_world_t world;
+	maybe_world_read_guard_t guard;
+	read_guard_test_reader_t test = { 0 };
+	maybe_vector_allocator_t failing_allocator = { fail_reallocate, heap_free, NULL };
+	pthread_t thread;
+
+	init_world(&world);
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_read_guard_init(&guard, &world));
+
+	test.guard = &guard;
+	atomic_init(&test.stage, READ_GUARD_TEST_STAGE_STARTED);
+	TEST_CHECK(0 == pthread_create(&thread, NULL, hold_view_until_waited_for, &test));
+	wait_for_stage(&test, READ_GUARD_TEST_STAGE_PINNED);
+
+	/* Once the retired list is full, every storage the growth moves is freed right away */
+	guard.retired.allocator = &failing_allocator;
+	add_entities(&world, MAYBE_COMPONENT_ID(other_t), READ_GUARD_TEST_GROWTH, NULL);
+	add_entities(&world, MAYBE_COMPONENT_ID(third_t), READ_GUARD_TEST_GROWTH, NULL);
+	TEST_CHECK(guard.retired.length == guard.retired.capacity);
+
+	atomic_store(&test.stage, READ_GUARD_TEST_STAGE_CHANGED);
+	wait_for_stage(&test, READ_GUARD_TEST_STAGE_ENDED);
+	guard.retired.allocator = NULL;
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_update(&world));
+	atomic_store(&test.stage, READ_GUARD_TEST_STAGE_PUBLISHED);
+
+	TEST_CHECK(0 == pthread_join(thread, NULL));
+	TEST_CHECK(2 * READ_GUARD_TEST_ENTITIES == test.first_row_count);
+	TEST_CHECK(0 == test.first_wrong_count);
+	TEST_CHECK(0 == test.empty_archetype_count);
+	TEST_CHECK(2 * (READ_GUARD_TEST_ENTITIES + READ_GUARD_TEST_GROWTH) == test.second_row_count);
+	TEST_CHECK(0 == test.second_wrong_count);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&world));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_read_guard_free(&guard));
+}
+
+int main(void) {
+	test_retired_storage_stays_readable();
+	test_retire_fallback();
+
+	return TEST_RESULT();
+}
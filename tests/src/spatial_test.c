@@ -0,0 +1,92 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <common/error.h>
+#include <common/vector/vector.h>
+#include <ecs/ecs.h>
+#include <ecs/spatial.h>
+
+#include "test.h"
+
+#define SPATIAL_TEST_ENTITIES (10000)
+
+typedef struct {
+	float x;
+	float y;
+	float z;
+} position_t;
+
+MAYBE_DEFINE_COMPONENT_TYPE(position_t)
+
+/* @brief Whether the test disables an entity, in runs long enough to split chunks and short enough to leave single rows */
+static bool is_disabled(
+	uint32_t i
+) {
+	return ((i % 7) == 0) || ((i >= 3000) && (i < 5000));
+}
+
+/* @brief Disabled entities are left out of a rebuild, and found again once they are enabled */
+static void test_disabled_entities(void) {
+	maybe_world_t world;
+	maybe_spatial_index_t index;
+	maybe_vector_t results;
+	maybe_entity_t entities[SPATIAL_TEST_ENTITIES];
+	const maybe_spatial_index_config_t config = {
+		MAYBE_COMPONENT_ID(position_t), 0, 3, 4.0f, MAYBE_SYSTEM_RATE_VARIABLE
+	};
+	const float center[3] = { 0.0f, 0.0f, 0.0f };
+	uint32_t expected_count = 0;
+	uint32_t found_disabled = 0;
+	bool enabled;
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_init(&world));
+	MAYBE_REGISTER_COMPONENT_TYPE(&world, position_t);
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_spatial_index_init(&index, config));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_vector_init(&results, sizeof(maybe_spatial_result_t), 0));
+
+	for (uint32_t i = 0; i < SPATIAL_TEST_ENTITIES; i++) {
+		position_t position = { (float)(i % 100), (float)(i / 100), 0.0f };
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_add_entity(&world, 1, &entities[i], MAYBE_COMPONENT_ID(position_t)));
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_set_component(&world, entities[i], MAYBE_COMPONENT_ID(position_t), &position));
+		if (is_disabled(i)) {
+			TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_set_entity_enabled(&world, entities[i], false));
+		} else {
+			expected_count++;
+		}
+	}
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_spatial_index_rebuild(&index, &world, NULL));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_spatial_index_query_radius(&index, center, 1000.0f, &results));
+	TEST_CHECK(expected_count == results.length);
+	for (uint32_t i = 0; i < results.length; i++) {
+		maybe_spatial_result_t* result = &MAYBE_VECTOR_ELEMENT(results, maybe_spatial_result_t, i);
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_is_entity_enabled(&world, result->entity, &enabled));
+		found_disabled += !enabled;
+	}
+	TEST_CHECK(0 == found_disabled);
+
+	/* Entity 14 is disabled and alone at (14, 0) */
+	const float min[3] = { 13.5f, -0.5f, -0.5f };
+	const float max[3] = { 14.5f, 0.5f, 0.5f };
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_spatial_index_query_aabb(&index, min, max, &results));
+	TEST_CHECK(0 == results.length);
+
+	for (uint32_t i = 0; i < SPATIAL_TEST_ENTITIES; i++) {
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_set_entity_enabled(&world, entities[i], true));
+	}
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_spatial_index_rebuild(&index, &world, NULL));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_spatial_index_query_radius(&index, center, 1000.0f, &results));
+	TEST_CHECK(SPATIAL_TEST_ENTITIES == results.length);
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_spatial_index_query_aabb(&index, min, max, &results));
+	TEST_CHECK((1 == results.length) && (entities[14] == MAYBE_VECTOR_ELEMENT(results, maybe_spatial_result_t, 0).entity));
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_vector_free(&results));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_spatial_index_free(&index));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&world));
+}
+
+int main(void) {
+	test_disabled_entities();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,141 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <common/error.h>
+#include <ecs/ecs.h>
+#include <ecs/system.h>
+#include <ecs/query.h>
+
+#include "test.h"
+
+#define SYSTEM_TEST_ENTITIES (4000)
+#define SYSTEM_TEST_SLICES (4)
+
+typedef struct {
+	uint32_t query_visits;
+	uint32_t iterator_visits;
+} visits_t;
+
+typedef struct {
+	uint32_t value;
+} tag_t;
+
+MAYBE_DEFINE_COMPONENT_TYPE(visits_t)
+MAYBE_DEFINE_COMPONENT_TYPE(tag_t)
+
+void count_query_visits(void* system) {
+	MAYBE_SYSTEM_QUERY_EACH(system, (visits_t, visits)) {
+		visits->query_visits++;
+	}
+}
+
+void count_iterator_visits(void* system) {
+	maybe_system_component_iterator_t visits;
+
+	maybe_system_init_component_iterator(system, MAYBE_COMPONENT_ID(visits_t), &visits);
+
+	while (visits.current_component_pointer) {
+		((visits_t*)visits.current_component_pointer)->iterator_visits++;
+
+		maybe_system_component_iterator_get_next_component(system, &visits);
+	}
+}
+
+/* @brief Check that every live entity was visited a number of times by both systems, and disabled ones never */
+static void check_visits(
+	maybe_world_t* world,
+	const maybe_entity_t* entities,
+	const bool* is_live,
+	uint32_t expected_visits
+) {
+	visits_t* visits;
+	bool enabled;
+
+	for (uint32_t i = 0; i < SYSTEM_TEST_ENTITIES; i++) {
+		if (!is_live[i]) {
+			continue;
+		}
+
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_get_component(world, entities[i], MAYBE_COMPONENT_ID(visits_t), (void**)&visits));
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_is_entity_enabled(world, entities[i], &enabled));
+		TEST_CHECK(visits->query_visits == (enabled ? expected_visits : 0));
+		TEST_CHECK(visits->iterator_visits == (enabled ? expected_visits : 0));
+	}
+}
+
+/* @brief Every entity is visited once per cycle of slices, even if it moves in the middle of a cycle */
+static void test_slices(void) {
+	maybe_world_t world;
+	maybe_entity_t entities[SYSTEM_TEST_ENTITIES];
+	bool is_live[SYSTEM_TEST_ENTITIES];
+	const maybe_system_schedule_t schedule = { MAYBE_SYSTEM_RATE_VARIABLE, 1, 0, SYSTEM_TEST_SLICES };
+	visits_t* visits;
+	uint32_t tagged_visits, previous_tagged_visits = 0;
+	uint32_t tick;
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_init(&world));
+	MAYBE_REGISTER_COMPONENT_TYPE(&world, visits_t);
+	MAYBE_REGISTER_COMPONENT_TYPE(&world, tag_t);
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_register_system_with_schedule(&world, count_query_visits, schedule, 1, MAYBE_COMPONENT_ID(visits_t)));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_register_system_with_schedule(&world, count_iterator_visits, schedule, 1, MAYBE_COMPONENT_ID(visits_t)));
+
+	/* Every 4th entity is tagged, so the tagged archetype's IDs are all equal modulo the slice count */
+	for (uint32_t i = 0; i < SYSTEM_TEST_ENTITIES; i++) {
+		if (0 == (i % 4)) {
+			TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_add_entity(&world, 2, &entities[i], MAYBE_COMPONENT_ID(visits_t), MAYBE_COMPONENT_ID(tag_t)));
+		} else {
+			TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_add_entity(&world, 1, &entities[i], MAYBE_COMPONENT_ID(visits_t)));
+		}
+
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_set_component(&world, entities[i], MAYBE_COMPONENT_ID(visits_t), &(visits_t){ 0, 0 }));
+
+		if (3 == (i % 10)) {
+			TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_set_entity_enabled(&world, entities[i], false));
+		}
+		is_live[i] = true;
+	}
+
+	/* The tagged entities are spread over the slices */
+	for (tick = 0; tick < SYSTEM_TEST_SLICES; tick++) {
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_update(&world));
+
+		tagged_visits = 0;
+		for (uint32_t i = 0; i < SYSTEM_TEST_ENTITIES; i += 4) {
+			TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_get_component(&world, entities[i], MAYBE_COMPONENT_ID(visits_t), (void**)&visits));
+			tagged_visits += visits->query_visits;
+		}
+
+		TEST_CHECK((tagged_visits - previous_tagged_visits) > (SYSTEM_TEST_ENTITIES / 4 / SYSTEM_TEST_SLICES / 2));
+		TEST_CHECK((tagged_visits - previous_tagged_visits) < (SYSTEM_TEST_ENTITIES / 4 / SYSTEM_TEST_SLICES * 2));
+		previous_tagged_visits = tagged_visits;
+	}
+	check_visits(&world, entities, is_live, 1);
+
+	/* Move and remove entities in the middle of a cycle */
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_update(&world));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_update(&world));
+	for (uint32_t i = 0; i < SYSTEM_TEST_ENTITIES; i++) {
+		if (7 == (i % 50)) {
+			TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_remove_entity(&world, entities[i]));
+			is_live[i] = false;
+		} else if ((1 == (i % 3)) && (0 != (i % 4))) {
+			TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_add_component(&world, entities[i], MAYBE_COMPONENT_ID(tag_t)));
+		}
+	}
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_update(&world));
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_update(&world));
+	check_visits(&world, entities, is_live, 2);
+
+	for (tick = 0; tick < SYSTEM_TEST_SLICES; tick++) {
+		TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_update(&world));
+	}
+	check_visits(&world, entities, is_live, 3);
+
+	TEST_CHECK(MAYBE_ERROR_SUCCESS == maybe_world_free(&world));
+}
+
+int main(void) {
+	test_slices();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,26 @@
+#ifndef MAYBE_TEST_H
+#define MAYBE_TEST_H
+
+#include <stdio.h>
+
+/*
+ * @brief Minimal test helpers
+ *
+ * A test is a main function that calls TEST_CHECK for every expectation and returns TEST_RESULT().
+ * A failed check prints its location and condition, and the test keeps going so one run reports
+ * every failure.
+ * */
+
+static int test_failures = 0;
+
+#define TEST_CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			test_failures++; \
+		} \
+	} while (0)
+
+#define TEST_RESULT() (0 == test_failures ? 0 : 1)
+
+#endif